@@ -0,0 +1,91 @@
+#include "api/EasyAPI.h"
+#include "objects/ParticleSystem.h"
+#include <GLFW/glfw3.h>
+#include <iostream>
+
+/**
+ * @brief Smoke Demo - A Million Particles
+ *
+ * This example demonstrates Kalem's particle systems:
+ * - One ParticleSystem object holding up to a million particles
+ * - Emitters with spawn rates, directions and lifetimes
+ * - Gravity, drag and growth shaping the smoke
+ * - Particles fading out as they age
+ */
+int main() {
+    std::cout << "=== Kalem Smoke Demo ===" << std::endl;
+
+    // ============================================================================
+    // CREATE THE SMOKE
+    // ============================================================================
+
+    auto smoke = create_particle_system(0, -250, 1000000);
+
+    // Three chimneys, each releasing 150000 particles per second for about
+    // two seconds: close to a million particles alive at once
+    for (int i = -1; i <= 1; ++i) {
+        ParticleEmitter chimney;
+        chimney.position = glm::vec2(i * 200.0f, 0.0f);
+        chimney.rate = 150000.0f;
+        chimney.direction = glm::vec2(0.0f, 1.0f);
+        chimney.spread = 12.0f;
+        chimney.minSpeed = 60.0f;
+        chimney.maxSpeed = 120.0f;
+        chimney.minLifetime = 1.8f;
+        chimney.maxLifetime = 2.2f;
+        chimney.minRadius = 1.0f;
+        chimney.maxRadius = 2.0f;
+        chimney.color = glm::vec4(0.55f, 0.55f, 0.6f, 0.25f);
+        smoke->addEmitter(chimney);
+    }
+
+    // Warm smoke rises, slows down and spreads out
+    smoke->setGravity(glm::vec2(0.0f, 20.0f));
+    smoke->setDrag(0.6f);
+    smoke->setGrowth(3.0f);
+
+    auto title = create_text(0, 350, "Particle System - Smoke", WHITE);
+
+    // ============================================================================
+    // ADD INTERACTIVE CONTROLS
+    // ============================================================================
+
+    // Space to pause/resume
+    on_key_press(GLFW_KEY_SPACE, []() {
+        if (is_playing()) {
+            pause_animation();
+            std::cout << "Animation paused" << std::endl;
+        } else {
+            resume_animation();
+            std::cout << "Animation resumed" << std::endl;
+        }
+    });
+
+    // E to switch the middle chimney on and off
+    on_key_press(GLFW_KEY_E, [smoke]() {
+        ParticleEmitter& middle = smoke->getEmitter(1);
+        middle.enabled = !middle.enabled;
+        std::cout << "Middle chimney " << (middle.enabled ? "on" : "off") << std::endl;
+    });
+
+    // Mouse click releases a puff from the nearest chimney
+    on_mouse_click([smoke](float x, float) {
+        size_t chimney = x < -100.0f ? 0 : (x > 100.0f ? 2 : 1);
+        smoke->burst(chimney, 50000);
+        std::cout << "Puff from chimney " << chimney << ", "
+                  << smoke->getParticleCount() << " particles alive" << std::endl;
+    });
+
+    // ============================================================================
+    // RUN THE SIMULATION
+    // ============================================================================
+
+    std::cout << "Controls:" << std::endl;
+    std::cout << "  SPACE - Pause/Resume" << std::endl;
+    std::cout << "  E - Toggle the middle chimney" << std::endl;
+    std::cout << "  Mouse Click - Puff of smoke" << std::endl;
+
+    run_animation();
+
+    return 0;
+}
@@ -1,16 +1,14 @@
 #include "EasyAPI.h"
 #include "engine/AnimationEngine.h"
+#include "engine/Animator.h"
 #include "objects/AnimationObject.h"
 #include "objects/Particle.h"
+#include "objects/ParticleSystem.h"
 #include "objects/Shape.h"
 #include "objects/Text.h"
+#include <algorithm>
 #include <iostream>
-
-// ============================================================================
-// GLOBAL ENGINE INSTANCE
-// ============================================================================
-
-static AnimationEngine* g_engine = nullptr;
+#include <unordered_map>
 
 // ============================================================================
 // COLOR DEFINITIONS
@@ -30,24 +28,31 @@ const Color GRAY(0.5f, 0.5f, 0.5f);
 // ENGINE INITIALIZATION
 // ============================================================================
 
-void initEngine() {
+void initEngine(bool headless) {
     if (!g_engine) {
-        g_engine = new AnimationEngine();
-        std::cout << "Kalem Animation Engine initialized successfully!" << std::endl;
+        g_engine = new AnimationEngine(headless ? RenderMode::Headless : RenderMode::Windowed);
+        
+        // Headless runs are batch jobs whose output may be piped, so they stay quiet
+        if (!headless) {
+            std::cout << "Kalem Animation Engine initialized successfully!" << std::endl;
+        }
     }
 }
 
 void shutdownEngine() {
     if (g_engine) {
+        bool headless = g_engine->isHeadless();
         delete g_engine;
         g_engine = nullptr;
-        std::cout << "Kalem Animation Engine shutdown." << std::endl;
+        if (!headless) {
+            std::cout << "Kalem Animation Engine shutdown." << std::endl;
+        }
     }
 }
 
 AnimationEngine* getEngine() {
     if (!g_engine) {
-        initEngine();
+        initEngine(false);
     }
     return g_engine;
 }
@@ -95,69 +100,219 @@ std::shared_ptr<AnimationObject> create_particle(float x, float y, float mass) {
     return particle;
 }
 
+std::shared_ptr<ParticleSystem> create_particle_system(float x, float y, size_t maxParticles) {
+    auto engine = getEngine();
+    auto system = std::make_shared<ParticleSystem>(x, y, maxParticles);
+    engine->addObject(system);
+    return system;
+}
+
+// Shortest lifetime add_emitter() gives a particle, as a fraction of the
+// requested one, so particles do not all fade out together
+constexpr float kEmitterMinLifetimeRatio = 0.75f;
+
+size_t add_emitter(std::shared_ptr<ParticleSystem> system, float rate, const Color& color, const Time& lifetime) {
+    if (!system) return 0;
+    
+    ParticleEmitter emitter;
+    emitter.rate = rate;
+    emitter.color = glm::vec4(color.r, color.g, color.b, 1.0f);
+    emitter.minLifetime = lifetime.value * kEmitterMinLifetimeRatio;
+    emitter.maxLifetime = lifetime.value;
+    return system->addEmitter(emitter);
+}
+
 // ============================================================================
 // ANIMATION FUNCTIONS
 // ============================================================================
 
-std::function<void(AnimationObject*, float)> move_to(float x, float y) {
-    return [x, y](AnimationObject* obj, float progress) {
-        if (obj) {
-            // Simple linear interpolation
-            glm::vec3 startPos = obj->getPosition();
-            glm::vec3 endPos(x, y, startPos.z);
-            glm::vec3 newPos = startPos + (endPos - startPos) * progress;
-            obj->setPosition(newPos);
-        }
-    };
+namespace {
+
+Animation makeAnimation(Animation::Property property, const glm::vec4& value, bool relative, Easing easing) {
+    Animation animation;
+    animation.property = property;
+    animation.value = value;
+    animation.relative = relative;
+    animation.easing = easing;
+    return animation;
 }
 
-std::function<void(AnimationObject*, float)> move_by(float dx, float dy) {
-    return [dx, dy](AnimationObject* obj, float progress) {
-        if (obj) {
-            glm::vec3 pos = obj->getPosition();
-            obj->setPosition(pos.x + dx * progress, pos.y + dy * progress, pos.z);
+// Cuts a track at time, keeping its value there as a key; returns that value
+template <typename T>
+T holdAt(KeyframeTrack<T>& track, const T& current, float time) {
+    T value = track.empty() ? current : track.evaluate(time);
+    track.removeKeysAfter(time);
+    if (track.empty() || track.getEndTime() < time) {
+        track.addKey(time, value);
+    }
+    return value;
+}
+
+// Time the tracks an animation touches have no more keys after
+float getQueueEnd(const Animator::Tracks& tracks, const Animation& animation) {
+    switch (animation.property) {
+        case Animation::Property::Position: return tracks.position.getEndTime();
+        case Animation::Property::Rotation: return tracks.rotation.getEndTime();
+        case Animation::Property::Scale: return tracks.scale.getEndTime();
+        case Animation::Property::Color: return tracks.color.getEndTime();
+        case Animation::Property::Opacity: return tracks.opacity.getEndTime();
+        case Animation::Property::Sequence: {
+            float end = 0.0f;
+            for (const auto& step : animation.steps) {
+                end = std::max(end, getQueueEnd(tracks, step));
+            }
+            return end;
         }
-    };
+    }
+    return 0.0f;
+}
+
+// Holds every track an animation touches at its start, so a sequence
+// keeps properties its later steps animate still until they begin
+void holdTracks(Animator::Tracks& tracks, const AnimationObject& obj, const Animation& animation, float time) {
+    switch (animation.property) {
+        case Animation::Property::Position: holdAt(tracks.position, obj.getPosition(), time); break;
+        case Animation::Property::Rotation: holdAt(tracks.rotation, obj.getRotation(), time); break;
+        case Animation::Property::Scale: holdAt(tracks.scale, obj.getScale(), time); break;
+        case Animation::Property::Color: holdAt(tracks.color, obj.getColor(), time); break;
+        case Animation::Property::Opacity: holdAt(tracks.opacity, obj.getOpacity(), time); break;
+        case Animation::Property::Sequence:
+            for (const auto& step : animation.steps) {
+                holdTracks(tracks, obj, step, time);
+            }
+            break;
+    }
 }
 
-std::function<void(AnimationObject*, float)> rotate_to(float angle) {
-    return [angle](AnimationObject* obj, float progress) {
-        if (obj) {
-            glm::vec3 rotation = obj->getRotation();
-            float startAngle = rotation.z;
-            float endAngle = angle;
-            float newAngle = startAngle + (endAngle - startAngle) * progress;
-            obj->setRotation(rotation.x, rotation.y, newAngle);
+void addKeys(Animator::Tracks& tracks, const AnimationObject& obj, const Animation& animation,
+             float start, float duration) {
+    const glm::vec4& value = animation.value;
+    float end = start + duration;
+    
+    switch (animation.property) {
+        case Animation::Property::Position: {
+            glm::vec3 from = holdAt(tracks.position, obj.getPosition(), start);
+            glm::vec3 to = animation.relative ? from + glm::vec3(value.x, value.y, 0.0f)
+                                              : glm::vec3(value.x, value.y, from.z);
+            tracks.position.addKey(end, to, animation.easing);
+            break;
         }
-    };
+        case Animation::Property::Rotation: {
+            glm::vec3 from = holdAt(tracks.rotation, obj.getRotation(), start);
+            tracks.rotation.addKey(end, glm::vec3(from.x, from.y, value.x), animation.easing);
+            break;
+        }
+        case Animation::Property::Scale: {
+            holdAt(tracks.scale, obj.getScale(), start);
+            tracks.scale.addKey(end, glm::vec3(value), animation.easing);
+            break;
+        }
+        case Animation::Property::Color: {
+            glm::vec4 from = holdAt(tracks.color, obj.getColor(), start);
+            tracks.color.addKey(end, glm::vec4(value.r, value.g, value.b, from.a), animation.easing);
+            break;
+        }
+        case Animation::Property::Opacity: {
+            holdAt(tracks.opacity, obj.getOpacity(), start);
+            tracks.opacity.addKey(end, value.x, animation.easing);
+            break;
+        }
+        case Animation::Property::Sequence: {
+            if (animation.steps.empty()) break;
+            float stepDuration = duration / animation.steps.size();
+            for (size_t i = 0; i < animation.steps.size(); ++i) {
+                addKeys(tracks, obj, animation.steps[i], start + i * stepDuration, stepDuration);
+            }
+            break;
+        }
+    }
 }
 
-std::function<void(AnimationObject*, float)> scale_to(float factor) {
-    return [factor](AnimationObject* obj, float progress) {
-        if (obj) {
-            glm::vec3 scale = obj->getScale();
-            glm::vec3 startScale = scale;
-            glm::vec3 endScale(factor, factor, factor);
-            glm::vec3 newScale = startScale + (endScale - startScale) * progress;
-            obj->setScale(newScale);
+} // namespace
+
+Animation::operator std::function<void(AnimationObject*, float)>() const {
+    // Keys over progress 0..1 per object, laid down from its values at the
+    // first call, so every later call eases between the same two ends
+    struct ObjectKeys {
+        std::weak_ptr<AnimationObject> object;
+        bool owned;                 // Object was held by a shared_ptr, so its lifetime is known
+        Animator::Tracks tracks;
+    };
+    auto keys = std::make_shared<std::unordered_map<const AnimationObject*, ObjectKeys>>();
+    Animation animation = *this;
+    return [animation, keys](AnimationObject* obj, float progress) {
+        if (!obj) return;
+        
+        auto it = keys->find(obj);
+        if (it == keys->end() || (it->second.owned && it->second.object.expired())) {
+            // Forget dropped objects, including one whose address obj reuses
+            for (auto dead = keys->begin(); dead != keys->end();) {
+                if (dead->second.owned && dead->second.object.expired()) {
+                    dead = keys->erase(dead);
+                } else {
+                    ++dead;
+                }
+            }
+            
+            ObjectKeys entry;
+            entry.object = obj->weak_from_this();
+            entry.owned = !entry.object.expired();
+            holdTracks(entry.tracks, *obj, animation, 0.0f);
+            addKeys(entry.tracks, *obj, animation, 0.0f, 1.0f);
+            it = keys->emplace(obj, std::move(entry)).first;
         }
+        Animator::apply(*obj, it->second.tracks, progress);
     };
 }
 
+Animation move_to(float x, float y, Easing easing) {
+    return makeAnimation(Animation::Property::Position, glm::vec4(x, y, 0.0f, 0.0f), false, easing);
+}
+
+Animation move_by(float dx, float dy, Easing easing) {
+    return makeAnimation(Animation::Property::Position, glm::vec4(dx, dy, 0.0f, 0.0f), true, easing);
+}
+
+Animation rotate_to(float angle, Easing easing) {
+    return makeAnimation(Animation::Property::Rotation, glm::vec4(angle, 0.0f, 0.0f, 0.0f), false, easing);
+}
+
+Animation scale_to(float factor, Easing easing) {
+    return makeAnimation(Animation::Property::Scale, glm::vec4(factor), false, easing);
+}
+
+Animation fade_to(float opacity, Easing easing) {
+    return makeAnimation(Animation::Property::Opacity, glm::vec4(opacity, 0.0f, 0.0f, 0.0f), false, easing);
+}
+
+Animation color_to(const Color& color, Easing easing) {
+    return makeAnimation(Animation::Property::Color, glm::vec4(color.r, color.g, color.b, 1.0f), false, easing);
+}
+
+void animate(std::shared_ptr<AnimationObject> obj, const Animation& animation, const Time& duration) {
+    if (!obj) return;
+    
+    // Keys are placed on the timeline from now, so animations added later
+    // during playback start where the object is at that moment. Animations
+    // of the same property queue up instead of cutting each other off.
+    auto engine = getEngine();
+    Animator::Tracks& tracks = engine->getAnimator()->getTracks(obj);
+    float start = std::max(engine->getCurrentTime(), getQueueEnd(tracks, animation));
+    holdTracks(tracks, *obj, animation, start);
+    addKeys(tracks, *obj, animation, start, std::max(0.0f, duration.value));
+    
+    // Start the animation
+    engine->play();
+}
+
 void animate(std::shared_ptr<AnimationObject> obj, 
              std::function<void(AnimationObject*, float)> animation, 
              const Time& duration) {
     if (obj && animation) {
-        // Store animation data in the object
-        obj->setAnimationCallback([animation, duration](float progress) {
-            // This will be called by the engine during animation updates
-            if (animation) {
-                animation(nullptr, progress);
-            }
-        });
+        auto engine = getEngine();
+        engine->getAnimator()->addCustom(obj, animation, engine->getCurrentTime(), duration.value);
         
         // Start the animation
-        auto engine = getEngine();
         engine->play();
     }
 }
@@ -177,7 +332,7 @@ void apply_gravity(std::shared_ptr<AnimationObject> obj) {
     if (obj) {
         obj->setGravityAffected(true);
         auto engine = getEngine();
-        engine->setGravity(0.0f, -9.81f, 0.0f);
+        engine->setGravity(0.0f, -9.81f);
     }
 }
 
@@ -194,7 +349,7 @@ void run_simulation(const Time& duration) {
     
     // Run for the specified duration
     float elapsed = 0.0f;
-    while (elapsed < duration.seconds) {
+    while (elapsed < duration.value) {
         engine->update(1.0f / 60.0f); // 60 FPS
         elapsed += 1.0f / 60.0f;
     }
@@ -204,6 +359,17 @@ void run_simulation(const Time& duration) {
 // COMPLEX ANIMATIONS
 // ============================================================================
 
+Animation sequence(std::vector<Animation> animations) {
+    Animation combined;
+    combined.property = Animation::Property::Sequence;
+    combined.steps = std::move(animations);
+    return combined;
+}
+
+Animation sequence(std::initializer_list<Animation> animations) {
+    return sequence(std::vector<Animation>(animations));
+}
+
 std::function<void(AnimationObject*, float)> sequence(
     std::vector<std::function<void(AnimationObject*, float)>> animations) {
     
@@ -220,6 +386,23 @@ std::function<void(AnimationObject*, float)> sequence(
     };
 }
 
+void parallel(std::vector<std::shared_ptr<AnimationObject>> objects,
+             std::vector<Animation> animations,
+             const Time& duration) {
+    
+    if (objects.size() != animations.size()) return;
+    
+    for (size_t i = 0; i < objects.size(); ++i) {
+        animate(objects[i], animations[i], duration);
+    }
+}
+
+void parallel(std::vector<std::shared_ptr<AnimationObject>> objects,
+             std::initializer_list<Animation> animations,
+             const Time& duration) {
+    parallel(std::move(objects), std::vector<Animation>(animations), duration);
+}
+
 void parallel(std::vector<std::shared_ptr<AnimationObject>> objects,
              std::vector<std::function<void(AnimationObject*, float)>> animations,
              const Time& duration) {
@@ -264,11 +447,31 @@ void reset_animation() {
     engine->reset();
 }
 
+void set_duration(const Time& duration) {
+    auto engine = getEngine();
+    engine->setDuration(duration.value);
+}
+
 void set_speed(float scale) {
     auto engine = getEngine();
     engine->setTimeScale(scale);
 }
 
+void seek_to(const Time& time) {
+    auto engine = getEngine();
+    engine->seek(time.value);
+}
+
+void add_marker(const std::string& name, const Time& time) {
+    auto engine = getEngine();
+    engine->addMarker(time.value, name);
+}
+
+bool jump_to_marker(const std::string& name) {
+    auto engine = getEngine();
+    return engine->jumpToMarker(name);
+}
+
 // ============================================================================
 // STYLING FUNCTIONS
 // ============================================================================
@@ -295,14 +498,19 @@ void set_visible(std::shared_ptr<AnimationObject> obj, bool visible) {
 // EXPORT FUNCTIONS
 // ============================================================================
 
-void export_video(const std::string& filename, int fps) {
+void export_video(const std::string& filename, int fps, AntialiasingQuality quality) {
+    auto engine = getEngine();
+    engine->exportVideo(filename, fps, quality);
+}
+
+void export_gif(const std::string& filename, int fps, AntialiasingQuality quality) {
     auto engine = getEngine();
-    engine->exportVideo(filename, fps);
+    engine->exportGif(filename, fps, false, quality);
 }
 
-void export_gif(const std::string& filename, int fps) {
+void benchmark_antialiasing(int frames) {
     auto engine = getEngine();
-    engine->exportGif(filename, fps);
+    engine->benchmarkAntialiasing(frames);
 }
 
 void export_code(const std::string& filename) {
@@ -3,10 +3,15 @@
 #include <memory>
 #include <string>
 #include <functional>
+#include <initializer_list>
 #include <vector>
+#include <glm/glm.hpp>
+#include "../engine/KeyframeTrack.h"
+#include "../rendering/Antialiasing.h"
 
 // Forward declarations
 class AnimationObject;
+class ParticleSystem;
 class Color;
 class Time;
 
@@ -98,44 +103,134 @@ std::shared_ptr<AnimationObject> create_text(float x, float y, const std::string
  */
 std::shared_ptr<AnimationObject> create_particle(float x, float y, float mass = 1.0f);
 
+/**
+ * @brief Create a particle system for smoke, sparks and other effects
+ *
+ * Add emitters with add_emitter(), or include objects/ParticleSystem.h to
+ * configure emitters, gravity, drag and growth directly.
+ * @param x X position
+ * @param y Y position
+ * @param maxParticles Most particles alive at once; spawns beyond it are dropped
+ * @return Pointer to the created particle system
+ */
+std::shared_ptr<ParticleSystem> create_particle_system(float x, float y, size_t maxParticles = 100000);
+
+/**
+ * @brief Emit particles from the center of a particle system in every direction
+ * @param system Particle system to emit from
+ * @param rate Particles per second
+ * @param color Particle color
+ * @param lifetime Longest a particle lives before fading out completely.
+ *                 Each particle gets a random lifetime between 0.75x and 1x
+ *                 this, so they do not all vanish at once; set
+ *                 ParticleEmitter::minLifetime and maxLifetime directly to
+ *                 control the spread.
+ * @return Index of the emitter within the system
+ */
+size_t add_emitter(std::shared_ptr<ParticleSystem> system, float rate, const Color& color, const Time& lifetime = Time(2.0f));
+
 // ============================================================================
 // ANIMATION FUNCTIONS
 // ============================================================================
 
+/**
+ * @brief Description of a property animation
+ *
+ * Built by move_to() and friends and turned into keyframes by animate(),
+ * which runs it over its duration.
+ *
+ * move_to(), move_by(), rotate_to() and scale_to() used to return a
+ * std::function. An Animation still converts to one, so code that stores
+ * them as functions or passes them to the function overloads of
+ * animate(), sequence() and parallel() keeps compiling. The function
+ * eases the property from the object's value at its first call.
+ */
+struct Animation {
+    enum class Property {
+        Position,
+        Rotation,
+        Scale,
+        Color,
+        Opacity,
+        Sequence        // Runs steps one after another
+    };
+    
+    Property property = Property::Position;
+    glm::vec4 value = glm::vec4(0.0f);  // Target, or offset when relative
+    bool relative = false;
+    Easing easing = Easing::Linear;
+    std::vector<Animation> steps;
+    
+    operator std::function<void(AnimationObject*, float)>() const;
+};
+
 /**
  * @brief Move object to position
  * @param x Target X position
  * @param y Target Y position
- * @return Animation function
+ * @param easing Shape of the motion
+ * @return Animation
  */
-std::function<void(AnimationObject*, float)> move_to(float x, float y);
+Animation move_to(float x, float y, Easing easing = Easing::Linear);
 
 /**
  * @brief Move object by offset
  * @param dx X offset
  * @param dy Y offset
- * @return Animation function
+ * @param easing Shape of the motion
+ * @return Animation
  */
-std::function<void(AnimationObject*, float)> move_by(float dx, float dy);
+Animation move_by(float dx, float dy, Easing easing = Easing::Linear);
 
 /**
  * @brief Rotate object to angle
  * @param angle Target angle in degrees
- * @return Animation function
+ * @param easing Shape of the motion
+ * @return Animation
  */
-std::function<void(AnimationObject*, float)> rotate_to(float angle);
+Animation rotate_to(float angle, Easing easing = Easing::Linear);
 
 /**
  * @brief Scale object to factor
  * @param factor Target scale factor
- * @return Animation function
+ * @param easing Shape of the motion
+ * @return Animation
+ */
+Animation scale_to(float factor, Easing easing = Easing::Linear);
+
+/**
+ * @brief Fade object to opacity
+ * @param opacity Target opacity (0.0 = transparent, 1.0 = opaque)
+ * @param easing Shape of the motion
+ * @return Animation
  */
-std::function<void(AnimationObject*, float)> scale_to(float factor);
+Animation fade_to(float opacity, Easing easing = Easing::Linear);
+
+/**
+ * @brief Blend object to color
+ * @param color Target color
+ * @param easing Shape of the motion
+ * @return Animation
+ */
+Animation color_to(const Color& color, Easing easing = Easing::Linear);
 
 /**
  * @brief Animate an object
+ * 
+ * Adds keyframes from the object's value at the start to the target at
+ * the end of the duration. The animation starts at the current time, or
+ * once earlier animations of the same properties have finished, so
+ * several animate() calls in a row play one after another.
+ * @param obj Object to animate
+ * @param animation Animation to run
+ * @param duration Animation duration
+ */
+void animate(std::shared_ptr<AnimationObject> obj, const Animation& animation, const Time& duration);
+
+/**
+ * @brief Animate an object with a custom function
  * @param obj Object to animate
- * @param animation Animation function
+ * @param animation Function called with the object and progress (0..1)
  * @param duration Animation duration
  */
 void animate(std::shared_ptr<AnimationObject> obj, 
@@ -179,6 +274,17 @@ void run_simulation(const Time& duration);
 
 /**
  * @brief Create sequence of animations
+ * @param animations List of animations, each given an equal share of the duration
+ * @return Combined animation
+ */
+Animation sequence(std::vector<Animation> animations);
+
+// Picks the Animation overload for braced lists like {move_to(...), ...},
+// which could otherwise also convert to a list of functions
+Animation sequence(std::initializer_list<Animation> animations);
+
+/**
+ * @brief Create sequence of custom animation functions
  * @param animations List of animation functions
  * @return Combined animation function
  */
@@ -191,6 +297,20 @@ std::function<void(AnimationObject*, float)> sequence(
  * @param animations List of animations
  * @param duration Animation duration
  */
+void parallel(std::vector<std::shared_ptr<AnimationObject>> objects,
+             std::vector<Animation> animations,
+             const Time& duration);
+
+void parallel(std::vector<std::shared_ptr<AnimationObject>> objects,
+             std::initializer_list<Animation> animations,
+             const Time& duration);
+
+/**
+ * @brief Run custom animation functions in parallel
+ * @param objects List of objects
+ * @param animations List of animation functions
+ * @param duration Animation duration
+ */
 void parallel(std::vector<std::shared_ptr<AnimationObject>> objects,
              std::vector<std::function<void(AnimationObject*, float)>> animations,
              const Time& duration);
@@ -219,12 +339,38 @@ void resume_animation();
  */
 void reset_animation();
 
+/**
+ * @brief Set the total animation length used by exports
+ * @param duration Animation duration
+ */
+void set_duration(const Time& duration);
+
 /**
  * @brief Set animation speed
  * @param scale Time scale (1.0 = normal, 2.0 = double speed, 0.5 = half speed)
  */
 void set_speed(float scale);
 
+/**
+ * @brief Jump to a point on the timeline
+ * @param time Time from the start of the animation
+ */
+void seek_to(const Time& time);
+
+/**
+ * @brief Name a point on the timeline
+ * @param name Marker name
+ * @param time Time from the start of the animation
+ */
+void add_marker(const std::string& name, const Time& time);
+
+/**
+ * @brief Jump to a named point on the timeline
+ * @param name Marker name
+ * @return False if there is no marker with that name
+ */
+bool jump_to_marker(const std::string& name);
+
 // ============================================================================
 // STYLING FUNCTIONS
 // ============================================================================
@@ -258,15 +404,25 @@ void set_visible(std::shared_ptr<AnimationObject> obj, bool visible);
  * @brief Export animation to video
  * @param filename Output filename
  * @param fps Frames per second
+ * @param quality Anti-aliasing tier, e.g. None for quick drafts
  */
-void export_video(const std::string& filename, int fps = 30);
+void export_video(const std::string& filename, int fps = 30,
+                  AntialiasingQuality quality = AntialiasingQuality::Analytic);
 
 /**
  * @brief Export animation to GIF
  * @param filename Output filename
  * @param fps Frames per second
+ * @param quality Anti-aliasing tier, e.g. None for quick drafts
+ */
+void export_gif(const std::string& filename, int fps = 15,
+                AntialiasingQuality quality = AntialiasingQuality::Analytic);
+
+/**
+ * @brief Print the time per frame of each anti-aliasing tier
+ * @param frames Frames rendered per tier
  */
-void export_gif(const std::string& filename, int fps = 15);
+void benchmark_antialiasing(int frames = 60);
 
 /**
  * @brief Export animation code
@@ -321,5 +477,6 @@ std::shared_ptr<AnimationObject> findObjectByName(const std::string& name);
 void wait(const Time& duration); 
 
 // Engine initialization and shutdown
-void initEngine();
+// Pass headless = true to render into an in-memory framebuffer with no window or GPU
+void initEngine(bool headless = false);
 void shutdownEngine(); 
\ No newline at end of file
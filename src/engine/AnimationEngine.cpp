@@ -1,13 +1,18 @@
 #include "AnimationEngine.h"
 #include "Scene.h"
 #include "Timeline.h"
+#include "Animator.h"
 #include "PhysicsEngine.h"
 #include "../rendering/Renderer.h"
 #include "../objects/AnimationObject.h"
-#include <GLFW/glfw3.h>
+#include "../export/VideoExporter.h"
+#include "../export/GifEncoder.h"
+#include "../utils/Time.h"
 #include <glad/glad.h>
+#include <GLFW/glfw3.h>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -17,9 +22,33 @@
 // Global engine instance
 AnimationEngine* g_engine = nullptr;
 
-AnimationEngine::AnimationEngine() 
-    : m_isRunning(false)
-    , m_timeScale(1.0f) {
+struct AnimationEngine::Snapshot {
+    int64_t slot;       // Index of the interval the snapshot was taken in
+    float time;
+    PhysicsEngine::State physics;
+    std::string scene;
+};
+
+AnimationEngine::AnimationEngine(RenderMode mode) 
+    : m_renderMode(mode)
+    , m_window(nullptr)
+    , m_isRunning(false)
+    , m_timeScale(1.0f)
+    , m_snapshotInterval(1.0f)
+    , m_snapshotBodySet(0)
+    , m_snapshotObjectSet(0) {
+    
+    if (m_renderMode == RenderMode::Headless) {
+        // No window, no GL context: frames are rasterized into an in-memory framebuffer
+        m_currentScene = std::make_unique<Scene>("MainScene");
+        m_physicsEngine = std::make_unique<PhysicsEngine>();
+        m_renderer = std::make_unique<Renderer>(1200, 800);
+        m_timeline = std::make_unique<Timeline>();
+        m_animator = std::make_unique<Animator>();
+        
+        m_renderer->setBackground(0.1f, 0.1f, 0.1f);
+        return;
+    }
     
     // Initialize GLFW
     if (!glfwInit()) {
@@ -41,6 +70,7 @@ AnimationEngine::AnimationEngine()
     }
     
     glfwMakeContextCurrent(window);
+    m_window = window;
     
     // Initialize GLAD
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
@@ -53,6 +83,7 @@ AnimationEngine::AnimationEngine()
     m_physicsEngine = std::make_unique<PhysicsEngine>();
     m_renderer = std::make_unique<Renderer>(window);
     m_timeline = std::make_unique<Timeline>();
+    m_animator = std::make_unique<Animator>();
     
     // Minimal input handling for basic controls (ESC to exit)
     glfwSetWindowUserPointer(window, this);
@@ -70,7 +101,9 @@ AnimationEngine::AnimationEngine()
 }
 
 AnimationEngine::~AnimationEngine() {
-    glfwTerminate();
+    if (m_renderMode == RenderMode::Windowed) {
+        glfwTerminate();
+    }
 }
 
 Scene* AnimationEngine::createScene(const std::string& name) {
@@ -85,6 +118,7 @@ Scene* AnimationEngine::getCurrentScene() {
 void AnimationEngine::setCurrentScene(Scene* scene) {
     if (scene) {
         m_currentScene.reset(scene);
+        m_snapshots.clear();
     }
 }
 
@@ -99,10 +133,21 @@ void AnimationEngine::pause() {
 }
 
 void AnimationEngine::reset() {
+    // Rewind physics and per-frame state while the snapshots still describe
+    // this run. Bodies edited since, for example given new start positions,
+    // make seek() drop them and keep the edits instead.
+    seek(0.0f);
+    
     m_timeline->reset();
+    if (m_physicsEngine) {
+        m_physicsEngine->resetAccumulator();
+    }
     if (m_currentScene) {
         m_currentScene->reset();
     }
+    
+    // The next run records its own
+    clearSnapshots();
 }
 
 void AnimationEngine::setTimeScale(float scale) {
@@ -114,6 +159,147 @@ float AnimationEngine::getTimeScale() const {
     return m_timeScale;
 }
 
+void AnimationEngine::seek(float time) {
+    validateSnapshots();
+    
+    // Replay writes keyframed properties as playback did from the start
+    if (m_animator) {
+        m_animator->invalidate();
+    }
+    
+    m_timeline->setCurrentTime(time);
+    float target = m_timeline->getCurrentTime();
+    
+    // Physics and per-frame object state can only be re-simulated, so start
+    // from the nearest snapshot and step to the target the way playback
+    // does, saving snapshots on the way for later seeks. The steps are
+    // physics steps, so physics matches playback exactly and frame-rate
+    // dependent object updates closely. Without a snapshot at or before
+    // the target both stay as they are.
+    float snapshotTime = 0.0f;
+    if (restoreSnapshot(target, snapshotTime)) {
+        const double step = m_physicsEngine ? m_physicsEngine->getTimeStep() : 1.0 / 60.0;
+        double current = snapshotTime;
+        while (current < target) {
+            double dt = std::min(step, static_cast<double>(target) - current);
+            current += dt;
+            advance(static_cast<float>(current), static_cast<float>(dt));
+            recordSnapshot(static_cast<float>(current));
+        }
+    }
+    
+    // Keyframed properties at the target have the last word
+    if (m_animator) {
+        m_animator->invalidate();
+        m_animator->evaluate(target);
+    }
+    markBodies();
+}
+
+void AnimationEngine::setSnapshotInterval(float interval) {
+    m_snapshotInterval = std::max(0.01f, interval);
+    m_snapshots.clear();
+}
+
+float AnimationEngine::getSnapshotInterval() const {
+    return m_snapshotInterval;
+}
+
+void AnimationEngine::clearSnapshots() {
+    m_snapshots.clear();
+}
+
+size_t AnimationEngine::getSnapshotCount() const {
+    return m_snapshots.size();
+}
+
+void AnimationEngine::recordSnapshot(float time) {
+    if (time < 0.0f) return;
+    
+    int64_t slot = static_cast<int64_t>(std::floor(time / m_snapshotInterval));
+    auto it = std::lower_bound(m_snapshots.begin(), m_snapshots.end(), slot,
+        [](const Snapshot& snapshot, int64_t value) {
+            return snapshot.slot < value;
+        });
+    if (it != m_snapshots.end() && it->slot == slot) return;
+    
+    if (m_snapshots.empty()) {
+        m_snapshotBodySet = m_physicsEngine ? m_physicsEngine->getBodySetVersion() : 0;
+        m_snapshotObjectSet = m_currentScene ? m_currentScene->getObjectSetVersion() : 0;
+    }
+    
+    Snapshot snapshot;
+    snapshot.slot = slot;
+    snapshot.time = time;
+    if (m_physicsEngine) {
+        m_physicsEngine->saveState(snapshot.physics);
+    }
+    if (m_currentScene) {
+        m_currentScene->saveState(snapshot.scene);
+    }
+    m_snapshots.insert(it, std::move(snapshot));
+}
+
+bool AnimationEngine::restoreSnapshot(float time, float& snapshotTime) {
+    auto it = std::upper_bound(m_snapshots.begin(), m_snapshots.end(), time,
+        [](float value, const Snapshot& snapshot) {
+            return value < snapshot.time;
+        });
+    if (it == m_snapshots.begin()) return false;
+    
+    // Objects first, so physics has the last word on the bodies they share
+    const Snapshot& snapshot = *(it - 1);
+    if (m_currentScene) {
+        m_currentScene->restoreState(snapshot.scene);
+    }
+    if (m_physicsEngine) {
+        m_physicsEngine->restoreState(snapshot.physics);
+    }
+    
+    snapshotTime = snapshot.time;
+    return true;
+}
+
+void AnimationEngine::validateSnapshots() {
+    if (m_snapshots.empty()) return;
+    
+    // Snapshots describe one set of bodies and objects and the path the
+    // bodies took; an edit from outside starts a new path they don't know
+    bool bodiesChanged = m_physicsEngine &&
+        (m_physicsEngine->getBodySetVersion() != m_snapshotBodySet || m_physicsEngine->bodiesChangedSinceMark());
+    bool objectsChanged = m_currentScene && m_currentScene->getObjectSetVersion() != m_snapshotObjectSet;
+    if (bodiesChanged || objectsChanged) {
+        m_snapshots.clear();
+    }
+}
+
+void AnimationEngine::markBodies() {
+    if (m_physicsEngine) {
+        m_physicsEngine->markBodies();
+    }
+}
+
+void AnimationEngine::addMarker(float time, const std::string& name) {
+    m_timeline->addMarker(time, name);
+}
+
+bool AnimationEngine::jumpToMarker(const std::string& name) {
+    float time;
+    if (!m_timeline->getMarkerTime(name, time)) {
+        return false;
+    }
+    seek(time);
+    return true;
+}
+
+Timeline* AnimationEngine::getTimeline() {
+    return m_timeline.get();
+}
+
+Animator* AnimationEngine::getAnimator() {
+    return m_animator.get();
+}
+
 void AnimationEngine::addObject(std::shared_ptr<AnimationObject> obj) {
     if (m_currentScene) {
         m_currentScene->addObject(obj);
@@ -122,6 +308,10 @@ void AnimationEngine::addObject(std::shared_ptr<AnimationObject> obj) {
 
 void AnimationEngine::removeObject(const std::string& name) {
     if (m_currentScene) {
+        std::shared_ptr<AnimationObject> obj = m_currentScene->getObject(name);
+        if (obj && m_animator) {
+            m_animator->removeTracks(obj.get());
+        }
         m_currentScene->removeObject(name);
     }
 }
@@ -151,10 +341,19 @@ void AnimationEngine::setAirResistance(float resistance) {
     }
 }
 
+PhysicsEngine* AnimationEngine::getPhysicsEngine() {
+    return m_physicsEngine.get();
+}
+
+float AnimationEngine::getInterpolationAlpha() const {
+    if (!m_physicsEngine || !m_physicsEngine->isEnabled()) return 1.0f;
+    return m_physicsEngine->getInterpolationAlpha();
+}
+
 void AnimationEngine::render() {
     if (m_renderer && m_currentScene) {
         m_renderer->beginFrame();
-        m_currentScene->render(m_renderer.get());
+        m_currentScene->render(m_renderer.get(), getInterpolationAlpha());
         m_renderer->endFrame();
     }
 }
@@ -165,6 +364,18 @@ void AnimationEngine::setBackground(float r, float g, float b) {
     }
 }
 
+Renderer* AnimationEngine::getRenderer() {
+    return m_renderer.get();
+}
+
+RenderMode AnimationEngine::getRenderMode() const {
+    return m_renderMode;
+}
+
+bool AnimationEngine::isHeadless() const {
+    return m_renderMode == RenderMode::Headless;
+}
+
 void AnimationEngine::handleInput() {
     if (m_currentScene) {
         m_currentScene->handleInput();
@@ -183,14 +394,133 @@ void AnimationEngine::onMouseClick(std::function<void(float, float)> callback) {
     m_mouseCallbacks.push_back(callback);
 }
 
-void AnimationEngine::exportVideo(const std::string& filename, int fps) {
-    // TODO: Implement video export
-    std::cout << "Video export to " << filename << " (not yet implemented)" << std::endl;
+void AnimationEngine::exportVideo(const std::string& filename, int fps, AntialiasingQuality quality) {
+    if (!m_renderer || !m_currentScene || fps <= 0) return;
+    
+    float duration = getDuration();
+    if (duration <= 0.0f) {
+        std::cerr << "Video export needs a duration; call setDuration() or animate something first" << std::endl;
+        return;
+    }
+    
+    int width = m_renderer->getWindowWidth();
+    int height = m_renderer->getWindowHeight();
+    
+    VideoExporter exporter;
+    if (!exporter.open(filename, width, height, fps)) {
+        std::cerr << "Video export to " << filename << " failed to start" << std::endl;
+        return;
+    }
+    
+    std::cout << "Exporting video to " << filename << " (" << width << "x" << height
+              << " @ " << fps << " fps, " << getAntialiasingName(quality) << " anti-aliasing)..." << std::endl;
+    
+    Time::Timer timer;
+    timer.start();
+    
+    renderTimeline(fps, quality, [&exporter](Renderer* renderer) {
+        VideoFrame* frame = exporter.acquireFrame();
+        if (!frame) return false;
+        
+        renderer->readPixels(frame->pixels.data());
+        frame->bottomUp = !renderer->isHeadless();
+        frame->damage = renderer->getDamage();
+        frame->hasDamage = true;
+        exporter.submitFrame(frame);
+        return !exporter.hasFailed();
+    });
+    
+    bool ok = exporter.close();
+    timer.stop();
+    
+    float elapsed = timer.getElapsed();
+    std::cout << "Video export " << (ok ? "finished: " : "failed after ") << exporter.getFramesWritten()
+              << " frames in " << elapsed << "s (" << (elapsed > 0.0f ? duration / elapsed : 0.0f)
+              << "x real time)" << std::endl;
+}
+
+void AnimationEngine::exportGif(const std::string& filename, int fps, bool dither, AntialiasingQuality quality) {
+    if (!m_renderer || !m_currentScene || fps <= 0) return;
+    
+    float duration = getDuration();
+    if (duration <= 0.0f) {
+        std::cerr << "GIF export needs a duration; call setDuration() or animate something first" << std::endl;
+        return;
+    }
+    
+    int width = m_renderer->getWindowWidth();
+    int height = m_renderer->getWindowHeight();
+    
+    GifOptions options;
+    options.dither = dither;
+    GifEncoder encoder(options);
+    if (!encoder.open(filename, width, height, fps)) {
+        std::cerr << "GIF export to " << filename << " failed to start" << std::endl;
+        return;
+    }
+    
+    std::cout << "Exporting GIF to " << filename << " (" << width << "x" << height
+              << " @ " << fps << " fps, " << getAntialiasingName(quality) << " anti-aliasing)..." << std::endl;
+    
+    Time::Timer timer;
+    timer.start();
+    
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    renderTimeline(fps, quality, [&encoder, &pixels](Renderer* renderer) {
+        renderer->readPixels(pixels.data());
+        return encoder.addFrame(pixels.data(), !renderer->isHeadless(), &renderer->getDamage());
+    });
+    
+    bool ok = encoder.close();
+    timer.stop();
+    
+    std::cout << "GIF export " << (ok ? "finished: " : "failed after ") << encoder.getFramesWritten()
+              << " frames in " << timer.getElapsed() << "s" << std::endl;
 }
 
-void AnimationEngine::exportGif(const std::string& filename, int fps) {
-    // TODO: Implement GIF export
-    std::cout << "GIF export to " << filename << " (not yet implemented)" << std::endl;
+void AnimationEngine::benchmarkAntialiasing(int frames) {
+    if (!m_renderer || !m_currentScene || frames <= 0) return;
+    
+    // The CPU path has no multisampling, so it only has two distinct tiers
+    std::vector<AntialiasingQuality> tiers = { AntialiasingQuality::None, AntialiasingQuality::Analytic };
+    if (!m_renderer->isHeadless()) {
+        tiers.push_back(AntialiasingQuality::MSAA2x);
+        tiers.push_back(AntialiasingQuality::MSAA4x);
+        tiers.push_back(AntialiasingQuality::MSAA8x);
+    }
+    
+    int width = m_renderer->getWindowWidth();
+    int height = m_renderer->getWindowHeight();
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    
+    // Repaint every frame in full, or the repeated frames would cost nothing
+    AntialiasingQuality previousQuality = m_renderer->getAntialiasing();
+    bool previousTracking = m_renderer->isDamageTrackingEnabled();
+    m_renderer->setDamageTracking(false);
+    
+    std::cout << "Anti-aliasing benchmark (" << width << "x" << height << ", "
+              << frames << " frames per tier):" << std::endl;
+    
+    for (AntialiasingQuality tier : tiers) {
+        m_renderer->setAntialiasing(tier);
+        
+        Time::Timer timer;
+        timer.start();
+        for (int i = 0; i < frames; ++i) {
+            // Reading the frame back waits until the GPU has finished it
+            m_renderer->beginFrame();
+            m_currentScene->render(m_renderer.get(), getInterpolationAlpha());
+            m_renderer->readPixels(pixels.data());
+            m_renderer->endFrame();
+        }
+        timer.stop();
+        
+        std::cout << "  " << getAntialiasingName(tier) << ": "
+                  << timer.getElapsed() * 1000.0f / frames << " ms/frame" << std::endl;
+    }
+    
+    m_renderer->setAntialiasing(previousQuality);
+    m_renderer->setDamageTracking(previousTracking);
 }
 
 void AnimationEngine::exportCode(const std::string& filename) {
@@ -199,16 +529,105 @@ void AnimationEngine::exportCode(const std::string& filename) {
 }
 
 bool AnimationEngine::isRunning() const {
-    return m_isRunning && !glfwWindowShouldClose(glfwGetCurrentContext());
+    if (m_renderMode == RenderMode::Headless) {
+        return m_isRunning;
+    }
+    return m_isRunning && m_window && !glfwWindowShouldClose(m_window);
 }
 
 float AnimationEngine::getCurrentTime() const {
     return m_timeline->getCurrentTime();
 }
 
+void AnimationEngine::setDuration(float duration) {
+    m_timeline->setDuration(duration);
+}
+
+float AnimationEngine::getDuration() const {
+    float duration = m_timeline->getDuration();
+    if (duration <= 0.0f && m_animator) {
+        duration = m_animator->getEndTime();
+    }
+    return duration;
+}
+
 void AnimationEngine::update(float dt) {
-    // Update timeline
-    m_timeline->update(dt * m_timeScale);
+    // Advance timeline, physics and scene
+    simulate(dt);
+    
+    // Render
+    render();
+    
+    // Handle input
+    handleInput();
+    
+    // Poll events
+    if (m_window) {
+        glfwPollEvents();
+    }
+}
+
+int AnimationEngine::renderTimeline(int fps, AntialiasingQuality quality,
+                                    const std::function<bool(Renderer*)>& captureFrame) {
+    AntialiasingQuality previousQuality = m_renderer->getAntialiasing();
+    m_renderer->setAntialiasing(quality);
+    
+    reset();
+    play();
+    
+    // Step the timeline at exactly 1/fps so exports are independent of wall-clock speed
+    const float frameTime = 1.0f / fps;
+    const int frameCount = static_cast<int>(std::ceil(getDuration() * fps));
+    
+    int rendered = 0;
+    for (; rendered < frameCount; ++rendered) {
+        if (rendered > 0) {
+            simulate(frameTime);
+        }
+        
+        // Capture before endFrame() so the GL back buffer is still valid
+        m_renderer->beginFrame();
+        m_currentScene->render(m_renderer.get(), getInterpolationAlpha());
+        bool keepGoing = captureFrame(m_renderer.get());
+        m_renderer->endFrame();
+        
+        if (!keepGoing) break;
+    }
+    
+    pause();
+    m_renderer->setAntialiasing(previousQuality);
+    return rendered;
+}
+
+void AnimationEngine::simulate(float dt) {
+    validateSnapshots();
+    
+    // State now matches the timeline time, so it can be a seek target.
+    // While paused physics keeps running without the timeline, so it can't.
+    bool playing = m_timeline->isPlaying();
+    if (playing) {
+        recordSnapshot(m_timeline->getCurrentTime());
+    }
+    
+    // Physics and objects run on the timeline's clock, time scale included,
+    // so snapshots taken at timeline times match the simulated state. A
+    // timeline stopping at its end only advances part of the frame.
+    float startTime = m_timeline->getCurrentTime();
+    m_timeline->update(dt);
+    float scaledDt = dt * m_timeline->getTimeScale();
+    if (playing && !m_timeline->isPlaying()) {
+        scaledDt = m_timeline->getCurrentTime() - startTime;
+    }
+    
+    advance(m_timeline->getCurrentTime(), scaledDt);
+    markBodies();
+}
+
+void AnimationEngine::advance(float time, float dt) {
+    // Apply keyframed properties at the new timeline time
+    if (m_animator) {
+        m_animator->evaluate(time);
+    }
     
     // Update physics
     if (m_physicsEngine && m_physicsEngine->isEnabled()) {
@@ -219,15 +638,6 @@ void AnimationEngine::update(float dt) {
     if (m_currentScene) {
         m_currentScene->update(dt);
     }
-    
-    // Render
-    render();
-    
-    // Handle input
-    handleInput();
-    
-    // Poll events
-    glfwPollEvents();
 }
 
 void AnimationEngine::handleKeyPress(int key) {
@@ -1,16 +1,32 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
 #include <functional>
+#include "../rendering/Antialiasing.h"
 
 // Forward declarations
 class Scene;
 class AnimationObject;
 class Timeline;
+class Animator;
 class PhysicsEngine;
 class Renderer;
+struct GLFWwindow;
+
+/**
+ * @brief How the engine presents rendered frames
+ * 
+ * Windowed opens a GLFW window with an OpenGL context. Headless creates
+ * no window and renders every frame into an in-memory framebuffer on the
+ * CPU, for batch rendering on machines without a display or GPU.
+ */
+enum class RenderMode {
+    Windowed,
+    Headless
+};
 
 /**
  * @brief Main animation engine class
@@ -20,7 +36,7 @@ class Renderer;
  */
 class AnimationEngine {
 public:
-    AnimationEngine();
+    AnimationEngine(RenderMode mode = RenderMode::Windowed);
     ~AnimationEngine();
 
     // Scene management
@@ -35,6 +51,23 @@ public:
     void setTimeScale(float scale);
     float getTimeScale() const;
     
+    // Seeking. Keyframed properties are evaluated at the new time. Physics
+    // and the objects' per-frame state restore the latest snapshot before
+    // it and simulate the remainder. Snapshots are taken once per interval
+    // of playback and dropped when objects are added or removed, or when
+    // bodies are changed from outside the simulation.
+    void seek(float time);
+    void setSnapshotInterval(float interval);
+    float getSnapshotInterval() const;
+    void clearSnapshots();
+    size_t getSnapshotCount() const;
+    void addMarker(float time, const std::string& name);
+    bool jumpToMarker(const std::string& name);
+    Timeline* getTimeline();
+    
+    // Keyframe animation, evaluated at the timeline's time every update
+    Animator* getAnimator();
+    
     // Object management
     void addObject(std::shared_ptr<AnimationObject> obj);
     void removeObject(const std::string& name);
@@ -44,10 +77,15 @@ public:
     void enablePhysics(bool enable);
     void setGravity(float gx, float gy);
     void setAirResistance(float resistance);
+    PhysicsEngine* getPhysicsEngine();
+    float getInterpolationAlpha() const;
     
     // Rendering
     void render();
     void setBackground(float r, float g, float b);
+    Renderer* getRenderer();
+    RenderMode getRenderMode() const;
+    bool isHeadless() const;
     
     // Input handling
     void handleInput();
@@ -57,13 +95,24 @@ public:
     void onMouseClick(std::function<void(float, float)> callback);
     
     // Export
-    void exportVideo(const std::string& filename, int fps = 30);
-    void exportGif(const std::string& filename, int fps = 15);
+    // Exports render the timeline's duration at a fixed fps and anti-aliasing
+    // tier, e.g. None for drafts. For video, .y4m files use the built-in
+    // writer and every other extension is encoded by ffmpeg.
+    void exportVideo(const std::string& filename, int fps = 30,
+                     AntialiasingQuality quality = AntialiasingQuality::Analytic);
+    void exportGif(const std::string& filename, int fps = 15, bool dither = false,
+                   AntialiasingQuality quality = AntialiasingQuality::Analytic);
     void exportCode(const std::string& filename);
     
+    // Renders the current frame repeatedly at every anti-aliasing tier the
+    // renderer supports and prints the time per frame of each
+    void benchmarkAntialiasing(int frames = 60);
+    
     // Utility
     bool isRunning() const;
     float getCurrentTime() const;
+    void setDuration(float duration);
+    float getDuration() const;      // Set duration, or else when the last animation ends
     void update(float dt);
 
 private:
@@ -71,11 +120,31 @@ private:
     std::unique_ptr<PhysicsEngine> m_physicsEngine;
     std::unique_ptr<Renderer> m_renderer;
     std::unique_ptr<Timeline> m_timeline;
+    std::unique_ptr<Animator> m_animator;
     
+    RenderMode m_renderMode;
+    GLFWwindow* m_window;
     bool m_isRunning;
     float m_timeScale;
     std::vector<std::function<void()>> m_keyCallbacks;
     std::vector<std::function<void(float, float)>> m_mouseCallbacks;
+    
+    // Seek snapshots, sorted by time, at most one per interval; all of them
+    // describe the body and object sets of the given versions
+    struct Snapshot;
+    float m_snapshotInterval;
+    std::vector<Snapshot> m_snapshots;
+    uint64_t m_snapshotBodySet;
+    uint64_t m_snapshotObjectSet;
+    
+    // Helper methods
+    void simulate(float dt);
+    void advance(float time, float dt);
+    void recordSnapshot(float time);
+    bool restoreSnapshot(float time, float& snapshotTime);
+    void validateSnapshots();
+    void markBodies();
+    int renderTimeline(int fps, AntialiasingQuality quality, const std::function<bool(Renderer*)>& captureFrame);
 };
 
 // Global engine instance
@@ -83,5 +152,5 @@ extern AnimationEngine* g_engine;
 
 // Easy access functions
 AnimationEngine* getEngine();
-void initEngine();
+void initEngine(bool headless);
 void shutdownEngine(); 
\ No newline at end of file
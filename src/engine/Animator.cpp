@@ -0,0 +1,155 @@
+#include "Animator.h"
+#include "../objects/AnimationObject.h"
+#include <algorithm>
+
+Animator::Animator() {
+}
+
+Animator::~Animator() {
+}
+
+// ============================================================================
+// Tracks
+// ============================================================================
+
+Animator::Tracks& Animator::getTracks(const std::shared_ptr<AnimationObject>& object) {
+    auto it = m_bindingIndex.find(object.get());
+    if (it != m_bindingIndex.end()) {
+        Binding& binding = m_bindings[it->second];
+        if (!binding.object.expired()) {
+            binding.tracks.written.mask = 0;
+            return binding.tracks;
+        }
+        // A new object reused the address of a dropped one
+        binding.object = object;
+        binding.tracks = Tracks();
+        return binding.tracks;
+    }
+
+    m_bindingIndex[object.get()] = m_bindings.size();
+    m_bindings.push_back(Binding{object, object.get(), Tracks()});
+    return m_bindings.back().tracks;
+}
+
+bool Animator::hasTracks(const AnimationObject* object) const {
+    return m_bindingIndex.find(object) != m_bindingIndex.end();
+}
+
+void Animator::removeTracks(const AnimationObject* object) {
+    auto it = m_bindingIndex.find(object);
+    if (it == m_bindingIndex.end()) {
+        return;
+    }
+
+    // Swap the last binding into the hole so the list stays contiguous
+    size_t index = it->second;
+    m_bindingIndex.erase(it);
+    if (index + 1 != m_bindings.size()) {
+        m_bindings[index] = std::move(m_bindings.back());
+        m_bindingIndex[m_bindings[index].key] = index;
+    }
+    m_bindings.pop_back();
+}
+
+void Animator::addCustom(const std::shared_ptr<AnimationObject>& object, CustomAnimation animation,
+                         float startTime, float duration) {
+    if (!animation) {
+        return;
+    }
+    m_customs.push_back(Custom{object, std::move(animation), startTime, std::max(0.0f, duration), false});
+}
+
+void Animator::clear() {
+    m_bindings.clear();
+    m_bindingIndex.clear();
+    m_customs.clear();
+}
+
+void Animator::invalidate() {
+    for (auto& binding : m_bindings) {
+        binding.tracks.written.mask = 0;
+    }
+}
+
+// ============================================================================
+// Evaluation
+// ============================================================================
+
+void Animator::evaluate(float time) {
+    // Forget objects that were dropped; removal swaps the last binding in,
+    // so the index only moves past live ones
+    for (size_t i = 0; i < m_bindings.size();) {
+        auto object = m_bindings[i].object.lock();
+        if (!object) {
+            removeTracks(m_bindings[i].key);
+            continue;
+        }
+        apply(*object, m_bindings[i].tracks, time);
+        ++i;
+    }
+
+    for (auto& custom : m_customs) {
+        auto object = custom.object.lock();
+        if (!object || time < custom.startTime) {
+            custom.finished = false;
+            continue;
+        }
+
+        float endTime = custom.startTime + custom.duration;
+        if (time < endTime) {
+            custom.finished = false;
+            custom.animation(object.get(), (time - custom.startTime) / custom.duration);
+        } else if (!custom.finished) {
+            custom.finished = true;
+            custom.animation(object.get(), 1.0f);
+        }
+    }
+
+    m_customs.erase(
+        std::remove_if(m_customs.begin(), m_customs.end(),
+            [](const Custom& custom) {
+                return custom.object.expired();
+            }),
+        m_customs.end()
+    );
+}
+
+float Animator::getEndTime() const {
+    float endTime = 0.0f;
+    for (const auto& binding : m_bindings) {
+        const Tracks& tracks = binding.tracks;
+        endTime = std::max(endTime, tracks.position.getEndTime());
+        endTime = std::max(endTime, tracks.rotation.getEndTime());
+        endTime = std::max(endTime, tracks.scale.getEndTime());
+        endTime = std::max(endTime, tracks.color.getEndTime());
+        endTime = std::max(endTime, tracks.opacity.getEndTime());
+    }
+    for (const auto& custom : m_customs) {
+        endTime = std::max(endTime, custom.startTime + custom.duration);
+    }
+    return endTime;
+}
+
+namespace {
+
+// Samples a track into its written value; true if that value is new
+template <typename T>
+bool update(const KeyframeTrack<T>& track, float time, T& written, unsigned bit, unsigned& mask) {
+    if (track.empty()) return false;
+    T value = track.evaluate(time);
+    if ((mask & bit) && value == written) return false;
+    written = value;
+    mask |= bit;
+    return true;
+}
+
+} // namespace
+
+void Animator::apply(AnimationObject& object, Tracks& tracks, float time) {
+    Tracks::Written& written = tracks.written;
+    if (update(tracks.position, time, written.position, 1u, written.mask)) object.setPosition(written.position);
+    if (update(tracks.rotation, time, written.rotation, 2u, written.mask)) object.setRotation(written.rotation);
+    if (update(tracks.scale, time, written.scale, 4u, written.mask)) object.setScale(written.scale);
+    if (update(tracks.color, time, written.color, 8u, written.mask)) object.setColor(written.color);
+    if (update(tracks.opacity, time, written.opacity, 16u, written.mask)) object.setOpacity(written.opacity);
+}
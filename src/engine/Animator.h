@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "KeyframeTrack.h"
+
+// Forward declarations
+class AnimationObject;
+
+/**
+ * @brief Keyframe animation of object properties over timeline time
+ *
+ * Every animated object gets a set of typed tracks for its position,
+ * rotation, scale, color and opacity. evaluate() samples each non-empty
+ * track at the timeline's time and writes the result to the object only
+ * if it differs from the value the track wrote last. Held values before
+ * the first key and after the last are written once, so they cost no
+ * scene updates and leave later changes to the object alone. Objects
+ * are stored in one contiguous list and no closure is called for them.
+ *
+ * Motion that keyframes can't describe is still possible with a custom
+ * animation: a function called with the object and its progress, 0..1,
+ * while the timeline is inside its time range.
+ *
+ * The animator only keeps weak references, so removing an object from
+ * its scene and dropping it also ends its animation; evaluate() forgets
+ * the tracks and custom animations of dropped objects.
+ */
+class Animator {
+public:
+    struct Tracks {
+        KeyframeTrack<glm::vec3> position;
+        KeyframeTrack<glm::vec3> rotation;     // Degrees per axis
+        KeyframeTrack<glm::vec3> scale;
+        KeyframeTrack<glm::vec4> color;
+        KeyframeTrack<float> opacity;
+
+        // Values apply() last wrote. Each value is written once, so a held
+        // key doesn't undo what physics or code does to the object later.
+        struct Written {
+            glm::vec3 position;
+            glm::vec3 rotation;
+            glm::vec3 scale;
+            glm::vec4 color;
+            float opacity;
+            unsigned mask = 0;      // Bit per property above that has a value
+        } written;
+    };
+
+    using CustomAnimation = std::function<void(AnimationObject*, float)>;
+
+    Animator();
+    ~Animator();
+
+    // Tracks of an object, created empty on first use. The reference is
+    // valid until tracks are created for another object. The next
+    // evaluate() writes every track of the object again.
+    Tracks& getTracks(const std::shared_ptr<AnimationObject>& object);
+    bool hasTracks(const AnimationObject* object) const;
+    void removeTracks(const AnimationObject* object);
+
+    void addCustom(const std::shared_ptr<AnimationObject>& object, CustomAnimation animation,
+                   float startTime, float duration);
+
+    void clear();
+
+    // Makes the next evaluate() write every track again, e.g. after a seek
+    void invalidate();
+
+    // Applies every animation at a timeline time
+    void evaluate(float time);
+
+    // Time the last key or custom animation ends
+    float getEndTime() const;
+
+    // Writes each non-empty track's value at a time to the object when it
+    // differs from the value the track wrote last
+    static void apply(AnimationObject& object, Tracks& tracks, float time);
+
+private:
+    struct Binding {
+        std::weak_ptr<AnimationObject> object;
+        const AnimationObject* key;     // Address the binding is indexed under
+        Tracks tracks;
+    };
+
+    struct Custom {
+        std::weak_ptr<AnimationObject> object;
+        CustomAnimation animation;
+        float startTime;
+        float duration;
+        bool finished;      // Has been called with progress 1 since the timeline passed its end
+    };
+
+    std::vector<Binding> m_bindings;
+    std::unordered_map<const AnimationObject*, size_t> m_bindingIndex;
+    std::vector<Custom> m_customs;
+};
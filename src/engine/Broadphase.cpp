@@ -0,0 +1,391 @@
+#include "Broadphase.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Proxies covering more cells than this are tested against everything instead
+const int64_t kMaxCellsPerProxy = 64;
+
+bool overlaps(const BroadphaseProxy& a, const BroadphaseProxy& b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y;
+}
+
+bool bothStatic(const BroadphaseProxy& a, const BroadphaseProxy& b) {
+    return a.isStatic && b.isStatic;
+}
+
+BroadphasePair makePair(uint32_t a, uint32_t b) {
+    BroadphasePair pair;
+    pair.first = std::min(a, b);
+    pair.second = std::max(a, b);
+    return pair;
+}
+
+uint64_t pairKey(uint32_t a, uint32_t b) {
+    BroadphasePair pair = makePair(a, b);
+    return (static_cast<uint64_t>(pair.first) << 32) | pair.second;
+}
+
+BroadphasePair pairFromKey(uint64_t key) {
+    BroadphasePair pair;
+    pair.first = static_cast<uint32_t>(key >> 32);
+    pair.second = static_cast<uint32_t>(key);
+    return pair;
+}
+
+void sortPairs(std::vector<BroadphasePair>& pairs) {
+    std::sort(pairs.begin(), pairs.end(), [](const BroadphasePair& a, const BroadphasePair& b) {
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    });
+}
+
+} // namespace
+
+Broadphase::~Broadphase() {
+}
+
+// ============================================================================
+// ALL PAIRS
+// ============================================================================
+
+AllPairsBroadphase::AllPairsBroadphase()
+    : m_proxies(nullptr) {
+}
+
+BroadphaseType AllPairsBroadphase::getType() const {
+    return BroadphaseType::AllPairs;
+}
+
+void AllPairsBroadphase::update(const std::vector<BroadphaseProxy>& proxies) {
+    m_proxies = &proxies;
+    m_active.clear();
+    for (size_t i = 0; i < proxies.size(); ++i) {
+        if (proxies[i].active) {
+            m_active.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+void AllPairsBroadphase::findPairs(std::vector<BroadphasePair>& pairs) {
+    pairs.clear();
+    if (!m_proxies) return;
+    const std::vector<BroadphaseProxy>& proxies = *m_proxies;
+    
+    for (size_t i = 0; i < m_active.size(); ++i) {
+        for (size_t j = i + 1; j < m_active.size(); ++j) {
+            if (bothStatic(proxies[m_active[i]], proxies[m_active[j]])) continue;
+            pairs.push_back(makePair(m_active[i], m_active[j]));
+        }
+    }
+}
+
+// ============================================================================
+// SPATIAL HASH
+// ============================================================================
+
+SpatialHashBroadphase::SpatialHashBroadphase()
+    : m_proxies(nullptr)
+    , m_cellSize(1.0f)
+    , m_inverseCellSize(1.0f) {
+}
+
+BroadphaseType SpatialHashBroadphase::getType() const {
+    return BroadphaseType::SpatialHash;
+}
+
+float SpatialHashBroadphase::getCellSize() const {
+    return m_cellSize;
+}
+
+void SpatialHashBroadphase::update(const std::vector<BroadphaseProxy>& proxies) {
+    m_proxies = &proxies;
+    m_entries.clear();
+    m_oversized.clear();
+
+    // Size cells after the average body so most bodies land in one to four cells
+    double extentSum = 0.0;
+    size_t activeCount = 0;
+    for (const auto& proxy : proxies) {
+        if (!proxy.active) continue;
+        glm::vec2 size = proxy.max - proxy.min;
+        extentSum += std::max(size.x, size.y);
+        ++activeCount;
+    }
+    if (activeCount == 0) {
+        m_sorted.clear();
+        m_bucketStarts.assign(1, 0);
+        return;
+    }
+
+    m_cellSize = std::max(static_cast<float>(extentSum / activeCount), 1e-4f);
+    m_inverseCellSize = 1.0f / m_cellSize;
+
+    for (size_t i = 0; i < proxies.size(); ++i) {
+        const BroadphaseProxy& proxy = proxies[i];
+        if (!proxy.active) continue;
+
+        int32_t x0 = toCell(proxy.min.x);
+        int32_t y0 = toCell(proxy.min.y);
+        int32_t x1 = toCell(proxy.max.x);
+        int32_t y1 = toCell(proxy.max.y);
+
+        int64_t cellCount = (static_cast<int64_t>(x1) - x0 + 1) * (static_cast<int64_t>(y1) - y0 + 1);
+        if (cellCount > kMaxCellsPerProxy) {
+            m_oversized.push_back(static_cast<uint32_t>(i));
+            continue;
+        }
+
+        for (int32_t y = y0; y <= y1; ++y) {
+            for (int32_t x = x0; x <= x1; ++x) {
+                m_entries.push_back({x, y, static_cast<uint32_t>(i)});
+            }
+        }
+    }
+
+    // Counting sort of the entries into a power-of-two bucket table
+    size_t bucketCount = 16;
+    while (bucketCount < m_entries.size() * 2) {
+        bucketCount *= 2;
+    }
+
+    m_bucketStarts.assign(bucketCount + 1, 0);
+    for (const auto& entry : m_entries) {
+        ++m_bucketStarts[bucketOf(entry.cellX, entry.cellY) + 1];
+    }
+    for (size_t i = 1; i <= bucketCount; ++i) {
+        m_bucketStarts[i] += m_bucketStarts[i - 1];
+    }
+
+    m_sorted.resize(m_entries.size());
+    m_bucketCursor.assign(m_bucketStarts.begin(), m_bucketStarts.end() - 1);
+    for (const auto& entry : m_entries) {
+        m_sorted[m_bucketCursor[bucketOf(entry.cellX, entry.cellY)]++] = entry;
+    }
+}
+
+void SpatialHashBroadphase::findPairs(std::vector<BroadphasePair>& pairs) {
+    pairs.clear();
+    if (!m_proxies) return;
+    const std::vector<BroadphaseProxy>& proxies = *m_proxies;
+
+    size_t bucketCount = m_bucketStarts.size() - 1;
+    for (size_t bucket = 0; bucket < bucketCount; ++bucket) {
+        uint32_t begin = m_bucketStarts[bucket];
+        uint32_t end = m_bucketStarts[bucket + 1];
+
+        for (uint32_t i = begin; i < end; ++i) {
+            const CellEntry& a = m_sorted[i];
+            for (uint32_t j = i + 1; j < end; ++j) {
+                const CellEntry& b = m_sorted[j];
+
+                // Buckets can hold several cells that hash alike
+                if (a.cellX != b.cellX || a.cellY != b.cellY) continue;
+
+                const BroadphaseProxy& proxyA = proxies[a.proxy];
+                const BroadphaseProxy& proxyB = proxies[b.proxy];
+                if (bothStatic(proxyA, proxyB) || !overlaps(proxyA, proxyB)) continue;
+
+                // Bodies sharing several cells are reported only from the cell
+                // holding the minimum corner of their overlap
+                int32_t ownerX = toCell(std::max(proxyA.min.x, proxyB.min.x));
+                int32_t ownerY = toCell(std::max(proxyA.min.y, proxyB.min.y));
+                if (ownerX != a.cellX || ownerY != a.cellY) continue;
+
+                pairs.push_back(makePair(a.proxy, b.proxy));
+            }
+        }
+    }
+
+    // Oversized proxies skip the grid and are tested against every other proxy
+    for (uint32_t big : m_oversized) {
+        for (size_t other = 0; other < proxies.size(); ++other) {
+            if (other == big || !proxies[other].active) continue;
+
+            // m_oversized is filled in index order
+            bool otherOversized = std::binary_search(m_oversized.begin(), m_oversized.end(), static_cast<uint32_t>(other));
+            if (otherOversized && other < big) continue;
+
+            if (!bothStatic(proxies[big], proxies[other]) && overlaps(proxies[big], proxies[other])) {
+                pairs.push_back(makePair(big, static_cast<uint32_t>(other)));
+            }
+        }
+    }
+
+    sortPairs(pairs);
+}
+
+int32_t SpatialHashBroadphase::toCell(float value) const {
+    float cell = std::floor(value * m_inverseCellSize);
+    return static_cast<int32_t>(glm::clamp(cell, -1.0e9f, 1.0e9f));
+}
+
+size_t SpatialHashBroadphase::bucketOf(int32_t cellX, int32_t cellY) const {
+    // Large primes from Teschner et al., "Optimized Spatial Hashing for Collision Detection"
+    uint32_t hash = (static_cast<uint32_t>(cellX) * 73856093u) ^ (static_cast<uint32_t>(cellY) * 19349663u);
+    return hash & (m_bucketStarts.size() - 2);
+}
+
+// ============================================================================
+// SWEEP AND PRUNE
+// ============================================================================
+
+SweepAndPruneBroadphase::SweepAndPruneBroadphase()
+    : m_proxies(nullptr) {
+}
+
+BroadphaseType SweepAndPruneBroadphase::getType() const {
+    return BroadphaseType::SweepAndPrune;
+}
+
+const std::vector<BroadphasePair>& SweepAndPruneBroadphase::getAddedPairs() const {
+    return m_addedPairs;
+}
+
+const std::vector<BroadphasePair>& SweepAndPruneBroadphase::getRemovedPairs() const {
+    return m_removedPairs;
+}
+
+void SweepAndPruneBroadphase::update(const std::vector<BroadphaseProxy>& proxies) {
+    m_proxies = &proxies;
+    m_addedPairs.clear();
+    m_removedPairs.clear();
+
+    // Bodies appearing, disappearing or changing static state invalidate the lists
+    bool layoutChanged = m_layout.size() != proxies.size();
+    for (size_t i = 0; i < proxies.size() && !layoutChanged; ++i) {
+        uint8_t layout = static_cast<uint8_t>(proxies[i].active | (proxies[i].isStatic << 1));
+        layoutChanged = layout != m_layout[i];
+    }
+    if (layoutChanged) {
+        rebuild(proxies);
+        return;
+    }
+
+    // Refresh endpoint values in place, then restore order with insertion sort
+    for (int axis = 0; axis < 2; ++axis) {
+        for (auto& endpoint : m_axes[axis]) {
+            const BroadphaseProxy& proxy = proxies[endpoint.data >> 1];
+            endpoint.value = (endpoint.data & 1) ? proxy.max[axis] : proxy.min[axis];
+        }
+        sortAxis(axis, proxies);
+    }
+}
+
+void SweepAndPruneBroadphase::findPairs(std::vector<BroadphasePair>& pairs) {
+    pairs.clear();
+    pairs.reserve(m_overlaps.size());
+    for (uint64_t key : m_overlaps) {
+        pairs.push_back(pairFromKey(key));
+    }
+    sortPairs(pairs);
+}
+
+void SweepAndPruneBroadphase::rebuild(const std::vector<BroadphaseProxy>& proxies) {
+    m_layout.resize(proxies.size());
+    for (int axis = 0; axis < 2; ++axis) {
+        m_axes[axis].clear();
+    }
+
+    for (size_t i = 0; i < proxies.size(); ++i) {
+        const BroadphaseProxy& proxy = proxies[i];
+        m_layout[i] = static_cast<uint8_t>(proxy.active | (proxy.isStatic << 1));
+        if (!proxy.active) continue;
+
+        uint32_t data = static_cast<uint32_t>(i) << 1;
+        for (int axis = 0; axis < 2; ++axis) {
+            m_axes[axis].push_back({proxy.min[axis], data});
+            m_axes[axis].push_back({proxy.max[axis], data | 1});
+        }
+    }
+
+    // Mins sort before maxes at equal values so touching bounds count as overlapping
+    for (int axis = 0; axis < 2; ++axis) {
+        std::sort(m_axes[axis].begin(), m_axes[axis].end(), [](const Endpoint& a, const Endpoint& b) {
+            return a.value != b.value ? a.value < b.value : (a.data & 1) < (b.data & 1);
+        });
+    }
+
+    // One sweep along x finds every overlap; y is checked on the proxies directly
+    std::unordered_set<uint64_t> overlaps;
+    std::vector<uint32_t> open;
+    for (const auto& endpoint : m_axes[0]) {
+        uint32_t index = endpoint.data >> 1;
+
+        if (endpoint.data & 1) {
+            open.erase(std::find(open.begin(), open.end(), index));
+            continue;
+        }
+
+        const BroadphaseProxy& proxy = proxies[index];
+        for (uint32_t other : open) {
+            const BroadphaseProxy& otherProxy = proxies[other];
+            if (!bothStatic(proxy, otherProxy) && proxy.min.y <= otherProxy.max.y && proxy.max.y >= otherProxy.min.y) {
+                overlaps.insert(pairKey(index, other));
+            }
+        }
+        open.push_back(index);
+    }
+
+    // Report the difference to the previous pair set as events
+    for (uint64_t key : overlaps) {
+        if (m_overlaps.count(key) == 0) m_addedPairs.push_back(pairFromKey(key));
+    }
+    for (uint64_t key : m_overlaps) {
+        if (overlaps.count(key) == 0) m_removedPairs.push_back(pairFromKey(key));
+    }
+    sortPairs(m_addedPairs);
+    sortPairs(m_removedPairs);
+
+    m_overlaps.swap(overlaps);
+}
+
+void SweepAndPruneBroadphase::sortAxis(int axis, const std::vector<BroadphaseProxy>& proxies) {
+    std::vector<Endpoint>& endpoints = m_axes[axis];
+
+    for (size_t i = 1; i < endpoints.size(); ++i) {
+        Endpoint moving = endpoints[i];
+        bool movingIsMax = (moving.data & 1) != 0;
+        uint32_t movingProxy = moving.data >> 1;
+
+        size_t j = i;
+        while (j > 0) {
+            const Endpoint& previous = endpoints[j - 1];
+            bool previousIsMax = (previous.data & 1) != 0;
+
+            bool before = moving.value < previous.value ||
+                          (moving.value == previous.value && !movingIsMax && previousIsMax);
+            if (!before) break;
+
+            uint32_t previousProxy = previous.data >> 1;
+            if (!movingIsMax && previousIsMax) {
+                // A min passing a max: the two may have started overlapping
+                const BroadphaseProxy& a = proxies[movingProxy];
+                const BroadphaseProxy& b = proxies[previousProxy];
+                if (!bothStatic(a, b) && overlaps(a, b)) {
+                    addPair(movingProxy, previousProxy);
+                }
+            } else if (movingIsMax && !previousIsMax) {
+                // A max passing a min: the two separated on this axis
+                removePair(movingProxy, previousProxy);
+            }
+
+            endpoints[j] = previous;
+            --j;
+        }
+        endpoints[j] = moving;
+    }
+}
+
+void SweepAndPruneBroadphase::addPair(uint32_t a, uint32_t b) {
+    if (m_overlaps.insert(pairKey(a, b)).second) {
+        m_addedPairs.push_back(makePair(a, b));
+    }
+}
+
+void SweepAndPruneBroadphase::removePair(uint32_t a, uint32_t b) {
+    if (m_overlaps.erase(pairKey(a, b)) > 0) {
+        m_removedPairs.push_back(makePair(a, b));
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_set>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Axis-aligned bounds of one physics body, as seen by the broadphase
+ *
+ * Proxies are indexed like PhysicsEngine's object list, so pairs can be
+ * reported as index pairs without touching the objects themselves.
+ */
+struct BroadphaseProxy {
+    glm::vec2 min;
+    glm::vec2 max;
+    bool isStatic;
+    bool active;    // false for empty slots; never reported in a pair
+};
+
+/**
+ * @brief Candidate pair of proxy indices, always with first < second
+ */
+struct BroadphasePair {
+    uint32_t first;
+    uint32_t second;
+};
+
+enum class BroadphaseType {
+    AllPairs,
+    SpatialHash,
+    SweepAndPrune
+};
+
+/**
+ * @brief Finds the pairs of bodies that may be colliding
+ *
+ * update() is given every proxy once per physics step; findPairs() then
+ * fills a list of candidates for the narrowphase. Pairs are always sorted
+ * by (first, second), so every implementation resolves collisions in the
+ * same order as the all-pairs reference. Two static proxies never form a
+ * pair.
+ */
+class Broadphase {
+public:
+    virtual ~Broadphase();
+
+    virtual BroadphaseType getType() const = 0;
+    virtual void update(const std::vector<BroadphaseProxy>& proxies) = 0;
+    virtual void findPairs(std::vector<BroadphasePair>& pairs) = 0;
+};
+
+/**
+ * @brief Reference broadphase that reports every pair of active proxies
+ *
+ * O(n²); kept to validate the faster implementations against.
+ */
+class AllPairsBroadphase : public Broadphase {
+public:
+    AllPairsBroadphase();
+
+    BroadphaseType getType() const override;
+    void update(const std::vector<BroadphaseProxy>& proxies) override;
+    void findPairs(std::vector<BroadphasePair>& pairs) override;
+
+private:
+    const std::vector<BroadphaseProxy>* m_proxies;
+    std::vector<uint32_t> m_active;
+};
+
+/**
+ * @brief Uniform grid hashed into a flat bucket table
+ *
+ * The cell size follows the average proxy extent and the grid is rebuilt
+ * on every update with a counting sort, so there are no per-cell
+ * allocations. Proxies spanning too many cells are kept in a separate
+ * list and tested against everything directly.
+ */
+class SpatialHashBroadphase : public Broadphase {
+public:
+    SpatialHashBroadphase();
+
+    BroadphaseType getType() const override;
+    void update(const std::vector<BroadphaseProxy>& proxies) override;
+    void findPairs(std::vector<BroadphasePair>& pairs) override;
+
+    float getCellSize() const;
+
+private:
+    struct CellEntry {
+        int32_t cellX;
+        int32_t cellY;
+        uint32_t proxy;
+    };
+
+    const std::vector<BroadphaseProxy>* m_proxies;
+    float m_cellSize;
+    float m_inverseCellSize;
+
+    std::vector<CellEntry> m_entries;       // Unsorted, one per covered cell
+    std::vector<CellEntry> m_sorted;        // Entries grouped by bucket
+    std::vector<uint32_t> m_bucketStarts;   // Bucket i is [starts[i], starts[i + 1])
+    std::vector<uint32_t> m_bucketCursor;
+    std::vector<uint32_t> m_oversized;
+
+    // Helper methods
+    int32_t toCell(float value) const;
+    size_t bucketOf(int32_t cellX, int32_t cellY) const;
+};
+
+/**
+ * @brief Sweep and prune over persistent, insertion-sorted endpoint lists
+ *
+ * Each axis keeps its min/max endpoints sorted between steps. Bodies move
+ * little from one step to the next, so re-sorting is close to O(n), and
+ * every endpoint swap updates the overlapping pair set directly. Best
+ * suited to mostly static scenes, where fixed endpoints never move.
+ *
+ * Pairs that started or stopped overlapping during the last update are
+ * available through getAddedPairs() and getRemovedPairs().
+ */
+class SweepAndPruneBroadphase : public Broadphase {
+public:
+    SweepAndPruneBroadphase();
+
+    BroadphaseType getType() const override;
+    void update(const std::vector<BroadphaseProxy>& proxies) override;
+    void findPairs(std::vector<BroadphasePair>& pairs) override;
+
+    // Pair events from the last update
+    const std::vector<BroadphasePair>& getAddedPairs() const;
+    const std::vector<BroadphasePair>& getRemovedPairs() const;
+
+private:
+    // Proxy index in the upper bits, lowest bit set for a max endpoint
+    struct Endpoint {
+        float value;
+        uint32_t data;
+    };
+
+    const std::vector<BroadphaseProxy>* m_proxies;
+    std::vector<Endpoint> m_axes[2];
+    std::vector<uint8_t> m_layout;      // active | static << 1, per proxy at last rebuild
+    std::unordered_set<uint64_t> m_overlaps;
+
+    std::vector<BroadphasePair> m_addedPairs;
+    std::vector<BroadphasePair> m_removedPairs;
+
+    // Helper methods
+    void rebuild(const std::vector<BroadphaseProxy>& proxies);
+    void sortAxis(int axis, const std::vector<BroadphaseProxy>& proxies);
+    void addPair(uint32_t a, uint32_t b);
+    void removePair(uint32_t a, uint32_t b);
+};
@@ -0,0 +1,181 @@
+#include "CullingGrid.h"
+#include <algorithm>
+#include <cmath>
+
+CullingGrid::CullingGrid(float cellSize)
+    : m_cellSize(1.0f)
+    , m_inverseCellSize(1.0f)
+    , m_count(0) {
+    setCellSize(cellSize);
+}
+
+void CullingGrid::setCellSize(float cellSize) {
+    m_cellSize = std::max(cellSize, 1e-3f);
+    m_inverseCellSize = 1.0f / m_cellSize;
+
+    // Re-bucket every item under the new size
+    m_cells.clear();
+    m_oversized.clear();
+    for (uint32_t handle = 0; handle < m_items.size(); ++handle) {
+        if (m_items[handle].active) {
+            link(handle);
+        }
+    }
+}
+
+float CullingGrid::getCellSize() const {
+    return m_cellSize;
+}
+
+uint32_t CullingGrid::insert(const glm::vec2& min, const glm::vec2& max) {
+    uint32_t handle;
+    if (!m_freeHandles.empty()) {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    } else {
+        handle = static_cast<uint32_t>(m_items.size());
+        m_items.push_back(Item());
+    }
+
+    Item& item = m_items[handle];
+    item.min = min;
+    item.max = max;
+    item.active = true;
+    link(handle);
+    ++m_count;
+    return handle;
+}
+
+void CullingGrid::update(uint32_t handle, const glm::vec2& min, const glm::vec2& max) {
+    if (handle >= m_items.size() || !m_items[handle].active) return;
+    Item& item = m_items[handle];
+
+    // Staying in the same cell only changes the stored bounds
+    bool oversized = !fitsCell(min, max);
+    if (oversized == item.oversized && (oversized || cellOf(min, max) == item.cell)) {
+        item.min = min;
+        item.max = max;
+        return;
+    }
+
+    unlink(handle);
+    item.min = min;
+    item.max = max;
+    link(handle);
+}
+
+void CullingGrid::remove(uint32_t handle) {
+    if (handle >= m_items.size() || !m_items[handle].active) return;
+
+    unlink(handle);
+    m_items[handle].active = false;
+    m_freeHandles.push_back(handle);
+    --m_count;
+}
+
+void CullingGrid::clear() {
+    m_items.clear();
+    m_freeHandles.clear();
+    m_cells.clear();
+    m_oversized.clear();
+    m_count = 0;
+}
+
+size_t CullingGrid::size() const {
+    return m_count;
+}
+
+void CullingGrid::query(const glm::vec2& min, const glm::vec2& max, std::vector<uint32_t>& handles) const {
+    auto testList = [&](const std::vector<uint32_t>& list) {
+        for (uint32_t handle : list) {
+            const Item& item = m_items[handle];
+            if (item.min.x <= max.x && item.max.x >= min.x &&
+                item.min.y <= max.y && item.max.y >= min.y) {
+                handles.push_back(handle);
+            }
+        }
+    };
+
+    // Items reach up to half a cell outside their own cell
+    float reach = m_cellSize * 0.5f;
+    int32_t minX = toCell(min.x - reach);
+    int32_t minY = toCell(min.y - reach);
+    int32_t maxX = toCell(max.x + reach);
+    int32_t maxY = toCell(max.y + reach);
+
+    double rangeCells = (static_cast<double>(maxX) - minX + 1.0) * (static_cast<double>(maxY) - minY + 1.0);
+    if (rangeCells > static_cast<double>(m_cells.size())) {
+        // Fewer occupied cells than cells in range: walk the occupied ones
+        for (const auto& cell : m_cells) {
+            int32_t cellX = static_cast<int32_t>(static_cast<uint32_t>(cell.first >> 32));
+            int32_t cellY = static_cast<int32_t>(static_cast<uint32_t>(cell.first));
+            if (cellX >= minX && cellX <= maxX && cellY >= minY && cellY <= maxY) {
+                testList(cell.second);
+            }
+        }
+    } else {
+        for (int32_t cellY = minY; cellY <= maxY; ++cellY) {
+            for (int32_t cellX = minX; cellX <= maxX; ++cellX) {
+                auto it = m_cells.find(packCell(cellX, cellY));
+                if (it != m_cells.end()) {
+                    testList(it->second);
+                }
+            }
+        }
+    }
+
+    testList(m_oversized);
+}
+
+int32_t CullingGrid::toCell(float value) const {
+    float cell = std::floor(value * m_inverseCellSize);
+    return static_cast<int32_t>(std::max(-1.0e9f, std::min(cell, 1.0e9f)));
+}
+
+uint64_t CullingGrid::packCell(int32_t cellX, int32_t cellY) const {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY);
+}
+
+bool CullingGrid::fitsCell(const glm::vec2& min, const glm::vec2& max) const {
+    // Half the extent may stick out at most half a cell past the center's cell
+    return max.x - min.x <= m_cellSize && max.y - min.y <= m_cellSize;
+}
+
+uint64_t CullingGrid::cellOf(const glm::vec2& min, const glm::vec2& max) const {
+    glm::vec2 center = (min + max) * 0.5f;
+    return packCell(toCell(center.x), toCell(center.y));
+}
+
+void CullingGrid::link(uint32_t handle) {
+    Item& item = m_items[handle];
+    item.oversized = !fitsCell(item.min, item.max);
+
+    std::vector<uint32_t>* list = &m_oversized;
+    if (!item.oversized) {
+        item.cell = cellOf(item.min, item.max);
+        list = &m_cells[item.cell];
+    }
+    item.slot = static_cast<uint32_t>(list->size());
+    list->push_back(handle);
+}
+
+void CullingGrid::unlink(uint32_t handle) {
+    Item& item = m_items[handle];
+
+    std::vector<uint32_t>* list = &m_oversized;
+    auto cell = m_cells.end();
+    if (!item.oversized) {
+        cell = m_cells.find(item.cell);
+        list = &cell->second;
+    }
+
+    // Swap-remove, fixing up the slot of the item moved into the gap
+    uint32_t last = list->back();
+    (*list)[item.slot] = last;
+    m_items[last].slot = item.slot;
+    list->pop_back();
+
+    if (cell != m_cells.end() && list->empty()) {
+        m_cells.erase(cell);
+    }
+}
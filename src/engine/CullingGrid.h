@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Loose uniform grid of 2D boxes for visibility queries
+ *
+ * Every item lives in the single cell holding its center, so inserting,
+ * moving or removing an item touches one cell. An item may reach half a
+ * cell past its own cell, which queries make up for by widening their
+ * range by the same amount. Items too large for that are kept in a
+ * separate list that every query tests directly.
+ *
+ * Moving an item within its cell only rewrites its stored bounds. Cells
+ * are kept in a hash map, so the grid is unbounded and empty space costs
+ * nothing. Items are referred to by the handles insert() returns; handles
+ * of removed items are reused.
+ */
+class CullingGrid {
+public:
+    explicit CullingGrid(float cellSize);
+
+    void setCellSize(float cellSize);   // Re-buckets every item
+    float getCellSize() const;
+
+    uint32_t insert(const glm::vec2& min, const glm::vec2& max);
+    void update(uint32_t handle, const glm::vec2& min, const glm::vec2& max);
+    void remove(uint32_t handle);
+    void clear();
+
+    size_t size() const;
+
+    // Appends the handles of all items whose bounds overlap [min, max]
+    void query(const glm::vec2& min, const glm::vec2& max, std::vector<uint32_t>& handles) const;
+
+private:
+    struct Item {
+        glm::vec2 min;
+        glm::vec2 max;
+        uint64_t cell;      // Packed cell coordinates
+        uint32_t slot;      // Position in the cell's (or oversized) list
+        bool oversized;
+        bool active;
+    };
+
+    float m_cellSize;
+    float m_inverseCellSize;
+    std::vector<Item> m_items;
+    std::vector<uint32_t> m_freeHandles;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+    std::vector<uint32_t> m_oversized;
+    size_t m_count;
+
+    // Helper methods
+    int32_t toCell(float value) const;
+    uint64_t packCell(int32_t cellX, int32_t cellY) const;
+    bool fitsCell(const glm::vec2& min, const glm::vec2& max) const;
+    uint64_t cellOf(const glm::vec2& min, const glm::vec2& max) const;
+    void link(uint32_t handle);
+    void unlink(uint32_t handle);
+};
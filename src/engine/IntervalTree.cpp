@@ -0,0 +1,113 @@
+#include "IntervalTree.h"
+#include <algorithm>
+
+namespace {
+
+// Subtrees of this level or lower are scanned instead of descended
+const int kScanLevel = 3;
+
+} // namespace
+
+IntervalTree::IntervalTree()
+    : m_maxLevel(-1) {
+}
+
+void IntervalTree::build(std::vector<Interval> intervals) {
+    m_intervals = std::move(intervals);
+    std::sort(m_intervals.begin(), m_intervals.end(),
+        [](const Interval& a, const Interval& b) {
+            return a.start < b.start;
+        });
+
+    size_t count = m_intervals.size();
+    m_maxEnds.resize(count);
+    m_maxLevel = -1;
+    if (count == 0) {
+        return;
+    }
+
+    // Leaves
+    size_t lastIndex = 0;
+    float lastEnd = 0.0f;
+    for (size_t i = 0; i < count; i += 2) {
+        lastIndex = i;
+        lastEnd = m_maxEnds[i] = m_intervals[i].end;
+    }
+
+    // Inner nodes, level by level. A right child past the end of the array
+    // stands for the incomplete subtree at the end, whose latest end is
+    // tracked in lastEnd.
+    int level = 1;
+    for (; (size_t(1) << level) <= count; ++level) {
+        size_t half = size_t(1) << (level - 1);
+        size_t first = (half << 1) - 1;
+        size_t step = half << 2;
+        for (size_t i = first; i < count; i += step) {
+            float leftEnd = m_maxEnds[i - half];
+            float rightEnd = i + half < count ? m_maxEnds[i + half] : lastEnd;
+            m_maxEnds[i] = std::max(m_intervals[i].end, std::max(leftEnd, rightEnd));
+        }
+
+        lastIndex = (lastIndex >> level & 1) ? lastIndex - half : lastIndex + half;
+        if (lastIndex < count) {
+            lastEnd = std::max(lastEnd, m_maxEnds[lastIndex]);
+        }
+    }
+    m_maxLevel = level - 1;
+}
+
+void IntervalTree::clear() {
+    m_intervals.clear();
+    m_maxEnds.clear();
+    m_maxLevel = -1;
+}
+
+size_t IntervalTree::size() const {
+    return m_intervals.size();
+}
+
+void IntervalTree::stab(float time, std::vector<uint32_t>& values) const {
+    if (m_maxLevel < 0) {
+        return;
+    }
+
+    struct Frame {
+        size_t node;
+        int level;
+        bool leftDone;
+    };
+
+    // One frame per level for the path, plus one pending right child each
+    Frame stack[130];
+    int top = 0;
+    stack[top++] = Frame{(size_t(1) << m_maxLevel) - 1, m_maxLevel, false};
+
+    size_t count = m_intervals.size();
+    while (top > 0) {
+        Frame frame = stack[--top];
+
+        if (frame.level <= kScanLevel) {
+            size_t begin = frame.node >> frame.level << frame.level;
+            size_t end = std::min(count, begin + (size_t(1) << (frame.level + 1)) - 1);
+            for (size_t i = begin; i < end && m_intervals[i].start <= time; ++i) {
+                if (time < m_intervals[i].end) {
+                    values.push_back(m_intervals[i].value);
+                }
+            }
+        } else if (!frame.leftDone) {
+            // Come back for the node itself and its right subtree once the
+            // left subtree is done, which is only worth visiting if it
+            // reaches past the time
+            size_t left = frame.node - (size_t(1) << (frame.level - 1));
+            stack[top++] = Frame{frame.node, frame.level, true};
+            if (left >= count || m_maxEnds[left] > time) {
+                stack[top++] = Frame{left, frame.level - 1, false};
+            }
+        } else if (frame.node < count && m_intervals[frame.node].start <= time) {
+            if (time < m_intervals[frame.node].end) {
+                values.push_back(m_intervals[frame.node].value);
+            }
+            stack[top++] = Frame{frame.node + (size_t(1) << (frame.level - 1)), frame.level - 1, false};
+        }
+    }
+}
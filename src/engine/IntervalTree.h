@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Static index of time intervals for stabbing queries
+ *
+ * Intervals are sorted by start and laid out as an implicit binary
+ * search tree over that array: leaves at even indices, and the nodes of
+ * level k at the indices whose lowest k bits are all set. Each node also
+ * stores the latest end in its subtree, which lets a query skip every
+ * subtree that ends before the time it asks about. Finding the k
+ * intervals that contain a time takes O(log n + k).
+ *
+ * The index is rebuilt as a whole by build(); there is no insert or
+ * remove, as the intervals it indexes rarely change.
+ */
+class IntervalTree {
+public:
+    struct Interval {
+        float start;
+        float end;
+        uint32_t value;
+    };
+
+    IntervalTree();
+
+    void build(std::vector<Interval> intervals);
+    void clear();
+
+    size_t size() const;
+
+    // Appends the values of all intervals with start <= time < end
+    void stab(float time, std::vector<uint32_t>& values) const;
+
+private:
+    std::vector<Interval> m_intervals;  // Sorted by start
+    std::vector<float> m_maxEnds;       // Latest end in each node's subtree
+    int m_maxLevel;                     // Level of the root, -1 when empty
+};
@@ -0,0 +1,17 @@
+#include "KeyframeTrack.h"
+
+float applyEasing(Easing easing, float progress) {
+    float t = std::max(0.0f, std::min(progress, 1.0f));
+    switch (easing) {
+        case Easing::EaseIn:
+            return t * t;
+        case Easing::EaseOut:
+            return t * (2.0f - t);
+        case Easing::EaseInOut:
+            return t * t * (3.0f - 2.0f * t);
+        case Easing::Step:
+            return t >= 1.0f ? 1.0f : 0.0f;
+        default:
+            return t;
+    }
+}
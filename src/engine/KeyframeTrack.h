@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Shape of the motion between two keyframes
+ */
+enum class Easing {
+    Linear,
+    EaseIn,         // Starts slow
+    EaseOut,        // Ends slow
+    EaseInOut,      // Starts and ends slow
+    Step            // Holds the previous value until the key
+};
+
+// Maps progress through a segment, 0..1, to interpolation weight, 0..1
+float applyEasing(Easing easing, float progress);
+
+/**
+ * @brief Keyframed value of one animated property
+ *
+ * Keys are kept sorted by time in parallel arrays of times, values and
+ * easings; a key's easing shapes the segment that ends at it. Before the
+ * first key and after the last the track holds their values.
+ *
+ * evaluate() finds the segment around a time by binary search. The last
+ * segment found is cached, so playback that moves forward through the
+ * track checks that segment and the next one and usually searches
+ * nothing. T needs + and -, and * by a float, e.g. float or glm vectors.
+ */
+template <typename T>
+class KeyframeTrack {
+public:
+    KeyframeTrack()
+        : m_cursor(0) {
+    }
+
+    // Adds a key, replacing one at the same time
+    void addKey(float time, const T& value, Easing easing = Easing::Linear) {
+        auto it = std::lower_bound(m_times.begin(), m_times.end(), time);
+        size_t index = static_cast<size_t>(it - m_times.begin());
+        if (it != m_times.end() && *it == time) {
+            m_values[index] = value;
+            m_easings[index] = easing;
+            return;
+        }
+        m_times.insert(it, time);
+        m_values.insert(m_values.begin() + index, value);
+        m_easings.insert(m_easings.begin() + index, easing);
+    }
+
+    // Drops the keys later than time
+    void removeKeysAfter(float time) {
+        size_t count = static_cast<size_t>(std::upper_bound(m_times.begin(), m_times.end(), time) - m_times.begin());
+        m_times.resize(count);
+        m_values.resize(count);
+        m_easings.resize(count);
+        m_cursor = 0;
+    }
+
+    void clear() {
+        m_times.clear();
+        m_values.clear();
+        m_easings.clear();
+        m_cursor = 0;
+    }
+
+    bool empty() const {
+        return m_times.empty();
+    }
+
+    size_t getKeyCount() const {
+        return m_times.size();
+    }
+
+    float getStartTime() const {
+        return m_times.empty() ? 0.0f : m_times.front();
+    }
+
+    float getEndTime() const {
+        return m_times.empty() ? 0.0f : m_times.back();
+    }
+
+    // Value at a time; the track must not be empty
+    T evaluate(float time) const {
+        if (time <= m_times.front()) return m_values.front();
+        if (time >= m_times.back()) return m_values.back();
+
+        size_t segment = findSegment(time);
+        float t0 = m_times[segment];
+        float t1 = m_times[segment + 1];
+        float weight = applyEasing(m_easings[segment + 1], (time - t0) / (t1 - t0));
+        return m_values[segment] + (m_values[segment + 1] - m_values[segment]) * weight;
+    }
+
+private:
+    std::vector<float> m_times;
+    std::vector<T> m_values;
+    std::vector<Easing> m_easings;
+    mutable size_t m_cursor;    // Segment found by the last evaluation
+
+    // Segment i with m_times[i] <= time < m_times[i + 1], for a time inside the track
+    size_t findSegment(float time) const {
+        size_t last = m_times.size() - 2;
+        for (size_t segment = m_cursor; segment <= std::min(m_cursor + 1, last); ++segment) {
+            if (m_times[segment] <= time && time < m_times[segment + 1]) {
+                m_cursor = segment;
+                return segment;
+            }
+        }
+
+        auto it = std::upper_bound(m_times.begin(), m_times.end(), time);
+        m_cursor = static_cast<size_t>(it - m_times.begin()) - 1;
+        return m_cursor;
+    }
+};
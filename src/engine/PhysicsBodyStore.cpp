@@ -0,0 +1,177 @@
+#include "PhysicsBodyStore.h"
+#include "../utils/Simd.h"
+#include <algorithm>
+
+namespace {
+
+// Every kernel computes, per movable body and axis:
+//   a' = a + g * gravityScale
+//   v' = (v + a' * dt) * damping
+//   p' = p + v' * dt
+//   a  = 0
+// and leaves other bodies untouched.
+
+void integrateAxisScalar(float* position, float* velocity, float* acceleration, size_t index,
+                         float gravity, float gravityScale, float deltaTime, float damping) {
+    float accel = acceleration[index] + gravity * gravityScale;
+    float vel = (velocity[index] + accel * deltaTime) * damping;
+    position[index] += vel * deltaTime;
+    velocity[index] = vel;
+    acceleration[index] = 0.0f;
+}
+
+#if defined(KALEM_SIMD_AVX2)
+
+void integrateAxisAvx2(float* position, float* velocity, float* acceleration, size_t index,
+                       __m256 gravity, __m256 gravityScale, __m256 mask, __m256 deltaTime, __m256 damping) {
+    __m256 accel = _mm256_loadu_ps(acceleration + index);
+    __m256 vel = _mm256_loadu_ps(velocity + index);
+    __m256 pos = _mm256_loadu_ps(position + index);
+
+    __m256 newAccel = _mm256_add_ps(accel, _mm256_mul_ps(gravity, gravityScale));
+    __m256 newVel = _mm256_mul_ps(_mm256_add_ps(vel, _mm256_mul_ps(newAccel, deltaTime)), damping);
+    __m256 newPos = _mm256_add_ps(pos, _mm256_mul_ps(newVel, deltaTime));
+
+    _mm256_storeu_ps(position + index, _mm256_blendv_ps(pos, newPos, mask));
+    _mm256_storeu_ps(velocity + index, _mm256_blendv_ps(vel, newVel, mask));
+    _mm256_storeu_ps(acceleration + index, _mm256_blendv_ps(accel, _mm256_setzero_ps(), mask));
+}
+
+#elif defined(KALEM_SIMD_SSE2)
+
+__m128 select(__m128 mask, __m128 ifSet, __m128 ifClear) {
+    return _mm_or_ps(_mm_and_ps(mask, ifSet), _mm_andnot_ps(mask, ifClear));
+}
+
+void integrateAxisSse2(float* position, float* velocity, float* acceleration, size_t index,
+                       __m128 gravity, __m128 gravityScale, __m128 mask, __m128 deltaTime, __m128 damping) {
+    __m128 accel = _mm_loadu_ps(acceleration + index);
+    __m128 vel = _mm_loadu_ps(velocity + index);
+    __m128 pos = _mm_loadu_ps(position + index);
+
+    __m128 newAccel = _mm_add_ps(accel, _mm_mul_ps(gravity, gravityScale));
+    __m128 newVel = _mm_mul_ps(_mm_add_ps(vel, _mm_mul_ps(newAccel, deltaTime)), damping);
+    __m128 newPos = _mm_add_ps(pos, _mm_mul_ps(newVel, deltaTime));
+
+    _mm_storeu_ps(position + index, select(mask, newPos, pos));
+    _mm_storeu_ps(velocity + index, select(mask, newVel, vel));
+    _mm_storeu_ps(acceleration + index, _mm_andnot_ps(mask, accel));
+}
+
+#endif
+
+} // namespace
+
+void PhysicsBodyStore::resize(size_t count) {
+    for (auto* array : {&positionX, &positionY, &positionZ,
+                        &velocityX, &velocityY, &velocityZ,
+                        &accelerationX, &accelerationY, &accelerationZ,
+                        &previousX, &previousY, &previousZ,
+                        &inverseMass, &bounce, &radius, &gravityScale, &movable}) {
+        array->resize(count, 0.0f);
+    }
+    flags.resize(count, 0);
+    shape.resize(count, Shape::Circle);
+    segmentStart.resize(count, glm::vec2(0.0f));
+    segmentEnd.resize(count, glm::vec2(0.0f));
+    restingSteps.resize(count, 0);
+    boundsMinOffset.resize(count, glm::vec2(0.0f));
+    boundsMaxOffset.resize(count, glm::vec2(0.0f));
+}
+
+size_t PhysicsBodyStore::size() const {
+    return flags.size();
+}
+
+glm::vec3 PhysicsBodyStore::getPosition(size_t index) const {
+    return glm::vec3(positionX[index], positionY[index], positionZ[index]);
+}
+
+void PhysicsBodyStore::setPosition(size_t index, const glm::vec3& position) {
+    positionX[index] = position.x;
+    positionY[index] = position.y;
+    positionZ[index] = position.z;
+}
+
+glm::vec3 PhysicsBodyStore::getVelocity(size_t index) const {
+    return glm::vec3(velocityX[index], velocityY[index], velocityZ[index]);
+}
+
+void PhysicsBodyStore::setVelocity(size_t index, const glm::vec3& velocity) {
+    velocityX[index] = velocity.x;
+    velocityY[index] = velocity.y;
+    velocityZ[index] = velocity.z;
+}
+
+glm::vec3 PhysicsBodyStore::getAcceleration(size_t index) const {
+    return glm::vec3(accelerationX[index], accelerationY[index], accelerationZ[index]);
+}
+
+glm::vec3 PhysicsBodyStore::getPreviousPosition(size_t index) const {
+    return glm::vec3(previousX[index], previousY[index], previousZ[index]);
+}
+
+void PhysicsBodyStore::setPreviousPosition(size_t index, const glm::vec3& position) {
+    previousX[index] = position.x;
+    previousY[index] = position.y;
+    previousZ[index] = position.z;
+}
+
+void PhysicsBodyStore::savePreviousPositions() {
+    std::copy(positionX.begin(), positionX.end(), previousX.begin());
+    std::copy(positionY.begin(), positionY.end(), previousY.begin());
+    std::copy(positionZ.begin(), positionZ.end(), previousZ.begin());
+}
+
+void PhysicsBodyStore::integrate(const glm::vec3& gravity, float airResistance, float deltaTime) {
+    integrate(gravity, airResistance, deltaTime, 0, size());
+}
+
+void PhysicsBodyStore::integrate(const glm::vec3& gravity, float airResistance, float deltaTime, size_t begin, size_t end) {
+    const float damping = 1.0f - airResistance * deltaTime;
+    const size_t count = std::min(end, size());
+    size_t i = begin;
+
+#if defined(KALEM_SIMD_AVX2)
+    const __m256 gravityX8 = _mm256_set1_ps(gravity.x);
+    const __m256 gravityY8 = _mm256_set1_ps(gravity.y);
+    const __m256 gravityZ8 = _mm256_set1_ps(gravity.z);
+    const __m256 deltaTime8 = _mm256_set1_ps(deltaTime);
+    const __m256 damping8 = _mm256_set1_ps(damping);
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 mask = _mm256_cmp_ps(_mm256_loadu_ps(&movable[i]), _mm256_setzero_ps(), _CMP_NEQ_OQ);
+        if (_mm256_movemask_ps(mask) == 0) continue;
+
+        __m256 scale = _mm256_loadu_ps(&gravityScale[i]);
+        integrateAxisAvx2(positionX.data(), velocityX.data(), accelerationX.data(), i, gravityX8, scale, mask, deltaTime8, damping8);
+        integrateAxisAvx2(positionY.data(), velocityY.data(), accelerationY.data(), i, gravityY8, scale, mask, deltaTime8, damping8);
+        integrateAxisAvx2(positionZ.data(), velocityZ.data(), accelerationZ.data(), i, gravityZ8, scale, mask, deltaTime8, damping8);
+    }
+#elif defined(KALEM_SIMD_SSE2)
+    const __m128 gravityX4 = _mm_set1_ps(gravity.x);
+    const __m128 gravityY4 = _mm_set1_ps(gravity.y);
+    const __m128 gravityZ4 = _mm_set1_ps(gravity.z);
+    const __m128 deltaTime4 = _mm_set1_ps(deltaTime);
+    const __m128 damping4 = _mm_set1_ps(damping);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 mask = _mm_cmpneq_ps(_mm_loadu_ps(&movable[i]), _mm_setzero_ps());
+        if (_mm_movemask_ps(mask) == 0) continue;
+
+        __m128 scale = _mm_loadu_ps(&gravityScale[i]);
+        integrateAxisSse2(positionX.data(), velocityX.data(), accelerationX.data(), i, gravityX4, scale, mask, deltaTime4, damping4);
+        integrateAxisSse2(positionY.data(), velocityY.data(), accelerationY.data(), i, gravityY4, scale, mask, deltaTime4, damping4);
+        integrateAxisSse2(positionZ.data(), velocityZ.data(), accelerationZ.data(), i, gravityZ4, scale, mask, deltaTime4, damping4);
+    }
+#endif
+
+    // Remaining bodies, or all of them without SIMD support
+    for (; i < count; ++i) {
+        if (movable[i] == 0.0f) continue;
+
+        integrateAxisScalar(positionX.data(), velocityX.data(), accelerationX.data(), i, gravity.x, gravityScale[i], deltaTime, damping);
+        integrateAxisScalar(positionY.data(), velocityY.data(), accelerationY.data(), i, gravity.y, gravityScale[i], deltaTime, damping);
+        integrateAxisScalar(positionZ.data(), velocityZ.data(), accelerationZ.data(), i, gravity.z, gravityScale[i], deltaTime, damping);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Structure-of-arrays copy of every physics body's state
+ *
+ * PhysicsEngine fills the store from its objects once per frame, runs all
+ * substeps on these arrays and writes the results back once at the end.
+ * Each array is indexed like PhysicsEngine's object list. Sleep state and
+ * previous positions are the only parts that carry over between frames.
+ *
+ * Bodies are circles of the given radius, except Line objects, which are
+ * segments with a radius of half their thickness.
+ */
+struct PhysicsBodyStore {
+    enum Flags : uint8_t {
+        Active = 1 << 0,    // Slot holds an object
+        Static = 1 << 1,
+        Sleeping = 1 << 2,  // Resting body, skipped until something wakes it
+        Fast = 1 << 3,      // Always swept by continuous collision detection
+        Swept = 1 << 4,     // Swept in the current step; set by the engine
+        Moved = 1 << 5      // Moved from outside the engine since the last update
+    };
+
+    enum class Shape : uint8_t {
+        Circle,     // radius around the position
+        Segment     // segmentStart to segmentEnd, relative to the position
+    };
+
+    // State
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> velocityX, velocityY, velocityZ;
+    std::vector<float> accelerationX, accelerationY, accelerationZ;
+    std::vector<float> previousX, previousY, previousZ;     // Position before the last step
+
+    // Properties
+    std::vector<float> inverseMass;
+    std::vector<float> bounce;
+    std::vector<float> radius;          // Circle radius, or segment half-thickness
+    std::vector<float> gravityScale;    // 1 when gravity applies, else 0
+    std::vector<float> movable;         // 1 for active, awake, non-static bodies, else 0
+    std::vector<uint8_t> flags;
+    std::vector<Shape> shape;
+    std::vector<glm::vec2> segmentStart;
+    std::vector<glm::vec2> segmentEnd;
+    std::vector<uint16_t> restingSteps; // Consecutive steps below the sleep speed
+
+    // Object bounds relative to the position, for broadphase proxies
+    std::vector<glm::vec2> boundsMinOffset;
+    std::vector<glm::vec2> boundsMaxOffset;
+
+    void resize(size_t count);
+    size_t size() const;
+
+    glm::vec3 getPosition(size_t index) const;
+    void setPosition(size_t index, const glm::vec3& position);
+    glm::vec3 getVelocity(size_t index) const;
+    void setVelocity(size_t index, const glm::vec3& velocity);
+    glm::vec3 getAcceleration(size_t index) const;
+    glm::vec3 getPreviousPosition(size_t index) const;
+    void setPreviousPosition(size_t index, const glm::vec3& position);
+    void savePreviousPositions();
+
+    /**
+     * @brief Semi-implicit Euler step with air resistance for all movable bodies
+     *
+     * Adds gravity to the accumulated acceleration, integrates velocity and
+     * then position, and clears the acceleration, one SIMD register of
+     * bodies at a time (see utils/Simd.h). Every body is integrated
+     * independently, so disjoint [begin, end) ranges can run on different
+     * threads.
+     */
+    void integrate(const glm::vec3& gravity, float airResistance, float deltaTime);
+    void integrate(const glm::vec3& gravity, float airResistance, float deltaTime, size_t begin, size_t end);
+};
@@ -1,16 +1,108 @@
 #include "PhysicsEngine.h"
 #include "../objects/AnimationObject.h"
+#include "../objects/Shape.h"
+#include "../utils/JobSystem.h"
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <iostream>
 
+namespace {
+
+// Work sizes below which a stage is not worth splitting across threads
+const size_t kIntegrateGrain = 8192;
+const size_t kConstraintGrain = 4096;
+const size_t kMinParallelPairs = 256;
+
+// Fraction of the step a swept body stops short of its time of impact,
+// so it rests just outside the contact instead of on it
+const float kTimeOfImpactSlop = 1e-3f;
+
+const float kNoImpact = std::numeric_limits<float>::max();
+
+// Earliest t in [0, 1] at which start + motion * t comes within radius of
+// the origin, or kNoImpact. Starting inside does not count as an impact.
+float sweepSphere(const glm::vec3& start, const glm::vec3& motion, float radius) {
+    float a = glm::dot(motion, motion);
+    float b = glm::dot(start, motion);
+    float c = glm::dot(start, start) - radius * radius;
+    if (c <= 0.0f || b >= 0.0f || a <= 0.0f) return kNoImpact;
+    
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) return kNoImpact;
+    
+    float t = (-b - std::sqrt(discriminant)) / a;
+    return t <= 1.0f ? std::max(0.0f, t) : kNoImpact;
+}
+
+// Closest point to p on the segment from a to b
+glm::vec2 closestPointOnSegment(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b) {
+    glm::vec2 ab = b - a;
+    float lengthSquared = glm::dot(ab, ab);
+    if (lengthSquared <= 0.0f) return a;
+    
+    float t = glm::clamp(glm::dot(p - a, ab) / lengthSquared, 0.0f, 1.0f);
+    return a + ab * t;
+}
+
+// Earliest t in [0, 1] at which a circle moving from start by motion
+// touches the segment from a to b, both radii already summed
+float sweepCircleSegment(const glm::vec2& start, const glm::vec2& motion, const glm::vec2& a, const glm::vec2& b, float radius) {
+    glm::vec2 closest = closestPointOnSegment(start, a, b);
+    if (glm::dot(start - closest, start - closest) <= radius * radius) return kNoImpact;
+    
+    float earliest = kNoImpact;
+    
+    // Flat sides: the signed distance to the line crosses the radius
+    glm::vec2 ab = b - a;
+    float length = glm::length(ab);
+    if (length > 0.0f) {
+        glm::vec2 normal(-ab.y / length, ab.x / length);
+        float distance0 = glm::dot(start - a, normal);
+        float distance1 = glm::dot(start + motion - a, normal);
+        float side = distance0 > 0.0f ? radius : -radius;
+        
+        if (std::abs(distance0) > radius && (distance1 - side) * (distance0 - side) <= 0.0f) {
+            float t = (distance0 - side) / (distance0 - distance1);
+            float along = glm::dot(start + motion * t - a, ab) / length;
+            if (along >= 0.0f && along <= length) {
+                earliest = t;
+            }
+        }
+    }
+    
+    // Rounded ends
+    for (const glm::vec2& end : {a, b}) {
+        glm::vec2 offset = start - end;
+        earliest = std::min(earliest, sweepSphere(glm::vec3(offset, 0.0f), glm::vec3(motion, 0.0f), radius));
+    }
+    return earliest;
+}
+
+} // namespace
+
 PhysicsEngine::PhysicsEngine()
     : m_enabled(false)
     , m_collisionDetectionEnabled(true)
+    , m_continuousCollisionEnabled(true)
     , m_gravity(0.0f, -9.81f, 0.0f)
     , m_airResistance(0.1f)
     , m_timeStep(1.0f / 60.0f)
+    , m_maxSubsteps(8)
+    , m_accumulator(0.0)
+    , m_sleepingEnabled(true)
+    , m_sleepThreshold(0.25f)
+    , m_sleepSteps(30)
+    , m_awakeBodyCount(0)
+    , m_sleepingBodyCount(0)
+    , m_movedBodyCount(0)
+    , m_broadphase(std::make_unique<SpatialHashBroadphase>())
+    , m_sweptBodyCount(0)
+    , m_bodySetVersion(0)
+    , m_threadCount(1)
     , m_groundConstraintEnabled(false)
     , m_groundY(0.0f) {
+    setThreadCount(0);
 }
 
 PhysicsEngine::~PhysicsEngine() {
@@ -26,6 +118,9 @@ bool PhysicsEngine::isEnabled() const {
 }
 
 void PhysicsEngine::setGravity(const glm::vec3& gravity) {
+    if (gravity != m_gravity) {
+        wakeAllBodies();
+    }
     m_gravity = gravity;
 }
 
@@ -34,7 +129,11 @@ glm::vec3 PhysicsEngine::getGravity() const {
 }
 
 void PhysicsEngine::setAirResistance(float resistance) {
-    m_airResistance = std::max(0.0f, std::min(1.0f, resistance));
+    resistance = std::max(0.0f, std::min(1.0f, resistance));
+    if (resistance != m_airResistance) {
+        wakeAllBodies();
+    }
+    m_airResistance = resistance;
 }
 
 float PhysicsEngine::getAirResistance() const {
@@ -49,9 +148,150 @@ float PhysicsEngine::getTimeStep() const {
     return m_timeStep;
 }
 
+void PhysicsEngine::setMaxSubsteps(int maxSubsteps) {
+    m_maxSubsteps = std::max(1, maxSubsteps);
+}
+
+int PhysicsEngine::getMaxSubsteps() const {
+    return m_maxSubsteps;
+}
+
+float PhysicsEngine::getInterpolationAlpha() const {
+    return static_cast<float>(std::max(0.0, std::min(1.0, m_accumulator / m_timeStep)));
+}
+
+void PhysicsEngine::resetAccumulator() {
+    m_accumulator = 0.0;
+}
+
+void PhysicsEngine::setThreadCount(size_t threadCount) {
+    // The calling thread takes part in every parallel stage, so it counts as one
+    size_t available = JobSystem::instance().getThreadCount();
+    m_threadCount = threadCount == 0 ? available : std::min(threadCount, available);
+}
+
+size_t PhysicsEngine::getThreadCount() const {
+    return m_threadCount;
+}
+
+void PhysicsEngine::setSleepingEnabled(bool enabled) {
+    m_sleepingEnabled = enabled;
+}
+
+bool PhysicsEngine::isSleepingEnabled() const {
+    return m_sleepingEnabled;
+}
+
+void PhysicsEngine::setSleepThreshold(float speed) {
+    m_sleepThreshold = std::max(0.0f, speed);
+}
+
+float PhysicsEngine::getSleepThreshold() const {
+    return m_sleepThreshold;
+}
+
+void PhysicsEngine::setSleepSteps(int steps) {
+    m_sleepSteps = std::max(1, std::min(65535, steps));
+}
+
+int PhysicsEngine::getSleepSteps() const {
+    return m_sleepSteps;
+}
+
+size_t PhysicsEngine::getAwakeBodyCount() const {
+    return m_awakeBodyCount;
+}
+
+size_t PhysicsEngine::getSleepingBodyCount() const {
+    return m_sleepingBodyCount;
+}
+
+void PhysicsEngine::saveState(State& state) const {
+    // Sleep state only lives in the store, which is stale after a removal
+    bool haveBodies = m_bodies.size() == m_physicsObjects.size();
+    
+    state.bodySet = m_bodySetVersion;
+    state.accumulator = m_accumulator;
+    state.bodies.resize(m_physicsObjects.size());
+    for (size_t i = 0; i < m_physicsObjects.size(); ++i) {
+        const AnimationObject* obj = m_physicsObjects[i].get();
+        if (!obj) continue;
+        
+        BodyState& body = state.bodies[i];
+        body.position = obj->getPosition();
+        body.previousPosition = obj->getPreviousPosition();
+        body.velocity = obj->getVelocity();
+        body.acceleration = obj->getAcceleration();
+        body.restingSteps = haveBodies ? m_bodies.restingSteps[i] : 0;
+        body.sleeping = haveBodies && (m_bodies.flags[i] & PhysicsBodyStore::Sleeping) != 0;
+    }
+}
+
+bool PhysicsEngine::restoreState(const State& state) {
+    if (state.bodySet != m_bodySetVersion || state.bodies.size() != m_physicsObjects.size()) {
+        return false;
+    }
+    
+    m_accumulator = state.accumulator;
+    
+    // Fill the store as well, so the next sync sees undisturbed bodies and
+    // keeps their sleep state
+    m_bodies.resize(m_physicsObjects.size());
+    for (size_t i = 0; i < m_physicsObjects.size(); ++i) {
+        AnimationObject* obj = m_physicsObjects[i].get();
+        if (!obj) continue;
+        
+        const BodyState& body = state.bodies[i];
+        obj->setPosition(body.position);
+        obj->setPreviousPosition(body.previousPosition);
+        obj->setVelocity(body.velocity);
+        obj->setAcceleration(body.acceleration);
+        
+        m_bodies.setPosition(i, body.position);
+        m_bodies.setPreviousPosition(i, body.previousPosition);
+        m_bodies.setVelocity(i, body.velocity);
+        m_bodies.restingSteps[i] = body.restingSteps;
+        m_bodies.flags[i] = body.sleeping ? PhysicsBodyStore::Sleeping : 0;
+    }
+    return true;
+}
+
+uint64_t PhysicsEngine::getBodySetVersion() const {
+    return m_bodySetVersion;
+}
+
+void PhysicsEngine::markBodies() {
+    m_markedState.resize(m_physicsObjects.size() * 3);
+    for (size_t i = 0; i < m_physicsObjects.size(); ++i) {
+        const AnimationObject* obj = m_physicsObjects[i].get();
+        if (!obj) continue;
+        
+        m_markedState[3 * i] = obj->getPosition();
+        m_markedState[3 * i + 1] = obj->getVelocity();
+        m_markedState[3 * i + 2] = obj->getAcceleration();
+    }
+}
+
+bool PhysicsEngine::bodiesChangedSinceMark() const {
+    if (m_markedState.size() != m_physicsObjects.size() * 3) return true;
+    
+    for (size_t i = 0; i < m_physicsObjects.size(); ++i) {
+        const AnimationObject* obj = m_physicsObjects[i].get();
+        if (!obj) continue;
+        
+        if (obj->getPosition() != m_markedState[3 * i] ||
+            obj->getVelocity() != m_markedState[3 * i + 1] ||
+            obj->getAcceleration() != m_markedState[3 * i + 2]) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void PhysicsEngine::addObject(std::shared_ptr<AnimationObject> obj) {
     if (obj) {
         m_physicsObjects.push_back(obj);
+        ++m_bodySetVersion;
     }
 }
 
@@ -61,48 +301,55 @@ void PhysicsEngine::removeObject(std::shared_ptr<AnimationObject> obj) {
             std::remove(m_physicsObjects.begin(), m_physicsObjects.end(), obj),
             m_physicsObjects.end()
         );
+        
+        // Indices have shifted and the removed body may have been holding
+        // others up, so everything starts awake again
+        m_bodies.resize(0);
+        ++m_bodySetVersion;
     }
 }
 
 void PhysicsEngine::clearObjects() {
     m_physicsObjects.clear();
+    m_bodies.resize(0);
+    ++m_bodySetVersion;
 }
 
 void PhysicsEngine::update(float deltaTime) {
     if (!m_enabled) return;
     
-    // Use fixed time step for physics
-    float remainingTime = deltaTime;
-    while (remainingTime >= m_timeStep) {
-        step(m_timeStep);
-        remainingTime -= m_timeStep;
-    }
+    // Whole steps are counted with a small tolerance so frame times like
+    // 1/24 s land on step boundaries despite rounding. The accumulator may
+    // then dip just below zero, which keeps the total time exact.
+    m_accumulator += deltaTime;
+    int steps = static_cast<int>(std::floor(m_accumulator / m_timeStep + 1e-4));
+    if (steps <= 0) return;
     
-    // Handle remaining time
-    if (remainingTime > 0.0f) {
-        step(remainingTime);
-    }
-}
-
-void PhysicsEngine::step(float deltaTime) {
-    // Update physics for all objects
-    for (auto& obj : m_physicsObjects) {
-        if (obj && !obj->isStatic()) {
-            updateObjectPhysics(obj, deltaTime);
-        }
+    if (steps > m_maxSubsteps) {
+        m_accumulator = std::fmod(m_accumulator, static_cast<double>(m_timeStep)) + m_maxSubsteps * static_cast<double>(m_timeStep);
+        steps = m_maxSubsteps;
     }
+    m_accumulator -= steps * static_cast<double>(m_timeStep);
     
-    // Handle collisions
-    if (m_collisionDetectionEnabled) {
-        updateCollisions();
+    syncFromObjects();
+    
+    // A fully settled scene has nothing to simulate unless something was
+    // moved into it from outside
+    if (m_awakeBodyCount == 0 && m_sleepingBodyCount > 0 && m_movedBodyCount == 0) {
+        return;
     }
     
-    // Apply constraints
-    for (auto& obj : m_physicsObjects) {
-        if (obj) {
-            applyConstraints(obj);
-        }
+    for (int i = 0; i < steps; ++i) {
+        stepBodies(m_timeStep);
     }
+    
+    syncToObjects();
+}
+
+void PhysicsEngine::step(float deltaTime) {
+    syncFromObjects();
+    stepBodies(deltaTime);
+    syncToObjects();
 }
 
 void PhysicsEngine::enableCollisionDetection(bool enable) {
@@ -113,20 +360,44 @@ bool PhysicsEngine::isCollisionDetectionEnabled() const {
     return m_collisionDetectionEnabled;
 }
 
-void PhysicsEngine::updateCollisions() {
-    // Simple collision detection between all objects
-    for (size_t i = 0; i < m_physicsObjects.size(); ++i) {
-        for (size_t j = i + 1; j < m_physicsObjects.size(); ++j) {
-            auto obj1 = m_physicsObjects[i];
-            auto obj2 = m_physicsObjects[j];
-            
-            if (obj1 && obj2 && checkCollision(obj1, obj2)) {
-                resolveCollision(obj1, obj2);
-            }
-        }
+void PhysicsEngine::enableContinuousCollision(bool enable) {
+    m_continuousCollisionEnabled = enable;
+}
+
+bool PhysicsEngine::isContinuousCollisionEnabled() const {
+    return m_continuousCollisionEnabled;
+}
+
+void PhysicsEngine::setBroadphase(BroadphaseType type) {
+    if (m_broadphase && m_broadphase->getType() == type) return;
+    
+    switch (type) {
+        case BroadphaseType::AllPairs:
+            m_broadphase = std::make_unique<AllPairsBroadphase>();
+            break;
+        case BroadphaseType::SpatialHash:
+            m_broadphase = std::make_unique<SpatialHashBroadphase>();
+            break;
+        case BroadphaseType::SweepAndPrune:
+            m_broadphase = std::make_unique<SweepAndPruneBroadphase>();
+            break;
     }
 }
 
+BroadphaseType PhysicsEngine::getBroadphaseType() const {
+    return m_broadphase->getType();
+}
+
+Broadphase* PhysicsEngine::getBroadphase() {
+    return m_broadphase.get();
+}
+
+void PhysicsEngine::updateCollisions() {
+    syncFromObjects();
+    collideBodies();
+    syncToObjects();
+}
+
 void PhysicsEngine::resolveCollisions() {
     // This is handled in updateCollisions()
 }
@@ -192,46 +463,434 @@ std::vector<std::shared_ptr<AnimationObject>> PhysicsEngine::getObjectsInBox(con
     return result;
 }
 
-void PhysicsEngine::updateObjectPhysics(std::shared_ptr<AnimationObject> obj, float deltaTime) {
-    if (!obj || obj->isStatic()) return;
+void PhysicsEngine::syncFromObjects() {
+    m_bodies.resize(m_physicsObjects.size());
+    m_movedBodyCount = 0;
     
-    // Apply gravity
-    if (obj->isGravityAffected()) {
-        glm::vec3 currentAccel = obj->getAcceleration();
-        obj->setAcceleration(currentAccel + m_gravity);
+    for (size_t i = 0; i < m_physicsObjects.size(); ++i) {
+        const AnimationObject* obj = m_physicsObjects[i].get();
+        if (!obj) {
+            m_bodies.flags[i] = 0;
+            m_bodies.movable[i] = 0.0f;
+            continue;
+        }
+        
+        glm::vec3 pos = obj->getPosition();
+        glm::vec3 vel = obj->getVelocity();
+        glm::vec3 accel = obj->getAcceleration();
+        
+        // The store still holds what was written back last frame, so any
+        // difference means the object was moved or pushed from outside
+        bool moved = pos != m_bodies.getPosition(i);
+        bool disturbed = moved || vel != m_bodies.getVelocity(i) || accel != glm::vec3(0.0f);
+        bool sleeping = (m_bodies.flags[i] & PhysicsBodyStore::Sleeping) != 0 && m_sleepingEnabled &&
+                        !obj->isStatic() && !disturbed;
+        if (disturbed) {
+            m_bodies.restingSteps[i] = 0;
+            m_bodies.setPreviousPosition(i, pos);
+        }
+        if (moved) {
+            ++m_movedBodyCount;
+        }
+        
+        m_bodies.setPosition(i, pos);
+        m_bodies.setVelocity(i, vel);
+        m_bodies.accelerationX[i] = accel.x;
+        m_bodies.accelerationY[i] = accel.y;
+        m_bodies.accelerationZ[i] = accel.z;
+        
+        m_bodies.inverseMass[i] = 1.0f / obj->getMass();
+        m_bodies.bounce[i] = obj->getBounce();
+        
+        // Lines collide as segments; everything else as a circle
+        const Line* line = dynamic_cast<const Line*>(obj);
+        if (line) {
+            m_bodies.shape[i] = PhysicsBodyStore::Shape::Segment;
+            m_bodies.segmentStart[i] = line->getStartPoint() - glm::vec2(pos);
+            m_bodies.segmentEnd[i] = line->getEndPoint() - glm::vec2(pos);
+            m_bodies.radius[i] = line->getThickness() * 0.5f;
+        } else {
+            m_bodies.shape[i] = PhysicsBodyStore::Shape::Circle;
+            m_bodies.radius[i] = obj->getScale().x;  // Assuming uniform scale
+        }
+        m_bodies.gravityScale[i] = obj->isGravityAffected() ? 1.0f : 0.0f;
+        m_bodies.movable[i] = (obj->isStatic() || sleeping) ? 0.0f : 1.0f;
+        m_bodies.flags[i] = PhysicsBodyStore::Active |
+                            (obj->isStatic() ? PhysicsBodyStore::Static : 0) |
+                            (sleeping ? PhysicsBodyStore::Sleeping : 0) |
+                            (moved ? PhysicsBodyStore::Moved : 0) |
+                            (obj->isFastMoving() ? PhysicsBodyStore::Fast : 0);
+        
+        m_bodies.boundsMinOffset[i] = glm::vec2(obj->getMinBounds() - pos);
+        m_bodies.boundsMaxOffset[i] = glm::vec2(obj->getMaxBounds() - pos);
     }
     
-    // Update velocity
-    glm::vec3 currentVel = obj->getVelocity();
-    glm::vec3 currentAccel = obj->getAcceleration();
-    glm::vec3 newVel = currentVel + currentAccel * deltaTime;
+    countBodies();
+}
+
+void PhysicsEngine::syncToObjects() {
+    // Setters only run for values that changed, so each moved object fires
+    // PositionChanged once per frame
+    for (size_t i = 0; i < m_physicsObjects.size(); ++i) {
+        AnimationObject* obj = m_physicsObjects[i].get();
+        if (!obj) continue;
+        
+        glm::vec3 pos = m_bodies.getPosition(i);
+        if (pos != obj->getPosition()) {
+            obj->setPosition(pos);
+        }
+        
+        // setPosition() snaps the previous position, so restore it afterwards
+        if (!(m_bodies.flags[i] & PhysicsBodyStore::Static)) {
+            obj->setPreviousPosition(m_bodies.getPreviousPosition(i));
+        }
+        
+        glm::vec3 vel = m_bodies.getVelocity(i);
+        if (vel != obj->getVelocity()) {
+            obj->setVelocity(vel);
+        }
+        
+        glm::vec3 accel = m_bodies.getAcceleration(i);
+        if (!(m_bodies.flags[i] & PhysicsBodyStore::Static) && accel != obj->getAcceleration()) {
+            obj->setAcceleration(accel);
+        }
+    }
+    
+    countBodies();
+}
+
+void PhysicsEngine::countBodies() {
+    m_awakeBodyCount = 0;
+    m_sleepingBodyCount = 0;
+    for (size_t i = 0; i < m_bodies.size(); ++i) {
+        uint8_t flags = m_bodies.flags[i];
+        if (!(flags & PhysicsBodyStore::Active) || (flags & PhysicsBodyStore::Static)) continue;
+        
+        if (flags & PhysicsBodyStore::Sleeping) {
+            ++m_sleepingBodyCount;
+        } else {
+            ++m_awakeBodyCount;
+        }
+    }
+}
+
+void PhysicsEngine::stepBodies(float deltaTime) {
+    m_bodies.savePreviousPositions();
+    
+    // Integrate every movable body; accelerations are cleared after the
+    // step, so forces only act on the step that follows them
+    parallelFor(m_bodies.size(), kIntegrateGrain, [this, deltaTime](size_t begin, size_t end) {
+        m_bodies.integrate(m_gravity, m_airResistance, deltaTime, begin, end);
+    });
+    
+    // Handle collisions
+    if (m_collisionDetectionEnabled) {
+        collideBodies();
+    }
+    
+    // Apply constraints; each body is clamped independently
+    if (m_groundConstraintEnabled || !m_wallConstraints.empty()) {
+        parallelFor(m_bodies.size(), kConstraintGrain, [this](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                uint8_t flags = m_bodies.flags[i];
+                if ((flags & PhysicsBodyStore::Active) && !(flags & PhysicsBodyStore::Sleeping)) {
+                    applyConstraints(i);
+                }
+            }
+        });
+    }
+    
+    if (m_sleepingEnabled) {
+        updateSleep();
+    }
+    
+    // Outside moves only wake sleepers in the first step after them
+    if (m_movedBodyCount > 0) {
+        for (uint8_t& flags : m_bodies.flags) {
+            flags &= ~PhysicsBodyStore::Moved;
+        }
+        m_movedBodyCount = 0;
+    }
+}
+
+void PhysicsEngine::updateSleep() {
+    const float thresholdSquared = m_sleepThreshold * m_sleepThreshold;
+    const uint16_t sleepSteps = static_cast<uint16_t>(m_sleepSteps);
     
-    // Apply air resistance
-    newVel *= (1.0f - m_airResistance * deltaTime);
+    parallelFor(m_bodies.size(), kConstraintGrain, [this, thresholdSquared, sleepSteps](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (m_bodies.movable[i] == 0.0f) continue;
+            
+            glm::vec3 vel = m_bodies.getVelocity(i);
+            if (glm::dot(vel, vel) >= thresholdSquared) {
+                m_bodies.restingSteps[i] = 0;
+                continue;
+            }
+            
+            if (++m_bodies.restingSteps[i] >= sleepSteps) {
+                m_bodies.flags[i] |= PhysicsBodyStore::Sleeping;
+                m_bodies.movable[i] = 0.0f;
+                m_bodies.setVelocity(i, glm::vec3(0.0f));
+            }
+        }
+    });
+}
+
+void PhysicsEngine::wakeTouchedBodies() {
+    const float thresholdSquared = m_sleepThreshold * m_sleepThreshold;
     
-    obj->setVelocity(newVel);
+    // A body wakes the sleepers it touches when it moves at least the sleep
+    // speed or was moved from outside, which includes static and kinematic
+    // bodies. Slower awake bodies don't, otherwise a body resting on a
+    // sleeping pile would keep the whole pile awake.
+    auto wakes = [this, thresholdSquared](uint32_t body) {
+        uint8_t flags = m_bodies.flags[body];
+        if (flags & PhysicsBodyStore::Sleeping) return false;
+        if (flags & PhysicsBodyStore::Moved) return true;
+        if (m_bodies.movable[body] == 0.0f) return false;
+        glm::vec3 vel = m_bodies.getVelocity(body);
+        return glm::dot(vel, vel) >= thresholdSquared;
+    };
     
-    // Update position
-    glm::vec3 currentPos = obj->getPosition();
-    glm::vec3 newPos = currentPos + newVel * deltaTime;
-    obj->setPosition(newPos);
+    for (const auto& pair : m_candidatePairs) {
+        uint32_t sleeper;
+        uint32_t mover;
+        if ((m_bodies.flags[pair.first] & PhysicsBodyStore::Sleeping) && wakes(pair.second)) {
+            sleeper = pair.first;
+            mover = pair.second;
+        } else if ((m_bodies.flags[pair.second] & PhysicsBodyStore::Sleeping) && wakes(pair.first)) {
+            sleeper = pair.second;
+            mover = pair.first;
+        } else {
+            continue;
+        }
+        
+        if (checkCollision(sleeper, mover)) {
+            m_bodies.flags[sleeper] &= ~PhysicsBodyStore::Sleeping;
+            m_bodies.movable[sleeper] = 1.0f;
+            m_bodies.restingSteps[sleeper] = 0;
+        }
+    }
+}
+
+void PhysicsEngine::wakeAllBodies() {
+    for (size_t i = 0; i < m_bodies.size(); ++i) {
+        if (m_bodies.flags[i] & PhysicsBodyStore::Sleeping) {
+            m_bodies.flags[i] &= ~PhysicsBodyStore::Sleeping;
+            m_bodies.movable[i] = 1.0f;
+            m_bodies.restingSteps[i] = 0;
+        }
+    }
+    countBodies();
+}
+
+void PhysicsEngine::collideBodies() {
+    // Broadphase narrows the O(n²) pairs down to bodies whose bounds overlap
+    updateProxies();
+    m_broadphase->update(m_proxies);
+    m_broadphase->findPairs(m_candidatePairs);
+    
+    if (m_sleepingEnabled) {
+        wakeTouchedBodies();
+        
+        // Sleep is left out of the broadphase so falling asleep or waking
+        // never changes its layout; pairs of bodies that both stay still
+        // are dropped here instead
+        m_candidatePairs.erase(std::remove_if(m_candidatePairs.begin(), m_candidatePairs.end(),
+            [this](const BroadphasePair& pair) {
+                return m_bodies.movable[pair.first] == 0.0f && m_bodies.movable[pair.second] == 0.0f;
+            }), m_candidatePairs.end());
+    }
+    
+    if (m_sweptBodyCount > 0) {
+        solveTimesOfImpact();
+    }
+    
+    // Pairs arrive sorted, so resolution order matches the all-pairs reference
+    if (m_threadCount <= 1 || m_candidatePairs.size() < kMinParallelPairs) {
+        for (const auto& pair : m_candidatePairs) {
+            if (checkCollision(pair.first, pair.second)) {
+                resolveCollision(pair.first, pair.second);
+            }
+        }
+        return;
+    }
     
-    // Reset acceleration (forces are applied per frame)
-    obj->setAcceleration(glm::vec3(0.0f));
+    // Islands share no movable bodies, so they can be solved concurrently;
+    // within an island pairs keep their sorted order
+    buildIslands();
+    
+    size_t islandCount = m_islandPairStarts.size() - 1;
+    size_t grainSize = std::max<size_t>(1, islandCount / (getThreadCount() * 4));
+    parallelFor(islandCount, grainSize, [this](size_t begin, size_t end) {
+        for (size_t island = begin; island < end; ++island) {
+            for (uint32_t i = m_islandPairStarts[island]; i < m_islandPairStarts[island + 1]; ++i) {
+                const BroadphasePair& pair = m_islandPairs[i];
+                if (checkCollision(pair.first, pair.second)) {
+                    resolveCollision(pair.first, pair.second);
+                }
+            }
+        }
+    });
 }
 
-void PhysicsEngine::applyConstraints(std::shared_ptr<AnimationObject> obj) {
-    if (!obj) return;
+void PhysicsEngine::solveTimesOfImpact() {
+    m_impacts.clear();
+    for (const auto& pair : m_candidatePairs) {
+        uint8_t swept = ((m_bodies.flags[pair.first] & PhysicsBodyStore::Swept) ? 1 : 0) |
+                        ((m_bodies.flags[pair.second] & PhysicsBodyStore::Swept) ? 2 : 0);
+        if (swept == 0) continue;
+        
+        float time = findTimeOfImpact(pair.first, pair.second);
+        if (time != kNoImpact) {
+            m_impacts.push_back({time, pair.first, pair.second, swept});
+        }
+    }
     
-    glm::vec3 pos = obj->getPosition();
-    glm::vec3 vel = obj->getVelocity();
+    // Earliest impacts first. A swept body only takes its first impact; its
+    // path after that is no longer the one the later impacts were found on.
+    std::sort(m_impacts.begin(), m_impacts.end(), [](const TimeOfImpact& a, const TimeOfImpact& b) {
+        if (a.time != b.time) return a.time < b.time;
+        if (a.first != b.first) return a.first < b.first;
+        return a.second < b.second;
+    });
+    
+    for (const auto& impact : m_impacts) {
+        uint32_t bodies[2] = {impact.first, impact.second};
+        
+        bool stale = false;
+        for (int side = 0; side < 2; ++side) {
+            if ((impact.swept & (1 << side)) && !(m_bodies.flags[bodies[side]] & PhysicsBodyStore::Swept)) {
+                stale = true;
+            }
+        }
+        if (stale) continue;
+        
+        // Move swept bodies back to just before the contact
+        float time = std::max(0.0f, impact.time - kTimeOfImpactSlop);
+        for (int side = 0; side < 2; ++side) {
+            uint32_t body = bodies[side];
+            if (impact.swept & (1 << side)) {
+                glm::vec3 previous = m_bodies.getPreviousPosition(body);
+                m_bodies.setPosition(body, previous + (m_bodies.getPosition(body) - previous) * time);
+                m_bodies.flags[body] &= ~PhysicsBodyStore::Swept;
+            } else if (m_bodies.flags[body] & PhysicsBodyStore::Sleeping) {
+                m_bodies.flags[body] &= ~PhysicsBodyStore::Sleeping;
+                m_bodies.movable[body] = 1.0f;
+                m_bodies.restingSteps[body] = 0;
+            }
+        }
+        
+        glm::vec3 normal;
+        computeContact(impact.first, impact.second, normal);
+        applyContactImpulse(impact.first, impact.second, normal);
+    }
+}
+
+float PhysicsEngine::findTimeOfImpact(size_t body1, size_t body2) const {
+    using Shape = PhysicsBodyStore::Shape;
+    
+    glm::vec3 previous1 = m_bodies.getPreviousPosition(body1);
+    glm::vec3 previous2 = m_bodies.getPreviousPosition(body2);
+    glm::vec3 motion1 = m_bodies.getPosition(body1) - previous1;
+    glm::vec3 motion2 = m_bodies.getPosition(body2) - previous2;
+    float radius = m_bodies.radius[body1] + m_bodies.radius[body2];
+    
+    Shape shape1 = m_bodies.shape[body1];
+    Shape shape2 = m_bodies.shape[body2];
+    if (shape1 == Shape::Circle && shape2 == Shape::Circle) {
+        return sweepSphere(previous1 - previous2, motion1 - motion2, radius);
+    }
+    if (shape1 == shape2) return kNoImpact;
+    
+    // Circle against a segment, in the segment's frame
+    size_t circle = shape1 == Shape::Circle ? body1 : body2;
+    size_t segment = shape1 == Shape::Circle ? body2 : body1;
+    glm::vec3 start = m_bodies.getPreviousPosition(circle) - m_bodies.getPreviousPosition(segment);
+    glm::vec3 motion = shape1 == Shape::Circle ? motion1 - motion2 : motion2 - motion1;
+    
+    return sweepCircleSegment(glm::vec2(start), glm::vec2(motion),
+                              m_bodies.segmentStart[segment], m_bodies.segmentEnd[segment], radius);
+}
+
+void PhysicsEngine::buildIslands() {
+    const size_t bodyCount = m_bodies.size();
+    m_islandParent.resize(bodyCount);
+    for (size_t i = 0; i < bodyCount; ++i) {
+        m_islandParent[i] = static_cast<uint32_t>(i);
+    }
+    
+    // Static bodies are never moved by a contact, so they do not join islands
+    for (const auto& pair : m_candidatePairs) {
+        if (m_bodies.movable[pair.first] == 0.0f || m_bodies.movable[pair.second] == 0.0f) continue;
+        
+        uint32_t root1 = findIslandRoot(pair.first);
+        uint32_t root2 = findIslandRoot(pair.second);
+        if (root1 != root2) {
+            // Lower index becomes the root, keeping the forest independent of timing
+            m_islandParent[std::max(root1, root2)] = std::min(root1, root2);
+        }
+    }
+    
+    // Number islands by first appearance in pair order, then bucket pairs stably
+    m_islandOfRoot.assign(bodyCount, -1);
+    std::vector<int32_t> pairIsland(m_candidatePairs.size());
+    int32_t islandCount = 0;
+    for (size_t i = 0; i < m_candidatePairs.size(); ++i) {
+        const BroadphasePair& pair = m_candidatePairs[i];
+        uint32_t body = m_bodies.movable[pair.first] != 0.0f ? pair.first : pair.second;
+        uint32_t root = findIslandRoot(body);
+        if (m_islandOfRoot[root] < 0) {
+            m_islandOfRoot[root] = islandCount++;
+        }
+        pairIsland[i] = m_islandOfRoot[root];
+    }
+    
+    m_islandPairStarts.assign(islandCount + 1, 0);
+    for (int32_t island : pairIsland) {
+        ++m_islandPairStarts[island + 1];
+    }
+    for (int32_t i = 1; i <= islandCount; ++i) {
+        m_islandPairStarts[i] += m_islandPairStarts[i - 1];
+    }
+    
+    std::vector<uint32_t> cursor(m_islandPairStarts.begin(), m_islandPairStarts.end() - 1);
+    m_islandPairs.resize(m_candidatePairs.size());
+    for (size_t i = 0; i < m_candidatePairs.size(); ++i) {
+        m_islandPairs[cursor[pairIsland[i]]++] = m_candidatePairs[i];
+    }
+}
+
+uint32_t PhysicsEngine::findIslandRoot(uint32_t body) {
+    uint32_t root = body;
+    while (m_islandParent[root] != root) {
+        root = m_islandParent[root];
+    }
+    
+    // Path compression
+    while (m_islandParent[body] != root) {
+        uint32_t next = m_islandParent[body];
+        m_islandParent[body] = root;
+        body = next;
+    }
+    return root;
+}
+
+void PhysicsEngine::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+    JobSystem::instance().parallelFor(count, grainSize, body, m_threadCount);
+}
+
+void PhysicsEngine::applyConstraints(size_t body) {
+    glm::vec3 pos = m_bodies.getPosition(body);
+    glm::vec3 vel = m_bodies.getVelocity(body);
+    float bounce = m_bodies.bounce[body];
     bool modified = false;
     
     // Ground constraint
     if (m_groundConstraintEnabled && pos.y < m_groundY) {
         pos.y = m_groundY;
         if (vel.y < 0.0f) {
-            vel.y = -vel.y * obj->getBounce();
+            vel.y = -vel.y * bounce;
         }
         modified = true;
     }
@@ -240,91 +899,171 @@ void PhysicsEngine::applyConstraints(std::shared_ptr<AnimationObject> obj) {
     for (const auto& wall : m_wallConstraints) {
         if (pos.x < wall.x) {
             pos.x = wall.x;
-            if (vel.x < 0.0f) vel.x = -vel.x * obj->getBounce();
+            if (vel.x < 0.0f) vel.x = -vel.x * bounce;
             modified = true;
         }
         if (pos.x > wall.x + wall.width) {
             pos.x = wall.x + wall.width;
-            if (vel.x > 0.0f) vel.x = -vel.x * obj->getBounce();
+            if (vel.x > 0.0f) vel.x = -vel.x * bounce;
             modified = true;
         }
         if (pos.y < wall.y) {
             pos.y = wall.y;
-            if (vel.y < 0.0f) vel.y = -vel.y * obj->getBounce();
+            if (vel.y < 0.0f) vel.y = -vel.y * bounce;
             modified = true;
         }
         if (pos.y > wall.y + wall.height) {
             pos.y = wall.y + wall.height;
-            if (vel.y > 0.0f) vel.y = -vel.y * obj->getBounce();
+            if (vel.y > 0.0f) vel.y = -vel.y * bounce;
             modified = true;
         }
     }
     
     if (modified) {
-        obj->setPosition(pos);
-        obj->setVelocity(vel);
+        m_bodies.setPosition(body, pos);
+        m_bodies.setVelocity(body, vel);
     }
 }
 
-bool PhysicsEngine::checkCollision(std::shared_ptr<AnimationObject> obj1, std::shared_ptr<AnimationObject> obj2) {
-    if (!obj1 || !obj2) return false;
+void PhysicsEngine::updateProxies() {
+    m_proxies.resize(m_bodies.size());
+    m_sweptBodyCount = 0;
     
-    // Simple circle-circle collision for now
-    glm::vec3 pos1 = obj1->getPosition();
-    glm::vec3 pos2 = obj2->getPosition();
-    
-    float distance = glm::length(pos1 - pos2);
-    float radius1 = obj1->getScale().x;  // Assuming uniform scale
-    float radius2 = obj2->getScale().x;
-    
-    return distance < (radius1 + radius2);
+    for (size_t i = 0; i < m_bodies.size(); ++i) {
+        BroadphaseProxy& proxy = m_proxies[i];
+        m_bodies.flags[i] &= ~PhysicsBodyStore::Swept;
+        proxy.active = (m_bodies.flags[i] & PhysicsBodyStore::Active) != 0;
+        if (!proxy.active) continue;
+        
+        // Object bounds, grown to cover the circle or thick segment the narrowphase tests
+        glm::vec2 pos(m_bodies.positionX[i], m_bodies.positionY[i]);
+        float radius = std::abs(m_bodies.radius[i]);
+        bool segment = m_bodies.shape[i] == PhysicsBodyStore::Shape::Segment;
+        float padding = segment ? radius : 0.0f;
+        proxy.min = glm::min(pos + m_bodies.boundsMinOffset[i] - padding, pos - radius);
+        proxy.max = glm::max(pos + m_bodies.boundsMaxOffset[i] + padding, pos + radius);
+        
+        // A circle moving farther than its radius could step over a thin
+        // body, so its proxy covers the whole path instead
+        if (m_continuousCollisionEnabled && !segment && m_bodies.movable[i] != 0.0f) {
+            glm::vec2 previous(m_bodies.previousX[i], m_bodies.previousY[i]);
+            glm::vec2 motion = pos - previous;
+            if ((m_bodies.flags[i] & PhysicsBodyStore::Fast) || glm::dot(motion, motion) > radius * radius) {
+                proxy.min = glm::min(proxy.min, previous - radius);
+                proxy.max = glm::max(proxy.max, previous + radius);
+                m_bodies.flags[i] |= PhysicsBodyStore::Swept;
+                ++m_sweptBodyCount;
+            }
+        }
+        
+        proxy.isStatic = (m_bodies.flags[i] & PhysicsBodyStore::Static) != 0;
+    }
+}
+
+bool PhysicsEngine::checkCollision(size_t body1, size_t body2) const {
+    glm::vec3 normal;
+    return computeContact(body1, body2, normal) < 0.0f;
 }
 
-void PhysicsEngine::resolveCollision(std::shared_ptr<AnimationObject> obj1, std::shared_ptr<AnimationObject> obj2) {
-    if (!obj1 || !obj2) return;
+void PhysicsEngine::resolveCollision(size_t body1, size_t body2) {
+    glm::vec3 pos1 = m_bodies.getPosition(body1);
+    glm::vec3 pos2 = m_bodies.getPosition(body2);
     
-    // Simple elastic collision resolution
-    glm::vec3 pos1 = obj1->getPosition();
-    glm::vec3 pos2 = obj2->getPosition();
-    glm::vec3 vel1 = obj1->getVelocity();
-    glm::vec3 vel2 = obj2->getVelocity();
+    glm::vec3 normal;
+    float separation = computeContact(body1, body2, normal);
     
-    glm::vec3 normal = glm::normalize(pos1 - pos2);
+    // Static and sleeping bodies behave as immovable here
+    bool static1 = m_bodies.movable[body1] == 0.0f;
+    bool static2 = m_bodies.movable[body2] == 0.0f;
     
-    // Separate objects
-    float overlap = glm::length(pos1 - pos2) - (obj1->getScale().x + obj2->getScale().x);
-    if (overlap < 0) {
-        glm::vec3 separation = normal * (-overlap * 0.5f);
-        obj1->setPosition(pos1 + separation);
-        obj2->setPosition(pos2 - separation);
+    // Separate objects; a static body stays put and the other takes the full push
+    if (separation < 0) {
+        float share1 = static1 ? 0.0f : (static2 ? 1.0f : 0.5f);
+        float share2 = static2 ? 0.0f : (static1 ? 1.0f : 0.5f);
+        if (share1 > 0.0f) m_bodies.setPosition(body1, pos1 + normal * (-separation * share1));
+        if (share2 > 0.0f) m_bodies.setPosition(body2, pos2 - normal * (-separation * share2));
     }
     
-    // Calculate collision response
-    float mass1 = obj1->getMass();
-    float mass2 = obj2->getMass();
+    applyContactImpulse(body1, body2, normal);
+}
+
+void PhysicsEngine::applyContactImpulse(size_t body1, size_t body2, const glm::vec3& normal) {
+    glm::vec3 vel1 = m_bodies.getVelocity(body1);
+    glm::vec3 vel2 = m_bodies.getVelocity(body2);
     
     float relativeVel = glm::dot(vel1 - vel2, normal);
-    
     if (relativeVel > 0) return;  // Objects are moving apart
     
-    float restitution = std::min(obj1->getBounce(), obj2->getBounce());
-    float impulse = -(1.0f + restitution) * relativeVel / (1.0f / mass1 + 1.0f / mass2);
+    // Immovable bodies have infinite mass, so the other body reflects off them
+    bool static1 = m_bodies.movable[body1] == 0.0f;
+    bool static2 = m_bodies.movable[body2] == 0.0f;
+    float inverseMass1 = static1 ? 0.0f : m_bodies.inverseMass[body1];
+    float inverseMass2 = static2 ? 0.0f : m_bodies.inverseMass[body2];
+    if (inverseMass1 + inverseMass2 <= 0.0f) return;
+    
+    float restitution = std::min(m_bodies.bounce[body1], m_bodies.bounce[body2]);
+    float impulse = -(1.0f + restitution) * relativeVel / (inverseMass1 + inverseMass2);
     
     glm::vec3 impulseVec = impulse * normal;
     
-    if (!obj1->isStatic()) {
-        obj1->setVelocity(vel1 + impulseVec / mass1);
+    if (!static1) {
+        m_bodies.setVelocity(body1, vel1 + impulseVec * inverseMass1);
     }
-    if (!obj2->isStatic()) {
-        obj2->setVelocity(vel2 - impulseVec / mass2);
+    if (!static2) {
+        m_bodies.setVelocity(body2, vel2 - impulseVec * inverseMass2);
     }
 }
 
-glm::vec3 PhysicsEngine::calculateCollisionNormal(std::shared_ptr<AnimationObject> obj1, std::shared_ptr<AnimationObject> obj2) {
-    if (!obj1 || !obj2) return glm::vec3(0.0f);
+float PhysicsEngine::computeContact(size_t body1, size_t body2, glm::vec3& normal) const {
+    using Shape = PhysicsBodyStore::Shape;
+    
+    // Returns the gap between the two surfaces, negative when they overlap,
+    // and the contact normal pointing from body2 towards body1
+    Shape shape1 = m_bodies.shape[body1];
+    Shape shape2 = m_bodies.shape[body2];
+    glm::vec3 pos1 = m_bodies.getPosition(body1);
+    glm::vec3 pos2 = m_bodies.getPosition(body2);
+    float radius = m_bodies.radius[body1] + m_bodies.radius[body2];
+    
+    if (shape1 == Shape::Circle && shape2 == Shape::Circle) {
+        // Coincident bodies (e.g. stacked by the ground clamp) get pushed apart vertically
+        glm::vec3 delta = pos1 - pos2;
+        float distance = glm::length(delta);
+        normal = distance > 1e-6f ? delta / distance : glm::vec3(0.0f, 1.0f, 0.0f);
+        return distance - radius;
+    }
     
-    glm::vec3 pos1 = obj1->getPosition();
-    glm::vec3 pos2 = obj2->getPosition();
+    if (shape1 == shape2) {
+        // Segments never collide with each other
+        normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        return kNoImpact;
+    }
+    
+    size_t circle = shape1 == Shape::Circle ? body1 : body2;
+    size_t segment = shape1 == Shape::Circle ? body2 : body1;
+    glm::vec2 center(m_bodies.getPosition(circle));
+    glm::vec2 origin(m_bodies.getPosition(segment));
+    glm::vec2 start = origin + m_bodies.segmentStart[segment];
+    glm::vec2 end = origin + m_bodies.segmentEnd[segment];
+    
+    glm::vec2 delta = center - closestPointOnSegment(center, start, end);
+    float distance = glm::length(delta);
+    glm::vec2 direction;
+    if (distance > 1e-6f) {
+        direction = delta / distance;
+    } else {
+        // Center on the segment: push out along its normal
+        glm::vec2 along = end - start;
+        float length = glm::length(along);
+        direction = length > 0.0f ? glm::vec2(-along.y, along.x) / length : glm::vec2(0.0f, 1.0f);
+    }
     
-    return glm::normalize(pos1 - pos2);
-} 
\ No newline at end of file
+    normal = glm::vec3(circle == body1 ? direction : -direction, 0.0f);
+    return distance - radius;
+}
+
+glm::vec3 PhysicsEngine::calculateCollisionNormal(size_t body1, size_t body2) const {
+    glm::vec3 normal;
+    computeContact(body1, body2, normal);
+    return normal;
+}
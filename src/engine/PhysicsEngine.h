@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include <functional>
 #include <glm/glm.hpp>
+#include "Broadphase.h"
+#include "PhysicsBodyStore.h"
 
 // Forward declarations
 class AnimationObject;
@@ -11,7 +15,33 @@ class AnimationObject;
  * @brief PhysicsEngine class for real-time physics simulation
  * 
  * Handles gravity, forces, collisions, and physics-based animations
- * for all objects in the scene.
+ * for all objects in the scene. Simulation runs on a structure-of-arrays
+ * copy of the objects' state that is read once per update() and written
+ * back once at the end, however many substeps it takes.
+ * 
+ * Integration, contact solving and constraints are spread over the
+ * engine's job system. Contacts are split into islands of bodies with touching bounds;
+ * each island is solved in pair order on one thread, which gives the same
+ * result as solving every pair serially, whatever the thread count.
+ * 
+ * Bodies that stay slower than the sleep speed for a number of steps fall
+ * asleep. Sleeping bodies are not integrated, clamped or tested against
+ * each other. They wake when a moving body hits them, including a static
+ * body moved from outside, when gravity or air resistance changes, or when
+ * their position, velocity or acceleration is changed outside the engine,
+ * for example by applyForce(), applyImpulse(), setPosition() or setVelocity().
+ * 
+ * Circles that move farther than their radius in one step, or that are
+ * flagged with setFastMoving(), are swept from their previous position so
+ * they cannot tunnel through thin bodies. The earliest time of impact
+ * along the sweep moves the body back to the contact and bounces it; the
+ * rest of that step is dropped.
+ * 
+ * Because all of this depends on the path the bodies took, the state at
+ * an arbitrary time can't be computed directly. saveState() and
+ * restoreState() capture every body so the engine can seek from a
+ * snapshot, and markBodies() lets it notice bodies edited from outside,
+ * whose past no snapshot describes.
  */
 class PhysicsEngine {
 public:
@@ -32,19 +62,77 @@ public:
     void setTimeStep(float timeStep);
     float getTimeStep() const;
     
+    // Fixed-step accumulator. Time that does not fill a whole step carries
+    // over to the next update; frames needing more than the substep limit
+    // drop the excess time instead of falling further behind.
+    void setMaxSubsteps(int maxSubsteps);
+    int getMaxSubsteps() const;
+    float getInterpolationAlpha() const;
+    void resetAccumulator();
+    
+    // Threads the step may use; 0 uses every job system thread, 1 runs serially
+    void setThreadCount(size_t threadCount);
+    size_t getThreadCount() const;
+    
+    // Sleeping
+    void setSleepingEnabled(bool enabled);
+    bool isSleepingEnabled() const;
+    void setSleepThreshold(float speed);
+    float getSleepThreshold() const;
+    void setSleepSteps(int steps);
+    int getSleepSteps() const;
+    
+    // Non-static bodies by state, as of the end of the last update
+    size_t getAwakeBodyCount() const;
+    size_t getSleepingBodyCount() const;
+    
+    // State of every body, for seeking. A state only restores onto the
+    // bodies it was saved from: adding or removing objects bumps the body
+    // set version and makes restoreState() refuse older states.
+    struct BodyState {
+        glm::vec3 position;
+        glm::vec3 previousPosition;
+        glm::vec3 velocity;
+        glm::vec3 acceleration;
+        uint16_t restingSteps;
+        bool sleeping;
+    };
+    struct State {
+        uint64_t bodySet;       // getBodySetVersion() when saved
+        double accumulator;
+        std::vector<BodyState> bodies;      // Body i is the i-th object added
+    };
+    void saveState(State& state) const;
+    bool restoreState(const State& state);
+    uint64_t getBodySetVersion() const;
+    
+    // markBodies() remembers every body's position, velocity and
+    // acceleration; bodiesChangedSinceMark() tells whether anything other
+    // than the engine's own update changed one of them since
+    void markBodies();
+    bool bodiesChangedSinceMark() const;
+    
     // Object management
     void addObject(std::shared_ptr<AnimationObject> obj);
     void removeObject(std::shared_ptr<AnimationObject> obj);
     void clearObjects();
     
     // Physics simulation
-    void update(float deltaTime);
-    void step(float deltaTime);
+    void update(float deltaTime);   // Runs as many whole fixed steps as time allows
+    void step(float deltaTime);     // Runs exactly one step of deltaTime
     
     // Collision detection
     void enableCollisionDetection(bool enable);
     bool isCollisionDetectionEnabled() const;
     
+    void enableContinuousCollision(bool enable);
+    bool isContinuousCollisionEnabled() const;
+    
+    // Broadphase used to find candidate pairs; AllPairs is the O(n²) reference
+    void setBroadphase(BroadphaseType type);
+    BroadphaseType getBroadphaseType() const;
+    Broadphase* getBroadphase();
+    
     void updateCollisions();
     void resolveCollisions();
     
@@ -63,12 +151,49 @@ public:
 private:
     bool m_enabled;
     bool m_collisionDetectionEnabled;
+    bool m_continuousCollisionEnabled;
     
     glm::vec3 m_gravity;
     float m_airResistance;
     float m_timeStep;
+    int m_maxSubsteps;
+    double m_accumulator;
+    
+    bool m_sleepingEnabled;
+    float m_sleepThreshold;
+    int m_sleepSteps;
+    size_t m_awakeBodyCount;
+    size_t m_sleepingBodyCount;
+    size_t m_movedBodyCount;
     
     std::vector<std::shared_ptr<AnimationObject>> m_physicsObjects;
+    PhysicsBodyStore m_bodies;
+    
+    // Broadphase state, indexed like m_physicsObjects
+    std::unique_ptr<Broadphase> m_broadphase;
+    std::vector<BroadphaseProxy> m_proxies;
+    std::vector<BroadphasePair> m_candidatePairs;
+    
+    // Continuous collision detection
+    struct TimeOfImpact {
+        float time;         // Fraction of the step, in [0, 1]
+        uint32_t first;
+        uint32_t second;
+        uint8_t swept;      // Bit 0 if first was swept, bit 1 if second was
+    };
+    size_t m_sweptBodyCount;
+    std::vector<TimeOfImpact> m_impacts;
+    
+    // Body set version, and the bodies as of the last markBodies()
+    uint64_t m_bodySetVersion;
+    std::vector<glm::vec3> m_markedState;   // Position, velocity, acceleration per body
+    
+    // Threading and contact islands
+    size_t m_threadCount;
+    std::vector<uint32_t> m_islandParent;       // Union-find forest over bodies
+    std::vector<int32_t> m_islandOfRoot;
+    std::vector<uint32_t> m_islandPairStarts;   // Island i owns [starts[i], starts[i + 1])
+    std::vector<BroadphasePair> m_islandPairs;  // Candidate pairs grouped by island
     
     // Ground constraint
     bool m_groundConstraintEnabled;
@@ -81,9 +206,24 @@ private:
     std::vector<WallConstraint> m_wallConstraints;
     
     // Helper methods
-    void updateObjectPhysics(std::shared_ptr<AnimationObject> obj, float deltaTime);
-    void applyConstraints(std::shared_ptr<AnimationObject> obj);
-    bool checkCollision(std::shared_ptr<AnimationObject> obj1, std::shared_ptr<AnimationObject> obj2);
-    void resolveCollision(std::shared_ptr<AnimationObject> obj1, std::shared_ptr<AnimationObject> obj2);
-    glm::vec3 calculateCollisionNormal(std::shared_ptr<AnimationObject> obj1, std::shared_ptr<AnimationObject> obj2);
+    void syncFromObjects();
+    void syncToObjects();
+    void stepBodies(float deltaTime);
+    void collideBodies();
+    void wakeTouchedBodies();
+    void wakeAllBodies();
+    void solveTimesOfImpact();
+    float findTimeOfImpact(size_t body1, size_t body2) const;
+    void updateSleep();
+    void countBodies();
+    void buildIslands();
+    uint32_t findIslandRoot(uint32_t body);
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+    void applyConstraints(size_t body);
+    void updateProxies();
+    bool checkCollision(size_t body1, size_t body2) const;
+    void resolveCollision(size_t body1, size_t body2);
+    void applyContactImpulse(size_t body1, size_t body2, const glm::vec3& normal);
+    float computeContact(size_t body1, size_t body2, glm::vec3& normal) const;
+    glm::vec3 calculateCollisionNormal(size_t body1, size_t body2) const;
 }; 
\ No newline at end of file
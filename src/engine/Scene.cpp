@@ -1,11 +1,115 @@
 #include "Scene.h"
 #include "../objects/AnimationObject.h"
 #include "../rendering/Renderer.h"
+#include "../utils/JobSystem.h"
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <sstream>
+
+namespace {
+
+// Default culling grid cell, in world units; a few cells span the default view
+const float kDefaultCullingCellSize = 128.0f;
+
+// Objects per update chunk; enough to amortize scheduling, few enough to
+// spread a few thousand objects over every thread
+const size_t kUpdateGrain = 256;
+
+// World-space box covering everything an object draws at any interpolation
+// alpha. pixelMargin is how far drawing may reach past the box in pixels:
+// the anti-aliased edge, plus half the width of a line.
+void computeRenderBounds(const AnimationObject& obj, glm::vec3& boundsMin, glm::vec3& boundsMax, float& pixelMargin) {
+    const RenderPrimitive& primitive = obj.getRenderPrimitive();
+    pixelMargin = 1.0f;
+    
+    if (primitive.kind == RenderPrimitive::Line) {
+        boundsMin = glm::vec3(glm::min(primitive.lineStart, primitive.lineEnd), 0.0f);
+        boundsMax = glm::vec3(glm::max(primitive.lineStart, primitive.lineEnd), 0.0f);
+        pixelMargin += std::max(primitive.lineThickness, 1.0f) * 0.5f;
+        return;
+    }
+    
+    // Drawing moves the object between its previous and current position
+    glm::vec3 current = obj.getPosition();
+    glm::vec3 previous = obj.getPreviousPosition();
+    
+    if (primitive.kind == RenderPrimitive::Custom) {
+        glm::vec3 offset = previous - current;
+        boundsMin = obj.getMinBounds() + glm::min(offset, glm::vec3(0.0f));
+        boundsMax = obj.getMaxBounds() + glm::max(offset, glm::vec3(0.0f));
+        return;
+    }
+    
+    // Unit circle or unit quad mapped by the transform's linear part
+    glm::mat4 transform = obj.getTransformMatrix();
+    float reach = primitive.kind == RenderPrimitive::Circle ? 1.0f : 0.5f;
+    glm::vec3 extent = (glm::abs(glm::vec3(transform[0])) + glm::abs(glm::vec3(transform[1]))) * reach;
+    boundsMin = glm::min(previous, current) - extent;
+    boundsMax = glm::max(previous, current) + extent;
+}
+
+// True unless the box lies entirely outside one side of the view volume.
+// Tested in clip space, so it holds for orthographic and perspective
+// projections alike; margin widens the sides in normalized device units.
+bool intersectsViewVolume(const glm::mat4& projection, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec2& margin) {
+    int outside[4] = {0, 0, 0, 0};
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec4 point((corner & 1) ? boundsMax.x : boundsMin.x,
+                        (corner & 2) ? boundsMax.y : boundsMin.y,
+                        (corner & 4) ? boundsMax.z : boundsMin.z,
+                        1.0f);
+        glm::vec4 clip = projection * point;
+        float reachX = clip.w * (1.0f + margin.x);
+        float reachY = clip.w * (1.0f + margin.y);
+        outside[0] += clip.x < -reachX;
+        outside[1] += clip.x > reachX;
+        outside[2] += clip.y < -reachY;
+        outside[3] += clip.y > reachY;
+    }
+    return outside[0] < 8 && outside[1] < 8 && outside[2] < 8 && outside[3] < 8;
+}
+
+// Feeds an object to the renderer's batch. Built-in shapes are submitted
+// from their render primitive; only custom objects go through render().
+void submitObject(AnimationObject& obj, Renderer* renderer) {
+    const RenderPrimitive& primitive = obj.getRenderPrimitive();
+    if (primitive.kind == RenderPrimitive::Custom) {
+        obj.render(renderer);
+        return;
+    }
+    
+    glm::vec4 color = obj.getColor();
+    color.a *= obj.getOpacity() * primitive.opacity;
+    
+    switch (primitive.kind) {
+        case RenderPrimitive::Circle:
+            renderer->drawCircle(obj.getRenderTransformMatrix(), color);
+            break;
+        case RenderPrimitive::Quad:
+            renderer->drawQuad(obj.getRenderTransformMatrix(), color);
+            break;
+        case RenderPrimitive::Line:
+            renderer->drawLine(primitive.lineStart, primitive.lineEnd, primitive.lineThickness, color);
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace
 
 Scene::Scene(const std::string& name) 
-    : m_name(name) {
+    : m_name(name)
+    , m_nextRenderSequence(0)
+    , m_cullingEnabled(true)
+    , m_cullingGrid(kDefaultCullingCellSize)
+    , m_maxPixelMargin(1.0f)
+    , m_cullFrame(0)
+    , m_lastDrawnCount(0)
+    , m_updateThreadCount(0)
+    , m_replayingDeferred(false)
+    , m_objectSetVersion(0) {
 }
 
 Scene::~Scene() {
@@ -14,8 +118,14 @@ Scene::~Scene() {
 
 void Scene::addObject(std::shared_ptr<AnimationObject> obj) {
     if (obj) {
+        if (m_renderHandles.count(obj.get())) {
+            std::cerr << "Object '" << obj->getName() << "' is already in scene '" << m_name << "'" << std::endl;
+            return;
+        }
         m_objects.push_back(obj);
+        ++m_objectSetVersion;
         updateObjectMap();
+        addToRenderList(obj.get());
         std::cout << "Added object '" << obj->getName() << "' to scene '" << m_name << "'" << std::endl;
     }
 }
@@ -27,7 +137,13 @@ void Scene::removeObject(const std::string& name) {
         });
     
     if (it != m_objects.end()) {
+        // Deferred notifications still to replay may point at the object
+        if (m_replayingDeferred) {
+            m_releasedObjects.push_back(*it);
+        }
+        removeFromRenderList(it->get());
         m_objects.erase(it);
+        ++m_objectSetVersion;
         updateObjectMap();
         std::cout << "Removed object '" << name << "' from scene '" << m_name << "'" << std::endl;
     }
@@ -52,29 +168,63 @@ std::vector<std::shared_ptr<AnimationObject>> Scene::getAllObjects() const {
 }
 
 void Scene::update(float deltaTime) {
-    for (auto& obj : m_objects) {
-        if (obj && obj->isVisible()) {
-            obj->update(deltaTime);
+    size_t count = m_objects.size();
+    m_deferredQueues.resize((count + kUpdateGrain - 1) / kUpdateGrain);
+    
+    JobSystem::instance().parallelFor(count, kUpdateGrain, [this, deltaTime](size_t begin, size_t end) {
+        AnimationObject::DeferredQueue& queue = m_deferredQueues[begin / kUpdateGrain];
+        AnimationObject::DeferredQueue* previous = AnimationObject::setDeferredQueue(&queue);
+        for (size_t i = begin; i < end; ++i) {
+            AnimationObject* obj = m_objects[i].get();
+            if (obj && obj->isVisible()) {
+                obj->update(deltaTime);
+            }
         }
+        AnimationObject::setDeferredQueue(previous);
+    }, m_updateThreadCount);
+    
+    // Chunk order is object order, so this replays what a serial update
+    // would have run. Callbacks may change the scene, so the queues are
+    // taken out of it first.
+    std::vector<AnimationObject::DeferredQueue> queues;
+    queues.swap(m_deferredQueues);
+    m_replayingDeferred = true;
+    for (auto& queue : queues) {
+        AnimationObject::replayDeferred(queue);
+        queue.clear();
+    }
+    m_replayingDeferred = false;
+    m_releasedObjects.clear();
+    
+    // Keep the queues' capacity for the next frame
+    if (m_deferredQueues.empty()) {
+        m_deferredQueues.swap(queues);
     }
 }
 
-void Scene::render(Renderer* renderer) {
+void Scene::setUpdateThreadCount(size_t threadCount) {
+    m_updateThreadCount = threadCount;
+}
+
+size_t Scene::getUpdateThreadCount() const {
+    return m_updateThreadCount == 0 ? JobSystem::instance().getThreadCount() : m_updateThreadCount;
+}
+
+void Scene::render(Renderer* renderer, float alpha) {
     if (!renderer) return;
     
-    // Sort objects by render order
-    std::vector<std::shared_ptr<AnimationObject>> sortedObjects = m_objects;
-    std::sort(sortedObjects.begin(), sortedObjects.end(),
-        [](const std::shared_ptr<AnimationObject>& a, const std::shared_ptr<AnimationObject>& b) {
-            return a->getRenderOrder() < b->getRenderOrder();
-        });
+    if (m_cullingEnabled) {
+        renderCulled(renderer, alpha);
+        return;
+    }
     
-    // Render all visible objects
-    for (auto& obj : sortedObjects) {
-        if (obj && obj->isVisible()) {
-            obj->render();
-        }
+    // Queue all visible objects in draw order; the renderer draws the batch
+    // when the frame is flushed
+    for (AnimationObject* obj : m_visibleList.objects) {
+        obj->setInterpolationAlpha(alpha);
+        submitObject(*obj, renderer);
     }
+    m_lastDrawnCount = m_visibleList.objects.size();
 }
 
 void Scene::reset() {
@@ -86,9 +236,41 @@ void Scene::reset() {
     }
 }
 
+void Scene::saveState(std::string& state) const {
+    std::ostringstream stream;
+    for (const auto& obj : m_objects) {
+        obj->saveState(stream);
+    }
+    state = stream.str();
+}
+
+void Scene::restoreState(const std::string& state) {
+    std::istringstream stream(state);
+    for (auto& obj : m_objects) {
+        obj->restoreState(stream);
+    }
+}
+
+uint64_t Scene::getObjectSetVersion() const {
+    return m_objectSetVersion;
+}
+
 void Scene::clear() {
+    for (auto& obj : m_objects) {
+        if (obj && obj->getScene() == this) {
+            obj->setScene(nullptr);
+        }
+    }
     m_objects.clear();
+    ++m_objectSetVersion;
     m_objectMap.clear();
+    m_renderList.clear();
+    m_visibleList.clear();
+    m_renderEntries.clear();
+    m_renderHandles.clear();
+    m_cullingGrid.clear();
+    m_dirtyBounds.clear();
+    m_maxPixelMargin = 1.0f;
 }
 
 void Scene::handleInput() {
@@ -133,6 +315,219 @@ std::vector<std::shared_ptr<AnimationObject>> Scene::findObjectsInArea(float x,
     return result;
 }
 
+const std::vector<AnimationObject*>& Scene::getRenderList() const {
+    return m_renderList.objects;
+}
+
+const std::vector<AnimationObject*>& Scene::getVisibleRenderList() const {
+    return m_visibleList.objects;
+}
+
+void Scene::setCulling(bool enabled) {
+    m_cullingEnabled = enabled;
+}
+
+bool Scene::isCullingEnabled() const {
+    return m_cullingEnabled;
+}
+
+void Scene::setCullingCellSize(float cellSize) {
+    m_cullingGrid.setCellSize(cellSize);
+}
+
+size_t Scene::getLastDrawnCount() const {
+    return m_lastDrawnCount;
+}
+
+void Scene::onRenderOrderChanged(AnimationObject* obj) {
+    auto it = m_renderHandles.find(obj);
+    if (it == m_renderHandles.end()) return;
+    
+    // Move the entry to its new place, keeping its insertion sequence
+    RenderEntry& entry = m_renderEntries[it->second];
+    RenderKey oldKey = entry.key;
+    entry.key = {obj->getLayer(), obj->getRenderOrder(), oldKey.sequence};
+    
+    m_renderList.erase(oldKey);
+    m_renderList.insert(entry.key, obj, it->second);
+    if (obj->isVisible()) {
+        m_visibleList.erase(oldKey);
+        m_visibleList.insert(entry.key, obj, it->second);
+    }
+}
+
+void Scene::onVisibilityChanged(AnimationObject* obj) {
+    auto it = m_renderHandles.find(obj);
+    if (it == m_renderHandles.end()) return;
+    
+    const RenderKey& key = m_renderEntries[it->second].key;
+    if (obj->isVisible()) {
+        m_visibleList.insert(key, obj, it->second);
+    } else {
+        m_visibleList.erase(key);
+    }
+}
+
+void Scene::onBoundsChanged(AnimationObject* obj) {
+    auto it = m_renderHandles.find(obj);
+    if (it == m_renderHandles.end()) return;
+    
+    // Bounds are recomputed once, when the next frame is culled
+    RenderEntry& entry = m_renderEntries[it->second];
+    if (!entry.boundsDirty) {
+        entry.boundsDirty = true;
+        m_dirtyBounds.push_back(it->second);
+    }
+}
+
+void Scene::RenderList::insert(const RenderKey& key, AnimationObject* obj, uint32_t handle) {
+    auto position = std::lower_bound(keys.begin(), keys.end(), key);
+    if (position != keys.end() && position->sequence == key.sequence) return;
+    
+    size_t index = position - keys.begin();
+    objects.insert(objects.begin() + index, obj);
+    handles.insert(handles.begin() + index, handle);
+    keys.insert(position, key);
+}
+
+void Scene::RenderList::erase(const RenderKey& key) {
+    auto position = std::lower_bound(keys.begin(), keys.end(), key);
+    if (position == keys.end() || position->sequence != key.sequence) return;
+    
+    size_t index = position - keys.begin();
+    objects.erase(objects.begin() + index);
+    handles.erase(handles.begin() + index);
+    keys.erase(position);
+}
+
+void Scene::RenderList::clear() {
+    keys.clear();
+    objects.clear();
+    handles.clear();
+}
+
+void Scene::addToRenderList(AnimationObject* obj) {
+    RenderEntry entry;
+    entry.object = obj;
+    entry.key = {obj->getLayer(), obj->getRenderOrder(), m_nextRenderSequence++};
+    entry.drawnFrame = 0;
+    entry.boundsDirty = false;
+    computeRenderBounds(*obj, entry.boundsMin, entry.boundsMax, entry.pixelMargin);
+    m_maxPixelMargin = std::max(m_maxPixelMargin, entry.pixelMargin);
+    
+    // Render entries share the culling grid's handles
+    uint32_t handle = m_cullingGrid.insert(glm::vec2(entry.boundsMin), glm::vec2(entry.boundsMax));
+    if (handle >= m_renderEntries.size()) {
+        m_renderEntries.resize(handle + 1);
+    }
+    m_renderEntries[handle] = entry;
+    m_renderHandles[obj] = handle;
+    
+    m_renderList.insert(entry.key, obj, handle);
+    if (obj->isVisible()) {
+        m_visibleList.insert(entry.key, obj, handle);
+    }
+    obj->setScene(this);
+}
+
+void Scene::removeFromRenderList(AnimationObject* obj) {
+    auto it = m_renderHandles.find(obj);
+    if (it == m_renderHandles.end()) return;
+    
+    RenderEntry& entry = m_renderEntries[it->second];
+    m_renderList.erase(entry.key);
+    m_visibleList.erase(entry.key);
+    m_cullingGrid.remove(it->second);
+    entry.object = nullptr;
+    entry.boundsDirty = false;
+    m_renderHandles.erase(it);
+    if (obj->getScene() == this) {
+        obj->setScene(nullptr);
+    }
+}
+
+void Scene::updateBounds(RenderEntry& entry) {
+    computeRenderBounds(*entry.object, entry.boundsMin, entry.boundsMax, entry.pixelMargin);
+    m_maxPixelMargin = std::max(m_maxPixelMargin, entry.pixelMargin);
+    entry.boundsDirty = false;
+}
+
+void Scene::refreshDirtyBounds() {
+    for (uint32_t handle : m_dirtyBounds) {
+        RenderEntry& entry = m_renderEntries[handle];
+        if (!entry.object || !entry.boundsDirty) continue;
+        
+        updateBounds(entry);
+        m_cullingGrid.update(handle, glm::vec2(entry.boundsMin), glm::vec2(entry.boundsMax));
+    }
+    m_dirtyBounds.clear();
+}
+
+void Scene::renderCulled(Renderer* renderer, float alpha) {
+    refreshDirtyBounds();
+    
+    const glm::mat4& projection = renderer->getProjectionMatrix();
+    glm::vec2 viewport(std::max(renderer->getWindowWidth(), 1), std::max(renderer->getWindowHeight(), 1));
+    
+    // World-space rectangle around the view volume: the corners of the
+    // clip cube mapped back through the projection
+    glm::mat4 inverse = glm::inverse(projection);
+    glm::vec2 viewMin(INFINITY);
+    glm::vec2 viewMax(-INFINITY);
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec4 point = inverse * glm::vec4((corner & 1) ? 1.0f : -1.0f,
+                                              (corner & 2) ? 1.0f : -1.0f,
+                                              (corner & 4) ? 1.0f : -1.0f,
+                                              1.0f);
+        glm::vec2 world = glm::vec2(point) / point.w;
+        viewMin = glm::min(viewMin, world);
+        viewMax = glm::max(viewMax, world);
+    }
+    
+    // Widen it by the largest pixel margin, at the view's scale
+    glm::vec2 pixelSize = (viewMax - viewMin) / viewport;
+    glm::vec2 reach = pixelSize * m_maxPixelMargin;
+    m_cullCandidates.clear();
+    m_cullingGrid.query(viewMin - reach, viewMax + reach, m_cullCandidates);
+    
+    // Keep the candidates that really reach into the view volume
+    ++m_cullFrame;
+    m_cullDrawList.clear();
+    for (uint32_t handle : m_cullCandidates) {
+        RenderEntry& entry = m_renderEntries[handle];
+        if (!entry.object->isVisible()) continue;
+        
+        glm::vec2 margin = entry.pixelMargin * 2.0f / viewport;
+        if (intersectsViewVolume(projection, entry.boundsMin, entry.boundsMax, margin)) {
+            entry.drawnFrame = m_cullFrame;
+            m_cullDrawList.push_back(std::make_pair(entry.key, entry.object));
+        }
+    }
+    m_lastDrawnCount = m_cullDrawList.size();
+    
+    // Restore draw order. When most of the scene is on screen, walking the
+    // already sorted visible list is cheaper than sorting the survivors.
+    if (m_cullDrawList.size() * 4 >= m_visibleList.handles.size()) {
+        for (uint32_t handle : m_visibleList.handles) {
+            RenderEntry& entry = m_renderEntries[handle];
+            if (entry.drawnFrame == m_cullFrame) {
+                entry.object->setInterpolationAlpha(alpha);
+                submitObject(*entry.object, renderer);
+            }
+        }
+        return;
+    }
+    
+    std::sort(m_cullDrawList.begin(), m_cullDrawList.end(),
+        [](const std::pair<RenderKey, AnimationObject*>& a, const std::pair<RenderKey, AnimationObject*>& b) {
+            return a.first < b.first;
+        });
+    for (auto& item : m_cullDrawList) {
+        item.second->setInterpolationAlpha(alpha);
+        submitObject(*item.second, renderer);
+    }
+}
+
 void Scene::updateObjectMap() {
     m_objectMap.clear();
     for (auto& obj : m_objects) {
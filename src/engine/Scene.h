@@ -1,12 +1,15 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <glm/glm.hpp>
+#include "CullingGrid.h"
+#include "../objects/AnimationObject.h"
 
 // Forward declarations
-class AnimationObject;
 class Renderer;
 
 /**
@@ -14,6 +17,28 @@ class Renderer;
  * 
  * A scene is a container for animation objects and provides
  * scene-level operations like rendering, updating, and object management.
+ *
+ * Objects are drawn in (layer, render order) order, ties in the order
+ * they were added. The scene keeps that order in a persistent render list,
+ * plus a view of just the visible objects, and objects report changes to
+ * their layer, render order or visibility so only the changed entry moves.
+ * Rendering walks the visible list without sorting or copying. An object
+ * reports to the last scene it was added to.
+ *
+ * With culling on, render() only draws objects whose bounds reach into
+ * the renderer's view volume. Object bounds are kept in a loose grid that
+ * is refreshed for the objects that moved since the last frame, so the
+ * cost of a frame follows the number of objects on screen. Built-in
+ * shapes are bounded by the geometry they draw, including interpolation
+ * and line thickness; custom objects by getMinBounds()/getMaxBounds().
+ *
+ * update() runs the objects' update() in parallel on the engine's job
+ * system, in chunks of neighbouring objects. An update() override may
+ * only change its own object. Everything an update raises that reaches
+ * outside the object, such as event listeners, animation callbacks and
+ * the scene's own bookkeeping, is deferred and run on the calling thread
+ * once every object is updated, in the order a serial update would have
+ * run it. Scenes with updates that share state can set one update thread.
  */
 class Scene {
 public:
@@ -29,10 +54,21 @@ public:
     
     // Scene operations
     void update(float deltaTime);
-    void render(Renderer* renderer);
+    // Threads update() may use; 0 uses every job system thread, 1 updates serially
+    void setUpdateThreadCount(size_t threadCount);
+    size_t getUpdateThreadCount() const;
+    // alpha blends each object between its previous and current physics step
+    void render(Renderer* renderer, float alpha = 1.0f);
     void reset();
     void clear();
     
+    // Per-frame state of every object, for seeking (see
+    // AnimationObject::saveState()). A state only restores onto the objects
+    // it was saved from; adding or removing objects bumps the version.
+    void saveState(std::string& state) const;
+    void restoreState(const std::string& state);
+    uint64_t getObjectSetVersion() const;
+    
     // Input handling
     void handleInput();
     
@@ -43,12 +79,92 @@ public:
     // Object queries
     std::vector<std::shared_ptr<AnimationObject>> findObjectsByType(const std::string& type);
     std::vector<std::shared_ptr<AnimationObject>> findObjectsInArea(float x, float y, float radius);
+    
+    // Draw order; the pointers stay valid while the objects are in the scene
+    const std::vector<AnimationObject*>& getRenderList() const;
+    const std::vector<AnimationObject*>& getVisibleRenderList() const;
+    
+    // View-frustum culling, on by default
+    void setCulling(bool enabled);
+    bool isCullingEnabled() const;
+    void setCullingCellSize(float cellSize);   // World units per grid cell
+    size_t getLastDrawnCount() const;          // Objects submitted by the last render()
+    
+    // Called by objects of this scene after the change
+    void onRenderOrderChanged(AnimationObject* obj);
+    void onVisibilityChanged(AnimationObject* obj);
+    void onBoundsChanged(AnimationObject* obj);
 
 private:
+    // Sort key of a render list entry; the sequence breaks ties by insertion
+    struct RenderKey {
+        int layer;
+        int order;
+        uint64_t sequence;
+        
+        bool operator<(const RenderKey& other) const {
+            if (layer != other.layer) return layer < other.layer;
+            if (order != other.order) return order < other.order;
+            return sequence < other.sequence;
+        }
+    };
+    
+    // Objects, their keys and render entry handles in draw order, as parallel arrays
+    struct RenderList {
+        std::vector<RenderKey> keys;
+        std::vector<AnimationObject*> objects;
+        std::vector<uint32_t> handles;
+        
+        void insert(const RenderKey& key, AnimationObject* obj, uint32_t handle);
+        void erase(const RenderKey& key);
+        void clear();
+    };
+    
     std::string m_name;
     std::vector<std::shared_ptr<AnimationObject>> m_objects;
     std::unordered_map<std::string, std::shared_ptr<AnimationObject>> m_objectMap;
     
+    // Per-object render state, indexed by culling grid handle
+    struct RenderEntry {
+        AnimationObject* object;
+        RenderKey key;
+        glm::vec3 boundsMin;        // World space, covering the whole interpolation
+        glm::vec3 boundsMax;
+        float pixelMargin;          // Extra reach in pixels, for line thickness
+        uint64_t drawnFrame;        // Last culling pass that kept the object
+        bool boundsDirty;
+    };
+    
+    // Render order index
+    RenderList m_renderList;
+    RenderList m_visibleList;
+    std::vector<RenderEntry> m_renderEntries;
+    std::unordered_map<const AnimationObject*, uint32_t> m_renderHandles;
+    uint64_t m_nextRenderSequence;
+    
+    // Culling
+    bool m_cullingEnabled;
+    CullingGrid m_cullingGrid;
+    std::vector<uint32_t> m_dirtyBounds;
+    std::vector<uint32_t> m_cullCandidates;
+    std::vector<std::pair<RenderKey, AnimationObject*>> m_cullDrawList;
+    float m_maxPixelMargin;
+    uint64_t m_cullFrame;
+    size_t m_lastDrawnCount;
+    
+    // Parallel update; one deferred queue per chunk of objects
+    size_t m_updateThreadCount;
+    std::vector<AnimationObject::DeferredQueue> m_deferredQueues;
+    bool m_replayingDeferred;
+    std::vector<std::shared_ptr<AnimationObject>> m_releasedObjects;  // Removed while replaying
+    
+    uint64_t m_objectSetVersion;    // Bumped whenever objects are added or removed
+    
     // Helper methods
     void updateObjectMap();
+    void addToRenderList(AnimationObject* obj);
+    void removeFromRenderList(AnimationObject* obj);
+    void updateBounds(RenderEntry& entry);
+    void refreshDirtyBounds();
+    void renderCulled(Renderer* renderer, float alpha);
 }; 
\ No newline at end of file
@@ -2,12 +2,32 @@
 #include <algorithm>
 #include <iostream>
 
+namespace {
+
+// Position in handles, sorted by key, of the first entry whose key is not
+// less than value, or with after set, greater than it
+template <typename Key>
+size_t findPosition(const std::vector<uint32_t>& handles, float value, bool after, Key key) {
+    auto it = after
+        ? std::upper_bound(handles.begin(), handles.end(), value,
+              [&key](float v, uint32_t handle) { return v < key(handle); })
+        : std::lower_bound(handles.begin(), handles.end(), value,
+              [&key](uint32_t handle, float v) { return key(handle) < v; });
+    return static_cast<size_t>(it - handles.begin());
+}
+
+} // namespace
+
 Timeline::Timeline()
     : m_isPlaying(false)
     , m_isPaused(false)
     , m_currentTime(0.0f)
     , m_duration(0.0f)
-    , m_timeScale(1.0f) {
+    , m_timeScale(1.0f)
+    , m_nextCallback(0)
+    , m_nextStart(0)
+    , m_nextEnd(0)
+    , m_intervalTreeDirty(false) {
 }
 
 Timeline::~Timeline() {
@@ -27,12 +47,14 @@ void Timeline::reset() {
     m_currentTime = 0.0f;
     m_isPlaying = false;
     m_isPaused = false;
+    seekCallbacks();
 }
 
 void Timeline::stop() {
     m_isPlaying = false;
     m_isPaused = false;
     m_currentTime = 0.0f;
+    seekCallbacks();
 }
 
 void Timeline::setTimeScale(float scale) {
@@ -44,7 +66,12 @@ float Timeline::getTimeScale() const {
 }
 
 void Timeline::setCurrentTime(float time) {
-    m_currentTime = std::max(0.0f, std::min(time, m_duration));
+    // Without a duration the timeline is open-ended, like in update()
+    m_currentTime = std::max(0.0f, time);
+    if (m_duration > 0.0f) {
+        m_currentTime = std::min(m_currentTime, m_duration);
+    }
+    seekCallbacks();
 }
 
 float Timeline::getCurrentTime() const {
@@ -55,6 +82,7 @@ void Timeline::setDuration(float duration) {
     m_duration = std::max(0.0f, duration);
     if (m_currentTime > m_duration) {
         m_currentTime = m_duration;
+        seekCallbacks();
     }
 }
 
@@ -108,42 +136,240 @@ void Timeline::removeMarker(const std::string& name) {
 }
 
 void Timeline::jumpToMarker(const std::string& name) {
+    float time;
+    if (getMarkerTime(name, time)) {
+        setCurrentTime(time);
+    }
+}
+
+bool Timeline::getMarkerTime(const std::string& name, float& time) const {
     for (const auto& marker : m_markers) {
         if (marker.name == name) {
-            setCurrentTime(marker.time);
-            return;
+            time = marker.time;
+            return true;
         }
     }
+    return false;
 }
 
 void Timeline::addTimeCallback(float time, TimelineCallback callback) {
     TimeCallback timeCallback;
     timeCallback.time = time;
     timeCallback.callback = callback;
-    m_callbacks.push_back(timeCallback);
+    
+    // A callback inserted behind the cursor, or at it but behind the
+    // playhead, has been passed already; one at the current time is due
+    auto it = std::upper_bound(m_callbacks.begin(), m_callbacks.end(), time,
+        [](float value, const TimeCallback& callback) {
+            return value < callback.time;
+        });
+    if (isPassed(static_cast<size_t>(it - m_callbacks.begin()), m_nextCallback, time)) {
+        ++m_nextCallback;
+    }
+    m_callbacks.insert(it, timeCallback);
 }
 
 void Timeline::removeTimeCallback(float time) {
-    m_callbacks.erase(
-        std::remove_if(m_callbacks.begin(), m_callbacks.end(),
-            [time](const TimeCallback& callback) {
-                return callback.time == time;
-            }),
-        m_callbacks.end()
-    );
+    auto begin = std::lower_bound(m_callbacks.begin(), m_callbacks.end(), time,
+        [](const TimeCallback& callback, float value) {
+            return callback.time < value;
+        });
+    auto end = std::upper_bound(begin, m_callbacks.end(), time,
+        [](float value, const TimeCallback& callback) {
+            return value < callback.time;
+        });
+    
+    size_t first = static_cast<size_t>(begin - m_callbacks.begin());
+    size_t last = static_cast<size_t>(end - m_callbacks.begin());
+    if (m_nextCallback > first) {
+        m_nextCallback -= std::min(m_nextCallback, last) - first;
+    }
+    m_callbacks.erase(begin, end);
+}
+
+uint32_t Timeline::addIntervalCallback(float start, float end, TimelineCallback onEnter, TimelineCallback onExit) {
+    uint32_t handle;
+    if (!m_freeIntervals.empty()) {
+        handle = m_freeIntervals.back();
+        m_freeIntervals.pop_back();
+    } else {
+        handle = static_cast<uint32_t>(m_intervals.size());
+        m_intervals.push_back(IntervalCallback());
+    }
+    
+    IntervalCallback& interval = m_intervals[handle];
+    interval.start = start;
+    interval.end = std::max(start, end);
+    interval.onEnter = std::move(onEnter);
+    interval.onExit = std::move(onExit);
+    interval.activeSlot = 0;
+    interval.used = true;
+    interval.active = false;
+    
+    // Like time callbacks, a start or end behind the playhead has been passed,
+    // so an interval added around the current time is entered by a seek
+    size_t startPosition = findPosition(m_intervalStarts, interval.start, true,
+        [this](uint32_t h) { return m_intervals[h].start; });
+    if (isPassed(startPosition, m_nextStart, interval.start)) ++m_nextStart;
+    m_intervalStarts.insert(m_intervalStarts.begin() + startPosition, handle);
+    
+    size_t endPosition = findPosition(m_intervalEnds, interval.end, true,
+        [this](uint32_t h) { return m_intervals[h].end; });
+    if (isPassed(endPosition, m_nextEnd, interval.end)) ++m_nextEnd;
+    m_intervalEnds.insert(m_intervalEnds.begin() + endPosition, handle);
+    
+    m_intervalTreeDirty = true;
+    return handle;
+}
+
+void Timeline::removeIntervalCallback(uint32_t handle) {
+    if (handle >= m_intervals.size() || !m_intervals[handle].used) {
+        return;
+    }
+    
+    // Removal is not an exit, so onExit is not called
+    deactivateInterval(handle);
+    
+    auto unlink = [handle](std::vector<uint32_t>& handles, size_t& cursor) {
+        size_t position = static_cast<size_t>(std::find(handles.begin(), handles.end(), handle) - handles.begin());
+        if (position < cursor) --cursor;
+        handles.erase(handles.begin() + position);
+    };
+    unlink(m_intervalStarts, m_nextStart);
+    unlink(m_intervalEnds, m_nextEnd);
+    
+    IntervalCallback& interval = m_intervals[handle];
+    interval = IntervalCallback();
+    interval.used = false;
+    interval.active = false;
+    m_freeIntervals.push_back(handle);
+    m_intervalTreeDirty = true;
+}
+
+void Timeline::getActiveIntervals(std::vector<uint32_t>& handles) const {
+    handles.insert(handles.end(), m_activeIntervals.begin(), m_activeIntervals.end());
 }
 
 void Timeline::checkCallbacks() {
-    for (auto& callback : m_callbacks) {
-        if (m_currentTime >= callback.time && callback.callback) {
-            callback.callback(m_currentTime);
+    // Indices are re-checked every time round, as callbacks may add or
+    // remove others
+    while (m_nextCallback < m_callbacks.size() && m_callbacks[m_nextCallback].time <= m_currentTime) {
+        TimelineCallback callback = m_callbacks[m_nextCallback++].callback;
+        if (callback) {
+            callback(m_currentTime);
+        }
+    }
+    
+    // Entering first lets intervals that start and end within one update
+    // fire both callbacks
+    while (m_nextStart < m_intervalStarts.size() &&
+           m_intervals[m_intervalStarts[m_nextStart]].start <= m_currentTime) {
+        enterInterval(m_intervalStarts[m_nextStart++]);
+    }
+    while (m_nextEnd < m_intervalEnds.size() &&
+           m_intervals[m_intervalEnds[m_nextEnd]].end <= m_currentTime) {
+        exitInterval(m_intervalEnds[m_nextEnd++]);
+    }
+}
+
+void Timeline::seekCallbacks() {
+    float time = m_currentTime;
+    
+    // Everything at the new time is still due
+    auto callback = std::lower_bound(m_callbacks.begin(), m_callbacks.end(), time,
+        [](const TimeCallback& callback, float value) {
+            return callback.time < value;
+        });
+    m_nextCallback = static_cast<size_t>(callback - m_callbacks.begin());
+    m_nextStart = findPosition(m_intervalStarts, time, false,
+        [this](uint32_t h) { return m_intervals[h].start; });
+    m_nextEnd = findPosition(m_intervalEnds, time, false,
+        [this](uint32_t h) { return m_intervals[h].end; });
+    
+    if (m_intervalTreeDirty) {
+        std::vector<IntervalTree::Interval> intervals;
+        intervals.reserve(m_intervalStarts.size());
+        for (uint32_t handle : m_intervalStarts) {
+            intervals.push_back(IntervalTree::Interval{m_intervals[handle].start, m_intervals[handle].end, handle});
+        }
+        m_intervalTree.build(std::move(intervals));
+        m_intervalTreeDirty = false;
+    }
+    
+    // Intervals starting exactly at the new time are left to the start cursor
+    std::vector<uint32_t> stabbed;
+    m_intervalTree.stab(time, stabbed);
+    std::vector<uint32_t> entering;
+    for (uint32_t handle : stabbed) {
+        if (m_intervals[handle].start < time && !m_intervals[handle].active) {
+            entering.push_back(handle);
+        }
+    }
+    
+    // Exit what no longer contains the time, then enter what newly does
+    std::vector<uint32_t> active = m_activeIntervals;
+    for (uint32_t handle : active) {
+        const IntervalCallback& interval = m_intervals[handle];
+        if (interval.active && !(interval.start < time && time < interval.end)) {
+            exitInterval(handle);
+        }
+    }
+    for (uint32_t handle : entering) {
+        if (m_intervals[handle].used) {
+            enterInterval(handle);
         }
     }
 }
 
+void Timeline::enterInterval(uint32_t handle) {
+    IntervalCallback& interval = m_intervals[handle];
+    if (interval.active) {
+        return;
+    }
+    interval.active = true;
+    interval.activeSlot = static_cast<uint32_t>(m_activeIntervals.size());
+    m_activeIntervals.push_back(handle);
+    
+    TimelineCallback onEnter = interval.onEnter;
+    if (onEnter) {
+        onEnter(m_currentTime);
+    }
+}
+
+void Timeline::exitInterval(uint32_t handle) {
+    IntervalCallback& interval = m_intervals[handle];
+    if (!interval.active) {
+        return;
+    }
+    deactivateInterval(handle);
+    
+    TimelineCallback onExit = interval.onExit;
+    if (onExit) {
+        onExit(m_currentTime);
+    }
+}
+
+void Timeline::deactivateInterval(uint32_t handle) {
+    IntervalCallback& interval = m_intervals[handle];
+    if (!interval.active) {
+        return;
+    }
+    
+    // Swap the last active interval into the hole
+    interval.active = false;
+    uint32_t moved = m_activeIntervals.back();
+    m_activeIntervals[interval.activeSlot] = moved;
+    m_intervals[moved].activeSlot = interval.activeSlot;
+    m_activeIntervals.pop_back();
+}
+
+bool Timeline::isPassed(size_t position, size_t cursor, float time) const {
+    return position < cursor || (position == cursor && time < m_currentTime);
+}
+
 void Timeline::sortMarkers() {
     std::sort(m_markers.begin(), m_markers.end(),
         [](const Marker& a, const Marker& b) {
             return a.time < b.time;
         });
-} 
\ No newline at end of file
+}
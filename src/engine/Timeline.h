@@ -1,14 +1,27 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <functional>
 #include <string>
+#include "IntervalTree.h"
 
 /**
  * @brief Timeline class for managing animation timing and playback
  * 
  * The timeline controls the overall timing of animations, including
  * play/pause/reset functionality and time scaling.
+ * 
+ * Time callbacks are kept sorted by time, and a cursor marks the next one
+ * due, so each fires once when playback reaches its time and an update
+ * only looks at the callbacks it fires. Interval callbacks are entered
+ * and exited the same way, through cursors over their starts and ends.
+ * 
+ * Seeking, setCurrentTime(), moves the cursors by binary search. Callbacks
+ * behind the new time won't fire; those at it fire on the next update.
+ * The intervals that contain the new time are found in an interval tree
+ * and entered right away, and the ones left are exited, so a seek costs
+ * O(log n + k) for k intervals changing state.
  */
 class Timeline {
 public:
@@ -43,11 +56,20 @@ public:
     void addMarker(float time, const std::string& name);
     void removeMarker(const std::string& name);
     void jumpToMarker(const std::string& name);
+    bool getMarkerTime(const std::string& name, float& time) const;
     
     // Timeline events
     using TimelineCallback = std::function<void(float)>;
     void addTimeCallback(float time, TimelineCallback callback);
     void removeTimeCallback(float time);
+    
+    // Callbacks for a range [start, end); either may be empty. Returns a
+    // handle for removal; handles of removed intervals are reused.
+    uint32_t addIntervalCallback(float start, float end, TimelineCallback onEnter, TimelineCallback onExit);
+    void removeIntervalCallback(uint32_t handle);
+    
+    // Appends the handles of the intervals playback is inside of
+    void getActiveIntervals(std::vector<uint32_t>& handles) const;
 
 private:
     bool m_isPlaying;
@@ -66,10 +88,36 @@ private:
         TimelineCallback callback;
     };
     
+    struct IntervalCallback {
+        float start;
+        float end;
+        TimelineCallback onEnter;
+        TimelineCallback onExit;
+        uint32_t activeSlot;    // Position in m_activeIntervals while active
+        bool used;
+        bool active;
+    };
+    
     std::vector<Marker> m_markers;
-    std::vector<TimeCallback> m_callbacks;
+    std::vector<TimeCallback> m_callbacks;      // Sorted by time
+    size_t m_nextCallback;                      // First callback not yet due
+    
+    std::vector<IntervalCallback> m_intervals;  // Indexed by handle
+    std::vector<uint32_t> m_freeIntervals;
+    std::vector<uint32_t> m_intervalStarts;     // Handles sorted by start
+    std::vector<uint32_t> m_intervalEnds;       // Handles sorted by end
+    size_t m_nextStart;
+    size_t m_nextEnd;
+    std::vector<uint32_t> m_activeIntervals;
+    IntervalTree m_intervalTree;
+    bool m_intervalTreeDirty;
     
     // Helper methods
     void checkCallbacks();
+    void seekCallbacks();
+    void enterInterval(uint32_t handle);
+    void exitInterval(uint32_t handle);
+    void deactivateInterval(uint32_t handle);
+    bool isPassed(size_t position, size_t cursor, float time) const;
     void sortMarkers();
 }; 
\ No newline at end of file
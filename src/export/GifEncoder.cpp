@@ -0,0 +1,579 @@
+#include "GifEncoder.h"
+#include "../utils/JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// Packs RGB into 0x00BBGGRR for compact comparisons and hashing
+inline uint32_t packRGB(const uint8_t* pixel) {
+    return pixel[0] | (pixel[1] << 8) | (pixel[2] << 16);
+}
+
+// 15-bit histogram bin (5 bits per channel)
+inline int binOf(int r, int g, int b) {
+    return ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+}
+
+// Number of index bits a palette of the given size needs (GIF minimum is 1)
+int paletteBits(size_t colors) {
+    int bits = 1;
+    while ((1u << bits) < colors) ++bits;
+    return bits;
+}
+
+// ============================================================================
+// EXACT PALETTE (FAST PATH)
+// ============================================================================
+
+// Builds the palette directly when a frame has 256 colors or fewer.
+// Returns false as soon as a 257th color is seen.
+bool buildExactPalette(const std::vector<uint32_t>& colors, std::vector<uint32_t>& palette, std::vector<uint8_t>& indices) {
+    const uint32_t tableSize = 1024;  // Power of two, at most 25% full
+    const uint32_t empty = 0xFFFFFFFFu;
+    uint32_t keys[tableSize];
+    uint8_t values[tableSize];
+    std::fill(keys, keys + tableSize, empty);
+    
+    palette.clear();
+    indices.resize(colors.size());
+    
+    uint32_t lastColor = empty;
+    uint8_t lastIndex = 0;
+    
+    for (size_t i = 0; i < colors.size(); ++i) {
+        uint32_t color = colors[i];
+        
+        // Flat-color scenes repeat the same color along runs
+        if (color == lastColor) {
+            indices[i] = lastIndex;
+            continue;
+        }
+        
+        uint32_t slot = (color * 2654435761u) >> 22;
+        while (keys[slot] != empty && keys[slot] != color) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        
+        if (keys[slot] == empty) {
+            if (palette.size() == 256) return false;
+            keys[slot] = color;
+            values[slot] = static_cast<uint8_t>(palette.size());
+            palette.push_back(color);
+        }
+        
+        lastColor = color;
+        lastIndex = values[slot];
+        indices[i] = lastIndex;
+    }
+    return true;
+}
+
+// ============================================================================
+// MEDIAN CUT QUANTIZATION
+// ============================================================================
+
+struct ColorBox {
+    size_t begin;
+    size_t end;
+    int range;
+    int channel;
+};
+
+class MedianCutQuantizer {
+public:
+    explicit MedianCutQuantizer(const std::vector<uint32_t>& colors)
+        : m_count(32768, 0)
+        , m_sums(32768 * 3, 0)
+        , m_binToIndex(32768, -1) {
+        for (uint32_t color : colors) {
+            int r = color & 0xFF;
+            int g = (color >> 8) & 0xFF;
+            int b = (color >> 16) & 0xFF;
+            int bin = binOf(r, g, b);
+            if (m_count[bin]++ == 0) {
+                m_bins.push_back(static_cast<uint16_t>(bin));
+            }
+            m_sums[bin * 3 + 0] += r;
+            m_sums[bin * 3 + 1] += g;
+            m_sums[bin * 3 + 2] += b;
+        }
+        
+        buildPalette(256);
+    }
+    
+    const std::vector<uint32_t>& getPalette() const {
+        return m_palette;
+    }
+    
+    uint8_t map(int r, int g, int b) {
+        int bin = binOf(r, g, b);
+        if (m_binToIndex[bin] < 0) {
+            m_binToIndex[bin] = nearest(r, g, b);
+        }
+        return static_cast<uint8_t>(m_binToIndex[bin]);
+    }
+
+private:
+    std::vector<uint32_t> m_count;
+    std::vector<uint64_t> m_sums;
+    std::vector<uint16_t> m_bins;
+    std::vector<int16_t> m_binToIndex;
+    std::vector<uint32_t> m_palette;
+    
+    static int channelOf(uint16_t bin, int channel) {
+        return (bin >> (10 - channel * 5)) & 31;
+    }
+    
+    void measure(ColorBox& box) const {
+        int lo[3] = { 31, 31, 31 };
+        int hi[3] = { 0, 0, 0 };
+        for (size_t i = box.begin; i < box.end; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                int value = channelOf(m_bins[i], c);
+                lo[c] = std::min(lo[c], value);
+                hi[c] = std::max(hi[c], value);
+            }
+        }
+        box.channel = 0;
+        box.range = hi[0] - lo[0];
+        for (int c = 1; c < 3; ++c) {
+            if (hi[c] - lo[c] > box.range) {
+                box.range = hi[c] - lo[c];
+                box.channel = c;
+            }
+        }
+    }
+    
+    void buildPalette(size_t maxColors) {
+        std::vector<ColorBox> boxes;
+        ColorBox all = { 0, m_bins.size(), 0, 0 };
+        measure(all);
+        boxes.push_back(all);
+        
+        while (boxes.size() < maxColors) {
+            // Split the box with the widest channel range
+            auto widest = std::max_element(boxes.begin(), boxes.end(),
+                [](const ColorBox& a, const ColorBox& b) { return a.range < b.range; });
+            if (widest->range == 0) break;
+            
+            ColorBox box = *widest;
+            int channel = box.channel;
+            std::sort(m_bins.begin() + box.begin, m_bins.begin() + box.end,
+                [channel](uint16_t a, uint16_t b) { return channelOf(a, channel) < channelOf(b, channel); });
+            
+            uint64_t total = 0;
+            for (size_t i = box.begin; i < box.end; ++i) total += m_count[m_bins[i]];
+            
+            // Weighted median, keeping at least one bin on each side
+            uint64_t running = 0;
+            size_t split = box.begin + 1;
+            for (size_t i = box.begin; i < box.end - 1; ++i) {
+                running += m_count[m_bins[i]];
+                split = i + 1;
+                if (running * 2 >= total) break;
+            }
+            
+            ColorBox lower = { box.begin, split, 0, 0 };
+            ColorBox upper = { split, box.end, 0, 0 };
+            measure(lower);
+            measure(upper);
+            *widest = lower;
+            boxes.push_back(upper);
+        }
+        
+        // Each palette entry is the pixel-weighted mean of its box
+        m_palette.clear();
+        for (const auto& box : boxes) {
+            uint64_t count = 0;
+            uint64_t sum[3] = { 0, 0, 0 };
+            for (size_t i = box.begin; i < box.end; ++i) {
+                uint16_t bin = m_bins[i];
+                count += m_count[bin];
+                for (int c = 0; c < 3; ++c) sum[c] += m_sums[bin * 3 + c];
+                m_binToIndex[bin] = static_cast<int16_t>(m_palette.size());
+            }
+            if (count == 0) count = 1;
+            uint32_t r = static_cast<uint32_t>(sum[0] / count);
+            uint32_t g = static_cast<uint32_t>(sum[1] / count);
+            uint32_t b = static_cast<uint32_t>(sum[2] / count);
+            m_palette.push_back(r | (g << 8) | (b << 16));
+        }
+    }
+    
+    int16_t nearest(int r, int g, int b) const {
+        int best = 0;
+        int bestDistance = 1 << 30;
+        for (size_t i = 0; i < m_palette.size(); ++i) {
+            int dr = static_cast<int>(m_palette[i] & 0xFF) - r;
+            int dg = static_cast<int>((m_palette[i] >> 8) & 0xFF) - g;
+            int db = static_cast<int>((m_palette[i] >> 16) & 0xFF) - b;
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = static_cast<int>(i);
+            }
+        }
+        return static_cast<int16_t>(best);
+    }
+};
+
+// ============================================================================
+// LZW COMPRESSION
+// ============================================================================
+
+class LzwEncoder {
+public:
+    explicit LzwEncoder(std::vector<uint8_t>& output)
+        : m_output(output)
+        , m_bitBuffer(0)
+        , m_bitCount(0) {
+    }
+    
+    void encode(const std::vector<uint8_t>& indices, int minCodeSize) {
+        const int clearCode = 1 << minCodeSize;
+        const int endCode = clearCode + 1;
+        
+        int codeSize = minCodeSize + 1;
+        int maxCode = endCode;
+        resetDictionary();
+        writeCode(clearCode, codeSize);
+        
+        int current = -1;
+        for (uint8_t index : indices) {
+            if (current < 0) {
+                current = index;
+                continue;
+            }
+            
+            uint32_t key = (static_cast<uint32_t>(current) << 8) | index;
+            uint32_t slot = findSlot(key);
+            if (m_keys[slot] == key) {
+                current = m_codes[slot];
+                continue;
+            }
+            
+            writeCode(current, codeSize);
+            m_keys[slot] = key;
+            m_codes[slot] = static_cast<uint16_t>(++maxCode);
+            
+            if (maxCode >= (1 << codeSize)) {
+                ++codeSize;
+            }
+            if (maxCode == 4095) {
+                // Dictionary is full: start over
+                writeCode(clearCode, codeSize);
+                resetDictionary();
+                codeSize = minCodeSize + 1;
+                maxCode = endCode;
+            }
+            current = index;
+        }
+        
+        if (current >= 0) {
+            writeCode(current, codeSize);
+        }
+        writeCode(endCode, codeSize);
+        
+        if (m_bitCount > 0) {
+            m_output.push_back(static_cast<uint8_t>(m_bitBuffer & 0xFF));
+        }
+    }
+
+private:
+    static constexpr uint32_t kTableSize = 8192;  // Power of two, at most 50% full
+    static constexpr uint32_t kEmpty = 0xFFFFFFFFu;
+    
+    std::vector<uint8_t>& m_output;
+    uint32_t m_bitBuffer;
+    int m_bitCount;
+    uint32_t m_keys[kTableSize];
+    uint16_t m_codes[kTableSize];
+    
+    void resetDictionary() {
+        std::fill(m_keys, m_keys + kTableSize, kEmpty);
+    }
+    
+    uint32_t findSlot(uint32_t key) const {
+        uint32_t slot = (key * 2654435761u) >> 19;
+        while (m_keys[slot] != kEmpty && m_keys[slot] != key) {
+            slot = (slot + 1) & (kTableSize - 1);
+        }
+        return slot;
+    }
+    
+    void writeCode(int code, int codeSize) {
+        m_bitBuffer |= static_cast<uint32_t>(code) << m_bitCount;
+        m_bitCount += codeSize;
+        while (m_bitCount >= 8) {
+            m_output.push_back(static_cast<uint8_t>(m_bitBuffer & 0xFF));
+            m_bitBuffer >>= 8;
+            m_bitCount -= 8;
+        }
+    }
+};
+
+// Classic 4x4 Bayer matrix, values 0..15
+const int kBayer4x4[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+void writeShort(FILE* file, int value) {
+    fputc(value & 0xFF, file);
+    fputc((value >> 8) & 0xFF, file);
+}
+
+} // namespace
+
+// ============================================================================
+// GIF ENCODER
+// ============================================================================
+
+GifEncoder::GifEncoder(const GifOptions& options)
+    : m_options(options)
+    , m_file(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_fps(0)
+    , m_frameIndex(0)
+    , m_framesWritten(0) {
+}
+
+GifEncoder::~GifEncoder() {
+    close();
+}
+
+bool GifEncoder::open(const std::string& filename, int width, int height, int fps) {
+    if (m_file || width <= 0 || height <= 0 || width > 65535 || height > 65535 || fps <= 0) return false;
+    
+    m_file = fopen(filename.c_str(), "wb");
+    if (!m_file) {
+        std::cerr << "Failed to open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    
+    m_width = width;
+    m_height = height;
+    m_fps = fps;
+    m_frameIndex = 0;
+    m_framesWritten = 0;
+    m_previous.reset();
+    
+    // Header and logical screen descriptor (no global color table)
+    fwrite("GIF89a", 1, 6, m_file);
+    writeShort(m_file, width);
+    writeShort(m_file, height);
+    fputc(0x00, m_file);  // Flags
+    fputc(0x00, m_file);  // Background color index
+    fputc(0x00, m_file);  // Pixel aspect ratio
+    
+    // NETSCAPE2.0 application extension: loop forever
+    static const uint8_t loop[] = {
+        0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0',
+        0x03, 0x01, 0x00, 0x00, 0x00
+    };
+    fwrite(loop, 1, sizeof(loop), m_file);
+    return true;
+}
+
+bool GifEncoder::addFrame(const uint8_t* rgba, bool bottomUp, const std::vector<PixelRect>* damage) {
+    if (!m_file || !rgba) return false;
+    
+    // Copy the frame; the caller's buffer is reused for the next render
+    const size_t rowBytes = static_cast<size_t>(m_width) * 4;
+    auto pixels = std::make_shared<std::vector<uint8_t>>(rowBytes * m_height);
+    for (int y = 0; y < m_height; ++y) {
+        int sourceRow = bottomUp ? (m_height - 1 - y) : y;
+        memcpy(pixels->data() + y * rowBytes, rgba + sourceRow * rowBytes, rowBytes);
+    }
+    
+    // Spread rounding so the total duration matches fps exactly
+    int start = static_cast<int>(std::lround(m_frameIndex * 100.0 / m_fps));
+    int end = static_cast<int>(std::lround((m_frameIndex + 1) * 100.0 / m_fps));
+    ++m_frameIndex;
+    
+    // Pixels outside the damage match the previous frame, so only its
+    // bounding box needs comparing
+    PixelRect changed = { 0, 0, m_width, m_height };
+    if (damage && m_previous) {
+        changed = { m_width, m_height, 0, 0 };
+        for (const PixelRect& rect : *damage) {
+            changed.x0 = std::min(changed.x0, std::max(rect.x0, 0));
+            changed.y0 = std::min(changed.y0, std::max(rect.y0, 0));
+            changed.x1 = std::max(changed.x1, std::min(rect.x1, m_width));
+            changed.y1 = std::max(changed.y1, std::min(rect.y1, m_height));
+        }
+    }
+    
+    Pixels previous = m_previous;
+    int width = m_width;
+    int height = m_height;
+    bool dither = m_options.dither;
+    JobSystem& jobs = JobSystem::instance();
+    m_pending.push_back(jobs.submit([pixels, previous, width, height, changed, end, start, dither]() {
+        return encodeFrame(pixels, previous, width, height, changed, end - start, dither);
+    }));
+    m_previous = pixels;
+    
+    // Bound memory: keep a couple of frames in flight per thread
+    flush(m_options.threadCount > 0 ? m_options.threadCount : jobs.getThreadCount() * 2);
+    return true;
+}
+
+bool GifEncoder::close() {
+    if (!m_file) return true;
+    
+    flush(0);
+    fputc(0x3B, m_file);  // Trailer
+    bool ok = fclose(m_file) == 0;
+    
+    m_file = nullptr;
+    m_previous.reset();
+    return ok;
+}
+
+int GifEncoder::getFramesWritten() const {
+    return m_framesWritten;
+}
+
+void GifEncoder::flush(size_t maxPending) {
+    while (m_pending.size() > maxPending) {
+        EncodedFrame frame = m_pending.front().get();
+        m_pending.pop_front();
+        writeFrame(frame);
+    }
+}
+
+void GifEncoder::writeFrame(const EncodedFrame& frame) {
+    // Graphic control extension: leave the frame in place, no transparency
+    fputc(0x21, m_file);
+    fputc(0xF9, m_file);
+    fputc(0x04, m_file);
+    fputc(0x04, m_file);  // Disposal method 1 (do not dispose)
+    writeShort(m_file, frame.delay);
+    fputc(0x00, m_file);  // Transparent color index (unused)
+    fputc(0x00, m_file);
+    
+    // Image descriptor with a local color table
+    int bits = paletteBits(frame.palette.size() / 3);
+    fputc(0x2C, m_file);
+    writeShort(m_file, frame.x);
+    writeShort(m_file, frame.y);
+    writeShort(m_file, frame.width);
+    writeShort(m_file, frame.height);
+    fputc(0x80 | (bits - 1), m_file);
+    fwrite(frame.palette.data(), 1, frame.palette.size(), m_file);
+    
+    // Image data in sub-blocks of up to 255 bytes
+    fputc(frame.minCodeSize, m_file);
+    for (size_t offset = 0; offset < frame.data.size(); offset += 255) {
+        size_t length = std::min<size_t>(255, frame.data.size() - offset);
+        fputc(static_cast<int>(length), m_file);
+        fwrite(frame.data.data() + offset, 1, length, m_file);
+    }
+    fputc(0x00, m_file);
+    
+    ++m_framesWritten;
+}
+
+GifEncoder::EncodedFrame GifEncoder::encodeFrame(Pixels current, Pixels previous, int width, int height,
+                                                 const PixelRect& changed, int delay, bool dither) {
+    EncodedFrame frame;
+    frame.delay = delay;
+    
+    // Rectangle that changed since the previous frame, searched for only
+    // where it can be
+    int x0 = 0, y0 = 0, x1 = width - 1, y1 = height - 1;
+    if (previous) {
+        const uint8_t* a = current->data();
+        const uint8_t* b = previous->data();
+        const size_t rowBytes = static_cast<size_t>(width) * 4;
+        const size_t spanBytes = static_cast<size_t>(std::max(changed.x1 - changed.x0, 0)) * 4;
+        
+        x0 = width;
+        y0 = height;
+        x1 = -1;
+        y1 = -1;
+        for (int y = changed.y0; y < changed.y1 && spanBytes > 0; ++y) {
+            const uint8_t* rowA = a + y * rowBytes;
+            const uint8_t* rowB = b + y * rowBytes;
+            if (memcmp(rowA + changed.x0 * 4, rowB + changed.x0 * 4, spanBytes) == 0) continue;
+            
+            int left = changed.x0;
+            while (memcmp(rowA + left * 4, rowB + left * 4, 3) == 0 && left < changed.x1 - 1) ++left;
+            int right = changed.x1 - 1;
+            while (memcmp(rowA + right * 4, rowB + right * 4, 3) == 0 && right > left) --right;
+            
+            x0 = std::min(x0, left);
+            x1 = std::max(x1, right);
+            y0 = std::min(y0, y);
+            y1 = y;
+        }
+        
+        // Nothing changed: a single unchanged pixel keeps the frame's timing
+        if (x1 < 0) {
+            x0 = x1 = 0;
+            y0 = y1 = 0;
+        }
+    }
+    
+    frame.x = x0;
+    frame.y = y0;
+    frame.width = x1 - x0 + 1;
+    frame.height = y1 - y0 + 1;
+    
+    std::vector<uint32_t> colors;
+    colors.reserve(static_cast<size_t>(frame.width) * frame.height);
+    for (int y = y0; y <= y1; ++y) {
+        const uint8_t* row = current->data() + (static_cast<size_t>(y) * width + x0) * 4;
+        for (int x = 0; x < frame.width; ++x) {
+            colors.push_back(packRGB(row + x * 4));
+        }
+    }
+    
+    // Fast path: few enough colors to index exactly
+    std::vector<uint32_t> palette;
+    std::vector<uint8_t> indices;
+    if (!buildExactPalette(colors, palette, indices)) {
+        MedianCutQuantizer quantizer(colors);
+        palette = quantizer.getPalette();
+        indices.resize(colors.size());
+        
+        for (int y = 0; y < frame.height; ++y) {
+            for (int x = 0; x < frame.width; ++x) {
+                size_t i = static_cast<size_t>(y) * frame.width + x;
+                int r = colors[i] & 0xFF;
+                int g = (colors[i] >> 8) & 0xFF;
+                int b = (colors[i] >> 16) & 0xFF;
+                
+                if (dither) {
+                    // Offset by roughly one 5-bit quantization step
+                    int offset = (kBayer4x4[(y + y0) & 3][(x + x0) & 3] - 8) * 2;
+                    r = std::max(0, std::min(255, r + offset));
+                    g = std::max(0, std::min(255, g + offset));
+                    b = std::max(0, std::min(255, b + offset));
+                }
+                indices[i] = quantizer.map(r, g, b);
+            }
+        }
+    }
+    
+    // Local color table, padded to a power of two
+    int bits = paletteBits(palette.size());
+    frame.palette.assign(static_cast<size_t>(3) << bits, 0);
+    for (size_t i = 0; i < palette.size(); ++i) {
+        frame.palette[i * 3 + 0] = palette[i] & 0xFF;
+        frame.palette[i * 3 + 1] = (palette[i] >> 8) & 0xFF;
+        frame.palette[i * 3 + 2] = (palette[i] >> 16) & 0xFF;
+    }
+    
+    frame.minCodeSize = std::max(2, bits);
+    LzwEncoder lzw(frame.data);
+    lzw.encode(indices, frame.minCodeSize);
+    return frame;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../rendering/Framebuffer.h"
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Options for GIF export
+ */
+struct GifOptions {
+    bool dither = false;     // Ordered (Bayer 4x4) dithering for frames that need quantization
+    size_t threadCount = 0;  // Frames quantized and compressed at once, 0 = two per job system thread
+};
+
+/**
+ * @brief Native GIF89a writer with per-frame palettes
+ * 
+ * Each frame is cropped to the rectangle that changed since the previous
+ * frame, given its own local palette and LZW-compressed as a job on the
+ * engine's job system. Frames with 256 colors or fewer keep their exact
+ * colors and skip quantization; others are reduced with median cut.
+ * Compressed frames are written to the file strictly in submission order.
+ *
+ * A frame can come with the renderer's damage rectangles: the changed
+ * rectangle is then only searched for inside them, and a frame with no
+ * damage is stored as a single unchanged pixel without comparing it.
+ */
+class GifEncoder {
+public:
+    explicit GifEncoder(const GifOptions& options = GifOptions());
+    ~GifEncoder();
+
+    bool open(const std::string& filename, int width, int height, int fps);
+    // damage, in top-first rows, bounds where the frame differs from the last one
+    bool addFrame(const uint8_t* rgba, bool bottomUp = false, const std::vector<PixelRect>* damage = nullptr);
+    bool close();
+    
+    int getFramesWritten() const;
+
+private:
+    using Pixels = std::shared_ptr<std::vector<uint8_t>>;
+    
+    struct EncodedFrame {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        int delay = 0;                   // Centiseconds
+        int minCodeSize = 2;
+        std::vector<uint8_t> palette;    // RGB triplets, power-of-two entry count
+        std::vector<uint8_t> data;       // LZW code stream
+    };
+    
+    GifOptions m_options;
+    FILE* m_file;
+    int m_width;
+    int m_height;
+    int m_fps;
+    int m_frameIndex;
+    int m_framesWritten;
+    
+    std::deque<std::future<EncodedFrame>> m_pending;
+    Pixels m_previous;
+    
+    // Helper methods
+    static EncodedFrame encodeFrame(Pixels current, Pixels previous, int width, int height, const PixelRect& changed,
+                                    int delay, bool dither);
+    void writeFrame(const EncodedFrame& frame);
+    void flush(size_t maxPending);
+};
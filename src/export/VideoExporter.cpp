@@ -0,0 +1,201 @@
+#include "VideoExporter.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+VideoExporter::VideoExporter(size_t queueDepth)
+    : m_queueDepth(std::max<size_t>(1, queueDepth))
+    , m_width(0)
+    , m_height(0)
+    , m_nextIndex(0)
+    , m_isOpen(false)
+    , m_framesWritten(0)
+    , m_failed(false)
+    , m_hasConverted(false) {
+}
+
+VideoExporter::~VideoExporter() {
+    close();
+}
+
+bool VideoExporter::open(const std::string& filename, int width, int height, int fps) {
+    if (m_isOpen || width <= 0 || height <= 0 || fps <= 0) return false;
+    
+    m_sink = createVideoSink(filename);
+    if (!m_sink->open(filename, width, height, fps)) {
+        m_sink.reset();
+        return false;
+    }
+    
+    m_width = width;
+    m_height = height;
+    m_nextIndex = 0;
+    m_framesWritten = 0;
+    m_failed = false;
+    m_hasConverted = false;
+    
+    // Enough frames for every queue slot plus one being rendered and one being encoded
+    size_t poolSize = m_queueDepth + 2;
+    m_freeFrames = std::make_unique<BoundedQueue<VideoFrame*>>(poolSize);
+    m_capturedFrames = std::make_unique<BoundedQueue<VideoFrame*>>(m_queueDepth);
+    m_convertedFrames = std::make_unique<BoundedQueue<VideoFrame*>>(m_queueDepth);
+    
+    m_frames.clear();
+    for (size_t i = 0; i < poolSize; ++i) {
+        auto frame = std::make_unique<VideoFrame>();
+        frame->pixels.resize(static_cast<size_t>(width) * height * 4);
+        m_freeFrames->push(frame.get());
+        m_frames.push_back(std::move(frame));
+    }
+    
+    m_convertThread = std::thread(&VideoExporter::convertLoop, this);
+    m_encodeThread = std::thread(&VideoExporter::encodeLoop, this);
+    m_isOpen = true;
+    return true;
+}
+
+bool VideoExporter::close() {
+    if (!m_isOpen) return !m_failed;
+    
+    // Closing the first queue lets each stage drain and close the next one
+    m_capturedFrames->close();
+    m_convertThread.join();
+    m_encodeThread.join();
+    
+    if (!m_sink->close()) {
+        m_failed = true;
+    }
+    m_sink.reset();
+    m_isOpen = false;
+    return !m_failed;
+}
+
+bool VideoExporter::isOpen() const {
+    return m_isOpen;
+}
+
+VideoFrame* VideoExporter::acquireFrame() {
+    if (!m_isOpen) return nullptr;
+    
+    VideoFrame* frame = nullptr;
+    if (!m_freeFrames->pop(frame)) return nullptr;
+    
+    frame->bottomUp = false;
+    frame->hasDamage = false;
+    frame->index = m_nextIndex++;
+    return frame;
+}
+
+void VideoExporter::submitFrame(VideoFrame* frame) {
+    if (!m_isOpen || !frame) return;
+    m_capturedFrames->push(frame);
+}
+
+int VideoExporter::getFramesWritten() const {
+    return m_framesWritten;
+}
+
+bool VideoExporter::hasFailed() const {
+    return m_failed;
+}
+
+void VideoExporter::convertLoop() {
+    VideoFrame* frame = nullptr;
+    while (m_capturedFrames->pop(frame)) {
+        if (!m_failed) {
+            convertFrame(frame);
+        }
+        m_convertedFrames->push(frame);
+    }
+    m_convertedFrames->close();
+}
+
+void VideoExporter::encodeLoop() {
+    VideoFrame* frame = nullptr;
+    while (m_convertedFrames->pop(frame)) {
+        // Keep draining after a failure so the render thread never blocks on a dead sink
+        if (!m_failed) {
+            if (m_sink->writeFrame(frame->converted.data(), frame->converted.size())) {
+                ++m_framesWritten;
+            } else {
+                std::cerr << "Video export failed writing frame " << frame->index << std::endl;
+                m_failed = true;
+            }
+        }
+        m_freeFrames->push(frame);
+    }
+}
+
+void VideoExporter::convertFrame(VideoFrame* frame) {
+    if (!m_hasConverted || !frame->hasDamage) {
+        convertRegion(frame, PixelRect{ 0, 0, m_width, m_height });
+        m_hasConverted = true;
+    } else {
+        for (const PixelRect& rect : frame->damage) {
+            convertRegion(frame, rect);
+        }
+    }
+    frame->converted.assign(m_converted.begin(), m_converted.end());
+}
+
+void VideoExporter::convertRegion(const VideoFrame* frame, PixelRect region) {
+    region.x0 = std::max(region.x0, 0);
+    region.y0 = std::max(region.y0, 0);
+    region.x1 = std::min(region.x1, m_width);
+    region.y1 = std::min(region.y1, m_height);
+    if (region.x0 >= region.x1 || region.y0 >= region.y1) return;
+    
+    const size_t rowBytes = static_cast<size_t>(m_width) * 4;
+    auto sourceRow = [&](int y) {
+        int row = frame->bottomUp ? (m_height - 1 - y) : y;
+        return frame->pixels.data() + row * rowBytes;
+    };
+    
+    if (m_sink->getPixelFormat() == PixelFormat::RGBA) {
+        m_converted.resize(rowBytes * m_height);
+        const size_t spanBytes = static_cast<size_t>(region.x1 - region.x0) * 4;
+        for (int y = region.y0; y < region.y1; ++y) {
+            memcpy(m_converted.data() + y * rowBytes + region.x0 * 4, sourceRow(y) + region.x0 * 4, spanBytes);
+        }
+        return;
+    }
+    
+    // RGBA -> I420, BT.601 studio range, chroma averaged over 2x2 blocks
+    const int chromaWidth = (m_width + 1) / 2;
+    const int chromaHeight = (m_height + 1) / 2;
+    const size_t lumaSize = static_cast<size_t>(m_width) * m_height;
+    const size_t chromaSize = static_cast<size_t>(chromaWidth) * chromaHeight;
+    m_converted.resize(lumaSize + chromaSize * 2);
+    
+    uint8_t* yPlane = m_converted.data();
+    uint8_t* uPlane = yPlane + lumaSize;
+    uint8_t* vPlane = uPlane + chromaSize;
+    
+    for (int y = region.y0; y < region.y1; ++y) {
+        const uint8_t* src = sourceRow(y);
+        uint8_t* dst = yPlane + static_cast<size_t>(y) * m_width;
+        for (int x = region.x0; x < region.x1; ++x) {
+            int r = src[x * 4 + 0];
+            int g = src[x * 4 + 1];
+            int b = src[x * 4 + 2];
+            dst[x] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+    
+    // Every 2x2 block the region touches
+    for (int cy = region.y0 / 2; cy < (region.y1 + 1) / 2; ++cy) {
+        const uint8_t* row0 = sourceRow(cy * 2);
+        const uint8_t* row1 = sourceRow(std::min(cy * 2 + 1, m_height - 1));
+        for (int cx = region.x0 / 2; cx < (region.x1 + 1) / 2; ++cx) {
+            int x0 = cx * 2 * 4;
+            int x1 = std::min(cx * 2 + 1, m_width - 1) * 4;
+            int r = (row0[x0 + 0] + row0[x1 + 0] + row1[x0 + 0] + row1[x1 + 0] + 2) >> 2;
+            int g = (row0[x0 + 1] + row0[x1 + 1] + row1[x0 + 1] + row1[x1 + 1] + 2) >> 2;
+            int b = (row0[x0 + 2] + row0[x1 + 2] + row1[x0 + 2] + row1[x1 + 2] + 2) >> 2;
+            
+            size_t index = static_cast<size_t>(cy) * chromaWidth + cx;
+            uPlane[index] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[index] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "VideoSink.h"
+#include "../rendering/Framebuffer.h"
+#include "../utils/BoundedQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One captured frame travelling through the export pipeline
+ */
+struct VideoFrame {
+    std::vector<uint8_t> pixels;     // RGBA8 as captured from the renderer
+    std::vector<uint8_t> converted;  // Frame in the sink's pixel format
+    bool bottomUp = false;           // Rows are bottom-first (OpenGL readback)
+    std::vector<PixelRect> damage;   // Top-first regions that differ from the previous frame
+    bool hasDamage = false;          // False when the whole frame may have changed
+    int index = 0;
+};
+
+/**
+ * @brief Three-stage video export pipeline
+ * 
+ * The render thread captures into pooled frames; a conversion thread
+ * flips and converts them to the sink's pixel format; an encoder thread
+ * writes them to the sink in order. Stages are connected by bounded
+ * queues, so the renderer only waits when the whole pipeline is full.
+ *
+ * Frames that carry damage are only converted inside it: the conversion
+ * thread keeps the last converted frame and updates the damaged regions
+ * in place before handing a copy to the encoder.
+ * 
+ * Usage:
+ *   VideoExporter exporter;
+ *   exporter.open("out.mp4", 1200, 800, 30);
+ *   VideoFrame* frame = exporter.acquireFrame();
+ *   // ... fill frame->pixels ...
+ *   exporter.submitFrame(frame);
+ *   exporter.close();
+ */
+class VideoExporter {
+public:
+    VideoExporter(size_t queueDepth = 8);
+    ~VideoExporter();
+
+    // Pipeline control
+    bool open(const std::string& filename, int width, int height, int fps);
+    bool close();
+    bool isOpen() const;
+    
+    // Frame submission (render thread)
+    VideoFrame* acquireFrame();
+    void submitFrame(VideoFrame* frame);
+    
+    // Statistics
+    int getFramesWritten() const;
+    bool hasFailed() const;
+
+private:
+    size_t m_queueDepth;
+    int m_width;
+    int m_height;
+    int m_nextIndex;
+    bool m_isOpen;
+    
+    std::unique_ptr<VideoSink> m_sink;
+    std::vector<std::unique_ptr<VideoFrame>> m_frames;
+    
+    std::unique_ptr<BoundedQueue<VideoFrame*>> m_freeFrames;
+    std::unique_ptr<BoundedQueue<VideoFrame*>> m_capturedFrames;
+    std::unique_ptr<BoundedQueue<VideoFrame*>> m_convertedFrames;
+    
+    std::thread m_convertThread;
+    std::thread m_encodeThread;
+    
+    std::atomic<int> m_framesWritten;
+    std::atomic<bool> m_failed;
+    
+    // Last converted frame, owned by the conversion thread
+    std::vector<uint8_t> m_converted;
+    bool m_hasConverted;
+    
+    // Pipeline stages
+    void convertLoop();
+    void encodeLoop();
+    void convertFrame(VideoFrame* frame);
+    void convertRegion(const VideoFrame* frame, PixelRect region);
+};
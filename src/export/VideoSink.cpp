@@ -0,0 +1,214 @@
+#include "VideoSink.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define PIPE_WRITE_MODE "wb"
+#else
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+#define PIPE_WRITE_MODE "w"
+#endif
+
+namespace {
+
+// Quotes one argument so the shell passes it to ffmpeg unchanged
+bool quoteShellArgument(const std::string& argument, std::string& quoted) {
+#ifdef _WIN32
+    // cmd.exe has no way to escape a double quote inside a quoted argument
+    if (argument.find('"') != std::string::npos) return false;
+    quoted = "\"" + argument + "\"";
+#else
+    // Inside single quotes only the single quote itself needs care: close
+    // the quotes, emit an escaped quote and reopen them
+    quoted = "'";
+    for (char c : argument) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    quoted += "'";
+#endif
+    return true;
+}
+
+#ifndef _WIN32
+/**
+ * @brief Keeps SIGPIPE from killing the process while writing to ffmpeg
+ *
+ * When ffmpeg is missing or exits early the pipe has no reader and a write
+ * raises SIGPIPE, whose default action terminates us. The guard blocks the
+ * signal on the calling thread so the write fails with EPIPE instead, and
+ * discards a SIGPIPE left pending by the write before unblocking.
+ */
+class PipeSignalGuard {
+public:
+    PipeSignalGuard() {
+        sigemptyset(&m_pipeSignal);
+        sigaddset(&m_pipeSignal, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &m_pipeSignal, &m_previous);
+    }
+
+    ~PipeSignalGuard() {
+        // Leave a signal the caller had already blocked for the caller
+        if (!sigismember(&m_previous, SIGPIPE)) {
+            sigset_t pending;
+            if (sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE)) {
+                int signal = 0;
+                sigwait(&m_pipeSignal, &signal);
+            }
+        }
+        pthread_sigmask(SIG_SETMASK, &m_previous, nullptr);
+    }
+
+    PipeSignalGuard(const PipeSignalGuard&) = delete;
+    PipeSignalGuard& operator=(const PipeSignalGuard&) = delete;
+
+private:
+    sigset_t m_pipeSignal;
+    sigset_t m_previous;
+};
+#else
+// Windows has no SIGPIPE; writes to a closed pipe just fail
+struct PipeSignalGuard {};
+#endif
+
+} // namespace
+
+// ============================================================================
+// FFMPEG PIPE SINK
+// ============================================================================
+
+FFmpegSink::FFmpegSink()
+    : m_pipe(nullptr) {
+}
+
+FFmpegSink::~FFmpegSink() {
+    close();
+}
+
+bool FFmpegSink::open(const std::string& filename, int width, int height, int fps) {
+    std::string quotedFilename;
+    if (!quoteShellArgument(filename, quotedFilename)) {
+        std::cerr << "Cannot pass " << filename << " to ffmpeg: the name contains a quote" << std::endl;
+        return false;
+    }
+
+    std::string command = "ffmpeg -y -loglevel error"
+        " -f rawvideo -pix_fmt rgba"
+        " -s " + std::to_string(width) + "x" + std::to_string(height) +
+        " -r " + std::to_string(fps) +
+        " -i -"
+        " -pix_fmt yuv420p"
+        " " + quotedFilename;
+    
+    m_pipe = popen(command.c_str(), PIPE_WRITE_MODE);
+    if (!m_pipe) {
+        std::cerr << "Failed to start ffmpeg for " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool FFmpegSink::writeFrame(const uint8_t* data, size_t size) {
+    if (!m_pipe) return false;
+    PipeSignalGuard guard;
+    return fwrite(data, 1, size, m_pipe) == size;
+}
+
+bool FFmpegSink::close() {
+    if (!m_pipe) return true;
+    
+    int status;
+    {
+        // pclose flushes the last buffered frame, which can hit a dead pipe too
+        PipeSignalGuard guard;
+        status = pclose(m_pipe);
+    }
+    m_pipe = nullptr;
+#ifndef _WIN32
+    // popen succeeds even without ffmpeg; the shell then exits with 127
+    if (status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+        std::cerr << "ffmpeg was not found; install it or export to .y4m instead" << std::endl;
+        return false;
+    }
+#endif
+    if (status != 0) {
+        std::cerr << "ffmpeg exited with status " << status << std::endl;
+        return false;
+    }
+    return true;
+}
+
+PixelFormat FFmpegSink::getPixelFormat() const {
+    return PixelFormat::RGBA;
+}
+
+// ============================================================================
+// Y4M WRITER
+// ============================================================================
+
+Y4MSink::Y4MSink()
+    : m_file(nullptr) {
+}
+
+Y4MSink::~Y4MSink() {
+    close();
+}
+
+bool Y4MSink::open(const std::string& filename, int width, int height, int fps) {
+    m_file = fopen(filename.c_str(), "wb");
+    if (!m_file) {
+        std::cerr << "Failed to open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    
+    // Progressive, square pixels, 4:2:0 chroma
+    fprintf(m_file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+    return true;
+}
+
+bool Y4MSink::writeFrame(const uint8_t* data, size_t size) {
+    if (!m_file) return false;
+    
+    static const char frameHeader[] = "FRAME\n";
+    if (fwrite(frameHeader, 1, sizeof(frameHeader) - 1, m_file) != sizeof(frameHeader) - 1) return false;
+    return fwrite(data, 1, size, m_file) == size;
+}
+
+bool Y4MSink::close() {
+    if (!m_file) return true;
+    
+    bool ok = fclose(m_file) == 0;
+    m_file = nullptr;
+    return ok;
+}
+
+PixelFormat Y4MSink::getPixelFormat() const {
+    return PixelFormat::I420;
+}
+
+// ============================================================================
+// FACTORY
+// ============================================================================
+
+std::unique_ptr<VideoSink> createVideoSink(const std::string& filename) {
+    std::string extension;
+    size_t dot = filename.find_last_of('.');
+    if (dot != std::string::npos) {
+        extension = filename.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    }
+    
+    if (extension == "y4m") {
+        return std::make_unique<Y4MSink>();
+    }
+    return std::make_unique<FFmpegSink>();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Pixel layout a video sink expects for each frame
+ */
+enum class PixelFormat {
+    RGBA,   // 4 bytes per pixel, top row first
+    I420    // Planar Y, U, V with 2x2 subsampled chroma
+};
+
+/**
+ * @brief Destination for encoded video frames
+ * 
+ * A sink receives frames already converted to its pixel format and
+ * writes them in the order they arrive. Sinks are driven from a single
+ * encoder thread and do not need to be thread safe.
+ */
+class VideoSink {
+public:
+    virtual ~VideoSink() = default;
+
+    virtual bool open(const std::string& filename, int width, int height, int fps) = 0;
+    virtual bool writeFrame(const uint8_t* data, size_t size) = 0;
+    virtual bool close() = 0;
+    
+    virtual PixelFormat getPixelFormat() const = 0;
+};
+
+/**
+ * @brief Streams raw RGBA frames into a spawned ffmpeg process
+ * 
+ * ffmpeg must be on the PATH. The output container and codec are chosen
+ * by ffmpeg from the file extension (H.264 in yuv420p for .mp4/.mkv/.mov).
+ */
+class FFmpegSink : public VideoSink {
+public:
+    FFmpegSink();
+    ~FFmpegSink() override;
+
+    bool open(const std::string& filename, int width, int height, int fps) override;
+    bool writeFrame(const uint8_t* data, size_t size) override;
+    bool close() override;
+    
+    PixelFormat getPixelFormat() const override;
+
+private:
+    FILE* m_pipe;
+};
+
+/**
+ * @brief Built-in uncompressed YUV4MPEG2 (.y4m) writer
+ * 
+ * Needs no external tools; the output can be played directly or
+ * transcoded later.
+ */
+class Y4MSink : public VideoSink {
+public:
+    Y4MSink();
+    ~Y4MSink() override;
+
+    bool open(const std::string& filename, int width, int height, int fps) override;
+    bool writeFrame(const uint8_t* data, size_t size) override;
+    bool close() override;
+    
+    PixelFormat getPixelFormat() const override;
+
+private:
+    FILE* m_file;
+};
+
+// Picks the built-in writer for .y4m files and ffmpeg for everything else
+std::unique_ptr<VideoSink> createVideoSink(const std::string& filename);
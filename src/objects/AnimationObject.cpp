@@ -1,7 +1,15 @@
 #include "AnimationObject.h"
+#include "../engine/Scene.h"
 #include <iostream>
 #include <cmath>
 
+namespace {
+
+// Queue that notifications raised on this thread are deferred to, if any
+thread_local AnimationObject::DeferredQueue* t_deferredQueue = nullptr;
+
+} // namespace
+
 AnimationObject::AnimationObject(const std::string& name)
     : m_name(name)
     , m_position(0.0f, 0.0f, 0.0f)
@@ -18,8 +26,12 @@ AnimationObject::AnimationObject(const std::string& name)
     , m_friction(0.1f)
     , m_isStatic(false)
     , m_gravityAffected(false)
+    , m_fastMoving(false)
     , m_renderOrder(0)
     , m_layer(0)
+    , m_previousPosition(0.0f, 0.0f, 0.0f)
+    , m_interpolationAlpha(1.0f)
+    , m_renderPrimitive{RenderPrimitive::Custom, glm::vec2(0.0f), glm::vec2(0.0f), 1.0f, 1.0f}
     , m_scene(nullptr) {
 }
 
@@ -32,12 +44,16 @@ AnimationObject::~AnimationObject() {
 
 void AnimationObject::setPosition(float x, float y, float z) {
     m_position = glm::vec3(x, y, z);
+    m_previousPosition = m_position;
     notifyPositionChanged();
+    notifyBoundsChanged();
 }
 
 void AnimationObject::setPosition(const glm::vec3& position) {
     m_position = position;
+    m_previousPosition = m_position;
     notifyPositionChanged();
+    notifyBoundsChanged();
 }
 
 glm::vec3 AnimationObject::getPosition() const {
@@ -46,10 +62,12 @@ glm::vec3 AnimationObject::getPosition() const {
 
 void AnimationObject::setScale(float x, float y, float z) {
     m_scale = glm::vec3(x, y, z);
+    notifyBoundsChanged();
 }
 
 void AnimationObject::setScale(const glm::vec3& scale) {
     m_scale = scale;
+    notifyBoundsChanged();
 }
 
 glm::vec3 AnimationObject::getScale() const {
@@ -58,10 +76,12 @@ glm::vec3 AnimationObject::getScale() const {
 
 void AnimationObject::setRotation(float x, float y, float z) {
     m_rotation = glm::vec3(x, y, z);
+    notifyBoundsChanged();
 }
 
 void AnimationObject::setRotation(const glm::vec3& rotation) {
     m_rotation = rotation;
+    notifyBoundsChanged();
 }
 
 glm::vec3 AnimationObject::getRotation() const {
@@ -83,7 +103,11 @@ glm::vec4 AnimationObject::getColor() const {
 }
 
 void AnimationObject::setVisible(bool visible) {
+    if (m_visible == visible) return;
     m_visible = visible;
+    if (m_scene && !defer(DeferredNotification::VisibilityChanged)) {
+        m_scene->onVisibilityChanged(this);
+    }
 }
 
 bool AnimationObject::isVisible() const {
@@ -123,17 +147,28 @@ glm::mat4 AnimationObject::getTransformMatrix() const {
     return transform;
 }
 
+glm::mat4 AnimationObject::getRenderTransformMatrix() const {
+    // Translation is applied last, so it is the matrix's last column alone
+    glm::mat4 transform = getTransformMatrix();
+    transform[3] = glm::vec4(getRenderPosition(), 1.0f);
+    return transform;
+}
+
 void AnimationObject::translate(float x, float y, float z) {
     m_position += glm::vec3(x, y, z);
+    m_previousPosition = m_position;
     notifyPositionChanged();
+    notifyBoundsChanged();
 }
 
 void AnimationObject::rotate(float x, float y, float z) {
     m_rotation += glm::vec3(x, y, z);
+    notifyBoundsChanged();
 }
 
 void AnimationObject::scale(float x, float y, float z) {
     m_scale *= glm::vec3(x, y, z);
+    notifyBoundsChanged();
 }
 
 // ============================================================================
@@ -175,6 +210,8 @@ void AnimationObject::removeEventListener(EventType type, EventCallback callback
 }
 
 void AnimationObject::triggerEvent(EventType type) {
+    if (defer(DeferredNotification::Event, type)) return;
+    
     for (const auto& pair : m_eventCallbacks) {
         if (pair.first == type && pair.second) {
             pair.second(this, type);
@@ -182,6 +219,35 @@ void AnimationObject::triggerEvent(EventType type) {
     }
 }
 
+AnimationObject::DeferredQueue* AnimationObject::setDeferredQueue(DeferredQueue* queue) {
+    DeferredQueue* previous = t_deferredQueue;
+    t_deferredQueue = queue;
+    return previous;
+}
+
+void AnimationObject::replayDeferred(const DeferredQueue& queue) {
+    for (const auto& notification : queue) {
+        AnimationObject* obj = notification.object;
+        switch (notification.kind) {
+            case DeferredNotification::Event:
+                obj->triggerEvent(notification.event);
+                break;
+            case DeferredNotification::AnimationCallback:
+                if (obj->m_animationCallback) obj->m_animationCallback(obj->m_animationProgress);
+                break;
+            case DeferredNotification::BoundsChanged:
+                if (obj->m_scene) obj->m_scene->onBoundsChanged(obj);
+                break;
+            case DeferredNotification::VisibilityChanged:
+                if (obj->m_scene) obj->m_scene->onVisibilityChanged(obj);
+                break;
+            case DeferredNotification::RenderOrderChanged:
+                if (obj->m_scene) obj->m_scene->onRenderOrderChanged(obj);
+                break;
+        }
+    }
+}
+
 // ============================================================================
 // PHYSICS
 // ============================================================================
@@ -250,6 +316,14 @@ bool AnimationObject::isGravityAffected() const {
     return m_gravityAffected;
 }
 
+void AnimationObject::setFastMoving(bool fastMoving) {
+    m_fastMoving = fastMoving;
+}
+
+bool AnimationObject::isFastMoving() const {
+    return m_fastMoving;
+}
+
 // ============================================================================
 // COLLISION
 // ============================================================================
@@ -297,13 +371,17 @@ void AnimationObject::update(float deltaTime) {
     internalUpdate(deltaTime);
     
     // Call animation callback if set
-    if (m_animationCallback) {
+    if (m_animationCallback && !defer(DeferredNotification::AnimationCallback)) {
         m_animationCallback(m_animationProgress);
     }
 }
 
 void AnimationObject::setRenderOrder(int order) {
+    if (m_renderOrder == order) return;
     m_renderOrder = order;
+    if (m_scene && !defer(DeferredNotification::RenderOrderChanged)) {
+        m_scene->onRenderOrderChanged(this);
+    }
 }
 
 int AnimationObject::getRenderOrder() const {
@@ -311,13 +389,46 @@ int AnimationObject::getRenderOrder() const {
 }
 
 void AnimationObject::setLayer(int layer) {
+    if (m_layer == layer) return;
     m_layer = layer;
+    if (m_scene && !defer(DeferredNotification::RenderOrderChanged)) {
+        m_scene->onRenderOrderChanged(this);
+    }
 }
 
 int AnimationObject::getLayer() const {
     return m_layer;
 }
 
+const RenderPrimitive& AnimationObject::getRenderPrimitive() const {
+    return m_renderPrimitive;
+}
+
+void AnimationObject::setScene(Scene* scene) {
+    m_scene = scene;
+}
+
+Scene* AnimationObject::getScene() const {
+    return m_scene;
+}
+
+void AnimationObject::setPreviousPosition(const glm::vec3& position) {
+    m_previousPosition = position;
+    notifyBoundsChanged();
+}
+
+glm::vec3 AnimationObject::getPreviousPosition() const {
+    return m_previousPosition;
+}
+
+void AnimationObject::setInterpolationAlpha(float alpha) {
+    m_interpolationAlpha = std::max(0.0f, std::min(1.0f, alpha));
+}
+
+glm::vec3 AnimationObject::getRenderPosition() const {
+    return m_previousPosition + (m_position - m_previousPosition) * m_interpolationAlpha;
+}
+
 // ============================================================================
 // SERIALIZATION
 // ============================================================================
@@ -335,6 +446,22 @@ void AnimationObject::deserialize(std::istream& stream) {
     // Implementation would parse the stream and set properties
 }
 
+void AnimationObject::saveState(std::ostream& stream) const {
+    writeState(stream, m_animationProgress);
+}
+
+void AnimationObject::restoreState(std::istream& stream) {
+    readState(stream, m_animationProgress);
+}
+
+void AnimationObject::writeStateBytes(std::ostream& stream, const void* data, size_t size) {
+    stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+void AnimationObject::readStateBytes(std::istream& stream, void* data, size_t size) {
+    stream.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+}
+
 std::string AnimationObject::toJSON() const {
     // Basic JSON representation
     return "{\"name\":\"" + m_name + "\",\"type\":\"" + getTypeName() + "\"}";
@@ -380,10 +507,22 @@ std::string AnimationObject::getDebugInfo() const {
 // PROTECTED METHODS
 // ============================================================================
 
+bool AnimationObject::defer(DeferredNotification::Kind kind, EventType event) {
+    if (!t_deferredQueue) return false;
+    t_deferredQueue->push_back(DeferredNotification{this, kind, event});
+    return true;
+}
+
 void AnimationObject::notifyPositionChanged() {
     triggerEvent(EventType::PositionChanged);
 }
 
+void AnimationObject::notifyBoundsChanged() {
+    if (m_scene && !defer(DeferredNotification::BoundsChanged)) {
+        m_scene->onBoundsChanged(this);
+    }
+}
+
 void AnimationObject::notifyColorChanged() {
     triggerEvent(EventType::ColorChanged);
 }
@@ -10,6 +10,29 @@
 // Forward declarations
 class Scene;
 class AnimationEngine;
+class Renderer;
+
+/**
+ * @brief Batched shape that stands in for an object's render()
+ *
+ * Built-in shapes describe themselves with one of the renderer's batched
+ * primitives so Scene::render can submit them directly. Custom objects
+ * keep Kind::Custom and are drawn through their render() override.
+ */
+struct RenderPrimitive {
+    enum Kind {
+        Custom,
+        Circle,     // Unit circle placed by the transform matrix
+        Quad,       // Unit quad placed by the transform matrix
+        Line        // Segment between two world-space points
+    };
+
+    Kind kind;
+    glm::vec2 lineStart;
+    glm::vec2 lineEnd;
+    float lineThickness;    // In pixels
+    float opacity;          // Multiplied into the object's own opacity
+};
 
 /**
  * @brief Base class for all animation objects
@@ -17,7 +40,7 @@ class AnimationEngine;
  * This is the foundation of the Kalem animation system. All objects
  * (shapes, particles, text, etc.) inherit from this class.
  */
-class AnimationObject {
+class AnimationObject : public std::enable_shared_from_this<AnimationObject> {
 public:
     // ============================================================================
     // CONSTRUCTORS & DESTRUCTORS
@@ -66,8 +89,10 @@ public:
     // TRANSFORMATIONS
     // ============================================================================
     
-    // Transform matrix
+    // Transform matrix at the object's position, and the one drawing uses,
+    // which sits at the interpolated render position instead
     glm::mat4 getTransformMatrix() const;
+    glm::mat4 getRenderTransformMatrix() const;
     
     // Local transformations
     void translate(float x, float y, float z = 0.0f);
@@ -109,6 +134,29 @@ public:
     void removeEventListener(EventType type, EventCallback callback);
     void triggerEvent(EventType type);
     
+    // Deferred notifications. While a thread has a queue installed, event
+    // listeners, the animation callback and scene notifications raised on
+    // it are appended to the queue instead of run, so objects can update on
+    // worker threads. replayDeferred() runs them afterwards, in queue order.
+    struct DeferredNotification {
+        enum Kind : uint8_t {
+            Event,
+            AnimationCallback,
+            BoundsChanged,
+            VisibilityChanged,
+            RenderOrderChanged
+        };
+        
+        AnimationObject* object;
+        Kind kind;
+        EventType event;    // For Event
+    };
+    using DeferredQueue = std::vector<DeferredNotification>;
+    
+    // Installs a queue for the calling thread, nullptr for none, and returns the previous one
+    static DeferredQueue* setDeferredQueue(DeferredQueue* queue);
+    static void replayDeferred(const DeferredQueue& queue);
+    
     // ============================================================================
     // PHYSICS
     // ============================================================================
@@ -138,6 +186,10 @@ public:
     void setGravityAffected(bool affected);
     bool isGravityAffected() const;
     
+    // Always sweep this body between steps so it cannot tunnel
+    void setFastMoving(bool fastMoving);
+    bool isFastMoving() const;
+    
     // ============================================================================
     // COLLISION
     // ============================================================================
@@ -155,7 +207,7 @@ public:
     // ============================================================================
     
     // Render methods
-    virtual void render() = 0;
+    virtual void render(Renderer* renderer) = 0;
     virtual void update(float deltaTime);
     
     // Render properties
@@ -165,6 +217,21 @@ public:
     void setLayer(int layer);
     int getLayer() const;
     
+    const RenderPrimitive& getRenderPrimitive() const;
+    
+    // Scene the object was added to. The scene keeps a sorted render list
+    // and is told when the render order, layer or visibility changes.
+    void setScene(Scene* scene);
+    Scene* getScene() const;
+    
+    // Physics interpolation: drawing blends the previous physics step's
+    // position into the current one by alpha. Setting the position directly
+    // snaps the previous position to it.
+    void setPreviousPosition(const glm::vec3& position);
+    glm::vec3 getPreviousPosition() const;
+    void setInterpolationAlpha(float alpha);
+    glm::vec3 getRenderPosition() const;
+    
     // ============================================================================
     // SERIALIZATION
     // ============================================================================
@@ -177,6 +244,14 @@ public:
     virtual std::string toJSON() const;
     virtual void fromJSON(const std::string& json);
     
+    // Per-frame state that update() advances, such as the animation
+    // progress or a particle's age, in binary form. The engine saves it in
+    // its seek snapshots and restores it before re-simulating to the seek
+    // target. Properties only set from outside are left out, and physics
+    // state is saved by the physics engine.
+    virtual void saveState(std::ostream& stream) const;
+    virtual void restoreState(std::istream& stream);
+    
     // ============================================================================
     // UTILITY
     // ============================================================================
@@ -219,10 +294,14 @@ protected:
     float m_friction;
     bool m_isStatic;
     bool m_gravityAffected;
+    bool m_fastMoving;
     
     // Rendering
     int m_renderOrder;
     int m_layer;
+    glm::vec3 m_previousPosition;
+    float m_interpolationAlpha;
+    RenderPrimitive m_renderPrimitive;
     
     // Events
     std::vector<std::pair<EventType, EventCallback>> m_eventCallbacks;
@@ -234,13 +313,27 @@ protected:
     Scene* m_scene;
     
     // Helper methods
+    bool defer(DeferredNotification::Kind kind, EventType event = EventType::Created);
     void notifyPositionChanged();
+    void notifyBoundsChanged();     // Call after changing what the object covers on screen
     void notifyColorChanged();
     void notifyAnimationStarted();
     void notifyAnimationFinished();
     
     // Internal update
     virtual void internalUpdate(float deltaTime);
+    
+    // Raw copies of plain values for saveState() and restoreState()
+    template <typename T>
+    static void writeState(std::ostream& stream, const T& value) {
+        writeStateBytes(stream, &value, sizeof(T));
+    }
+    template <typename T>
+    static void readState(std::istream& stream, T& value) {
+        readStateBytes(stream, &value, sizeof(T));
+    }
+    static void writeStateBytes(std::ostream& stream, const void* data, size_t size);
+    static void readStateBytes(std::istream& stream, void* data, size_t size);
 };
 
 // ============================================================================
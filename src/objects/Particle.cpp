@@ -1,6 +1,5 @@
 #include "Particle.h"
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
+#include "../rendering/Renderer.h"
 #include <iostream>
 
 Particle::Particle(float x, float y, float mass)
@@ -13,6 +12,8 @@ Particle::Particle(float x, float y, float mass)
     setPosition(x, y, 0.0f);
     setMass(mass);
     setScale(m_radius, m_radius, 1.0f);
+    
+    m_renderPrimitive.kind = RenderPrimitive::Circle;
 }
 
 Particle::~Particle() {
@@ -29,6 +30,7 @@ float Particle::getRadius() const {
 
 void Particle::setLifetime(float lifetime) {
     m_lifetime = lifetime;
+    updateFade();
 }
 
 float Particle::getLifetime() const {
@@ -37,6 +39,7 @@ float Particle::getLifetime() const {
 
 void Particle::setAge(float age) {
     m_age = age;
+    updateFade();
 }
 
 float Particle::getAge() const {
@@ -59,43 +62,15 @@ float Particle::getAngularVelocity() const {
     return m_angularVelocity;
 }
 
-void Particle::render() {
-    if (!isVisible()) return;
-    
-    glPushMatrix();
-    
-    // Apply transformations
-    glm::mat4 transform = getTransformMatrix();
-    glLoadMatrixf(&transform[0][0]);
+void Particle::render(Renderer* renderer) {
+    if (!isVisible() || !renderer) return;
     
     // Set color with lifetime fade
     glm::vec4 color = getColor();
-    float alpha = color.a * getOpacity();
-    
-    // Fade out based on lifetime
-    if (m_lifetime > 0.0f) {
-        float lifeProgress = m_age / m_lifetime;
-        alpha *= (1.0f - lifeProgress);
-    }
-    
-    glColor4f(color.r, color.g, color.b, alpha);
+    color.a *= getOpacity() * m_renderPrimitive.opacity;
     
     // Draw particle as a circle
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex2f(0.0f, 0.0f);  // Center
-    
-    const int segments = 16;
-    for (int i = 0; i <= segments; ++i) {
-        float angle = 2.0f * M_PI * i / segments;
-        float x = cos(angle);
-        float y = sin(angle);
-        glVertex2f(x, y);
-    }
-    
-    glEnd();
-    
-    glPopMatrix();
-    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);  // Reset color
+    renderer->drawCircle(getRenderTransformMatrix(), color);
 }
 
 bool Particle::intersects(const AnimationObject* other) const {
@@ -167,6 +142,30 @@ void Particle::update(float deltaTime) {
     AnimationObject::update(deltaTime);
 }
 
+void Particle::saveState(std::ostream& stream) const {
+    AnimationObject::saveState(stream);
+    writeState(stream, m_velocity);
+    writeState(stream, m_rotation);
+    writeState(stream, m_age);
+    writeState(stream, m_visible);
+}
+
+void Particle::restoreState(std::istream& stream) {
+    AnimationObject::restoreState(stream);
+    
+    glm::vec3 velocity, rotation;
+    bool visible;
+    readState(stream, velocity);
+    readState(stream, rotation);
+    readState(stream, m_age);
+    readState(stream, visible);
+    
+    setVelocity(velocity);
+    setRotation(rotation);
+    setVisible(visible);
+    updateFade();
+}
+
 void Particle::updatePhysics(float deltaTime) {
     if (isStatic()) return;
     
@@ -192,5 +191,11 @@ void Particle::updateLifetime(float deltaTime) {
             setVisible(false);
             // Could trigger a destruction event here
         }
+        updateFade();
     }
+}
+
+void Particle::updateFade() {
+    // Fade out based on lifetime
+    m_renderPrimitive.opacity = m_lifetime > 0.0f ? 1.0f - m_age / m_lifetime : 1.0f;
 } 
\ No newline at end of file
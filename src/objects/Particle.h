@@ -35,7 +35,7 @@ public:
     float getAngularVelocity() const;
     
     // Rendering
-    void render() override;
+    void render(Renderer* renderer) override;
     
     // Collision detection
     bool intersects(const AnimationObject* other) const override;
@@ -53,6 +53,10 @@ public:
     
     // Update
     void update(float deltaTime) override;
+    
+    // Seeking: update() also drags the velocity, spins and ages the particle
+    void saveState(std::ostream& stream) const override;
+    void restoreState(std::istream& stream) override;
 
 private:
     float m_radius;
@@ -64,4 +68,5 @@ private:
     // Helper methods
     void updatePhysics(float deltaTime);
     void updateLifetime(float deltaTime);
+    void updateFade();
 }; 
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "ParticlePool.h"
+#include "../utils/Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Every kernel computes, per live particle:
+//   v' = (v + g * dt) * damping
+//   p' = p + v' * dt
+//   age' = age + dt,  radius' = radius + growth * dt
+//   opacity' = 1 - fade * clamp(age' / lifetime, 0, 1)
+// and leaves free slots untouched.
+
+void integrateScalar(ParticlePool& pool, size_t i, const glm::vec2& gravity, float damping,
+                     float growth, float fade, float deltaTime) {
+    float vx = (pool.velocityX[i] + gravity.x * deltaTime) * damping;
+    float vy = (pool.velocityY[i] + gravity.y * deltaTime) * damping;
+    pool.velocityX[i] = vx;
+    pool.velocityY[i] = vy;
+    pool.positionX[i] += vx * deltaTime;
+    pool.positionY[i] += vy * deltaTime;
+    pool.age[i] += deltaTime;
+    pool.radius[i] += growth * deltaTime;
+
+    float t = std::min(std::max(pool.age[i] / pool.lifetime[i], 0.0f), 1.0f);
+    pool.opacity[i] = 1.0f - fade * t;
+}
+
+#if defined(KALEM_SIMD_AVX2)
+
+void integrateAvx2(ParticlePool& pool, size_t i, __m256 mask, __m256 gravityX, __m256 gravityY,
+                   __m256 damping, __m256 growth, __m256 fade, __m256 deltaTime) {
+    __m256 vx = _mm256_loadu_ps(&pool.velocityX[i]);
+    __m256 vy = _mm256_loadu_ps(&pool.velocityY[i]);
+    __m256 px = _mm256_loadu_ps(&pool.positionX[i]);
+    __m256 py = _mm256_loadu_ps(&pool.positionY[i]);
+    __m256 age = _mm256_loadu_ps(&pool.age[i]);
+    __m256 radius = _mm256_loadu_ps(&pool.radius[i]);
+    __m256 opacity = _mm256_loadu_ps(&pool.opacity[i]);
+
+    __m256 newVx = _mm256_mul_ps(_mm256_add_ps(vx, _mm256_mul_ps(gravityX, deltaTime)), damping);
+    __m256 newVy = _mm256_mul_ps(_mm256_add_ps(vy, _mm256_mul_ps(gravityY, deltaTime)), damping);
+    __m256 newPx = _mm256_add_ps(px, _mm256_mul_ps(newVx, deltaTime));
+    __m256 newPy = _mm256_add_ps(py, _mm256_mul_ps(newVy, deltaTime));
+    __m256 newAge = _mm256_add_ps(age, deltaTime);
+    __m256 newRadius = _mm256_add_ps(radius, _mm256_mul_ps(growth, deltaTime));
+
+    __m256 t = _mm256_div_ps(newAge, _mm256_loadu_ps(&pool.lifetime[i]));
+    t = _mm256_min_ps(_mm256_max_ps(t, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    __m256 newOpacity = _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(fade, t));
+
+    _mm256_storeu_ps(&pool.velocityX[i], _mm256_blendv_ps(vx, newVx, mask));
+    _mm256_storeu_ps(&pool.velocityY[i], _mm256_blendv_ps(vy, newVy, mask));
+    _mm256_storeu_ps(&pool.positionX[i], _mm256_blendv_ps(px, newPx, mask));
+    _mm256_storeu_ps(&pool.positionY[i], _mm256_blendv_ps(py, newPy, mask));
+    _mm256_storeu_ps(&pool.age[i], _mm256_blendv_ps(age, newAge, mask));
+    _mm256_storeu_ps(&pool.radius[i], _mm256_blendv_ps(radius, newRadius, mask));
+    _mm256_storeu_ps(&pool.opacity[i], _mm256_blendv_ps(opacity, newOpacity, mask));
+}
+
+#elif defined(KALEM_SIMD_SSE2)
+
+__m128 select(__m128 mask, __m128 ifSet, __m128 ifClear) {
+    return _mm_or_ps(_mm_and_ps(mask, ifSet), _mm_andnot_ps(mask, ifClear));
+}
+
+void integrateSse2(ParticlePool& pool, size_t i, __m128 mask, __m128 gravityX, __m128 gravityY,
+                   __m128 damping, __m128 growth, __m128 fade, __m128 deltaTime) {
+    __m128 vx = _mm_loadu_ps(&pool.velocityX[i]);
+    __m128 vy = _mm_loadu_ps(&pool.velocityY[i]);
+    __m128 px = _mm_loadu_ps(&pool.positionX[i]);
+    __m128 py = _mm_loadu_ps(&pool.positionY[i]);
+    __m128 age = _mm_loadu_ps(&pool.age[i]);
+    __m128 radius = _mm_loadu_ps(&pool.radius[i]);
+    __m128 opacity = _mm_loadu_ps(&pool.opacity[i]);
+
+    __m128 newVx = _mm_mul_ps(_mm_add_ps(vx, _mm_mul_ps(gravityX, deltaTime)), damping);
+    __m128 newVy = _mm_mul_ps(_mm_add_ps(vy, _mm_mul_ps(gravityY, deltaTime)), damping);
+    __m128 newPx = _mm_add_ps(px, _mm_mul_ps(newVx, deltaTime));
+    __m128 newPy = _mm_add_ps(py, _mm_mul_ps(newVy, deltaTime));
+    __m128 newAge = _mm_add_ps(age, deltaTime);
+    __m128 newRadius = _mm_add_ps(radius, _mm_mul_ps(growth, deltaTime));
+
+    __m128 t = _mm_div_ps(newAge, _mm_loadu_ps(&pool.lifetime[i]));
+    t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    __m128 newOpacity = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(fade, t));
+
+    _mm_storeu_ps(&pool.velocityX[i], select(mask, newVx, vx));
+    _mm_storeu_ps(&pool.velocityY[i], select(mask, newVy, vy));
+    _mm_storeu_ps(&pool.positionX[i], select(mask, newPx, px));
+    _mm_storeu_ps(&pool.positionY[i], select(mask, newPy, py));
+    _mm_storeu_ps(&pool.age[i], select(mask, newAge, age));
+    _mm_storeu_ps(&pool.radius[i], select(mask, newRadius, radius));
+    _mm_storeu_ps(&pool.opacity[i], select(mask, newOpacity, opacity));
+}
+
+#endif
+
+} // namespace
+
+void ParticlePool::setCapacity(size_t capacity) {
+    m_capacity = capacity;
+    if (size() <= capacity) return;
+
+    for (size_t i = capacity; i < size(); ++i) {
+        if (alive[i] != 0.0f) --m_aliveCount;
+    }
+    for (auto* array : {&positionX, &positionY, &velocityX, &velocityY,
+                        &age, &lifetime, &radius, &opacity, &alive}) {
+        array->resize(capacity);
+    }
+    color.resize(capacity);
+    freeSlots.erase(std::remove_if(freeSlots.begin(), freeSlots.end(),
+                                   [capacity](uint32_t slot) { return slot >= capacity; }),
+                    freeSlots.end());
+}
+
+size_t ParticlePool::getCapacity() const {
+    return m_capacity;
+}
+
+size_t ParticlePool::size() const {
+    return alive.size();
+}
+
+size_t ParticlePool::getAliveCount() const {
+    return m_aliveCount;
+}
+
+void ParticlePool::clear() {
+    for (auto* array : {&positionX, &positionY, &velocityX, &velocityY,
+                        &age, &lifetime, &radius, &opacity, &alive}) {
+        array->clear();
+    }
+    color.clear();
+    freeSlots.clear();
+    m_aliveCount = 0;
+}
+
+bool ParticlePool::spawn(const glm::vec2& position, const glm::vec2& velocity, float particleLifetime,
+                         float particleRadius, const glm::vec4& particleColor) {
+    size_t i;
+    if (!freeSlots.empty()) {
+        i = freeSlots.back();
+        freeSlots.pop_back();
+    } else if (size() < m_capacity) {
+        i = size();
+        for (auto* array : {&positionX, &positionY, &velocityX, &velocityY,
+                            &age, &lifetime, &radius, &opacity, &alive}) {
+            array->push_back(0.0f);
+        }
+        color.push_back(glm::vec4(0.0f));
+    } else {
+        return false;
+    }
+
+    positionX[i] = position.x;
+    positionY[i] = position.y;
+    velocityX[i] = velocity.x;
+    velocityY[i] = velocity.y;
+    age[i] = 0.0f;
+    lifetime[i] = std::max(particleLifetime, std::numeric_limits<float>::min());
+    radius[i] = particleRadius;
+    opacity[i] = 1.0f;
+    alive[i] = 1.0f;
+    color[i] = particleColor;
+    ++m_aliveCount;
+    return true;
+}
+
+void ParticlePool::kill(size_t index) {
+    if (index >= size() || alive[index] == 0.0f) return;
+
+    alive[index] = 0.0f;
+    opacity[index] = 0.0f;
+    lifetime[index] = 1.0f;     // Keeps the kernels' division finite
+    freeSlots.push_back(static_cast<uint32_t>(index));
+    --m_aliveCount;
+}
+
+void ParticlePool::integrate(const glm::vec2& gravity, float damping, float growth, float fade,
+                             float deltaTime, size_t begin, size_t end) {
+    const size_t count = std::min(end, size());
+    size_t i = begin;
+
+#if defined(KALEM_SIMD_AVX2)
+    const __m256 gravityX8 = _mm256_set1_ps(gravity.x);
+    const __m256 gravityY8 = _mm256_set1_ps(gravity.y);
+    const __m256 damping8 = _mm256_set1_ps(damping);
+    const __m256 growth8 = _mm256_set1_ps(growth);
+    const __m256 fade8 = _mm256_set1_ps(fade);
+    const __m256 deltaTime8 = _mm256_set1_ps(deltaTime);
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 mask = _mm256_cmp_ps(_mm256_loadu_ps(&alive[i]), _mm256_setzero_ps(), _CMP_NEQ_OQ);
+        if (_mm256_movemask_ps(mask) == 0) continue;
+        integrateAvx2(*this, i, mask, gravityX8, gravityY8, damping8, growth8, fade8, deltaTime8);
+    }
+#elif defined(KALEM_SIMD_SSE2)
+    const __m128 gravityX4 = _mm_set1_ps(gravity.x);
+    const __m128 gravityY4 = _mm_set1_ps(gravity.y);
+    const __m128 damping4 = _mm_set1_ps(damping);
+    const __m128 growth4 = _mm_set1_ps(growth);
+    const __m128 fade4 = _mm_set1_ps(fade);
+    const __m128 deltaTime4 = _mm_set1_ps(deltaTime);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 mask = _mm_cmpneq_ps(_mm_loadu_ps(&alive[i]), _mm_setzero_ps());
+        if (_mm_movemask_ps(mask) == 0) continue;
+        integrateSse2(*this, i, mask, gravityX4, gravityY4, damping4, growth4, fade4, deltaTime4);
+    }
+#endif
+
+    // Remaining particles, or all of them without SIMD support
+    for (; i < count; ++i) {
+        if (alive[i] == 0.0f) continue;
+        integrateScalar(*this, i, gravity, damping, growth, fade, deltaTime);
+    }
+}
+
+void ParticlePool::collectExpired() {
+    const size_t count = size();
+    size_t i = 0;
+
+    // Most groups hold no expired particle, so test whole groups first
+#if defined(KALEM_SIMD_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        __m256 expired = _mm256_and_ps(
+            _mm256_cmp_ps(_mm256_loadu_ps(&age[i]), _mm256_loadu_ps(&lifetime[i]), _CMP_GE_OQ),
+            _mm256_cmp_ps(_mm256_loadu_ps(&alive[i]), _mm256_setzero_ps(), _CMP_NEQ_OQ));
+        int bits = _mm256_movemask_ps(expired);
+        for (int lane = 0; bits != 0; ++lane, bits >>= 1) {
+            if (bits & 1) kill(i + lane);
+        }
+    }
+#elif defined(KALEM_SIMD_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 expired = _mm_and_ps(
+            _mm_cmpge_ps(_mm_loadu_ps(&age[i]), _mm_loadu_ps(&lifetime[i])),
+            _mm_cmpneq_ps(_mm_loadu_ps(&alive[i]), _mm_setzero_ps()));
+        int bits = _mm_movemask_ps(expired);
+        for (int lane = 0; bits != 0; ++lane, bits >>= 1) {
+            if (bits & 1) kill(i + lane);
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (alive[i] != 0.0f && age[i] >= lifetime[i]) kill(i);
+    }
+}
+
+void ParticlePool::computeBounds(size_t begin, size_t end, glm::vec2& min, glm::vec2& max) const {
+    min = glm::vec2(std::numeric_limits<float>::max());
+    max = glm::vec2(std::numeric_limits<float>::lowest());
+
+    const size_t count = std::min(end, size());
+    for (size_t i = begin; i < count; ++i) {
+        if (alive[i] == 0.0f) continue;
+        float r = std::abs(radius[i]);
+        min = glm::min(min, glm::vec2(positionX[i] - r, positionY[i] - r));
+        max = glm::max(max, glm::vec2(positionX[i] + r, positionY[i] + r));
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Structure-of-arrays storage for the particles of a ParticleSystem
+ *
+ * Every array is indexed by slot. Slots grow up to the capacity and are
+ * never compacted: dead particles hand their slot to a free list and the
+ * next spawn takes the most recently freed one, so indices stay stable
+ * while a particle lives. Free slots have alive and opacity at 0 and are
+ * skipped by the kernels and by rendering.
+ */
+struct ParticlePool {
+    // State
+    std::vector<float> positionX, positionY;
+    std::vector<float> velocityX, velocityY;
+    std::vector<float> age;
+    std::vector<float> lifetime;        // Seconds, always positive for live particles
+    std::vector<float> radius;
+    std::vector<float> opacity;         // Lifetime fade, written by integrate()
+    std::vector<float> alive;           // 1 for live particles, else 0
+    std::vector<glm::vec4> color;
+
+    std::vector<uint32_t> freeSlots;
+
+    void setCapacity(size_t capacity);  // Kills every particle past the new capacity
+    size_t getCapacity() const;
+    size_t size() const;                // Slots handed out so far, live or free
+    size_t getAliveCount() const;
+    void clear();
+
+    // Returns false, spawning nothing, when every slot is taken
+    bool spawn(const glm::vec2& position, const glm::vec2& velocity, float lifetime,
+               float radius, const glm::vec4& color);
+    void kill(size_t index);
+
+    /**
+     * @brief Advances the live particles in [begin, end) by one step
+     *
+     * Per live particle: v' = (v + gravity * dt) * damping, p' = p + v' * dt,
+     * the age grows by dt and the radius by growth * dt, and opacity becomes
+     * 1 - fade * clamp(age / lifetime, 0, 1). Groups of slots with no live
+     * particle are skipped with a single compare. Particles are
+     * independent, so disjoint ranges can run on different threads.
+     */
+    void integrate(const glm::vec2& gravity, float damping, float growth, float fade,
+                   float deltaTime, size_t begin, size_t end);
+
+    // Frees every particle whose age reached its lifetime
+    void collectExpired();
+
+    // Box around the live particles in [begin, end); min > max when none
+    void computeBounds(size_t begin, size_t end, glm::vec2& min, glm::vec2& max) const;
+
+private:
+    size_t m_capacity = 0;
+    size_t m_aliveCount = 0;
+};
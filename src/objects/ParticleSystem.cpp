@@ -0,0 +1,287 @@
+#include "ParticleSystem.h"
+#include "../rendering/Renderer.h"
+#include "../utils/JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// Particles per update job; large enough that a chunk outweighs its scheduling
+const size_t kParticleGrain = 16384;
+
+} // namespace
+
+ParticleSystem::ParticleSystem(float x, float y, size_t maxParticles)
+    : AnimationObject("ParticleSystem")
+    , m_gravity(0.0f, 0.0f)
+    , m_drag(0.0f)
+    , m_growth(0.0f)
+    , m_fadeOut(true)
+    , m_random(5489u)
+    , m_boundsMin(x, y)
+    , m_boundsMax(x, y) {
+    setPosition(x, y, 0.0f);
+    m_pool.setCapacity(maxParticles);
+}
+
+ParticleSystem::~ParticleSystem() {
+}
+
+size_t ParticleSystem::addEmitter(const ParticleEmitter& emitter) {
+    m_emitters.push_back(emitter);
+    m_spawnCarry.push_back(0.0f);
+    return m_emitters.size() - 1;
+}
+
+ParticleEmitter& ParticleSystem::getEmitter(size_t index) {
+    return m_emitters.at(index);
+}
+
+const ParticleEmitter& ParticleSystem::getEmitter(size_t index) const {
+    return m_emitters.at(index);
+}
+
+size_t ParticleSystem::getEmitterCount() const {
+    return m_emitters.size();
+}
+
+void ParticleSystem::clearEmitters() {
+    m_emitters.clear();
+    m_spawnCarry.clear();
+}
+
+void ParticleSystem::burst(size_t emitter, size_t count) {
+    if (emitter < m_emitters.size()) {
+        spawn(m_emitters[emitter], count);
+    }
+}
+
+void ParticleSystem::setMaxParticles(size_t maxParticles) {
+    m_pool.setCapacity(maxParticles);
+}
+
+size_t ParticleSystem::getMaxParticles() const {
+    return m_pool.getCapacity();
+}
+
+size_t ParticleSystem::getParticleCount() const {
+    return m_pool.getAliveCount();
+}
+
+void ParticleSystem::clearParticles() {
+    m_pool.clear();
+    for (float& carry : m_spawnCarry) carry = 0.0f;
+    glm::vec3 position = getPosition();
+    m_boundsMin = m_boundsMax = glm::vec2(position);
+    notifyBoundsChanged();
+}
+
+const ParticlePool& ParticleSystem::getPool() const {
+    return m_pool;
+}
+
+void ParticleSystem::setGravity(const glm::vec2& gravity) {
+    m_gravity = gravity;
+}
+
+glm::vec2 ParticleSystem::getGravity() const {
+    return m_gravity;
+}
+
+void ParticleSystem::setDrag(float drag) {
+    m_drag = std::max(0.0f, drag);
+}
+
+float ParticleSystem::getDrag() const {
+    return m_drag;
+}
+
+void ParticleSystem::setGrowth(float growth) {
+    m_growth = growth;
+}
+
+float ParticleSystem::getGrowth() const {
+    return m_growth;
+}
+
+void ParticleSystem::setFadeOut(bool fadeOut) {
+    m_fadeOut = fadeOut;
+}
+
+bool ParticleSystem::isFadeOut() const {
+    return m_fadeOut;
+}
+
+void ParticleSystem::setSeed(uint32_t seed) {
+    m_random.seed(seed);
+}
+
+void ParticleSystem::render(Renderer* renderer) {
+    if (!isVisible() || !renderer || m_pool.getAliveCount() == 0) return;
+
+    glm::vec4 tint = getColor();
+    tint.a *= getOpacity() * m_renderPrimitive.opacity;
+    if (tint.a <= 0.0f) return;
+
+    renderer->drawCircles(getParticleTransform(), m_pool.positionX.data(), m_pool.positionY.data(),
+                          m_pool.radius.data(), m_pool.color.data(), m_pool.opacity.data(), m_pool.size(), tint);
+}
+
+glm::vec3 ParticleSystem::getMinBounds() const {
+    glm::vec2 min, max;
+    getTransformedBounds(min, max);
+    return glm::vec3(min, getPosition().z);
+}
+
+glm::vec3 ParticleSystem::getMaxBounds() const {
+    glm::vec2 min, max;
+    getTransformedBounds(min, max);
+    return glm::vec3(max, getPosition().z);
+}
+
+std::shared_ptr<AnimationObject> ParticleSystem::clone() const {
+    glm::vec3 position = getPosition();
+    auto system = std::make_shared<ParticleSystem>(position.x, position.y, getMaxParticles());
+    system->setColor(getColor());
+    system->setScale(getScale());
+    system->setRotation(getRotation());
+    system->setVisible(isVisible());
+    system->setOpacity(getOpacity());
+    system->m_emitters = m_emitters;
+    system->m_spawnCarry.assign(m_emitters.size(), 0.0f);
+    system->m_gravity = m_gravity;
+    system->m_drag = m_drag;
+    system->m_growth = m_growth;
+    system->m_fadeOut = m_fadeOut;
+    return system;
+}
+
+std::string ParticleSystem::getTypeName() const {
+    return "ParticleSystem";
+}
+
+void ParticleSystem::update(float deltaTime) {
+    if (deltaTime > 0.0f) {
+        // Emit what each emitter owes for this step, carrying the fraction
+        for (size_t e = 0; e < m_emitters.size(); ++e) {
+            const ParticleEmitter& emitter = m_emitters[e];
+            if (!emitter.enabled || emitter.rate <= 0.0f) continue;
+
+            float owed = m_spawnCarry[e] + emitter.rate * deltaTime;
+            float whole = std::floor(owed);
+            m_spawnCarry[e] = owed - whole;
+            spawn(emitter, static_cast<size_t>(whole));
+        }
+
+        // Integrate and bound each chunk in parallel, then merge the bounds.
+        // They still cover particles expiring in this step, which is harmless.
+        const float damping = std::max(0.0f, 1.0f - m_drag * deltaTime);
+        const float fade = m_fadeOut ? 1.0f : 0.0f;
+        const size_t count = m_pool.size();
+        m_chunkBounds.resize(2 * ((count + kParticleGrain - 1) / kParticleGrain));
+
+        JobSystem::instance().parallelFor(count, kParticleGrain, [&](size_t begin, size_t end) {
+            m_pool.integrate(m_gravity, damping, m_growth, fade, deltaTime, begin, end);
+            size_t chunk = begin / kParticleGrain;
+            m_pool.computeBounds(begin, end, m_chunkBounds[2 * chunk], m_chunkBounds[2 * chunk + 1]);
+        });
+
+        m_pool.collectExpired();
+
+        glm::vec2 boundsMin(std::numeric_limits<float>::max());
+        glm::vec2 boundsMax(std::numeric_limits<float>::lowest());
+        for (size_t chunk = 0; chunk + 1 < m_chunkBounds.size(); chunk += 2) {
+            boundsMin = glm::min(boundsMin, m_chunkBounds[chunk]);
+            boundsMax = glm::max(boundsMax, m_chunkBounds[chunk + 1]);
+        }
+        if (boundsMin.x > boundsMax.x) {
+            boundsMin = boundsMax = glm::vec2(getPosition());
+        }
+        if (boundsMin != m_boundsMin || boundsMax != m_boundsMax) {
+            m_boundsMin = boundsMin;
+            m_boundsMax = boundsMax;
+            notifyBoundsChanged();
+        }
+    }
+
+    AnimationObject::update(deltaTime);
+}
+
+void ParticleSystem::saveState(std::ostream& stream) const {
+    AnimationObject::saveState(stream);
+    
+    size_t emitterCount = m_spawnCarry.size();
+    writeState(stream, emitterCount);
+    writeStateBytes(stream, m_spawnCarry.data(), emitterCount * sizeof(float));
+    
+    // The standard only guarantees the engine's text form round-trips
+    std::ostringstream random;
+    random << m_random;
+    std::string text = random.str();
+    size_t length = text.size();
+    writeState(stream, length);
+    writeStateBytes(stream, text.data(), length);
+}
+
+void ParticleSystem::restoreState(std::istream& stream) {
+    AnimationObject::restoreState(stream);
+    clearParticles();
+    
+    size_t emitterCount = 0;
+    readState(stream, emitterCount);
+    std::vector<float> carry(emitterCount);
+    readStateBytes(stream, carry.data(), emitterCount * sizeof(float));
+    if (emitterCount == m_spawnCarry.size()) {
+        m_spawnCarry = carry;
+    }
+    
+    size_t length = 0;
+    readState(stream, length);
+    std::string text(length, '\0');
+    readStateBytes(stream, &text[0], length);
+    std::istringstream random(text);
+    random >> m_random;
+}
+
+glm::mat4 ParticleSystem::getParticleTransform() const {
+    // Scale and rotate about the system's position; particles already hold
+    // their world position, so the translation cancels out
+    return getTransformMatrix() * glm::translate(glm::mat4(1.0f), -getPosition());
+}
+
+void ParticleSystem::getTransformedBounds(glm::vec2& min, glm::vec2& max) const {
+    glm::mat4 transform = getParticleTransform();
+    min = glm::vec2(std::numeric_limits<float>::max());
+    max = glm::vec2(std::numeric_limits<float>::lowest());
+    for (int corner = 0; corner < 4; ++corner) {
+        glm::vec2 point((corner & 1) ? m_boundsMax.x : m_boundsMin.x,
+                        (corner & 2) ? m_boundsMax.y : m_boundsMin.y);
+        glm::vec2 placed(transform * glm::vec4(point, 0.0f, 1.0f));
+        min = glm::min(min, placed);
+        max = glm::max(max, placed);
+    }
+}
+
+void ParticleSystem::spawn(const ParticleEmitter& emitter, size_t count) {
+    const glm::vec2 origin = glm::vec2(getPosition()) + emitter.position;
+    const float heading = std::atan2(emitter.direction.y, emitter.direction.x);
+    const float spread = glm::radians(emitter.spread);
+
+    for (size_t i = 0; i < count; ++i) {
+        float angle = heading + randomRange(-spread, spread);
+        float speed = randomRange(emitter.minSpeed, emitter.maxSpeed);
+        glm::vec2 velocity(std::cos(angle) * speed, std::sin(angle) * speed);
+
+        if (!m_pool.spawn(origin, velocity, randomRange(emitter.minLifetime, emitter.maxLifetime),
+                          randomRange(emitter.minRadius, emitter.maxRadius), emitter.color)) {
+            break;  // Pool is full; the rest of this step's particles are dropped
+        }
+    }
+}
+
+float ParticleSystem::randomRange(float min, float max) {
+    if (max <= min) return min;
+    return std::uniform_real_distribution<float>(min, max)(m_random);
+}
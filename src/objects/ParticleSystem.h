@@ -0,0 +1,130 @@
+#pragma once
+
+#include "AnimationObject.h"
+#include "ParticlePool.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Spawn settings for one source of particles in a ParticleSystem
+ *
+ * Each new particle leaves position (relative to the system) in a random
+ * direction within spread degrees either side of direction, with speed,
+ * lifetime and radius drawn uniformly from their ranges.
+ */
+struct ParticleEmitter {
+    glm::vec2 position = glm::vec2(0.0f);
+    float rate = 100.0f;                    // Particles per second
+    glm::vec2 direction = glm::vec2(0.0f, 1.0f);
+    float spread = 180.0f;                  // Degrees either side of direction
+    float minSpeed = 20.0f, maxSpeed = 50.0f;
+    float minLifetime = 1.0f, maxLifetime = 2.0f;
+    float minRadius = 2.0f, maxRadius = 4.0f;
+    glm::vec4 color = glm::vec4(1.0f);
+    bool enabled = true;
+};
+
+/**
+ * @brief Many short-lived particles updated and drawn as a single object
+ *
+ * Unlike Particle, which is a full AnimationObject per particle, the
+ * particles of a system are plain entries in a ParticlePool: integrated
+ * with SIMD kernels across the job system, recycled through a free list
+ * and submitted to the renderer as one batch of circles. That keeps a
+ * million particles interactive.
+ *
+ * Particles live in world space, so moving the system moves its emitters
+ * but leaves particles already in flight alone. The system's scale and
+ * rotation apply about its position to every particle when drawing, in
+ * flight or not, and its bounds follow them. Particles ignore collisions and
+ * the physics engine; the system's own gravity and drag move them, and
+ * they fade out over their lifetime unless fading is turned off. The
+ * system's color and opacity tint every particle.
+ *
+ * Seek snapshots keep the emitters' spawn timing and the random sequence
+ * but not the live particles, which would make every snapshot as large as
+ * the pool. A seek empties the pool at the snapshot before the target and
+ * re-simulates from there, so only particles spawned since that snapshot
+ * are back; older ones return as the emitters refill the system.
+ */
+class ParticleSystem : public AnimationObject {
+public:
+    ParticleSystem(float x, float y, size_t maxParticles = 100000);
+    virtual ~ParticleSystem();
+
+    // Emitters
+    size_t addEmitter(const ParticleEmitter& emitter);
+    ParticleEmitter& getEmitter(size_t index);
+    const ParticleEmitter& getEmitter(size_t index) const;
+    size_t getEmitterCount() const;
+    void clearEmitters();
+
+    // Spawns count particles from an emitter at once, whether it is enabled or not
+    void burst(size_t emitter, size_t count);
+
+    // Pool
+    void setMaxParticles(size_t maxParticles);
+    size_t getMaxParticles() const;
+    size_t getParticleCount() const;
+    void clearParticles();
+    const ParticlePool& getPool() const;
+
+    // Motion
+    void setGravity(const glm::vec2& gravity);
+    glm::vec2 getGravity() const;
+
+    void setDrag(float drag);       // Fraction of velocity lost per second
+    float getDrag() const;
+
+    void setGrowth(float growth);   // Radius change per second
+    float getGrowth() const;
+
+    void setFadeOut(bool fadeOut);
+    bool isFadeOut() const;
+
+    // Seeds the random source for spawn directions and ranges
+    void setSeed(uint32_t seed);
+
+    // Rendering
+    void render(Renderer* renderer) override;
+
+    // Bounding box of the drawn particles, or the system's position when empty
+    glm::vec3 getMinBounds() const override;
+    glm::vec3 getMaxBounds() const override;
+
+    // Cloning copies emitters and settings but no particles
+    std::shared_ptr<AnimationObject> clone() const override;
+
+    // Type information
+    std::string getTypeName() const override;
+
+    // Update
+    void update(float deltaTime) override;
+    
+    // Seeking; restoring empties the pool
+    void saveState(std::ostream& stream) const override;
+    void restoreState(std::istream& stream) override;
+
+private:
+    ParticlePool m_pool;
+    std::vector<ParticleEmitter> m_emitters;
+    std::vector<float> m_spawnCarry;    // Fraction of a particle owed per emitter
+
+    glm::vec2 m_gravity;
+    float m_drag;
+    float m_growth;
+    bool m_fadeOut;
+
+    std::mt19937 m_random;
+
+    glm::vec2 m_boundsMin;
+    glm::vec2 m_boundsMax;
+    std::vector<glm::vec2> m_chunkBounds;   // Min and max per update chunk
+
+    glm::mat4 getParticleTransform() const;
+    void getTransformedBounds(glm::vec2& min, glm::vec2& max) const;
+    void spawn(const ParticleEmitter& emitter, size_t count);
+    float randomRange(float min, float max);
+};
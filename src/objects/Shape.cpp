@@ -1,6 +1,5 @@
 #include "Shape.h"
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
+#include "../rendering/Renderer.h"
 #include <iostream>
 #include <cmath>
 
@@ -78,6 +77,7 @@ Circle::Circle(float x, float y, float radius)
     , m_radius(radius) {
     setPosition(x, y, 0.0f);
     setSize(radius * 2.0f, radius * 2.0f);
+    m_renderPrimitive.kind = RenderPrimitive::Circle;
 }
 
 Circle::~Circle() {
@@ -102,38 +102,13 @@ glm::vec2 Circle::getSize() const {
     return glm::vec2(m_radius * 2.0f, m_radius * 2.0f);
 }
 
-void Circle::render() {
-    if (!isVisible()) return;
+void Circle::render(Renderer* renderer) {
+    if (!isVisible() || !renderer) return;
     
-    // Simple OpenGL immediate mode rendering for now
-    // In a real implementation, you'd use vertex buffers and shaders
-    
-    glPushMatrix();
-    
-    // Apply transformations
-    glm::mat4 transform = getTransformMatrix();
-    glLoadMatrixf(&transform[0][0]);
-    
-    // Set color
     glm::vec4 color = getColor();
-    glColor4f(color.r, color.g, color.b, color.a * getOpacity());
-    
-    // Draw circle using triangle fan
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex2f(0.0f, 0.0f);  // Center
-    
-    const int segments = 32;
-    for (int i = 0; i <= segments; ++i) {
-        float angle = 2.0f * M_PI * i / segments;
-        float x = cos(angle);
-        float y = sin(angle);
-        glVertex2f(x, y);
-    }
-    
-    glEnd();
+    color.a *= getOpacity();
     
-    glPopMatrix();
-    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);  // Reset color
+    renderer->drawCircle(getRenderTransformMatrix(), color);
 }
 
 bool Circle::intersects(const AnimationObject* other) const {
@@ -205,6 +180,7 @@ Rectangle::Rectangle(float x, float y, float width, float height)
     : Shape("Rectangle") {
     setPosition(x, y, 0.0f);
     setSize(width, height);
+    m_renderPrimitive.kind = RenderPrimitive::Quad;
 }
 
 Rectangle::~Rectangle() {
@@ -236,29 +212,13 @@ glm::vec2 Rectangle::getSize() const {
     return Shape::getSize();
 }
 
-void Rectangle::render() {
-    if (!isVisible()) return;
-    
-    glPushMatrix();
+void Rectangle::render(Renderer* renderer) {
+    if (!isVisible() || !renderer) return;
     
-    // Apply transformations
-    glm::mat4 transform = getTransformMatrix();
-    glLoadMatrixf(&transform[0][0]);
-    
-    // Set color
     glm::vec4 color = getColor();
-    glColor4f(color.r, color.g, color.b, color.a * getOpacity());
-    
-    // Draw rectangle
-    glBegin(GL_QUADS);
-    glVertex2f(-0.5f, -0.5f);
-    glVertex2f( 0.5f, -0.5f);
-    glVertex2f( 0.5f,  0.5f);
-    glVertex2f(-0.5f,  0.5f);
-    glEnd();
+    color.a *= getOpacity();
     
-    glPopMatrix();
-    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);  // Reset color
+    renderer->drawQuad(getRenderTransformMatrix(), color);
 }
 
 bool Rectangle::intersects(const AnimationObject* other) const {
@@ -340,6 +300,11 @@ Line::Line(float x1, float y1, float x2, float y2)
     float width = abs(x2 - x1);
     float height = abs(y2 - y1);
     setSize(width, height);
+    
+    m_renderPrimitive.kind = RenderPrimitive::Line;
+    m_renderPrimitive.lineStart = m_startPoint;
+    m_renderPrimitive.lineEnd = m_endPoint;
+    m_renderPrimitive.lineThickness = m_thickness;
 }
 
 Line::~Line() {
@@ -365,6 +330,8 @@ glm::vec2 Line::getEndPoint() const {
 
 void Line::setThickness(float thickness) {
     m_thickness = thickness;
+    m_renderPrimitive.lineThickness = thickness;
+    notifyBoundsChanged();
 }
 
 float Line::getThickness() const {
@@ -379,24 +346,13 @@ glm::vec2 Line::getSize() const {
     return Shape::getSize();
 }
 
-void Line::render() {
-    if (!isVisible()) return;
+void Line::render(Renderer* renderer) {
+    if (!isVisible() || !renderer) return;
     
-    // Set color
     glm::vec4 color = getColor();
-    glColor4f(color.r, color.g, color.b, color.a * getOpacity());
+    color.a *= getOpacity();
     
-    // Set line width
-    glLineWidth(m_thickness);
-    
-    // Draw line
-    glBegin(GL_LINES);
-    glVertex2f(m_startPoint.x, m_startPoint.y);
-    glVertex2f(m_endPoint.x, m_endPoint.y);
-    glEnd();
-    
-    glLineWidth(1.0f);  // Reset line width
-    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);  // Reset color
+    renderer->drawLine(m_startPoint, m_endPoint, m_thickness, color);
 }
 
 bool Line::intersects(const AnimationObject* other) const {
@@ -469,6 +425,9 @@ void Line::updateLine() {
     float width = abs(m_endPoint.x - m_startPoint.x);
     float height = abs(m_endPoint.y - m_startPoint.y);
     setSize(width, height);
+    
+    m_renderPrimitive.lineStart = m_startPoint;
+    m_renderPrimitive.lineEnd = m_endPoint;
 }
 
 float Line::distanceToLine(float x, float y) const {
@@ -19,7 +19,7 @@ public:
     virtual glm::vec2 getSize() const;
     
     // Rendering
-    virtual void render() override = 0;
+    virtual void render(Renderer* renderer) override = 0;
     
     // Collision detection
     virtual bool intersects(const AnimationObject* other) const override;
@@ -60,7 +60,7 @@ public:
     glm::vec2 getSize() const override;
     
     // Rendering
-    void render() override;
+    void render(Renderer* renderer) override;
     
     // Collision detection
     bool intersects(const AnimationObject* other) const override;
@@ -102,7 +102,7 @@ public:
     glm::vec2 getSize() const override;
     
     // Rendering
-    void render() override;
+    void render(Renderer* renderer) override;
     
     // Collision detection
     bool intersects(const AnimationObject* other) const override;
@@ -144,7 +144,7 @@ public:
     glm::vec2 getSize() const override;
     
     // Rendering
-    void render() override;
+    void render(Renderer* renderer) override;
     
     // Collision detection
     bool intersects(const AnimationObject* other) const override;
@@ -167,4 +167,8 @@ private:
     glm::vec2 m_startPoint;
     glm::vec2 m_endPoint;
     float m_thickness;
+    
+    // Helper methods
+    void updateLine();
+    float distanceToLine(float x, float y) const;
 }; 
\ No newline at end of file
@@ -1,26 +1,46 @@
 #include "Text.h"
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
+#include "../rendering/Renderer.h"
+#include <algorithm>
 #include <iostream>
 
+namespace {
+
+// Used for the text's box when no font is available
+const float kFallbackAdvance = 0.6f;
+const float kFallbackAscent = 0.5f;
+const float kFallbackDescent = -0.5f;
+
+// Outlines and glows reach at most this far past the glyphs, in em
+const float kMaxEffectReach = 0.2f;
+
+} // namespace
+
 TextObject::TextObject(float x, float y, const std::string& text)
     : AnimationObject("Text")
     , m_text(text)
     , m_fontSize(16.0f)
-    , m_fontFamily("Arial")
+    , m_fontFamily("DejaVu Sans")
     , m_bold(false)
     , m_italic(false)
-    , m_alignment(Alignment::Left) {
+    , m_alignment(Alignment::Left)
+    , m_outlineWidth(0.0f)
+    , m_outlineColor(0.0f, 0.0f, 0.0f, 1.0f)
+    , m_glowRadius(0.0f)
+    , m_glowColor(1.0f, 1.0f, 1.0f, 0.5f)
+    , m_advance(0.0f)
+    , m_inkMin(0.0f)
+    , m_inkMax(0.0f) {
     setPosition(x, y, 0.0f);
-    updateTextBounds();
+    updateFont();
 }
 
 TextObject::~TextObject() {
 }
 
 void TextObject::setText(const std::string& text) {
+    if (text == m_text) return;
     m_text = text;
-    updateTextBounds();
+    updateLayout();
 }
 
 std::string TextObject::getText() const {
@@ -28,8 +48,9 @@ std::string TextObject::getText() const {
 }
 
 void TextObject::setFontSize(float size) {
+    // The run is laid out in em units, so only the bounds change
     m_fontSize = size;
-    updateTextBounds();
+    notifyBoundsChanged();
 }
 
 float TextObject::getFontSize() const {
@@ -37,7 +58,9 @@ float TextObject::getFontSize() const {
 }
 
 void TextObject::setFontFamily(const std::string& family) {
+    if (family == m_fontFamily) return;
     m_fontFamily = family;
+    updateFont();
 }
 
 std::string TextObject::getFontFamily() const {
@@ -45,7 +68,9 @@ std::string TextObject::getFontFamily() const {
 }
 
 void TextObject::setBold(bool bold) {
+    if (bold == m_bold) return;
     m_bold = bold;
+    updateFont();
 }
 
 bool TextObject::isBold() const {
@@ -53,7 +78,9 @@ bool TextObject::isBold() const {
 }
 
 void TextObject::setItalic(bool italic) {
+    if (italic == m_italic) return;
     m_italic = italic;
+    updateFont();
 }
 
 bool TextObject::isItalic() const {
@@ -62,34 +89,45 @@ bool TextObject::isItalic() const {
 
 void TextObject::setAlignment(Alignment alignment) {
     m_alignment = alignment;
+    notifyBoundsChanged();
 }
 
 TextObject::Alignment TextObject::getAlignment() const {
     return m_alignment;
 }
 
-void TextObject::render() {
-    if (!isVisible() || m_text.empty()) return;
-    
-    // For now, we'll use a simple approach with OpenGL immediate mode
-    // In a real implementation, you'd use a proper text rendering library like FreeType
-    
-    glPushMatrix();
-    
-    // Apply transformations
-    glm::mat4 transform = getTransformMatrix();
-    glLoadMatrixf(&transform[0][0]);
-    
-    // Set color
-    glm::vec4 color = getColor();
-    glColor4f(color.r, color.g, color.b, color.a * getOpacity());
-    
-    // Simple text rendering using GLUT bitmap characters
-    // This is a basic implementation - in production you'd use proper text rendering
-    renderText();
+void TextObject::setOutline(float width, const glm::vec4& color) {
+    m_outlineWidth = std::max(width, 0.0f);
+    m_outlineColor = color;
+    notifyBoundsChanged();
+}
+
+float TextObject::getOutlineWidth() const {
+    return m_outlineWidth;
+}
+
+glm::vec4 TextObject::getOutlineColor() const {
+    return m_outlineColor;
+}
+
+void TextObject::setGlow(float radius, const glm::vec4& color) {
+    m_glowRadius = std::max(radius, 0.0f);
+    m_glowColor = color;
+    notifyBoundsChanged();
+}
+
+float TextObject::getGlowRadius() const {
+    return m_glowRadius;
+}
+
+glm::vec4 TextObject::getGlowColor() const {
+    return m_glowColor;
+}
+
+void TextObject::render(Renderer* renderer) {
+    if (!isVisible() || m_text.empty() || !renderer) return;
     
-    glPopMatrix();
-    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);  // Reset color
+    renderText(renderer);
 }
 
 bool TextObject::intersects(const AnimationObject* other) const {
@@ -115,46 +153,26 @@ glm::vec3 TextObject::getCollisionNormal(const AnimationObject* other) const {
 }
 
 glm::vec3 TextObject::getMinBounds() const {
-    glm::vec3 pos = getPosition();
-    float width = m_text.length() * m_fontSize * 0.6f;  // Approximate character width
-    float height = m_fontSize;
+    glm::vec2 min, max;
+    getLocalBounds(min, max);
     
-    // Adjust for alignment
-    float offsetX = 0.0f;
-    switch (m_alignment) {
-        case Alignment::Center:
-            offsetX = -width * 0.5f;
-            break;
-        case Alignment::Right:
-            offsetX = -width;
-            break;
-        default:
-            break;
-    }
-    
-    return pos + glm::vec3(offsetX, -height * 0.5f, 0.0f);
+    // Local box through the rotation and scale, around the position
+    glm::mat4 transform = getTransformMatrix();
+    glm::vec3 center = glm::vec3(transform * glm::vec4((min + max) * 0.5f, 0.0f, 0.0f));
+    glm::vec3 extent = glm::abs(glm::vec3(transform[0])) * (max.x - min.x) * 0.5f +
+                       glm::abs(glm::vec3(transform[1])) * (max.y - min.y) * 0.5f;
+    return getPosition() + center - extent;
 }
 
 glm::vec3 TextObject::getMaxBounds() const {
-    glm::vec3 pos = getPosition();
-    float width = m_text.length() * m_fontSize * 0.6f;  // Approximate character width
-    float height = m_fontSize;
+    glm::vec2 min, max;
+    getLocalBounds(min, max);
     
-    // Adjust for alignment
-    float offsetX = 0.0f;
-    switch (m_alignment) {
-        case Alignment::Center:
-            offsetX = width * 0.5f;
-            break;
-        case Alignment::Right:
-            offsetX = 0.0f;
-            break;
-        default:
-            offsetX = width;
-            break;
-    }
-    
-    return pos + glm::vec3(offsetX, height * 0.5f, 0.0f);
+    glm::mat4 transform = getTransformMatrix();
+    glm::vec3 center = glm::vec3(transform * glm::vec4((min + max) * 0.5f, 0.0f, 0.0f));
+    glm::vec3 extent = glm::abs(glm::vec3(transform[0])) * (max.x - min.x) * 0.5f +
+                       glm::abs(glm::vec3(transform[1])) * (max.y - min.y) * 0.5f;
+    return getPosition() + center + extent;
 }
 
 std::shared_ptr<AnimationObject> TextObject::clone() const {
@@ -169,6 +187,8 @@ std::shared_ptr<AnimationObject> TextObject::clone() const {
     text->setBold(m_bold);
     text->setItalic(m_italic);
     text->setAlignment(m_alignment);
+    text->setOutline(m_outlineWidth, m_outlineColor);
+    text->setGlow(m_glowRadius, m_glowColor);
     return text;
 }
 
@@ -176,47 +196,96 @@ std::string TextObject::getTypeName() const {
     return "Text";
 }
 
-void TextObject::updateTextBounds() {
-    // Update the object's scale based on text size
-    float width = m_text.length() * m_fontSize * 0.6f;  // Approximate character width
-    float height = m_fontSize;
-    setScale(width, height, 1.0f);
+void TextObject::updateFont() {
+    m_font = Font::find(m_fontFamily, m_bold, m_italic);
+    updateLayout();
 }
 
-void TextObject::renderText() {
-    // Simple text rendering using OpenGL immediate mode
-    // This is a placeholder - in a real implementation you'd use proper text rendering
+void TextObject::updateLayout() {
+    m_glyphs.clear();
     
-    // For now, we'll just draw a rectangle to represent the text
-    // In production, you'd use FreeType or similar for proper text rendering
+    if (!m_font) {
+        // Approximate character width
+        m_advance = m_text.length() * kFallbackAdvance;
+        m_inkMin = glm::vec2(0.0f, kFallbackDescent);
+        m_inkMax = glm::vec2(m_advance, kFallbackAscent);
+        notifyBoundsChanged();
+        return;
+    }
     
-    float width = m_text.length() * m_fontSize * 0.6f;
-    float height = m_fontSize;
+    m_advance = m_font->shape(m_text, m_glyphs);
+    
+    // Ink can stick out of the line box, e.g. accents or italic overhangs
+    m_inkMin = glm::vec2(0.0f, m_font->getDescent());
+    m_inkMax = glm::vec2(m_advance, m_font->getAscent());
+    for (const ShapedGlyph& glyph : m_glyphs) {
+        glm::vec2 min, max;
+        if (m_font->getGlyphBounds(glyph.glyph, min, max)) {
+            m_inkMin = glm::min(m_inkMin, min + glm::vec2(glyph.x, 0.0f));
+            m_inkMax = glm::max(m_inkMax, max + glm::vec2(glyph.x, 0.0f));
+        }
+    }
+    notifyBoundsChanged();
+}
+
+glm::vec2 TextObject::getLayoutOffset() const {
+    // Pen origin relative to the position: aligned horizontally, and with
+    // the line box centered vertically
+    float ascent = m_font ? m_font->getAscent() : kFallbackAscent;
+    float descent = m_font ? m_font->getDescent() : kFallbackDescent;
     
-    // Adjust position based on alignment
     float offsetX = 0.0f;
     switch (m_alignment) {
         case Alignment::Center:
-            offsetX = -width * 0.5f;
+            offsetX = -m_advance * 0.5f;
             break;
         case Alignment::Right:
-            offsetX = -width;
+            offsetX = -m_advance;
             break;
         default:
             break;
     }
     
-    // Draw a simple rectangle to represent the text area
-    glBegin(GL_QUADS);
-    glVertex2f(offsetX, -height * 0.5f);
-    glVertex2f(offsetX + width, -height * 0.5f);
-    glVertex2f(offsetX + width, height * 0.5f);
-    glVertex2f(offsetX, height * 0.5f);
-    glEnd();
+    return glm::vec2(offsetX, -(ascent + descent) * 0.5f) * m_fontSize;
+}
+
+void TextObject::getLocalBounds(glm::vec2& min, glm::vec2& max) const {
+    glm::vec2 offset = getLayoutOffset();
+    float effects = std::min(m_outlineWidth + m_glowRadius, m_fontSize * kMaxEffectReach);
+    min = offset + m_inkMin * m_fontSize - effects;
+    max = offset + m_inkMax * m_fontSize + effects;
+}
+
+void TextObject::renderText(Renderer* renderer) {
+    glm::vec4 color = getColor();
+    color.a *= getOpacity();
+    
+    glm::vec2 offset = getLayoutOffset();
+    glm::mat4 transform = glm::translate(getRenderTransformMatrix(), glm::vec3(offset, 0.0f));
     
-    // In a real implementation, you would:
-    // 1. Load a font using FreeType
-    // 2. Generate texture atlas for characters
-    // 3. Render each character as a textured quad
-    // 4. Handle different font styles, sizes, and alignments
-} 
\ No newline at end of file
+    if (m_font) {
+        // Glow, then outline, then fill, each for the whole run so an
+        // effect never covers a neighbouring glyph
+        const ShapedGlyph* glyphs = m_glyphs.data();
+        size_t count = m_glyphs.size();
+        if (m_glowRadius > 0.0f) {
+            glm::vec4 glowColor = m_glowColor;
+            glowColor.a *= getOpacity();
+            renderer->drawGlyphs(transform, *m_font, glyphs, count, m_fontSize, glowColor,
+                                 m_outlineWidth + m_glowRadius * 0.5f, m_glowRadius);
+        }
+        if (m_outlineWidth > 0.0f) {
+            glm::vec4 outlineColor = m_outlineColor;
+            outlineColor.a *= getOpacity();
+            renderer->drawGlyphs(transform, *m_font, glyphs, count, m_fontSize, outlineColor, m_outlineWidth);
+        }
+        renderer->drawGlyphs(transform, *m_font, glyphs, count, m_fontSize, color);
+        return;
+    }
+    
+    // No font: draw a rectangle to represent the text area
+    glm::vec2 size = (m_inkMax - m_inkMin) * m_fontSize;
+    transform = glm::translate(transform, glm::vec3(m_inkMin * m_fontSize + size * 0.5f, 0.0f));
+    transform = glm::scale(transform, glm::vec3(size, 1.0f));
+    renderer->drawQuad(transform, color);
+}
@@ -1,13 +1,25 @@
 #pragma once
 
 #include "AnimationObject.h"
+#include "../rendering/Font.h"
+#include <memory>
 #include <string>
+#include <vector>
 
 /**
  * @brief Text object for rendering text and labels
  * 
  * Provides text rendering capabilities with customizable
  * font, size, color, and positioning.
+ *
+ * The text is shaped once into a run of glyphs with kerning, in em units,
+ * and reshaped only when the text or font changes; a new font size just
+ * rescales the run. Rendering hands the run to the renderer, which draws
+ * every glyph from its shared atlas in the frame's batch. Glyphs are
+ * distance fields, so the text stays sharp at any scale or zoom, and an
+ * outline and a glow are drawn from the same glyphs behind the text. The
+ * text is centered vertically on its position. When no font file can be
+ * found, the text's box is drawn instead.
  */
 class TextObject : public AnimationObject {
 public:
@@ -40,8 +52,18 @@ public:
     void setAlignment(Alignment alignment);
     Alignment getAlignment() const;
     
+    // Effects, with widths in the units of the font size; an outline and
+    // glow together reach at most a fifth of the font size
+    void setOutline(float width, const glm::vec4& color);
+    float getOutlineWidth() const;
+    glm::vec4 getOutlineColor() const;
+    
+    void setGlow(float radius, const glm::vec4& color);
+    float getGlowRadius() const;
+    glm::vec4 getGlowColor() const;
+    
     // Rendering
-    void render() override;
+    void render(Renderer* renderer) override;
     
     // Collision detection
     bool intersects(const AnimationObject* other) const override;
@@ -64,8 +86,22 @@ private:
     bool m_bold;
     bool m_italic;
     Alignment m_alignment;
+    float m_outlineWidth;
+    glm::vec4 m_outlineColor;
+    float m_glowRadius;
+    glm::vec4 m_glowColor;
+    
+    // Shaped run, in em units
+    std::shared_ptr<Font> m_font;
+    std::vector<ShapedGlyph> m_glyphs;
+    float m_advance;
+    glm::vec2 m_inkMin;
+    glm::vec2 m_inkMax;
     
     // Helper methods
-    void updateTextBounds();
-    void renderText();
+    void updateFont();
+    void updateLayout();
+    glm::vec2 getLayoutOffset() const;
+    void getLocalBounds(glm::vec2& min, glm::vec2& max) const;
+    void renderText(Renderer* renderer);
 }; 
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+/**
+ * @brief Anti-aliasing tiers, from cheapest to smoothest
+ *
+ * None draws hard edges, for fast previews. Analytic gives every edge a
+ * one-pixel coverage ramp computed per pixel, on the CPU and in the
+ * OpenGL shader alike. The multisample tiers render OpenGL frames into a
+ * multisampled target with that many samples per pixel, which smooths
+ * edges the shader cannot ramp, such as overlapping or very thin
+ * geometry; circles and glyphs keep their analytic edges. The CPU path
+ * has no samples to take, so it draws them like Analytic.
+ */
+enum class AntialiasingQuality {
+    None,
+    Analytic,
+    MSAA2x,
+    MSAA4x,
+    MSAA8x
+};
+
+// Samples per pixel of a tier; 1 for the tiers that do not multisample
+inline int getSampleCount(AntialiasingQuality quality) {
+    switch (quality) {
+        case AntialiasingQuality::MSAA2x: return 2;
+        case AntialiasingQuality::MSAA4x: return 4;
+        case AntialiasingQuality::MSAA8x: return 8;
+        default: return 1;
+    }
+}
+
+inline const char* getAntialiasingName(AntialiasingQuality quality) {
+    switch (quality) {
+        case AntialiasingQuality::None: return "none";
+        case AntialiasingQuality::Analytic: return "analytic";
+        case AntialiasingQuality::MSAA2x: return "2x MSAA";
+        case AntialiasingQuality::MSAA4x: return "4x MSAA";
+        case AntialiasingQuality::MSAA8x: return "8x MSAA";
+    }
+    return "unknown";
+}
@@ -0,0 +1,189 @@
+#include "DamageTracker.h"
+#include "SoftwareRasterizer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Damage rectangles kept per frame before the closest ones are merged
+const size_t kMaxDamageRects = 32;
+
+uint64_t hashInstance(const RenderInstance& instance) {
+    // FNV-1a over the raw bytes; equality is checked on the bytes as well
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&instance);
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < sizeof(RenderInstance); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool sameInstance(const RenderInstance& a, const RenderInstance& b) {
+    return std::memcmp(&a, &b, sizeof(RenderInstance)) == 0;
+}
+
+int64_t area(const PixelRect& rect) {
+    return static_cast<int64_t>(rect.x1 - rect.x0) * (rect.y1 - rect.y0);
+}
+
+bool overlaps(const PixelRect& a, const PixelRect& b) {
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+PixelRect unite(const PixelRect& a, const PixelRect& b) {
+    return PixelRect{std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1)};
+}
+
+} // namespace
+
+DamageTracker::DamageTracker()
+    : m_width(0)
+    , m_height(0)
+    , m_invalid(true) {
+}
+
+void DamageTracker::invalidate() {
+    // Whatever was drawn this frame is gone as well
+    m_invalid = true;
+    m_damage.assign(1, PixelRect{0, 0, m_width, m_height});
+}
+
+void DamageTracker::beginFrame(const SoftwareRasterizer& rasterizer, const RenderInstance* instances, size_t count,
+                               int width, int height) {
+    m_damage.clear();
+
+    if (m_invalid || width != m_width || height != m_height) {
+        m_damage.push_back(PixelRect{0, 0, width, height});
+        m_width = width;
+        m_height = height;
+        m_invalid = false;
+        m_previous.assign(instances, instances + count);
+        return;
+    }
+
+    m_matched.assign(m_previous.size(), false);
+    m_previousByHash.clear();
+
+    // Match in order; an instance that matches out of order is treated as
+    // changed, since it may now cover its neighbours differently
+    int64_t lastMatch = -1;
+    for (size_t i = 0; i < count; ++i) {
+        int64_t match = -1;
+        size_t next = static_cast<size_t>(lastMatch + 1);
+        if (next < m_previous.size() && sameInstance(m_previous[next], instances[i])) {
+            match = static_cast<int64_t>(next);
+        } else {
+            if (m_previousByHash.empty() && !m_previous.empty()) {
+                buildHashTable();
+            }
+            match = findMatch(instances[i], lastMatch);
+        }
+
+        if (match >= 0) {
+            m_matched[match] = true;
+            lastMatch = match;
+        } else {
+            addDamage(rasterizer, instances[i]);
+        }
+    }
+
+    for (size_t i = 0; i < m_previous.size(); ++i) {
+        if (!m_matched[i]) {
+            addDamage(rasterizer, m_previous[i]);
+        }
+    }
+
+    m_previous.assign(instances, instances + count);
+}
+
+void DamageTracker::append(const SoftwareRasterizer& rasterizer, const RenderInstance* instances, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        addDamage(rasterizer, instances[i]);
+    }
+    m_previous.insert(m_previous.end(), instances, instances + count);
+}
+
+const std::vector<PixelRect>& DamageTracker::getDamage() const {
+    return m_damage;
+}
+
+void DamageTracker::buildHashTable() {
+    m_previousByHash.resize(m_previous.size());
+    for (size_t i = 0; i < m_previous.size(); ++i) {
+        m_previousByHash[i] = std::make_pair(hashInstance(m_previous[i]), static_cast<uint32_t>(i));
+    }
+    std::sort(m_previousByHash.begin(), m_previousByHash.end());
+
+    // Each group of equal hashes is consumed in index order from its first entry
+    m_cursors.resize(m_previousByHash.size());
+    for (size_t i = 0; i < m_previousByHash.size(); ++i) {
+        m_cursors[i] = static_cast<uint32_t>(i);
+    }
+}
+
+int64_t DamageTracker::findMatch(const RenderInstance& instance, int64_t lastMatch) {
+    if (m_previousByHash.empty()) return -1;
+
+    uint64_t hash = hashInstance(instance);
+    auto group = std::lower_bound(m_previousByHash.begin(), m_previousByHash.end(),
+                                  std::make_pair(hash, static_cast<uint32_t>(0)));
+    if (group == m_previousByHash.end() || group->first != hash) return -1;
+
+    // Candidates behind the last match can never match again, and matched
+    // ones are used up, so the group's cursor only moves forward
+    size_t groupStart = static_cast<size_t>(group - m_previousByHash.begin());
+    uint32_t& cursor = m_cursors[groupStart];
+    while (cursor < m_previousByHash.size() && m_previousByHash[cursor].first == hash) {
+        uint32_t index = m_previousByHash[cursor++].second;
+        if (static_cast<int64_t>(index) > lastMatch && !m_matched[index] &&
+            sameInstance(m_previous[index], instance)) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+void DamageTracker::addDamage(const SoftwareRasterizer& rasterizer, const RenderInstance& instance) {
+    PixelRect bounds;
+    if (rasterizer.getPixelBounds(instance, m_width, m_height, bounds)) {
+        addDamage(bounds);
+    }
+}
+
+void DamageTracker::addDamage(PixelRect rect) {
+    // Absorb every rectangle the new one overlaps, growing it as it goes
+    for (size_t i = 0; i < m_damage.size();) {
+        if (overlaps(m_damage[i], rect)) {
+            rect = unite(rect, m_damage[i]);
+            m_damage[i] = m_damage.back();
+            m_damage.pop_back();
+            i = 0;
+        } else {
+            ++i;
+        }
+    }
+    m_damage.push_back(rect);
+
+    if (m_damage.size() <= kMaxDamageRects) return;
+
+    // Too many: merge the pair whose union adds the least area
+    size_t bestA = 0;
+    size_t bestB = 1;
+    int64_t bestWaste = INT64_MAX;
+    for (size_t a = 0; a < m_damage.size(); ++a) {
+        for (size_t b = a + 1; b < m_damage.size(); ++b) {
+            int64_t waste = area(unite(m_damage[a], m_damage[b])) - area(m_damage[a]) - area(m_damage[b]);
+            if (waste < bestWaste) {
+                bestWaste = waste;
+                bestA = a;
+                bestB = b;
+            }
+        }
+    }
+    PixelRect merged = unite(m_damage[bestA], m_damage[bestB]);
+    m_damage[bestB] = m_damage.back();
+    m_damage.pop_back();
+    m_damage[bestA] = m_damage.back();
+    m_damage.pop_back();
+    addDamage(merged);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "Framebuffer.h"
+#include "RenderBatch.h"
+
+// Forward declarations
+class SoftwareRasterizer;
+
+/**
+ * @brief Finds the pixels that can differ between consecutive frames
+ *
+ * Each frame's instances are matched against the previous frame's: an
+ * instance that is byte-for-byte identical to one of last frame's, and
+ * keeps its order relative to the other matches, draws exactly the same
+ * pixels. Everything else damages the frame: the new bounds of instances
+ * that moved, changed color or appeared, and the old bounds of instances
+ * that moved away or disappeared. A pixel outside the damage is covered
+ * by the same instances in the same order as before, so it keeps its
+ * value.
+ *
+ * Frames that draw the same list in the same order match in one linear
+ * pass. Damage is kept as a short list of rectangles, merging those that
+ * overlap and, beyond a fixed count, the pair that wastes the least area.
+ */
+class DamageTracker {
+public:
+    DamageTracker();
+
+    // This frame and the next are damaged everywhere, e.g. after a clear
+    void invalidate();
+
+    // Starts a frame drawing the given instances and computes its damage
+    void beginFrame(const SoftwareRasterizer& rasterizer, const RenderInstance* instances, size_t count,
+                    int width, int height);
+
+    // Instances drawn later in the same frame; all of them count as damage
+    void append(const SoftwareRasterizer& rasterizer, const RenderInstance* instances, size_t count);
+
+    // Damage of the current frame, top row first; empty when nothing changed
+    const std::vector<PixelRect>& getDamage() const;
+
+private:
+    std::vector<RenderInstance> m_previous;
+    std::vector<PixelRect> m_damage;
+    int m_width;
+    int m_height;
+    bool m_invalid;
+
+    // Matching state, reused between frames
+    std::vector<std::pair<uint64_t, uint32_t>> m_previousByHash;    // Sorted (hash, index)
+    std::vector<uint32_t> m_cursors;                                // Next candidate per hash group
+    std::vector<bool> m_matched;
+
+    // Helper methods
+    void buildHashTable();
+    int64_t findMatch(const RenderInstance& instance, int64_t lastMatch);
+    void addDamage(const SoftwareRasterizer& rasterizer, const RenderInstance& instance);
+    void addDamage(PixelRect rect);
+};
@@ -0,0 +1,1074 @@
+#include "Font.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+// Directory of the assets shipped with the engine, set by the build
+#ifndef KALEM_ASSET_DIR
+#define KALEM_ASSET_DIR "assets"
+#endif
+
+namespace {
+
+// ============================================================================
+// FONT REGISTRY
+// ============================================================================
+
+struct FontRegistry {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::string> families;          // Style key to file path
+    std::unordered_map<std::string, std::shared_ptr<Font>> fonts;   // File path to loaded font
+    std::unordered_map<std::string, std::shared_ptr<Font>> found;   // Style key to lookup result
+    std::unordered_map<std::string, std::string> files;             // Lowercase file name to path
+    bool bundled = false;
+    bool scanned = false;
+};
+
+// Family of the font shipped in assets/fonts, the fallback for every other
+const char* kBundledFamily = "DejaVu Sans";
+
+FontRegistry& getRegistry() {
+    static FontRegistry registry;
+    return registry;
+}
+
+std::string toLower(const std::string& text) {
+    std::string result = text;
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+std::string styleKey(const std::string& family, bool bold, bool italic) {
+    return toLower(family) + (bold ? "|bold" : "|") + (italic ? "|italic" : "|");
+}
+
+// Registers the shipped font unless its family was registered already, so
+// text falls back to the same font whatever the host has installed
+void registerBundledFonts(FontRegistry& registry) {
+    registry.bundled = true;
+
+    std::string path = std::string(KALEM_ASSET_DIR) + "/fonts/DejaVuSans.ttf";
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) {
+        path = "assets/fonts/DejaVuSans.ttf";
+    }
+    registry.families.emplace(styleKey(kBundledFamily, false, false), path);
+}
+
+// Indexes every .ttf file in the usual font directories by file name
+void scanFontDirectories(FontRegistry& registry) {
+    registry.scanned = true;
+
+    std::vector<std::string> directories = {
+        "fonts", "assets/fonts",
+        "/usr/share/fonts", "/usr/local/share/fonts",
+        "/Library/Fonts", "/System/Library/Fonts",
+        "C:/Windows/Fonts"
+    };
+    if (const char* home = std::getenv("HOME")) {
+        directories.push_back(std::string(home) + "/.fonts");
+        directories.push_back(std::string(home) + "/.local/share/fonts");
+    }
+
+    namespace fs = std::filesystem;
+    for (const std::string& directory : directories) {
+        std::error_code error;
+        if (!fs::is_directory(directory, error)) continue;
+
+        fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, error);
+        for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+            if (!it->is_regular_file(error)) continue;
+            std::string name = toLower(it->path().filename().string());
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".ttf") == 0) {
+                registry.files.emplace(name, it->path().string());
+            }
+        }
+    }
+}
+
+// Common file names of a family's style, e.g. "DejaVuSans-Bold.ttf" or "arialbd.ttf"
+std::string findFontFile(const FontRegistry& registry, const std::string& family, bool bold, bool italic) {
+    std::string name = toLower(family);
+    name.erase(std::remove(name.begin(), name.end(), ' '), name.end());
+
+    std::vector<const char*> suffixes;
+    if (bold && italic) {
+        suffixes = {"-bolditalic", "-boldoblique", "bi", "z"};
+    } else if (bold) {
+        suffixes = {"-bold", "bd", "b"};
+    } else if (italic) {
+        suffixes = {"-italic", "-oblique", "i"};
+    } else {
+        suffixes = {"", "-regular"};
+    }
+
+    for (const char* suffix : suffixes) {
+        auto it = registry.files.find(name + suffix + ".ttf");
+        if (it != registry.files.end()) return it->second;
+    }
+    return std::string();
+}
+
+std::shared_ptr<Font> loadRegistered(FontRegistry& registry, const std::string& path) {
+    auto it = registry.fonts.find(path);
+    if (it != registry.fonts.end()) return it->second;
+
+    std::shared_ptr<Font> font = Font::loadFromFile(path);
+    registry.fonts[path] = font;
+    return font;
+}
+
+// ============================================================================
+// TEXT DECODING
+// ============================================================================
+
+// Next code point of UTF-8 text; malformed sequences give U+FFFD
+uint32_t decodeUtf8(const std::string& text, size_t& index) {
+    unsigned char lead = static_cast<unsigned char>(text[index++]);
+    if (lead < 0x80) return lead;
+
+    int length = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+    if (length == 0 || lead >= 0xF8) return 0xFFFD;
+
+    uint32_t codepoint = lead & (0x3F >> length);
+    for (int i = 0; i < length; ++i) {
+        if (index >= text.size()) return 0xFFFD;
+        unsigned char next = static_cast<unsigned char>(text[index]);
+        if ((next & 0xC0) != 0x80) return 0xFFFD;
+        codepoint = (codepoint << 6) | (next & 0x3F);
+        ++index;
+    }
+    return codepoint;
+}
+
+// ============================================================================
+// COVERAGE RASTERIZATION
+// ============================================================================
+
+/**
+ * Signed-area accumulation buffer. Each line segment adds, to every pixel
+ * it crosses, the area it sweeps to the pixel's right edge, and to the
+ * next pixel the remainder; summing a row from left to right then gives
+ * the exact winding-weighted coverage of every pixel.
+ */
+class CoverageAccumulator {
+public:
+    CoverageAccumulator(int width, int height)
+        : m_width(width)
+        , m_height(height)
+        , m_stride(width + 2)
+        , m_area(static_cast<size_t>(width + 2) * height, 0.0f) {
+    }
+
+    void addLine(glm::vec2 p0, glm::vec2 p1) {
+        if (p0.y == p1.y) return;
+
+        float direction = 1.0f;
+        if (p0.y > p1.y) {
+            std::swap(p0, p1);
+            direction = -1.0f;
+        }
+
+        float dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+        float x = p0.x;
+        if (p0.y < 0.0f) x -= p0.y * dxdy;
+
+        int rowBegin = std::max(0, static_cast<int>(p0.y));
+        int rowEnd = std::min(m_height, static_cast<int>(std::ceil(p1.y)));
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            float* row = &m_area[static_cast<size_t>(y) * m_stride];
+            float dy = std::min(static_cast<float>(y + 1), p1.y) - std::max(static_cast<float>(y), p0.y);
+            float xNext = x + dxdy * dy;
+            float d = dy * direction;
+
+            float x0 = std::min(x, xNext);
+            float x1 = std::max(x, xNext);
+            float x0Floor = std::floor(x0);
+            int x0i = static_cast<int>(x0Floor);
+            float x1Ceil = std::ceil(x1);
+            int x1i = static_cast<int>(x1Ceil);
+            if (x0i < 0 || x1i > m_width + 1) {
+                x = xNext;
+                continue;
+            }
+
+            if (x1i <= x0i + 1) {
+                // Within one pixel: split by the segment's mean position
+                float xm = 0.5f * (x + xNext) - x0Floor;
+                row[x0i] += d - d * xm;
+                row[x0i + 1] += d * xm;
+            } else {
+                // Across several pixels: trapezoid areas of a linear ramp
+                float s = 1.0f / (x1 - x0);
+                float x0f = x0 - x0Floor;
+                float a0 = 0.5f * s * (1.0f - x0f) * (1.0f - x0f);
+                float x1f = x1 - x1Ceil + 1.0f;
+                float am = 0.5f * s * x1f * x1f;
+
+                row[x0i] += d * a0;
+                if (x1i == x0i + 2) {
+                    row[x0i + 1] += d * (1.0f - a0 - am);
+                } else {
+                    float a1 = s * (1.5f - x0f);
+                    row[x0i + 1] += d * (a1 - a0);
+                    for (int xi = x0i + 2; xi < x1i - 1; ++xi) {
+                        row[xi] += d * s;
+                    }
+                    float a2 = a1 + (x1i - x0i - 3) * s;
+                    row[x1i - 1] += d * (1.0f - a2 - am);
+                }
+                row[x1i] += d * am;
+            }
+            x = xNext;
+        }
+    }
+
+    void resolve(std::vector<uint8_t>& coverage) const {
+        coverage.resize(static_cast<size_t>(m_width) * m_height);
+        for (int y = 0; y < m_height; ++y) {
+            const float* row = &m_area[static_cast<size_t>(y) * m_stride];
+            float sum = 0.0f;
+            for (int x = 0; x < m_width; ++x) {
+                sum += row[x];
+                float value = std::min(std::abs(sum), 1.0f);
+                coverage[static_cast<size_t>(y) * m_width + x] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+            }
+        }
+    }
+
+private:
+    int m_width;
+    int m_height;
+    int m_stride;
+    std::vector<float> m_area;
+};
+
+// Appends a quadratic curve as line segments (pairs of points). A
+// quadratic strays |p0 - 2c + p1| / 4 from its chord; it is split so every
+// piece stays within a tenth of a pixel.
+void appendQuadratic(const glm::vec2& p0, const glm::vec2& control, const glm::vec2& p1, std::vector<glm::vec2>& lines) {
+    float deviation = glm::length(p0 - control * 2.0f + p1);
+    int segments = std::min(64, std::max(1, static_cast<int>(std::ceil(std::sqrt(deviation / 0.4f)))));
+
+    glm::vec2 previous = p0;
+    for (int i = 1; i <= segments; ++i) {
+        float t = static_cast<float>(i) / segments;
+        float u = 1.0f - t;
+        glm::vec2 point = p0 * (u * u) + control * (2.0f * u * t) + p1 * (t * t);
+        lines.push_back(previous);
+        lines.push_back(point);
+        previous = point;
+    }
+}
+
+// ============================================================================
+// DISTANCE FIELDS
+// ============================================================================
+
+float distanceToSegment(const glm::vec2& point, const glm::vec2& a, const glm::vec2& b) {
+    glm::vec2 edge = b - a;
+    float lengthSquared = glm::dot(edge, edge);
+    float t = lengthSquared > 0.0f ? glm::clamp(glm::dot(point - a, edge) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+    return glm::length(point - (a + edge * t));
+}
+
+/**
+ * Signed distance from every pixel center to a closed outline given as
+ * line segments in bitmap space, positive inside. Rows are handled one at
+ * a time: only segments within `spread` of the row can be nearer than the
+ * clamp, and the nonzero winding at each pixel comes from the row's
+ * crossings sorted left to right.
+ */
+void computeDistanceField(const std::vector<glm::vec2>& lines, int width, int height, float spread,
+                          std::vector<uint8_t>& field) {
+    field.assign(static_cast<size_t>(width) * height, 0);
+
+    std::vector<size_t> nearby;
+    std::vector<std::pair<float, int>> crossings;
+    for (int y = 0; y < height; ++y) {
+        float centerY = y + 0.5f;
+
+        nearby.clear();
+        crossings.clear();
+        for (size_t i = 0; i < lines.size(); i += 2) {
+            const glm::vec2& a = lines[i];
+            const glm::vec2& b = lines[i + 1];
+            if (std::min(a.y, b.y) - spread <= centerY && std::max(a.y, b.y) + spread >= centerY) {
+                nearby.push_back(i);
+            }
+
+            // Half-open in y so shared endpoints cross once
+            if ((a.y <= centerY) != (b.y <= centerY)) {
+                float x = a.x + (centerY - a.y) * (b.x - a.x) / (b.y - a.y);
+                crossings.emplace_back(x, b.y > a.y ? 1 : -1);
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        size_t crossing = 0;
+        int winding = 0;
+        for (int x = 0; x < width; ++x) {
+            glm::vec2 center(x + 0.5f, centerY);
+            while (crossing < crossings.size() && crossings[crossing].first <= center.x) {
+                winding += crossings[crossing++].second;
+            }
+
+            float distance = spread;
+            for (size_t i : nearby) {
+                distance = std::min(distance, distanceToSegment(center, lines[i], lines[i + 1]));
+            }
+            if (winding == 0) distance = -distance;
+
+            // The edge maps to the middle of the range
+            float value = glm::clamp(0.5f + distance / (2.0f * spread), 0.0f, 1.0f);
+            field[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+        }
+    }
+}
+
+int countBits(uint16_t value) {
+    int count = 0;
+    for (; value; value &= value - 1) ++count;
+    return count;
+}
+
+// Nested composite glyphs deeper than this are treated as malformed
+const int kMaxCompositeDepth = 8;
+
+} // namespace
+
+// ============================================================================
+// LOADING
+// ============================================================================
+
+Font::Font()
+    : m_id(0)
+    , m_unitsPerEm(1000.0f)
+    , m_ascent(0.0f)
+    , m_descent(0.0f)
+    , m_lineGap(0.0f)
+    , m_glyphCount(0)
+    , m_horizontalMetricCount(0)
+    , m_indexToLocFormat(0)
+    , m_cmap(0)
+    , m_glyf(0)
+    , m_loca(0)
+    , m_hmtx(0)
+    , m_kern(0)
+    , m_gpos(0) {
+    static std::atomic<uint32_t> nextId(1);
+    m_id = nextId++;
+}
+
+std::shared_ptr<Font> Font::loadFromFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open font " << path << std::endl;
+        return nullptr;
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::shared_ptr<Font> font = loadFromMemory(std::move(data));
+    if (!font) {
+        std::cerr << "Unsupported font file " << path << std::endl;
+    }
+    return font;
+}
+
+std::shared_ptr<Font> Font::loadFromMemory(std::vector<uint8_t> data) {
+    std::shared_ptr<Font> font(new Font());
+    font->m_data = std::move(data);
+    if (!font->parse()) return nullptr;
+    return font;
+}
+
+void Font::registerFamily(const std::string& family, const std::string& path, bool bold, bool italic) {
+    FontRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.families[styleKey(family, bold, italic)] = path;
+    registry.found.clear();
+}
+
+std::shared_ptr<Font> Font::find(const std::string& family, bool bold, bool italic) {
+    FontRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::string key = styleKey(family, bold, italic);
+    auto cached = registry.found.find(key);
+    if (cached != registry.found.end()) return cached->second;
+
+    if (!registry.bundled) {
+        registerBundledFonts(registry);
+    }
+
+    // The family, then the bundled font, then common sans-serif families,
+    // each from a registered file and then from the font directories in
+    // the requested style and then the plain one
+    const char* fallbacks[] = {kBundledFamily, "Liberation Sans", "Arial", "Helvetica", "FreeSans", "Lato"};
+    std::vector<std::string> names(1, family);
+    names.insert(names.end(), std::begin(fallbacks), std::end(fallbacks));
+
+    std::shared_ptr<Font> font;
+    for (const std::string& name : names) {
+        for (const std::string& candidate : {styleKey(name, bold, italic), styleKey(name, false, false)}) {
+            auto it = registry.families.find(candidate);
+            if (!font && it != registry.families.end()) {
+                font = loadRegistered(registry, it->second);
+            }
+        }
+        if (font) break;
+
+        if (!registry.scanned) {
+            scanFontDirectories(registry);
+        }
+        std::string path = findFontFile(registry, name, bold, italic);
+        if (path.empty()) path = findFontFile(registry, name, false, false);
+        if (!path.empty()) {
+            font = loadRegistered(registry, path);
+            if (font) break;
+        }
+    }
+
+    if (!font) {
+        std::cerr << "No font found for family '" << family << "'" << std::endl;
+    }
+    registry.found[key] = font;
+    return font;
+}
+
+bool Font::parse() {
+    // Plain TrueType outlines only
+    uint32_t version = read32(0);
+    if (version != 0x00010000u && version != 0x74727565u) return false;
+
+    uint32_t head = findTable("head");
+    uint32_t hhea = findTable("hhea");
+    uint32_t maxp = findTable("maxp");
+    m_cmap = findTable("cmap");
+    m_glyf = findTable("glyf");
+    m_loca = findTable("loca");
+    m_hmtx = findTable("hmtx");
+    m_kern = findTable("kern");
+    m_gpos = findTable("GPOS");
+    if (!head || !hhea || !maxp || !m_cmap || !m_glyf || !m_loca || !m_hmtx) return false;
+
+    m_unitsPerEm = read16(head + 18);
+    m_indexToLocFormat = readSigned16(head + 50);
+    m_glyphCount = read16(maxp + 4);
+    m_horizontalMetricCount = read16(hhea + 34);
+    if (m_unitsPerEm <= 0.0f || m_glyphCount == 0 || m_horizontalMetricCount == 0) return false;
+
+    m_ascent = readSigned16(hhea + 4) / m_unitsPerEm;
+    m_descent = readSigned16(hhea + 6) / m_unitsPerEm;
+    m_lineGap = readSigned16(hhea + 8) / m_unitsPerEm;
+
+    m_cmap = selectCharacterMap();
+    return m_cmap != 0;
+}
+
+uint32_t Font::findTable(const char* tag) const {
+    uint16_t tableCount = read16(4);
+    for (uint32_t i = 0; i < tableCount; ++i) {
+        uint32_t record = 12 + 16 * i;
+        if (record + 16 <= m_data.size() && std::memcmp(&m_data[record], tag, 4) == 0) {
+            // Tables cut off by the end of the file count as missing
+            uint32_t offset = read32(record + 8);
+            uint32_t length = read32(record + 12);
+            if (offset > m_data.size() || length > m_data.size() - offset) return 0;
+            return offset;
+        }
+    }
+    return 0;
+}
+
+uint32_t Font::selectCharacterMap() const {
+    // Prefer full Unicode (format 12), then the Basic Multilingual Plane (format 4)
+    uint32_t best = 0;
+    int bestScore = 0;
+    uint16_t tableCount = read16(m_cmap + 2);
+    for (uint32_t i = 0; i < tableCount; ++i) {
+        uint32_t record = m_cmap + 4 + 8 * i;
+        uint16_t platform = read16(record);
+        uint16_t encoding = read16(record + 2);
+        uint32_t subtable = m_cmap + read32(record + 4);
+        uint16_t format = read16(subtable);
+
+        bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+        int score = 0;
+        if (unicode && format == 12) {
+            score = 3;
+        } else if (unicode && format == 4) {
+            score = 2;
+        } else if (platform == 3 && encoding == 0 && format == 4) {
+            score = 1;      // Symbol fonts
+        }
+        if (score > bestScore) {
+            best = subtable;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+// ============================================================================
+// METRICS
+// ============================================================================
+
+uint32_t Font::getId() const {
+    return m_id;
+}
+
+float Font::getAscent() const {
+    return m_ascent;
+}
+
+float Font::getDescent() const {
+    return m_descent;
+}
+
+float Font::getLineGap() const {
+    return m_lineGap;
+}
+
+uint32_t Font::getGlyphIndex(uint32_t codepoint) const {
+    uint16_t format = read16(m_cmap);
+
+    if (format == 12) {
+        uint32_t groupCount = read32(m_cmap + 12);
+        uint32_t low = 0;
+        uint32_t high = groupCount;
+        while (low < high) {
+            uint32_t middle = (low + high) / 2;
+            uint32_t group = m_cmap + 16 + 12 * middle;
+            if (codepoint < read32(group)) {
+                high = middle;
+            } else if (codepoint > read32(group + 4)) {
+                low = middle + 1;
+            } else {
+                return read32(group + 8) + codepoint - read32(group);
+            }
+        }
+        return 0;
+    }
+
+    if (format == 4 && codepoint <= 0xFFFF) {
+        uint32_t segmentCount = read16(m_cmap + 6) / 2;
+        uint32_t endCodes = m_cmap + 14;
+        uint32_t startCodes = endCodes + 2 * segmentCount + 2;
+        uint32_t deltas = startCodes + 2 * segmentCount;
+        uint32_t rangeOffsets = deltas + 2 * segmentCount;
+
+        // First segment whose end code is at least the code point
+        uint32_t low = 0;
+        uint32_t high = segmentCount;
+        while (low < high) {
+            uint32_t middle = (low + high) / 2;
+            if (read16(endCodes + 2 * middle) < codepoint) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (low >= segmentCount) return 0;
+
+        uint16_t start = read16(startCodes + 2 * low);
+        if (codepoint < start) return 0;
+
+        uint16_t delta = read16(deltas + 2 * low);
+        uint16_t rangeOffset = read16(rangeOffsets + 2 * low);
+        if (rangeOffset == 0) {
+            return (codepoint + delta) & 0xFFFF;
+        }
+        uint16_t glyph = read16(rangeOffsets + 2 * low + rangeOffset + 2 * (codepoint - start));
+        return glyph ? (glyph + delta) & 0xFFFF : 0;
+    }
+
+    return 0;
+}
+
+float Font::getAdvance(uint32_t glyph) const {
+    uint32_t metric = std::min(glyph, m_horizontalMetricCount - 1);
+    return read16(m_hmtx + 4 * metric) / m_unitsPerEm;
+}
+
+float Font::getKerning(uint32_t left, uint32_t right) const {
+    int adjustment = m_gpos ? gposAdjustment(left, right) : 0;
+    if (adjustment == 0 && m_kern) {
+        adjustment = kernTableAdjustment(left, right);
+    }
+    return adjustment / m_unitsPerEm;
+}
+
+bool Font::getGlyphBounds(uint32_t glyph, glm::vec2& min, glm::vec2& max) const {
+    uint32_t begin, end;
+    if (!getGlyphRange(glyph, begin, end) || readSigned16(begin) == 0) return false;
+
+    min = glm::vec2(readSigned16(begin + 2), readSigned16(begin + 4)) / m_unitsPerEm;
+    max = glm::vec2(readSigned16(begin + 6), readSigned16(begin + 8)) / m_unitsPerEm;
+    return true;
+}
+
+float Font::shape(const std::string& text, std::vector<ShapedGlyph>& glyphs) const {
+    glyphs.clear();
+
+    float pen = 0.0f;
+    uint32_t previous = 0;
+    size_t index = 0;
+    while (index < text.size()) {
+        uint32_t glyph = getGlyphIndex(decodeUtf8(text, index));
+        if (!glyphs.empty()) {
+            pen += getKerning(previous, glyph);
+        }
+        glyphs.push_back(ShapedGlyph{glyph, pen});
+        pen += getAdvance(glyph);
+        previous = glyph;
+    }
+    return pen;
+}
+
+int Font::kernTableAdjustment(uint32_t left, uint32_t right) const {
+    // Version 0 kern table; the first horizontal format 0 subtable is used
+    if (read16(m_kern) != 0) return 0;
+
+    uint16_t tableCount = read16(m_kern + 2);
+    uint32_t subtable = m_kern + 4;
+    for (uint32_t i = 0; i < tableCount; ++i) {
+        uint16_t length = read16(subtable + 2);
+        uint16_t coverage = read16(subtable + 4);
+        if ((coverage & 0x1) && !(coverage & 0x4) && (coverage >> 8) == 0) {
+            uint32_t key = (left << 16) | right;
+            uint32_t low = 0;
+            uint32_t high = read16(subtable + 6);
+            while (low < high) {
+                uint32_t middle = (low + high) / 2;
+                uint32_t pair = subtable + 14 + 6 * middle;
+                uint32_t pairKey = read32(pair);
+                if (pairKey < key) {
+                    low = middle + 1;
+                } else if (pairKey > key) {
+                    high = middle;
+                } else {
+                    return readSigned16(pair + 4);
+                }
+            }
+            return 0;
+        }
+        subtable += length;
+    }
+    return 0;
+}
+
+int Font::gposAdjustment(uint32_t left, uint32_t right) const {
+    // Pair adjustment lookups (type 2, possibly behind extension lookups),
+    // whatever feature they belong to; only the first glyph's x advance is read
+    uint32_t lookupList = m_gpos + read16(m_gpos + 8);
+    uint16_t lookupCount = read16(lookupList);
+    for (uint32_t i = 0; i < lookupCount; ++i) {
+        uint32_t lookup = lookupList + read16(lookupList + 2 + 2 * i);
+        uint16_t lookupType = read16(lookup);
+        uint16_t subtableCount = read16(lookup + 4);
+
+        for (uint32_t j = 0; j < subtableCount; ++j) {
+            uint32_t subtable = lookup + read16(lookup + 6 + 2 * j);
+            uint16_t type = lookupType;
+            if (type == 9) {
+                type = read16(subtable + 2);
+                subtable += read32(subtable + 4);
+            }
+            if (type != 2) continue;
+
+            int covered = coverageIndex(subtable + read16(subtable + 2), left);
+            if (covered < 0) continue;
+
+            uint16_t format = read16(subtable);
+            uint16_t valueFormat1 = read16(subtable + 4);
+            uint16_t valueFormat2 = read16(subtable + 6);
+            if (!(valueFormat1 & 0x4)) continue;
+
+            uint32_t size1 = 2 * countBits(valueFormat1);
+            uint32_t size2 = 2 * countBits(valueFormat2);
+            uint32_t advanceOffset = 2 * countBits(valueFormat1 & 0x3);
+
+            if (format == 1) {
+                uint32_t pairSet = subtable + read16(subtable + 10 + 2 * covered);
+                uint32_t recordSize = 2 + size1 + size2;
+                uint32_t low = 0;
+                uint32_t high = read16(pairSet);
+                while (low < high) {
+                    uint32_t middle = (low + high) / 2;
+                    uint32_t record = pairSet + 2 + recordSize * middle;
+                    uint16_t second = read16(record);
+                    if (second < right) {
+                        low = middle + 1;
+                    } else if (second > right) {
+                        high = middle;
+                    } else {
+                        return readSigned16(record + 2 + advanceOffset);
+                    }
+                }
+            } else if (format == 2) {
+                int class1 = glyphClass(subtable + read16(subtable + 8), left);
+                int class2 = glyphClass(subtable + read16(subtable + 10), right);
+                uint16_t class1Count = read16(subtable + 12);
+                uint16_t class2Count = read16(subtable + 14);
+                if (class1 < class1Count && class2 < class2Count) {
+                    uint32_t record = subtable + 16 + (class1 * class2Count + class2) * (size1 + size2);
+                    return readSigned16(record + advanceOffset);
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int Font::coverageIndex(uint32_t coverage, uint32_t glyph) const {
+    uint16_t format = read16(coverage);
+    uint32_t low = 0;
+    uint32_t high = read16(coverage + 2);
+
+    if (format == 1) {
+        while (low < high) {
+            uint32_t middle = (low + high) / 2;
+            uint16_t value = read16(coverage + 4 + 2 * middle);
+            if (value < glyph) {
+                low = middle + 1;
+            } else if (value > glyph) {
+                high = middle;
+            } else {
+                return static_cast<int>(middle);
+            }
+        }
+    } else if (format == 2) {
+        while (low < high) {
+            uint32_t middle = (low + high) / 2;
+            uint32_t range = coverage + 4 + 6 * middle;
+            if (read16(range + 2) < glyph) {
+                low = middle + 1;
+            } else if (read16(range) > glyph) {
+                high = middle;
+            } else {
+                return read16(range + 4) + static_cast<int>(glyph - read16(range));
+            }
+        }
+    }
+    return -1;
+}
+
+int Font::glyphClass(uint32_t classDefinition, uint32_t glyph) const {
+    uint16_t format = read16(classDefinition);
+
+    if (format == 1) {
+        uint16_t start = read16(classDefinition + 2);
+        uint16_t count = read16(classDefinition + 4);
+        if (glyph >= start && glyph < static_cast<uint32_t>(start) + count) {
+            return read16(classDefinition + 6 + 2 * (glyph - start));
+        }
+    } else if (format == 2) {
+        uint32_t low = 0;
+        uint32_t high = read16(classDefinition + 2);
+        while (low < high) {
+            uint32_t middle = (low + high) / 2;
+            uint32_t range = classDefinition + 4 + 6 * middle;
+            if (read16(range + 2) < glyph) {
+                low = middle + 1;
+            } else if (read16(range) > glyph) {
+                high = middle;
+            } else {
+                return read16(range + 4);
+            }
+        }
+    }
+    return 0;
+}
+
+// ============================================================================
+// OUTLINES
+// ============================================================================
+
+bool Font::getGlyphRange(uint32_t glyph, uint32_t& begin, uint32_t& end) const {
+    if (glyph >= m_glyphCount) return false;
+
+    if (m_indexToLocFormat == 0) {
+        begin = m_glyf + read16(m_loca + 2 * glyph) * 2u;
+        end = m_glyf + read16(m_loca + 2 * glyph + 2) * 2u;
+    } else {
+        begin = m_glyf + read32(m_loca + 4 * glyph);
+        end = m_glyf + read32(m_loca + 4 * glyph + 4);
+    }
+    return begin < end && end <= m_data.size();
+}
+
+bool Font::appendOutline(uint32_t glyph, const glm::mat3& transform, int depth, std::vector<OutlinePoint>& points) const {
+    uint32_t begin, end;
+    if (!getGlyphRange(glyph, begin, end)) return false;
+
+    int16_t contourCount = readSigned16(begin);
+
+    if (contourCount >= 0) {
+        if (contourCount == 0) return false;
+
+        uint32_t endPoints = begin + 10;
+        uint32_t pointCount = read16(endPoints + 2 * (contourCount - 1)) + 1u;
+        uint32_t cursor = endPoints + 2 * contourCount;
+        cursor += 2 + read16(cursor);   // Skip the hinting instructions
+
+        // Flags, with run-length repeats
+        std::vector<uint8_t> flags(pointCount);
+        for (uint32_t i = 0; i < pointCount;) {
+            uint8_t flag = read8(cursor++);
+            flags[i++] = flag;
+            if (flag & 0x8) {
+                for (uint8_t repeat = read8(cursor++); repeat > 0 && i < pointCount; --repeat) {
+                    flags[i++] = flag;
+                }
+            }
+        }
+
+        // Delta-encoded coordinates: short values carry their sign in a
+        // flag bit; long values may instead repeat the previous coordinate
+        std::vector<glm::vec2> positions(pointCount);
+        for (int axis = 0; axis < 2; ++axis) {
+            uint8_t shortBit = axis == 0 ? 0x2 : 0x4;
+            uint8_t sameBit = axis == 0 ? 0x10 : 0x20;
+            int value = 0;
+            for (uint32_t i = 0; i < pointCount; ++i) {
+                if (flags[i] & shortBit) {
+                    int delta = read8(cursor++);
+                    value += (flags[i] & sameBit) ? delta : -delta;
+                } else if (!(flags[i] & sameBit)) {
+                    value += readSigned16(cursor);
+                    cursor += 2;
+                }
+                positions[i][axis] = static_cast<float>(value);
+            }
+        }
+
+        uint32_t contour = 0;
+        uint32_t contourEnd = read16(endPoints);
+        for (uint32_t i = 0; i < pointCount; ++i) {
+            OutlinePoint point;
+            point.position = glm::vec2(transform * glm::vec3(positions[i], 1.0f));
+            point.onCurve = (flags[i] & 0x1) != 0;
+            point.contourEnd = i == contourEnd;
+            points.push_back(point);
+            if (point.contourEnd && ++contour < static_cast<uint32_t>(contourCount)) {
+                contourEnd = read16(endPoints + 2 * contour);
+            }
+        }
+        return true;
+    }
+
+    // Composite glyph: transformed references to other glyphs
+    if (depth >= kMaxCompositeDepth) return false;
+
+    bool appended = false;
+    uint32_t cursor = begin + 10;
+    uint16_t flags;
+    do {
+        flags = read16(cursor);
+        uint16_t component = read16(cursor + 2);
+        cursor += 4;
+
+        int argument1, argument2;
+        if (flags & 0x1) {
+            argument1 = readSigned16(cursor);
+            argument2 = readSigned16(cursor + 2);
+            cursor += 4;
+        } else {
+            argument1 = static_cast<int8_t>(read8(cursor));
+            argument2 = static_cast<int8_t>(read8(cursor + 1));
+            cursor += 2;
+        }
+
+        // Point-matched placement is not supported; such components stay at the origin
+        glm::vec2 offset(0.0f);
+        if (flags & 0x2) {
+            offset = glm::vec2(static_cast<float>(argument1), static_cast<float>(argument2));
+        }
+
+        // 2x2 matrix in F2Dot14
+        float a = 1.0f, b = 0.0f, c = 0.0f, d = 1.0f;
+        if (flags & 0x8) {
+            a = d = readSigned16(cursor) / 16384.0f;
+            cursor += 2;
+        } else if (flags & 0x40) {
+            a = readSigned16(cursor) / 16384.0f;
+            d = readSigned16(cursor + 2) / 16384.0f;
+            cursor += 4;
+        } else if (flags & 0x80) {
+            a = readSigned16(cursor) / 16384.0f;
+            b = readSigned16(cursor + 2) / 16384.0f;
+            c = readSigned16(cursor + 4) / 16384.0f;
+            d = readSigned16(cursor + 6) / 16384.0f;
+            cursor += 8;
+        }
+
+        glm::mat3 local(a, b, 0.0f,
+                        c, d, 0.0f,
+                        offset.x, offset.y, 1.0f);
+        appended = appendOutline(component, transform * local, depth + 1, points) || appended;
+    } while (flags & 0x20);
+
+    return appended;
+}
+
+bool Font::rasterizeGlyph(uint32_t glyph, float pixelsPerEm, GlyphBitmap& bitmap) const {
+    bitmap = GlyphBitmap();
+
+    std::vector<glm::vec2> lines;
+    glm::vec2 low, high;
+    if (!flattenOutline(glyph, pixelsPerEm, lines, low, high)) return false;
+
+    // Pixel bounds with a one-pixel border
+    bitmap.left = static_cast<int>(std::floor(low.x)) - 1;
+    bitmap.top = static_cast<int>(std::ceil(high.y)) + 1;
+    bitmap.width = static_cast<int>(std::ceil(high.x)) + 1 - bitmap.left;
+    bitmap.height = bitmap.top - (static_cast<int>(std::floor(low.y)) - 1);
+    if (bitmap.width <= 2 || bitmap.height <= 2) return false;
+
+    // Bitmap space: x from the left edge, y down from the top edge
+    CoverageAccumulator accumulator(bitmap.width, bitmap.height);
+    glm::vec2 origin(static_cast<float>(bitmap.left), static_cast<float>(bitmap.top));
+    for (size_t i = 0; i < lines.size(); i += 2) {
+        accumulator.addLine(glm::vec2(lines[i].x - origin.x, origin.y - lines[i].y),
+                            glm::vec2(lines[i + 1].x - origin.x, origin.y - lines[i + 1].y));
+    }
+
+    accumulator.resolve(bitmap.coverage);
+    return true;
+}
+
+bool Font::generateDistanceField(uint32_t glyph, float pixelsPerEm, float spread, GlyphBitmap& bitmap) const {
+    bitmap = GlyphBitmap();
+
+    std::vector<glm::vec2> lines;
+    glm::vec2 low, high;
+    if (!flattenOutline(glyph, pixelsPerEm, lines, low, high)) return false;
+
+    // The field reaches spread pixels past the outline, plus a border that
+    // stays fully outside
+    int border = static_cast<int>(std::ceil(spread)) + 1;
+    bitmap.left = static_cast<int>(std::floor(low.x)) - border;
+    bitmap.top = static_cast<int>(std::ceil(high.y)) + border;
+    bitmap.width = static_cast<int>(std::ceil(high.x)) + border - bitmap.left;
+    bitmap.height = bitmap.top - (static_cast<int>(std::floor(low.y)) - border);
+
+    glm::vec2 origin(static_cast<float>(bitmap.left), static_cast<float>(bitmap.top));
+    for (glm::vec2& point : lines) {
+        point = glm::vec2(point.x - origin.x, origin.y - point.y);
+    }
+
+    computeDistanceField(lines, bitmap.width, bitmap.height, spread, bitmap.coverage);
+    return true;
+}
+
+bool Font::flattenOutline(uint32_t glyph, float pixelsPerEm, std::vector<glm::vec2>& lines,
+                          glm::vec2& low, glm::vec2& high) const {
+    lines.clear();
+
+    std::vector<OutlinePoint> points;
+    if (!appendOutline(glyph, glm::mat3(1.0f), 0, points) || points.empty()) return false;
+
+    float scale = pixelsPerEm / m_unitsPerEm;
+    for (OutlinePoint& point : points) {
+        point.position *= scale;
+    }
+
+    size_t contourBegin = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (!points[i].contourEnd) continue;
+
+        size_t count = i + 1 - contourBegin;
+        const OutlinePoint* contour = &points[contourBegin];
+        contourBegin = i + 1;
+        if (count < 2) continue;
+
+        // Start on an on-curve point; with none, at the midpoint of the
+        // first two control points (implied on-curve)
+        size_t first = 0;
+        while (first < count && !contour[first].onCurve) ++first;
+        glm::vec2 start;
+        if (first < count) {
+            start = contour[first].position;
+        } else {
+            first = 0;
+            start = (contour[0].position + contour[1].position) * 0.5f;
+        }
+
+        glm::vec2 current = start;
+        glm::vec2 control(0.0f);
+        bool hasControl = false;
+        for (size_t step = 1; step <= count; ++step) {
+            const OutlinePoint& point = contour[(first + step) % count];
+            if (point.onCurve) {
+                if (hasControl) {
+                    appendQuadratic(current, control, point.position, lines);
+                } else {
+                    lines.push_back(current);
+                    lines.push_back(point.position);
+                }
+                current = point.position;
+                hasControl = false;
+            } else {
+                if (hasControl) {
+                    // Two control points in a row imply an on-curve point between them
+                    glm::vec2 middle = (control + point.position) * 0.5f;
+                    appendQuadratic(current, control, middle, lines);
+                    current = middle;
+                }
+                control = point.position;
+                hasControl = true;
+            }
+        }
+
+        // Close the contour
+        if (hasControl) {
+            appendQuadratic(current, control, start, lines);
+        } else {
+            lines.push_back(current);
+            lines.push_back(start);
+        }
+    }
+    if (lines.empty()) return false;
+
+    low = glm::vec2(INFINITY);
+    high = glm::vec2(-INFINITY);
+    for (const glm::vec2& point : lines) {
+        low = glm::min(low, point);
+        high = glm::max(high, point);
+    }
+    return true;
+}
+
+// ============================================================================
+// BINARY READING
+// ============================================================================
+
+uint8_t Font::read8(uint32_t offset) const {
+    return offset < m_data.size() ? m_data[offset] : 0;
+}
+
+uint16_t Font::read16(uint32_t offset) const {
+    if (static_cast<size_t>(offset) + 2 > m_data.size()) return 0;
+    return static_cast<uint16_t>((m_data[offset] << 8) | m_data[offset + 1]);
+}
+
+int16_t Font::readSigned16(uint32_t offset) const {
+    return static_cast<int16_t>(read16(offset));
+}
+
+uint32_t Font::read32(uint32_t offset) const {
+    if (static_cast<size_t>(offset) + 4 > m_data.size()) return 0;
+    return (static_cast<uint32_t>(m_data[offset]) << 24) | (static_cast<uint32_t>(m_data[offset + 1]) << 16) |
+           (static_cast<uint32_t>(m_data[offset + 2]) << 8) | m_data[offset + 3];
+}
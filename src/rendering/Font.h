@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief One glyph of a laid-out line of text
+ */
+struct ShapedGlyph {
+    uint32_t glyph;     // Glyph index in the font
+    float x;            // Pen position on the baseline, in em units
+};
+
+/**
+ * @brief 8-bit bitmap of one glyph: coverage or a signed distance field
+ *
+ * Rows are stored top first. left and top place the bitmap's top-left
+ * corner relative to the pen position on the baseline, in pixels with y
+ * pointing up. Bitmaps keep an empty border so they can be sampled
+ * bilinearly without bleeding.
+ */
+struct GlyphBitmap {
+    int width = 0;
+    int height = 0;
+    int left = 0;
+    int top = 0;
+    std::vector<uint8_t> coverage;
+};
+
+/**
+ * @brief TrueType font: metrics, kerning, shaping and glyph rasterization
+ *
+ * Parses the sfnt tables directly from the font file: cmap (formats 4 and
+ * 12), hmtx, simple and composite glyf outlines, and kerning from both
+ * the legacy kern table and GPOS pair adjustments. CFF-flavoured OpenType
+ * fonts and font collections are not supported. All metrics are returned
+ * in em units, so a value times the font size gives world units.
+ *
+ * Glyphs are rasterized with exact area coverage: outlines are flattened
+ * into line segments whose signed area is accumulated per pixel and
+ * integrated along each row, which fills with the nonzero rule. The same
+ * segments give signed distance fields for scalable rendering.
+ *
+ * Fonts are found by family name through a registry. Families can be
+ * registered with a file explicitly; otherwise the usual font directories
+ * are searched for a matching file name. DejaVu Sans ships in
+ * assets/fonts and is registered ahead of the host's fonts; families
+ * that can't be found fall back to it, so text renders the same on
+ * machines with different fonts installed.
+ */
+class Font {
+public:
+    static std::shared_ptr<Font> loadFromFile(const std::string& path);
+    static std::shared_ptr<Font> loadFromMemory(std::vector<uint8_t> data);
+
+    // Font registry
+    static void registerFamily(const std::string& family, const std::string& path, bool bold = false, bool italic = false);
+    static std::shared_ptr<Font> find(const std::string& family, bool bold = false, bool italic = false);
+
+    // Unique per loaded font, for cache keys
+    uint32_t getId() const;
+
+    // Vertical metrics; the descent is negative
+    float getAscent() const;
+    float getDescent() const;
+    float getLineGap() const;
+
+    // Glyph metrics
+    uint32_t getGlyphIndex(uint32_t codepoint) const;
+    float getAdvance(uint32_t glyph) const;
+    float getKerning(uint32_t left, uint32_t right) const;
+
+    // Outline bounding box from the glyph header; false for empty glyphs
+    bool getGlyphBounds(uint32_t glyph, glm::vec2& min, glm::vec2& max) const;
+
+    /**
+     * @brief Lays out UTF-8 text on a single line
+     *
+     * Fills glyphs with one entry per code point, starting at pen position
+     * 0 and applying advances and kerning. Returns the total advance.
+     */
+    float shape(const std::string& text, std::vector<ShapedGlyph>& glyphs) const;
+
+    // Rasterizes a glyph at the given pixels per em; false for empty glyphs
+    bool rasterizeGlyph(uint32_t glyph, float pixelsPerEm, GlyphBitmap& bitmap) const;
+
+    /**
+     * @brief Signed distance field of a glyph; false for empty glyphs
+     *
+     * Each pixel stores the distance from its center to the outline,
+     * mapped so 128 lies on the edge, 255 is spread pixels inside and 0 is
+     * spread pixels or more outside. The bitmap extends spread pixels past
+     * the outline. Sampled and thresholded at any scale, the field gives
+     * sharp edges, and shifting the threshold grows or shrinks the glyph.
+     */
+    bool generateDistanceField(uint32_t glyph, float pixelsPerEm, float spread, GlyphBitmap& bitmap) const;
+
+private:
+    // Outline point in font units, after composite transforms
+    struct OutlinePoint {
+        glm::vec2 position;
+        bool onCurve;
+        bool contourEnd;
+    };
+
+    std::vector<uint8_t> m_data;
+    uint32_t m_id;
+    float m_unitsPerEm;
+    float m_ascent;
+    float m_descent;
+    float m_lineGap;
+    uint32_t m_glyphCount;
+    uint32_t m_horizontalMetricCount;
+    int m_indexToLocFormat;
+
+    // Table offsets into m_data, 0 when absent
+    uint32_t m_cmap;
+    uint32_t m_glyf;
+    uint32_t m_loca;
+    uint32_t m_hmtx;
+    uint32_t m_kern;
+    uint32_t m_gpos;
+
+    Font();
+
+    // Helper methods
+    bool parse();
+    uint32_t findTable(const char* tag) const;
+    uint32_t selectCharacterMap() const;
+    bool getGlyphRange(uint32_t glyph, uint32_t& begin, uint32_t& end) const;
+    bool appendOutline(uint32_t glyph, const glm::mat3& transform, int depth, std::vector<OutlinePoint>& points) const;
+    bool flattenOutline(uint32_t glyph, float pixelsPerEm, std::vector<glm::vec2>& lines, glm::vec2& low, glm::vec2& high) const;
+    int kernTableAdjustment(uint32_t left, uint32_t right) const;
+    int gposAdjustment(uint32_t left, uint32_t right) const;
+    int coverageIndex(uint32_t coverage, uint32_t glyph) const;
+    int glyphClass(uint32_t classDefinition, uint32_t glyph) const;
+
+    // Bounds-checked big-endian reads; out-of-range reads return 0
+    uint8_t read8(uint32_t offset) const;
+    uint16_t read16(uint32_t offset) const;
+    int16_t readSigned16(uint32_t offset) const;
+    uint32_t read32(uint32_t offset) const;
+};
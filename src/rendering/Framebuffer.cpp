@@ -0,0 +1,149 @@
+#include "Framebuffer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+Framebuffer::Framebuffer(int width, int height)
+    : m_width(0)
+    , m_height(0) {
+    resize(width, height);
+}
+
+Framebuffer::~Framebuffer() {
+}
+
+void Framebuffer::resize(int width, int height) {
+    m_width = std::max(1, width);
+    m_height = std::max(1, height);
+    m_pixels.assign(static_cast<size_t>(m_width) * m_height * 4, 0);
+}
+
+int Framebuffer::getWidth() const {
+    return m_width;
+}
+
+int Framebuffer::getHeight() const {
+    return m_height;
+}
+
+uint8_t* Framebuffer::getPixels() {
+    return m_pixels.data();
+}
+
+const uint8_t* Framebuffer::getPixels() const {
+    return m_pixels.data();
+}
+
+size_t Framebuffer::getSizeInBytes() const {
+    return m_pixels.size();
+}
+
+glm::vec4 Framebuffer::getPixel(int x, int y) const {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return glm::vec4(0.0f);
+
+    const uint8_t* pixel = &m_pixels[(static_cast<size_t>(y) * m_width + x) * 4];
+    return glm::vec4(pixel[0], pixel[1], pixel[2], pixel[3]) / 255.0f;
+}
+
+void Framebuffer::clear(const glm::vec4& color) {
+    uint8_t r = static_cast<uint8_t>(glm::clamp(color.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+    uint8_t g = static_cast<uint8_t>(glm::clamp(color.g, 0.0f, 1.0f) * 255.0f + 0.5f);
+    uint8_t b = static_cast<uint8_t>(glm::clamp(color.b, 0.0f, 1.0f) * 255.0f + 0.5f);
+    uint8_t a = static_cast<uint8_t>(glm::clamp(color.a, 0.0f, 1.0f) * 255.0f + 0.5f);
+
+    // Fill the first row, then copy it down
+    size_t rowSize = static_cast<size_t>(m_width) * 4;
+    for (size_t i = 0; i < rowSize; i += 4) {
+        m_pixels[i + 0] = r;
+        m_pixels[i + 1] = g;
+        m_pixels[i + 2] = b;
+        m_pixels[i + 3] = a;
+    }
+    for (size_t offset = rowSize; offset < m_pixels.size(); offset += rowSize) {
+        memcpy(&m_pixels[offset], m_pixels.data(), rowSize);
+    }
+}
+
+void Framebuffer::clear(const glm::vec4& color, const PixelRect& rect) {
+    int x0 = std::max(rect.x0, 0);
+    int y0 = std::max(rect.y0, 0);
+    int x1 = std::min(rect.x1, m_width);
+    int y1 = std::min(rect.y1, m_height);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    uint8_t value[4];
+    for (int i = 0; i < 4; ++i) {
+        value[i] = static_cast<uint8_t>(glm::clamp(color[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    // Fill the rectangle's first row, then copy it down
+    size_t rowOffset = (static_cast<size_t>(y0) * m_width + x0) * 4;
+    size_t spanSize = static_cast<size_t>(x1 - x0) * 4;
+    for (size_t i = 0; i < spanSize; i += 4) {
+        memcpy(&m_pixels[rowOffset + i], value, 4);
+    }
+    for (int y = y0 + 1; y < y1; ++y) {
+        memcpy(&m_pixels[(static_cast<size_t>(y) * m_width + x0) * 4], &m_pixels[rowOffset], spanSize);
+    }
+}
+
+void Framebuffer::fillConvexPolygon(const glm::vec2* points, size_t count, const glm::vec4& color) {
+    if (!points || count < 3 || color.a <= 0.0f) return;
+
+    // Pixel-space bounding box, clipped to the framebuffer
+    glm::vec2 minPoint = points[0];
+    glm::vec2 maxPoint = points[0];
+    for (size_t i = 1; i < count; ++i) {
+        minPoint = glm::min(minPoint, points[i]);
+        maxPoint = glm::max(maxPoint, points[i]);
+    }
+
+    int x0 = std::max(0, static_cast<int>(std::floor(minPoint.x)));
+    int y0 = std::max(0, static_cast<int>(std::floor(minPoint.y)));
+    int x1 = std::min(m_width - 1, static_cast<int>(std::ceil(maxPoint.x)));
+    int y1 = std::min(m_height - 1, static_cast<int>(std::ceil(maxPoint.y)));
+    if (x0 > x1 || y0 > y1) return;
+
+    // Winding decides which side of each edge is inside
+    float area = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const glm::vec2& a = points[i];
+        const glm::vec2& b = points[(i + 1) % count];
+        area += a.x * b.y - b.x * a.y;
+    }
+    if (area == 0.0f) return;
+    float winding = area > 0.0f ? 1.0f : -1.0f;
+
+    // Sample at pixel centers against every edge function
+    for (int y = y0; y <= y1; ++y) {
+        float py = y + 0.5f;
+        uint8_t* row = &m_pixels[static_cast<size_t>(y) * m_width * 4];
+
+        for (int x = x0; x <= x1; ++x) {
+            float px = x + 0.5f;
+            bool inside = true;
+
+            for (size_t i = 0; i < count && inside; ++i) {
+                const glm::vec2& a = points[i];
+                const glm::vec2& b = points[(i + 1) % count];
+                float edge = (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+                inside = edge * winding >= 0.0f;
+            }
+
+            if (inside) {
+                blendPixel(&row[x * 4], color);
+            }
+        }
+    }
+}
+
+void Framebuffer::blendPixel(uint8_t* pixel, const glm::vec4& color) {
+    // Source-over blending, matching glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
+    float alpha = glm::clamp(color.a, 0.0f, 1.0f);
+    float inverse = 1.0f - alpha;
+
+    pixel[0] = static_cast<uint8_t>(glm::clamp(color.r, 0.0f, 1.0f) * 255.0f * alpha + pixel[0] * inverse + 0.5f);
+    pixel[1] = static_cast<uint8_t>(glm::clamp(color.g, 0.0f, 1.0f) * 255.0f * alpha + pixel[1] * inverse + 0.5f);
+    pixel[2] = static_cast<uint8_t>(glm::clamp(color.b, 0.0f, 1.0f) * 255.0f * alpha + pixel[2] * inverse + 0.5f);
+    pixel[3] = static_cast<uint8_t>(255.0f * alpha + pixel[3] * inverse + 0.5f);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Pixel rectangle [x0, x1) x [y0, y1), row 0 at the top
+ */
+struct PixelRect {
+    int x0, y0;
+    int x1, y1;
+};
+
+/**
+ * @brief In-memory RGBA8 framebuffer
+ *
+ * Render target used by the headless renderer. Pixels are stored
+ * row by row with the top row first, four bytes (R, G, B, A) per pixel.
+ */
+class Framebuffer {
+public:
+    Framebuffer(int width, int height);
+    ~Framebuffer();
+
+    // Size
+    void resize(int width, int height);
+    int getWidth() const;
+    int getHeight() const;
+
+    // Pixel access
+    uint8_t* getPixels();
+    const uint8_t* getPixels() const;
+    size_t getSizeInBytes() const;
+    glm::vec4 getPixel(int x, int y) const;
+
+    // Drawing
+    void clear(const glm::vec4& color);
+    void clear(const glm::vec4& color, const PixelRect& rect);
+    void fillConvexPolygon(const glm::vec2* points, size_t count, const glm::vec4& color);
+
+private:
+    int m_width;
+    int m_height;
+    std::vector<uint8_t> m_pixels;
+
+    // Helper methods
+    void blendPixel(uint8_t* pixel, const glm::vec4& color);
+};
@@ -0,0 +1,163 @@
+#include "GlyphAtlas.h"
+#include "Font.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Distance field texels per em, and texels of distance stored past the
+// outline. The spread bounds outline and glow widths to 0.2 em.
+const float kPixelsPerEm = 48.0f;
+const float kSpread = 9.6f;
+
+const int kAtlasWidth = 1024;
+const int kInitialHeight = 256;
+const int kMaxHeight = 4096;
+
+// Texels kept between glyphs; fields end in an all-outside border, so
+// bilinear sampling never bleeds into a neighbour
+const int kGlyphSpacing = 1;
+
+// Shelves are reused by glyphs at most this much shorter than the shelf
+const float kShelfSlack = 1.25f;
+
+uint64_t makeKey(const Font& font, uint32_t glyph) {
+    return (static_cast<uint64_t>(font.getId()) << 32) | glyph;
+}
+
+} // namespace
+
+GlyphAtlas::GlyphAtlas()
+    : m_width(kAtlasWidth)
+    , m_height(kInitialHeight)
+    , m_pixels(static_cast<size_t>(kAtlasWidth) * kInitialHeight, 0)
+    , m_shelfEnd(0)
+    , m_full(false)
+    , m_dirtyBegin(0)
+    , m_dirtyEnd(kInitialHeight) {
+}
+
+float GlyphAtlas::getPixelsPerEm() {
+    return kPixelsPerEm;
+}
+
+float GlyphAtlas::getSpread() {
+    return kSpread;
+}
+
+const GlyphAtlas::Entry* GlyphAtlas::getGlyph(const Font& font, uint32_t glyph) {
+    uint64_t key = makeKey(font, glyph);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) return &it->second;
+    if (m_full) return nullptr;
+
+    Entry entry;
+    entry.texRect = glm::vec4(0.0f);
+    entry.offset = glm::vec2(0.0f);
+    entry.size = glm::vec2(0.0f);
+    entry.empty = true;
+
+    GlyphBitmap bitmap;
+    if (font.generateDistanceField(glyph, kPixelsPerEm, kSpread, bitmap)) {
+        int x, y;
+        if (!allocate(bitmap.width, bitmap.height, x, y)) {
+            m_full = true;
+            return nullptr;
+        }
+
+        for (int row = 0; row < bitmap.height; ++row) {
+            std::memcpy(&m_pixels[static_cast<size_t>(y + row) * m_width + x],
+                        &bitmap.coverage[static_cast<size_t>(row) * bitmap.width], bitmap.width);
+        }
+        m_dirtyBegin = std::min(m_dirtyBegin, y);
+        m_dirtyEnd = std::max(m_dirtyEnd, y + bitmap.height);
+
+        // Atlas rows run downwards, so the glyph's bottom is its last row
+        entry.texRect = glm::vec4(x, y + bitmap.height, x + bitmap.width, y);
+        entry.offset = glm::vec2(bitmap.left, bitmap.top - bitmap.height);
+        entry.size = glm::vec2(bitmap.width, bitmap.height);
+        entry.empty = false;
+    }
+
+    return &m_entries.emplace(key, entry).first->second;
+}
+
+bool GlyphAtlas::beginFrame() {
+    if (!m_full) return false;
+    clear();
+    return true;
+}
+
+int GlyphAtlas::getWidth() const {
+    return m_width;
+}
+
+int GlyphAtlas::getHeight() const {
+    return m_height;
+}
+
+const uint8_t* GlyphAtlas::getPixels() const {
+    return m_pixels.data();
+}
+
+bool GlyphAtlas::isDirty() const {
+    return m_dirtyBegin < m_dirtyEnd;
+}
+
+int GlyphAtlas::getDirtyBegin() const {
+    return m_dirtyBegin;
+}
+
+int GlyphAtlas::getDirtyEnd() const {
+    return m_dirtyEnd;
+}
+
+void GlyphAtlas::markClean() {
+    m_dirtyBegin = m_height;
+    m_dirtyEnd = 0;
+}
+
+bool GlyphAtlas::allocate(int width, int height, int& x, int& y) {
+    int paddedWidth = width + kGlyphSpacing;
+    int paddedHeight = height + kGlyphSpacing;
+    if (paddedWidth > m_width) return false;
+
+    // Best-fitting shelf with room left
+    Shelf* best = nullptr;
+    for (Shelf& shelf : m_shelves) {
+        if (shelf.height >= paddedHeight && shelf.height <= paddedHeight * kShelfSlack &&
+            shelf.x + paddedWidth <= m_width && (!best || shelf.height < best->height)) {
+            best = &shelf;
+        }
+    }
+
+    if (!best) {
+        // Open a new shelf, growing the texture downwards as needed; rows
+        // are appended, so existing glyphs keep their texel positions
+        while (m_shelfEnd + paddedHeight > m_height) {
+            if (m_height >= kMaxHeight) return false;
+            m_height *= 2;
+            m_pixels.resize(static_cast<size_t>(m_width) * m_height, 0);
+            m_dirtyBegin = 0;
+            m_dirtyEnd = m_height;
+        }
+        m_shelves.push_back(Shelf{m_shelfEnd, paddedHeight, 0});
+        m_shelfEnd += paddedHeight;
+        best = &m_shelves.back();
+    }
+
+    x = best->x;
+    y = best->y;
+    best->x += paddedWidth;
+    return true;
+}
+
+void GlyphAtlas::clear() {
+    std::fill(m_pixels.begin(), m_pixels.end(), 0);
+    m_shelves.clear();
+    m_entries.clear();
+    m_shelfEnd = 0;
+    m_full = false;
+    m_dirtyBegin = 0;
+    m_dirtyEnd = m_height;
+}
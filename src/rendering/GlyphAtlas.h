@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Forward declarations
+class Font;
+
+/**
+ * @brief Single-channel texture of glyph distance fields, shared by all text
+ *
+ * Every glyph is stored once per font, as a signed distance field at a
+ * fixed resolution (Font::generateDistanceField), and kept for the
+ * lifetime of the atlas. A distance field thresholds to a sharp edge at
+ * any scale or rotation, so zooming or animating the font size never
+ * rasterizes again. Thresholding further out grows the glyph, which draws
+ * outlines and glows from the same entry, up to getSpread() texels.
+ *
+ * Every font shares one texture so a frame's glyphs can be drawn in the
+ * same batch as shapes. Glyphs are packed on shelves; the texture grows
+ * taller when it runs out of space, and if it reaches its largest size it
+ * is emptied at the start of the next frame.
+ */
+class GlyphAtlas {
+public:
+    struct Entry {
+        glm::vec4 texRect;  // Texels: left, bottom, right, top
+        glm::vec2 offset;   // Bottom-left corner from the pen position, in texels (y up)
+        glm::vec2 size;     // In texels
+        bool empty;         // Nothing to draw, e.g. a space
+    };
+
+    GlyphAtlas();
+
+    // Resolution of the distance fields, and how far they reach past the outline
+    static float getPixelsPerEm();
+    static float getSpread();
+
+    // Cached glyph, generated if needed; nullptr when the atlas is full
+    const Entry* getGlyph(const Font& font, uint32_t glyph);
+
+    // Empties the atlas if it filled up during the last frame; true if it did,
+    // since glyphs placed from then on can reuse the texels of old ones
+    bool beginFrame();
+
+    int getWidth() const;
+    int getHeight() const;
+    const uint8_t* getPixels() const;
+
+    // Changes since the last markClean(), as a range of rows to upload
+    bool isDirty() const;
+    int getDirtyBegin() const;
+    int getDirtyEnd() const;
+    void markClean();
+
+private:
+    struct Shelf {
+        int y;
+        int height;
+        int x;          // Next free column
+    };
+
+    int m_width;
+    int m_height;
+    std::vector<uint8_t> m_pixels;
+    std::vector<Shelf> m_shelves;
+    int m_shelfEnd;     // First row below the last shelf
+    std::unordered_map<uint64_t, Entry> m_entries;
+    bool m_full;
+    int m_dirtyBegin;
+    int m_dirtyEnd;
+
+    // Helper methods
+    bool allocate(int width, int height, int& x, int& y);
+    void clear();
+};
@@ -0,0 +1,71 @@
+#include "RenderBatch.h"
+
+namespace {
+
+RenderInstance makeInstance(const glm::mat4& clipTransform, const glm::vec4& color, RenderInstance::Shape shape) {
+    // Shapes are flat, so the z column of the transform never contributes
+    RenderInstance instance;
+    instance.axisX = clipTransform[0];
+    instance.axisY = clipTransform[1];
+    instance.origin = clipTransform[3];
+    instance.color = color;
+    instance.texRect = glm::vec4(0.0f);
+    instance.glyphEdge = glm::vec2(0.0f);
+    instance.shape = static_cast<float>(shape);
+    return instance;
+}
+
+} // namespace
+
+RenderBatch::RenderBatch() {
+}
+
+void RenderBatch::clear() {
+    m_instances.clear();
+}
+
+bool RenderBatch::empty() const {
+    return m_instances.empty();
+}
+
+size_t RenderBatch::size() const {
+    return m_instances.size();
+}
+
+void RenderBatch::addQuad(const glm::mat4& clipTransform, const glm::vec4& color) {
+    m_instances.push_back(makeInstance(clipTransform, color, RenderInstance::Quad));
+}
+
+void RenderBatch::addCircle(const glm::mat4& clipTransform, const glm::vec4& color) {
+    m_instances.push_back(makeInstance(clipTransform, color, RenderInstance::Circle));
+}
+
+void RenderBatch::addCircles(const glm::mat4& clipTransform, const float* x, const float* y, const float* radius,
+                             const glm::vec4* color, const float* opacity, size_t count, const glm::vec4& tint) {
+    // Expands clipTransform * translate(x, y) * scale(r) per circle without
+    // building the matrices
+    m_instances.reserve(m_instances.size() + count);
+    RenderInstance instance = makeInstance(clipTransform, tint, RenderInstance::Circle);
+    for (size_t i = 0; i < count; ++i) {
+        float alpha = color[i].a * tint.a * opacity[i];
+        if (alpha <= 0.0f || radius[i] <= 0.0f) continue;
+
+        instance.axisX = clipTransform[0] * radius[i];
+        instance.axisY = clipTransform[1] * radius[i];
+        instance.origin = clipTransform[0] * x[i] + clipTransform[1] * y[i] + clipTransform[3];
+        instance.color = glm::vec4(glm::vec3(color[i]) * glm::vec3(tint), alpha);
+        m_instances.push_back(instance);
+    }
+}
+
+void RenderBatch::add(const RenderInstance& instance) {
+    m_instances.push_back(instance);
+}
+
+const RenderInstance* RenderBatch::data() const {
+    return m_instances.data();
+}
+
+const std::vector<RenderInstance>& RenderBatch::getInstances() const {
+    return m_instances;
+}
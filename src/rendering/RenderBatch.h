@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief One batched shape, already placed in clip space
+ *
+ * A local point (x, y) maps to origin + axisX * x + axisY * y. Quads cover
+ * -0.5..0.5 on both axes and circles are the unit disc, so every instance
+ * is drawn from the same four corner vertices. Circles are never
+ * tessellated: both backends cover the disc analytically per pixel, so
+ * they stay round at any on-screen radius without a segment count.
+ *
+ * Glyphs are quads textured from the renderer's GlyphAtlas: texRect holds
+ * the atlas texels at the quad's (-0.5, -0.5) and (0.5, 0.5) corners.
+ * The sampled distance field, with its edge moved out by glyphEdge.x and
+ * ramped over glyphEdge.y texels (at least a pixel), gives the coverage
+ * that scales the color's alpha. Other shapes ignore both.
+ * The layout is uploaded to the GPU as-is, one instance per entry.
+ */
+struct RenderInstance {
+    enum Shape {
+        Quad = 0,
+        Circle = 1,
+        Glyph = 2
+    };
+
+    glm::vec4 axisX;
+    glm::vec4 axisY;
+    glm::vec4 origin;
+    glm::vec4 color;
+    glm::vec4 texRect;  // Glyphs: atlas texels as left, bottom, right, top
+    glm::vec2 glyphEdge; // Glyphs: edge offset outwards and ramp width, in atlas texels
+    float shape;        // Shape, as a float vertex attribute
+};
+
+/**
+ * @brief Draw list collected over one frame
+ *
+ * Renderer's drawing primitives append instances here instead of drawing
+ * immediately. The whole list is then drawn in submission order when the
+ * frame is flushed, with a single instanced draw on OpenGL.
+ */
+class RenderBatch {
+public:
+    RenderBatch();
+
+    void clear();
+    bool empty() const;
+    size_t size() const;
+
+    void addQuad(const glm::mat4& clipTransform, const glm::vec4& color);
+    void addCircle(const glm::mat4& clipTransform, const glm::vec4& color);
+    
+    // Circles of the given centers and radii, placed in clip space by the
+    // transform like addCircle(). Each color is multiplied by tint and its
+    // opacity; circles that end up fully transparent or have no radius are
+    // skipped.
+    void addCircles(const glm::mat4& clipTransform, const float* x, const float* y, const float* radius,
+                    const glm::vec4* color, const float* opacity, size_t count, const glm::vec4& tint);
+    void add(const RenderInstance& instance);
+
+    const RenderInstance* data() const;
+    const std::vector<RenderInstance>& getInstances() const;
+
+private:
+    std::vector<RenderInstance> m_instances;
+};
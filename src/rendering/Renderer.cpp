@@ -1,7 +1,138 @@
 #include "Renderer.h"
+#include "Framebuffer.h"
+#include "Font.h"
 #include <glad/glad.h>
+#include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+// Every instance is drawn from these corners as a triangle strip. Circles
+// use them as is; quads and glyphs halve them to the -0.5..0.5 unit quad.
+const float kCorners[8] = {
+    -1.0f, -1.0f,
+     1.0f, -1.0f,
+    -1.0f,  1.0f,
+     1.0f,  1.0f
+};
+
+const char* kBatchVertexShader = R"(
+#version 330 core
+layout(location = 0) in vec2 corner;
+layout(location = 1) in vec4 axisX;
+layout(location = 2) in vec4 axisY;
+layout(location = 3) in vec4 origin;
+layout(location = 4) in vec4 color;
+layout(location = 5) in float shape;
+layout(location = 6) in vec4 texRect;
+layout(location = 7) in vec2 glyphEdge;
+
+out vec2 vLocal;
+out vec2 vTexel;
+out vec4 vColor;
+flat out int vShape;
+flat out vec2 vGlyphEdge;
+
+uniform vec2 viewportSize;
+uniform float edgeRamp;
+uniform float quadEdgeRamp;
+
+void main() {
+    vShape = int(shape + 0.5);
+    
+    // Quads and circles with ramped edges grow by a pixel so the ramp can
+    // fade out past the edge; glyph quads already end in empty texels
+    vec2 extent = corner;
+    float ramp = vShape == 0 ? quadEdgeRamp : (vShape == 1 ? edgeRamp : 0.0);
+    if (ramp > 0.0) {
+        float unit = vShape == 1 ? 1.0 : 0.5;
+        vec2 pixels = vec2(length(axisX.xy * viewportSize), length(axisY.xy * viewportSize)) * 0.5 * unit / origin.w;
+        extent += corner / max(pixels, vec2(1e-5));
+    }
+    
+    vec2 local = vShape == 1 ? extent : extent * 0.5;
+    vLocal = extent;
+    vTexel = mix(texRect.xy, texRect.zw, corner * 0.5 + 0.5);
+    vGlyphEdge = glyphEdge;
+    vColor = color;
+    gl_Position = origin + axisX * local.x + axisY * local.y;
+}
+)";
+
+const char* kBatchFragmentShader = R"(
+#version 330 core
+in vec2 vLocal;
+in vec2 vTexel;
+in vec4 vColor;
+flat in int vShape;
+flat in vec2 vGlyphEdge;
+
+uniform sampler2D glyphAtlas;
+uniform float glyphSpread;
+uniform float edgeRamp;         // Pixels circle and glyph edges fade over; 0 is hard
+uniform float quadEdgeRamp;     // Same for quads; 0 leaves their edges to the geometry
+
+out vec4 fragColor;
+
+void main() {
+    float coverage = 1.0;
+    if (vShape == 0 && quadEdgeRamp > 0.0) {
+        // Both edges of each axis, in pixels from the pixel center
+        vec2 gradient = vec2(length(vec2(dFdx(vLocal.x), dFdy(vLocal.x))),
+                             length(vec2(dFdx(vLocal.y), dFdy(vLocal.y))));
+        vec2 inverseRamp = 1.0 / max(gradient * quadEdgeRamp, vec2(1e-5));
+        vec2 edges = clamp(0.5 + (1.0 + vLocal) * inverseRamp, 0.0, 1.0) *
+                     clamp(0.5 + (1.0 - vLocal) * inverseRamp, 0.0, 1.0);
+        coverage = edges.x * edges.y;
+        if (coverage <= 0.0) discard;
+    } else if (vShape == 1) {
+        // Unit disc with an analytic edge
+        float radius = length(vLocal);
+        coverage = clamp(0.5 + (1.0 - radius) / max(fwidth(radius) * edgeRamp, 1e-5), 0.0, 1.0);
+        if (coverage <= 0.0) discard;
+    } else if (vShape == 2) {
+        // Signed distance in atlas texels, ramped over the edge ramp's pixels
+        // unless the glyph asks for a softer edge
+        float field = texture(glyphAtlas, vTexel / vec2(textureSize(glyphAtlas, 0))).r;
+        float distance = (field - 0.5) * 2.0 * glyphSpread + vGlyphEdge.x;
+        float texelsPerPixel = 0.5 * (length(dFdx(vTexel)) + length(dFdy(vTexel)));
+        float ramp = min(max(vGlyphEdge.y, texelsPerPixel * edgeRamp), 2.0 * (glyphSpread - vGlyphEdge.x));
+        coverage = clamp(0.5 + distance / max(ramp, 1e-5), 0.0, 1.0);
+        if (coverage <= 0.0) discard;
+    }
+    fragColor = vec4(vColor.rgb, vColor.a * coverage);
+}
+)";
+
+GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    
+    GLint success = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Failed to compile batch shader: " << log << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+void setInstanceAttribute(GLuint location, GLint components, size_t offset) {
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, sizeof(RenderInstance),
+                          reinterpret_cast<const void*>(offset));
+    glVertexAttribDivisor(location, 1);
+}
+
+} // namespace
 
 Renderer::Renderer(GLFWwindow* window)
     : m_window(window)
@@ -10,7 +141,23 @@ Renderer::Renderer(GLFWwindow* window)
     , m_cameraTarget(0.0f, 0.0f, 0.0f)
     , m_cameraUp(0.0f, 1.0f, 0.0f)
     , m_windowWidth(1200)
-    , m_windowHeight(800) {
+    , m_windowHeight(800)
+    , m_shaderProgram(0)
+    , m_vertexArray(0)
+    , m_cornerBuffer(0)
+    , m_instanceBuffer(0)
+    , m_instanceCapacity(0)
+    , m_lastInstanceCount(0)
+    , m_lastDrawCallCount(0)
+    , m_glyphTexture(0)
+    , m_glyphTextureHeight(0)
+    , m_antialiasing(AntialiasingQuality::Analytic)
+    , m_multisampleFramebuffer(0)
+    , m_multisampleColor(0)
+    , m_multisampleDepth(0)
+    , m_damageTracking(true)
+    , m_framePending(false)
+    , m_lastAntialiasing(false) {
     
     setupOpenGL();
     
@@ -19,21 +166,63 @@ Renderer::Renderer(GLFWwindow* window)
     updateViewMatrix();
 }
 
+Renderer::Renderer(int width, int height)
+    : m_window(nullptr)
+    , m_framebuffer(std::make_unique<Framebuffer>(width, height))
+    , m_background(0.1f, 0.1f, 0.1f)
+    , m_cameraPosition(0.0f, 0.0f, 5.0f)
+    , m_cameraTarget(0.0f, 0.0f, 0.0f)
+    , m_cameraUp(0.0f, 1.0f, 0.0f)
+    , m_windowWidth(m_framebuffer->getWidth())
+    , m_windowHeight(m_framebuffer->getHeight())
+    , m_shaderProgram(0)
+    , m_vertexArray(0)
+    , m_cornerBuffer(0)
+    , m_instanceBuffer(0)
+    , m_instanceCapacity(0)
+    , m_lastInstanceCount(0)
+    , m_lastDrawCallCount(0)
+    , m_glyphTexture(0)
+    , m_glyphTextureHeight(0)
+    , m_antialiasing(AntialiasingQuality::Analytic)
+    , m_multisampleFramebuffer(0)
+    , m_multisampleColor(0)
+    , m_multisampleDepth(0)
+    , m_damageTracking(true)
+    , m_framePending(false)
+    , m_lastAntialiasing(false) {
+    
+    // Same default projection as the windowed renderer, so scenes frame identically
+    setOrthographic(-600.0f, 600.0f, -400.0f, 400.0f, -1.0f, 1.0f);
+    updateViewMatrix();
+}
+
 Renderer::~Renderer() {
+    releaseMultisampleTarget();
+    releaseBatchPipeline();
 }
 
 void Renderer::beginFrame() {
-    clear();
+    m_batch.clear();
+    if (m_glyphAtlas.beginFrame()) {
+        m_damageTracker.invalidate();
+    }
+    m_framePending = true;
     
-    // Set up matrices for this frame
-    glMatrixMode(GL_PROJECTION);
-    glLoadMatrixf(&m_projectionMatrix[0][0]);
+    if (m_multisampleFramebuffer) {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer);
+    }
     
-    glMatrixMode(GL_MODELVIEW);
-    glLoadMatrixf(&m_viewMatrix[0][0]);
+    // Headless frames are cleared where they are damaged, on the first flush
+    if (!isHeadless() || !m_damageTracking) {
+        clear();
+    }
 }
 
 void Renderer::endFrame() {
+    flush();
+    resolveMultisample();
+    
     // Swap buffers
     if (m_window) {
         glfwSwapBuffers(m_window);
@@ -41,12 +230,151 @@ void Renderer::endFrame() {
 }
 
 void Renderer::clear() {
+    if (isHeadless()) {
+        m_framebuffer->clear(glm::vec4(m_background, 1.0f));
+        m_damageTracker.invalidate();
+        return;
+    }
+    
     glClearColor(m_background.r, m_background.g, m_background.b, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
+void Renderer::flush() {
+    m_lastInstanceCount = m_batch.size();
+    m_lastDrawCallCount = 0;
+    
+    if (m_framePending) {
+        m_framePending = false;
+        
+        // Bounds depend on the anti-aliasing ramp, so a switch repaints everything
+        bool antialiasing = m_rasterizer.isAntialiasingEnabled();
+        if (!m_damageTracking || antialiasing != m_lastAntialiasing) {
+            m_damageTracker.invalidate();
+            m_lastAntialiasing = antialiasing;
+        }
+        m_damageTracker.beginFrame(m_rasterizer, m_batch.data(), m_batch.size(), m_windowWidth, m_windowHeight);
+        
+        if (isHeadless() && m_damageTracking) {
+            const std::vector<PixelRect>& damage = m_damageTracker.getDamage();
+            m_rasterizer.setGlyphAtlas(m_glyphAtlas.getPixels(), m_glyphAtlas.getWidth(), m_glyphAtlas.getHeight(),
+                                       GlyphAtlas::getSpread());
+            m_glyphAtlas.markClean();
+            m_rasterizer.redraw(*m_framebuffer, m_batch.data(), m_batch.size(), damage.data(), damage.size(),
+                                glm::vec4(m_background, 1.0f));
+            m_batch.clear();
+            return;
+        }
+    } else {
+        // Drawn over the frame so far, so they damage wherever they land
+        m_damageTracker.append(m_rasterizer, m_batch.data(), m_batch.size());
+    }
+    
+    if (m_batch.empty()) return;
+    
+    if (isHeadless()) {
+        flushToFramebuffer();
+    } else {
+        flushToOpenGL();
+    }
+    m_batch.clear();
+}
+
+void Renderer::drawCircle(const glm::mat4& transform, const glm::vec4& color) {
+    // Unit circle centered on the origin, placed by the transform
+    m_batch.addCircle(m_projectionMatrix * transform, color);
+}
+
+void Renderer::drawCircles(const glm::mat4& transform, const float* x, const float* y, const float* radius,
+                           const glm::vec4* color, const float* opacity, size_t count, const glm::vec4& tint) {
+    m_batch.addCircles(m_projectionMatrix * transform, x, y, radius, color, opacity, count, tint);
+}
+
+void Renderer::drawQuad(const glm::mat4& transform, const glm::vec4& color) {
+    // Unit quad from -0.5 to 0.5, placed by the transform
+    m_batch.addQuad(m_projectionMatrix * transform, color);
+}
+
+void Renderer::drawLine(const glm::vec2& start, const glm::vec2& end, float thickness, const glm::vec4& color) {
+    // Endpoints are in world space; thickness is in pixels like glLineWidth.
+    // The line becomes a quad whose width is measured in pixels.
+    glm::vec4 clipStart = m_projectionMatrix * glm::vec4(start, 0.0f, 1.0f);
+    glm::vec4 clipEnd = m_projectionMatrix * glm::vec4(end, 0.0f, 1.0f);
+    
+    glm::vec2 direction = toPixel(clipEnd) - toPixel(clipStart);
+    float length = glm::length(direction);
+    if (length <= 0.0f) return;
+    
+    // Full width in pixels, converted back to clip space (pixel rows run downwards)
+    glm::vec2 width = glm::vec2(-direction.y, direction.x) / length * std::max(thickness, 1.0f);
+    glm::vec4 origin = (clipStart + clipEnd) * 0.5f;
+    
+    RenderInstance instance;
+    instance.axisX = clipEnd - clipStart;
+    instance.axisY = glm::vec4(width.x * 2.0f / m_windowWidth, -width.y * 2.0f / m_windowHeight, 0.0f, 0.0f) * origin.w;
+    instance.origin = origin;
+    instance.color = color;
+    instance.texRect = glm::vec4(0.0f);
+    instance.glyphEdge = glm::vec2(0.0f);
+    instance.shape = static_cast<float>(RenderInstance::Quad);
+    m_batch.add(instance);
+}
+
+void Renderer::drawGlyphs(const glm::mat4& transform, const Font& font, const ShapedGlyph* glyphs, size_t count,
+                          float fontSize, const glm::vec4& color, float outset, float softness) {
+    if (count == 0 || fontSize <= 0.0f) return;
+    
+    glm::mat4 clipTransform = m_projectionMatrix * transform;
+    if (clipTransform[3].w <= 0.0f) return;
+    
+    // Distance fields are stored at a fixed size and scaled to the font size.
+    // The edge can only move as far as the field reaches.
+    float unitsPerTexel = fontSize / GlyphAtlas::getPixelsPerEm();
+    float spread = GlyphAtlas::getSpread();
+    float edgeOffset = glm::clamp(outset / unitsPerTexel, -spread, spread - 1.0f);
+    float edgeSoftness = glm::clamp(softness / unitsPerTexel, 0.0f, 2.0f * (spread - edgeOffset));
+    
+    RenderInstance instance;
+    instance.color = color;
+    instance.glyphEdge = glm::vec2(edgeOffset, edgeSoftness);
+    instance.shape = static_cast<float>(RenderInstance::Glyph);
+    
+    for (size_t i = 0; i < count; ++i) {
+        // A full atlas is emptied next frame; until then glyphs that miss are skipped
+        const GlyphAtlas::Entry* entry = m_glyphAtlas.getGlyph(font, glyphs[i].glyph);
+        if (!entry || entry->empty) continue;
+        
+        glm::vec2 size = entry->size * unitsPerTexel;
+        glm::vec2 center(glyphs[i].x * fontSize + entry->offset.x * unitsPerTexel + size.x * 0.5f,
+                         entry->offset.y * unitsPerTexel + size.y * 0.5f);
+        instance.axisX = clipTransform[0] * size.x;
+        instance.axisY = clipTransform[1] * size.y;
+        instance.origin = clipTransform * glm::vec4(center, 0.0f, 1.0f);
+        instance.texRect = entry->texRect;
+        m_batch.add(instance);
+    }
+}
+
 void Renderer::setBackground(float r, float g, float b) {
-    m_background = glm::vec3(r, g, b);
+    glm::vec3 background(r, g, b);
+    if (background != m_background) {
+        m_damageTracker.invalidate();
+    }
+    m_background = background;
+}
+
+void Renderer::setAntialiasing(AntialiasingQuality quality) {
+    m_antialiasing = quality;
+    m_rasterizer.setAntialiasing(quality != AntialiasingQuality::None);
+    
+    if (!isHeadless()) {
+        applyEdgeRamps();
+        updateMultisampleTarget();
+    }
+}
+
+AntialiasingQuality Renderer::getAntialiasing() const {
+    return m_antialiasing;
 }
 
 glm::vec3 Renderer::getBackground() const {
@@ -56,7 +384,14 @@ glm::vec3 Renderer::getBackground() const {
 void Renderer::setViewport(int width, int height) {
     m_windowWidth = width;
     m_windowHeight = height;
+    
+    if (isHeadless()) {
+        m_framebuffer->resize(width, height);
+        return;
+    }
     glViewport(0, 0, width, height);
+    applyEdgeRamps();
+    updateMultisampleTarget();
 }
 
 void Renderer::setOrthographic(float left, float right, float bottom, float top, float near, float far) {
@@ -67,6 +402,10 @@ void Renderer::setPerspective(float fov, float aspect, float near, float far) {
     m_projectionMatrix = glm::perspective(glm::radians(fov), aspect, near, far);
 }
 
+const glm::mat4& Renderer::getProjectionMatrix() const {
+    return m_projectionMatrix;
+}
+
 void Renderer::setCameraPosition(float x, float y, float z) {
     m_cameraPosition = glm::vec3(x, y, z);
     updateViewMatrix();
@@ -117,6 +456,58 @@ GLFWwindow* Renderer::getWindow() const {
     return m_window;
 }
 
+bool Renderer::isHeadless() const {
+    return m_framebuffer != nullptr;
+}
+
+const Framebuffer* Renderer::getFramebuffer() const {
+    return m_framebuffer.get();
+}
+
+SoftwareRasterizer& Renderer::getRasterizer() {
+    return m_rasterizer;
+}
+
+void Renderer::setDamageTracking(bool enabled) {
+    m_damageTracking = enabled;
+}
+
+bool Renderer::isDamageTrackingEnabled() const {
+    return m_damageTracking;
+}
+
+const std::vector<PixelRect>& Renderer::getDamage() const {
+    return m_damageTracker.getDamage();
+}
+
+void Renderer::readPixels(uint8_t* destination) {
+    if (!destination) return;
+    
+    flush();
+    
+    if (isHeadless()) {
+        memcpy(destination, m_framebuffer->getPixels(), m_framebuffer->getSizeInBytes());
+        return;
+    }
+    
+    // Samples can't be read directly; read the resolved back buffer
+    resolveMultisample();
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_windowWidth, m_windowHeight, GL_RGBA, GL_UNSIGNED_BYTE, destination);
+    if (m_multisampleFramebuffer) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_multisampleFramebuffer);
+    }
+}
+
+size_t Renderer::getLastInstanceCount() const {
+    return m_lastInstanceCount;
+}
+
+size_t Renderer::getLastDrawCallCount() const {
+    return m_lastDrawCallCount;
+}
+
 void Renderer::updateViewMatrix() {
     m_viewMatrix = glm::lookAt(m_cameraPosition, m_cameraTarget, m_cameraUp);
 }
@@ -132,8 +523,9 @@ void Renderer::setupOpenGL() {
         return;
     }
     
-    // Set up OpenGL state
+    // Set up OpenGL state; equal depths pass so flat scenes draw in submission order
     glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
@@ -141,5 +533,219 @@ void Renderer::setupOpenGL() {
     glfwGetFramebufferSize(m_window, &m_windowWidth, &m_windowHeight);
     glViewport(0, 0, m_windowWidth, m_windowHeight);
     
+    setupBatchPipeline();
+    
     std::cout << "Renderer initialized successfully!" << std::endl;
-} 
\ No newline at end of file
+}
+
+void Renderer::setupBatchPipeline() {
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, kBatchVertexShader);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, kBatchFragmentShader);
+    if (!vertexShader || !fragmentShader) {
+        if (vertexShader) glDeleteShader(vertexShader);
+        if (fragmentShader) glDeleteShader(fragmentShader);
+        return;
+    }
+    
+    m_shaderProgram = glCreateProgram();
+    glAttachShader(m_shaderProgram, vertexShader);
+    glAttachShader(m_shaderProgram, fragmentShader);
+    glLinkProgram(m_shaderProgram);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    
+    GLint success = 0;
+    glGetProgramiv(m_shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        char log[1024];
+        glGetProgramInfoLog(m_shaderProgram, sizeof(log), nullptr, log);
+        std::cerr << "Failed to link batch shader: " << log << std::endl;
+        glDeleteProgram(m_shaderProgram);
+        m_shaderProgram = 0;
+        return;
+    }
+    
+    glGenVertexArrays(1, &m_vertexArray);
+    glGenBuffers(1, &m_cornerBuffer);
+    glGenBuffers(1, &m_instanceBuffer);
+    
+    glBindVertexArray(m_vertexArray);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, m_cornerBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(kCorners), kCorners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    setInstanceAttribute(1, 4, offsetof(RenderInstance, axisX));
+    setInstanceAttribute(2, 4, offsetof(RenderInstance, axisY));
+    setInstanceAttribute(3, 4, offsetof(RenderInstance, origin));
+    setInstanceAttribute(4, 4, offsetof(RenderInstance, color));
+    setInstanceAttribute(5, 1, offsetof(RenderInstance, shape));
+    setInstanceAttribute(6, 4, offsetof(RenderInstance, texRect));
+    setInstanceAttribute(7, 2, offsetof(RenderInstance, glyphEdge));
+    
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    glGenTextures(1, &m_glyphTexture);
+    glBindTexture(GL_TEXTURE_2D, m_glyphTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    glUseProgram(m_shaderProgram);
+    glUniform1i(glGetUniformLocation(m_shaderProgram, "glyphAtlas"), 0);
+    glUniform1f(glGetUniformLocation(m_shaderProgram, "glyphSpread"), GlyphAtlas::getSpread());
+    glUseProgram(0);
+    
+    applyEdgeRamps();
+}
+
+void Renderer::releaseBatchPipeline() {
+    if (!m_window || !m_shaderProgram) return;
+    
+    glDeleteTextures(1, &m_glyphTexture);
+    glDeleteBuffers(1, &m_instanceBuffer);
+    glDeleteBuffers(1, &m_cornerBuffer);
+    glDeleteVertexArrays(1, &m_vertexArray);
+    glDeleteProgram(m_shaderProgram);
+    m_shaderProgram = 0;
+}
+
+void Renderer::applyEdgeRamps() {
+    if (!m_shaderProgram) return;
+    
+    // Circles and glyphs are shaded, so samples can't smooth them and they
+    // keep their ramps; multisampling takes over the quads' edges
+    float edgeRamp = m_antialiasing == AntialiasingQuality::None ? 0.0f : 1.0f;
+    float quadEdgeRamp = m_antialiasing == AntialiasingQuality::Analytic ? 1.0f : 0.0f;
+    
+    glUseProgram(m_shaderProgram);
+    glUniform2f(glGetUniformLocation(m_shaderProgram, "viewportSize"),
+                static_cast<float>(m_windowWidth), static_cast<float>(m_windowHeight));
+    glUniform1f(glGetUniformLocation(m_shaderProgram, "edgeRamp"), edgeRamp);
+    glUniform1f(glGetUniformLocation(m_shaderProgram, "quadEdgeRamp"), quadEdgeRamp);
+    glUseProgram(0);
+}
+
+void Renderer::updateMultisampleTarget() {
+    releaseMultisampleTarget();
+    
+    int samples = getSampleCount(m_antialiasing);
+    if (!m_window || samples <= 1 || m_windowWidth <= 0 || m_windowHeight <= 0) return;
+    
+    GLint maxSamples = 1;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    samples = std::min(samples, static_cast<int>(maxSamples));
+    if (samples <= 1) return;
+    
+    glGenRenderbuffers(1, &m_multisampleColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_multisampleColor);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, m_windowWidth, m_windowHeight);
+    
+    glGenRenderbuffers(1, &m_multisampleDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_multisampleDepth);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, m_windowWidth, m_windowHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    
+    glGenFramebuffers(1, &m_multisampleFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_multisampleColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_multisampleDepth);
+    
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Multisampled framebuffer is incomplete; drawing without MSAA" << std::endl;
+        releaseMultisampleTarget();
+    }
+}
+
+void Renderer::releaseMultisampleTarget() {
+    if (!m_multisampleFramebuffer && !m_multisampleColor && !m_multisampleDepth) return;
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &m_multisampleFramebuffer);
+    glDeleteRenderbuffers(1, &m_multisampleColor);
+    glDeleteRenderbuffers(1, &m_multisampleDepth);
+    m_multisampleFramebuffer = 0;
+    m_multisampleColor = 0;
+    m_multisampleDepth = 0;
+}
+
+void Renderer::resolveMultisample() {
+    if (!m_multisampleFramebuffer) return;
+    
+    // Average the samples into the window's back buffer, then keep drawing
+    // into the samples in case more follows
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_multisampleFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, m_windowWidth, m_windowHeight, 0, 0, m_windowWidth, m_windowHeight,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer);
+}
+
+void Renderer::flushToFramebuffer() {
+    m_rasterizer.setGlyphAtlas(m_glyphAtlas.getPixels(), m_glyphAtlas.getWidth(), m_glyphAtlas.getHeight(),
+                               GlyphAtlas::getSpread());
+    m_glyphAtlas.markClean();
+    m_rasterizer.draw(*m_framebuffer, m_batch.data(), m_batch.size());
+}
+
+void Renderer::flushToOpenGL() {
+    if (!m_shaderProgram) return;
+    
+    // Orphan the stream buffer every frame so the driver never waits on the
+    // previous frame's draw; grow it geometrically when the batch outgrows it
+    size_t count = m_batch.size();
+    if (count > m_instanceCapacity) {
+        m_instanceCapacity = std::max(count, m_instanceCapacity * 2);
+    }
+    
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(RenderInstance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(RenderInstance), m_batch.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    uploadGlyphAtlas();
+    
+    glUseProgram(m_shaderProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_glyphTexture);
+    glBindVertexArray(m_vertexArray);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(count));
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    
+    m_lastDrawCallCount = 1;
+}
+
+void Renderer::uploadGlyphAtlas() {
+    if (!m_glyphAtlas.isDirty()) return;
+    
+    // Only rows rasterized since the last upload are sent, unless the atlas grew
+    int width = m_glyphAtlas.getWidth();
+    int height = m_glyphAtlas.getHeight();
+    glBindTexture(GL_TEXTURE_2D, m_glyphTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (height != m_glyphTextureHeight) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, m_glyphAtlas.getPixels());
+        m_glyphTextureHeight = height;
+    } else {
+        int begin = m_glyphAtlas.getDirtyBegin();
+        int rows = m_glyphAtlas.getDirtyEnd() - begin;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, begin, width, rows, GL_RED, GL_UNSIGNED_BYTE,
+                        m_glyphAtlas.getPixels() + static_cast<size_t>(begin) * width);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_glyphAtlas.markClean();
+}
+
+glm::vec2 Renderer::toPixel(const glm::vec4& clipPosition) const {
+    // Clip space -> NDC -> framebuffer pixels (row 0 at the top)
+    glm::vec2 ndc = glm::vec2(clipPosition) / clipPosition.w;
+    return glm::vec2((ndc.x * 0.5f + 0.5f) * m_windowWidth,
+                     (0.5f - ndc.y * 0.5f) * m_windowHeight);
+}
@@ -1,23 +1,86 @@
 #pragma once
 
-#include <GLFW/glfw3.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
 #include <glm/glm.hpp>
+#include "Antialiasing.h"
+#include "DamageTracker.h"
+#include "GlyphAtlas.h"
+#include "RenderBatch.h"
+#include "SoftwareRasterizer.h"
+
+// Forward declarations
+struct GLFWwindow;
+class Framebuffer;
+class Font;
+struct ShapedGlyph;
 
 /**
  * @brief OpenGL renderer for the Kalem animation engine
  * 
  * Handles all rendering operations with minimal input handling.
  * Focuses on programmatic animation control like Manim.
+ *
+ * A renderer created without a window is headless: every frame is
+ * rasterized on the CPU by a SoftwareRasterizer into an in-memory
+ * Framebuffer instead of an OpenGL context, so it runs on machines with
+ * no display or GPU.
+ *
+ * Drawing primitives are retained: each call appends an instance to the
+ * frame's RenderBatch, and flush() draws the whole batch in submission
+ * order. With OpenGL that is one instanced draw through a 3.3 core
+ * shader; headless, the instances are rasterized one after another.
+ * Text joins the same batch: glyphs are quads sampling the distance
+ * fields in the renderer's GlyphAtlas, which is uploaded to a texture
+ * only when it changes.
+ *
+ * Each frame's first flush is compared with the previous frame by a
+ * DamageTracker, giving the rectangles whose pixels can have changed.
+ * Headless, only those are cleared and rasterized again, and the rest of
+ * the framebuffer keeps the previous frame; exporters read the same
+ * rectangles to skip unchanged areas when encoding.
+ *
+ * Edges are smoothed according to an AntialiasingQuality tier. With
+ * OpenGL the multisample tiers draw into a multisampled framebuffer that
+ * is resolved into the window when the frame is read back or presented.
  */
 class Renderer {
 public:
     Renderer(GLFWwindow* window);
+    Renderer(int width, int height);
     ~Renderer();
 
     // Rendering control
     void beginFrame();
     void endFrame();
     void clear();
+    void flush();   // Draws the pending batch; endFrame() and readPixels() flush first
+    
+    // Drawing primitives
+    void drawCircle(const glm::mat4& transform, const glm::vec4& color);
+    void drawQuad(const glm::mat4& transform, const glm::vec4& color);
+    void drawLine(const glm::vec2& start, const glm::vec2& end, float thickness, const glm::vec4& color);
+    
+    // Many circles at once from parallel arrays, as kept by ParticlePool:
+    // centers and radii placed by the transform, one color and opacity
+    // each, all tinted. Fully transparent entries are skipped, so free
+    // slots can stay in.
+    void drawCircles(const glm::mat4& transform, const float* x, const float* y, const float* radius,
+                     const glm::vec4* color, const float* opacity, size_t count,
+                     const glm::vec4& tint = glm::vec4(1.0f));
+    
+    // A shaped run of text. The transform places the pen origin on the
+    // baseline, with one local unit per world unit of font size. outset
+    // grows the glyphs and softness fades their edge out over that width,
+    // both in the units of the font size; together they draw outlines and
+    // glows, reaching at most 0.2 em past the outline.
+    void drawGlyphs(const glm::mat4& transform, const Font& font, const ShapedGlyph* glyphs, size_t count,
+                    float fontSize, const glm::vec4& color, float outset = 0.0f, float softness = 0.0f);
+    
+    // Anti-aliasing tier for both backends; Analytic by default
+    void setAntialiasing(AntialiasingQuality quality);
+    AntialiasingQuality getAntialiasing() const;
     
     // Background
     void setBackground(float r, float g, float b);
@@ -27,6 +90,7 @@ public:
     void setViewport(int width, int height);
     void setOrthographic(float left, float right, float bottom, float top, float near, float far);
     void setPerspective(float fov, float aspect, float near, float far);
+    const glm::mat4& getProjectionMatrix() const;
     
     // Camera control (for programmatic camera movements)
     void setCameraPosition(float x, float y, float z);
@@ -42,9 +106,31 @@ public:
     int getWindowWidth() const;
     int getWindowHeight() const;
     GLFWwindow* getWindow() const;
+    
+    // Headless rendering
+    bool isHeadless() const;
+    const Framebuffer* getFramebuffer() const;
+    SoftwareRasterizer& getRasterizer();     // Anti-aliasing and thread count of the CPU path
+    
+    // Damage tracking: when off, every frame is fully repainted and damaged
+    void setDamageTracking(bool enabled);
+    bool isDamageTrackingEnabled() const;
+    
+    // Rectangles of the current frame that can differ from the previous
+    // one, top row first; empty when the frame is unchanged
+    const std::vector<PixelRect>& getDamage() const;
+    
+    // Frame capture: copies width * height RGBA8 pixels of the current frame.
+    // Rows are top-first when headless and bottom-first (OpenGL order) otherwise.
+    void readPixels(uint8_t* destination);
+    
+    // Batching statistics for the last flush
+    size_t getLastInstanceCount() const;
+    size_t getLastDrawCallCount() const;
 
 private:
     GLFWwindow* m_window;
+    std::unique_ptr<Framebuffer> m_framebuffer;
     glm::vec3 m_background;
     glm::vec3 m_cameraPosition;
     glm::vec3 m_cameraTarget;
@@ -57,7 +143,47 @@ private:
     glm::mat4 m_projectionMatrix;
     glm::mat4 m_viewMatrix;
     
+    // Retained draw list and its GPU resources
+    RenderBatch m_batch;
+    unsigned int m_shaderProgram;
+    unsigned int m_vertexArray;
+    unsigned int m_cornerBuffer;
+    unsigned int m_instanceBuffer;
+    size_t m_instanceCapacity;
+    size_t m_lastInstanceCount;
+    size_t m_lastDrawCallCount;
+    
+    // Glyphs for text and the texture they are uploaded to
+    GlyphAtlas m_glyphAtlas;
+    unsigned int m_glyphTexture;
+    int m_glyphTextureHeight;
+    
+    // Anti-aliasing, and the multisampled target of the MSAA tiers
+    AntialiasingQuality m_antialiasing;
+    unsigned int m_multisampleFramebuffer;
+    unsigned int m_multisampleColor;
+    unsigned int m_multisampleDepth;
+    
+    // Headless backend
+    SoftwareRasterizer m_rasterizer;
+    
+    // Changes between frames
+    DamageTracker m_damageTracker;
+    bool m_damageTracking;
+    bool m_framePending;        // beginFrame() was called and nothing flushed yet
+    bool m_lastAntialiasing;
+    
     // Helper methods
     void updateViewMatrix();
     void setupOpenGL();
+    void setupBatchPipeline();
+    void releaseBatchPipeline();
+    void flushToFramebuffer();
+    void flushToOpenGL();
+    void uploadGlyphAtlas();
+    void applyEdgeRamps();
+    void updateMultisampleTarget();
+    void releaseMultisampleTarget();
+    void resolveMultisample();
+    glm::vec2 toPixel(const glm::vec4& clipPosition) const;
 }; 
\ No newline at end of file
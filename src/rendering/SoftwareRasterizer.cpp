@@ -0,0 +1,607 @@
+#include "SoftwareRasterizer.h"
+#include "Framebuffer.h"
+#include "../utils/JobSystem.h"
+#include "../utils/Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+// ============================================================================
+// LANES
+// ============================================================================
+
+// One row of a pixel block. Every variant does the same float operations
+// in the same order, so all of them produce identical coverage.
+
+#if defined(KALEM_SIMD_AVX2)
+
+const int kLanes = 8;
+typedef __m256 Lanes;
+
+inline Lanes lanesSplat(float value) { return _mm256_set1_ps(value); }
+inline Lanes lanesPixelCenters() { return _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f); }
+inline Lanes lanesAdd(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+inline Lanes lanesSub(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+inline Lanes lanesMul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+inline Lanes lanesSqrt(Lanes a) { return _mm256_sqrt_ps(a); }
+inline Lanes lanesClamp01(Lanes a) { return _mm256_min_ps(_mm256_max_ps(a, _mm256_setzero_ps()), _mm256_set1_ps(1.0f)); }
+inline Lanes lanesStep(Lanes a) { return _mm256_and_ps(_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GE_OQ), _mm256_set1_ps(1.0f)); }
+inline void lanesStore(float* out, Lanes a) { _mm256_storeu_ps(out, a); }
+
+#elif defined(KALEM_SIMD_SSE2)
+
+const int kLanes = 4;
+typedef __m128 Lanes;
+
+inline Lanes lanesSplat(float value) { return _mm_set1_ps(value); }
+inline Lanes lanesPixelCenters() { return _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f); }
+inline Lanes lanesAdd(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes lanesSub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+inline Lanes lanesMul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes lanesSqrt(Lanes a) { return _mm_sqrt_ps(a); }
+inline Lanes lanesClamp01(Lanes a) { return _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+inline Lanes lanesStep(Lanes a) { return _mm_and_ps(_mm_cmpge_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+inline void lanesStore(float* out, Lanes a) { _mm_storeu_ps(out, a); }
+
+#else
+
+const int kLanes = 4;
+struct Lanes {
+    float v[kLanes];
+};
+
+template <typename Function>
+inline Lanes lanesMap(Function function) {
+    Lanes result;
+    for (int i = 0; i < kLanes; ++i) result.v[i] = function(i);
+    return result;
+}
+
+inline Lanes lanesSplat(float value) { return lanesMap([=](int) { return value; }); }
+inline Lanes lanesPixelCenters() { return lanesMap([](int i) { return i + 0.5f; }); }
+inline Lanes lanesAdd(Lanes a, Lanes b) { return lanesMap([&](int i) { return a.v[i] + b.v[i]; }); }
+inline Lanes lanesSub(Lanes a, Lanes b) { return lanesMap([&](int i) { return a.v[i] - b.v[i]; }); }
+inline Lanes lanesMul(Lanes a, Lanes b) { return lanesMap([&](int i) { return a.v[i] * b.v[i]; }); }
+inline Lanes lanesSqrt(Lanes a) { return lanesMap([&](int i) { return std::sqrt(a.v[i]); }); }
+inline Lanes lanesClamp01(Lanes a) { return lanesMap([&](int i) { return std::min(std::max(a.v[i], 0.0f), 1.0f); }); }
+inline Lanes lanesStep(Lanes a) { return lanesMap([&](int i) { return a.v[i] >= 0.0f ? 1.0f : 0.0f; }); }
+inline void lanesStore(float* out, Lanes a) { std::memcpy(out, a.v, sizeof(a.v)); }
+
+#endif
+
+// ============================================================================
+// SHAPE SETUP
+// ============================================================================
+
+// Distance past the coverage thresholds a whole block must be before it is
+// skipped or filled without per-pixel coverage. It absorbs float rounding,
+// so classifying a block never changes a pixel.
+const float kClassifyMargin = 1.0f / 64.0f;
+
+// Side of the screen tiles drawn in parallel; a multiple of every block size
+const int kTileSize = 64;
+
+enum class BlockCoverage {
+    Outside,
+    Inside,
+    Partial
+};
+
+struct PixelShape {
+    bool circle;
+    bool glyph;
+    bool antialiasing;
+
+    // Local coordinates as functions of the pixel position p:
+    // local.x = dot(localX, (p.x, p.y, 1)), likewise local.y
+    glm::vec3 localX;
+    glm::vec3 localY;
+
+    glm::vec3 edges[4];     // Quads: signed pixel distance to each side, positive inside
+    float pixelRadius;      // Circles: pixels per local unit at the rim
+    glm::vec4 texRect;      // Glyphs: atlas texels at local (-0.5, -0.5) and (0.5, 0.5)
+    glm::vec2 glyphEdge;    // Glyphs: edge offset and ramp width, in texels
+    float texelsPerPixel;   // Glyphs: atlas texels per pixel step
+
+    glm::vec2 boundsMin;
+    glm::vec2 boundsMax;
+};
+
+bool setupShape(const RenderInstance& instance, int width, int height, bool antialiasing, PixelShape& shape) {
+    // Clip space to pixels, row 0 at the top. Shapes are flat, so w is
+    // taken from the origin for the whole instance.
+    float w = instance.origin.w;
+    if (w <= 0.0f) return false;
+
+    glm::vec2 scale(0.5f * width / w, -0.5f * height / w);
+    glm::vec2 origin(instance.origin.x * scale.x + 0.5f * width, instance.origin.y * scale.y + 0.5f * height);
+    glm::vec2 axisX = glm::vec2(instance.axisX) * scale;
+    glm::vec2 axisY = glm::vec2(instance.axisY) * scale;
+
+    float determinant = axisX.x * axisY.y - axisY.x * axisX.y;
+    if (std::abs(determinant) < 1e-12f) return false;
+
+    shape.circle = static_cast<int>(instance.shape) == RenderInstance::Circle;
+    shape.glyph = static_cast<int>(instance.shape) == RenderInstance::Glyph;
+    shape.texRect = instance.texRect;
+    shape.glyphEdge = instance.glyphEdge;
+    shape.antialiasing = antialiasing;
+    shape.localX = glm::vec3(axisY.y, -axisY.x, axisY.x * origin.y - axisY.y * origin.x) / determinant;
+    shape.localY = glm::vec3(-axisX.y, axisX.x, axisX.y * origin.x - axisX.x * origin.y) / determinant;
+
+    glm::vec2 extent;
+    if (shape.circle) {
+        shape.pixelRadius = std::sqrt(std::abs(determinant));
+        extent = glm::vec2(std::sqrt(axisX.x * axisX.x + axisY.x * axisY.x),
+                           std::sqrt(axisX.y * axisX.y + axisY.y * axisY.y));
+    } else {
+        float gradientX = glm::length(glm::vec2(shape.localX));
+        float gradientY = glm::length(glm::vec2(shape.localY));
+        glm::vec3 half(0.0f, 0.0f, 0.5f);
+        shape.edges[0] = (half - shape.localX) / gradientX;
+        shape.edges[1] = (half + shape.localX) / gradientX;
+        shape.edges[2] = (half - shape.localY) / gradientY;
+        shape.edges[3] = (half + shape.localY) / gradientY;
+        extent = (glm::abs(axisX) + glm::abs(axisY)) * 0.5f;
+
+        // Same footprint as the shader's derivatives of the texel position
+        glm::vec2 texelScale(shape.texRect.z - shape.texRect.x, shape.texRect.w - shape.texRect.y);
+        shape.texelsPerPixel = 0.5f * (glm::length(glm::vec2(shape.localX.x, shape.localY.x) * texelScale) +
+                                       glm::length(glm::vec2(shape.localX.y, shape.localY.y) * texelScale));
+    }
+
+    // Anti-aliased edges reach half a pixel further out
+    float padding = antialiasing ? 1.0f : 0.0f;
+    shape.boundsMin = origin - extent - padding;
+    shape.boundsMax = origin + extent + padding;
+    return true;
+}
+
+// Pixels whose centers the instance can cover, clipped to the target
+bool computePixelBounds(const PixelShape& shape, int width, int height, const PixelRect& clip, PixelRect& bounds) {
+    bounds.x0 = std::max({0, clip.x0, static_cast<int>(std::floor(shape.boundsMin.x))});
+    bounds.y0 = std::max({0, clip.y0, static_cast<int>(std::floor(shape.boundsMin.y))});
+    bounds.x1 = std::min({width, clip.x1, static_cast<int>(std::ceil(shape.boundsMax.x)) + 1});
+    bounds.y1 = std::min({height, clip.y1, static_cast<int>(std::ceil(shape.boundsMax.y)) + 1});
+    return bounds.x0 < bounds.x1 && bounds.y0 < bounds.y1;
+}
+
+BlockCoverage classifyRange(const PixelShape& shape, float minDistance, float maxDistance) {
+    float outside = shape.antialiasing ? -0.5f : 0.0f;
+    float inside = shape.antialiasing ? 0.5f : 0.0f;
+    if (maxDistance < outside - kClassifyMargin) return BlockCoverage::Outside;
+    if (minDistance >= inside + kClassifyMargin) return BlockCoverage::Inside;
+    return BlockCoverage::Partial;
+}
+
+BlockCoverage classifyBlock(const PixelShape& shape, int blockX, int blockY) {
+    // Pixel centers of the block span center +- radius on each axis
+    float radius = (kLanes - 1) * 0.5f;
+    float centerX = blockX + kLanes * 0.5f;
+    float centerY = blockY + kLanes * 0.5f;
+
+    if (shape.circle) {
+        glm::vec2 local(glm::dot(shape.localX, glm::vec3(centerX, centerY, 1.0f)),
+                        glm::dot(shape.localY, glm::vec3(centerX, centerY, 1.0f)));
+        glm::vec2 spread((std::abs(shape.localX.x) + std::abs(shape.localX.y)) * radius,
+                         (std::abs(shape.localY.x) + std::abs(shape.localY.y)) * radius);
+
+        // Nearest and farthest points of the block's local bounds from the center
+        glm::vec2 nearest = glm::clamp(glm::vec2(0.0f), local - spread, local + spread);
+        glm::vec2 farthest = glm::abs(local) + spread;
+        float minDistance = (1.0f - glm::length(farthest)) * shape.pixelRadius;
+        float maxDistance = (1.0f - glm::length(nearest)) * shape.pixelRadius;
+        return classifyRange(shape, minDistance, maxDistance);
+    }
+
+    bool inside = true;
+    for (const glm::vec3& edge : shape.edges) {
+        float center = edge.x * centerX + edge.y * centerY + edge.z;
+        float spread = (std::abs(edge.x) + std::abs(edge.y)) * radius;
+        BlockCoverage coverage = classifyRange(shape, center - spread, center + spread);
+        if (coverage == BlockCoverage::Outside) return BlockCoverage::Outside;
+        inside = inside && coverage == BlockCoverage::Inside;
+    }
+    return inside ? BlockCoverage::Inside : BlockCoverage::Partial;
+}
+
+// ============================================================================
+// COVERAGE
+// ============================================================================
+
+inline Lanes coverageFromDistance(const PixelShape& shape, Lanes distance) {
+    return shape.antialiasing ? lanesClamp01(lanesAdd(distance, lanesSplat(0.5f))) : lanesStep(distance);
+}
+
+inline Lanes evaluate(const glm::vec3& function, Lanes x, Lanes y) {
+    return lanesAdd(lanesAdd(lanesMul(lanesSplat(function.x), x), lanesMul(lanesSplat(function.y), y)), lanesSplat(function.z));
+}
+
+// Coverage of kLanes pixels starting at (x, y)
+void computeCoverage(const PixelShape& shape, int x, int y, float* coverage) {
+    Lanes px = lanesAdd(lanesSplat(static_cast<float>(x)), lanesPixelCenters());
+    Lanes py = lanesSplat(y + 0.5f);
+
+    if (shape.circle) {
+        Lanes localX = evaluate(shape.localX, px, py);
+        Lanes localY = evaluate(shape.localY, px, py);
+        Lanes radius = lanesSqrt(lanesAdd(lanesMul(localX, localX), lanesMul(localY, localY)));
+        Lanes distance = lanesMul(lanesSub(lanesSplat(1.0f), radius), lanesSplat(shape.pixelRadius));
+        lanesStore(coverage, coverageFromDistance(shape, distance));
+        return;
+    }
+
+    Lanes result = coverageFromDistance(shape, evaluate(shape.edges[0], px, py));
+    for (int i = 1; i < 4; ++i) {
+        result = lanesMul(result, coverageFromDistance(shape, evaluate(shape.edges[i], px, py)));
+    }
+    lanesStore(coverage, result);
+}
+
+// Scales the coverage of kLanes pixels starting at (x, y) by the glyph's
+// distance field, sampled bilinearly at each pixel center like GL_LINEAR
+// and thresholded like the shader
+void applyGlyphCoverage(const PixelShape& shape, const uint8_t* atlas, int atlasWidth, int atlasHeight,
+                        float spread, int x, int y, float* coverage) {
+    // Without anti-aliasing only an explicit soft edge is ramped
+    float minimumRamp = shape.antialiasing ? shape.texelsPerPixel : 1e-5f;
+    float ramp = std::min(std::max(shape.glyphEdge.y, minimumRamp), 2.0f * (spread - shape.glyphEdge.x));
+    float inverseRamp = 1.0f / std::max(ramp, 1e-5f);
+
+    for (int i = 0; i < kLanes; ++i) {
+        if (coverage[i] <= 0.0f) continue;
+
+        glm::vec3 pixel(x + i + 0.5f, y + 0.5f, 1.0f);
+        glm::vec2 local(glm::dot(shape.localX, pixel) + 0.5f, glm::dot(shape.localY, pixel) + 0.5f);
+        glm::vec2 texel = glm::mix(glm::vec2(shape.texRect.x, shape.texRect.y),
+                                   glm::vec2(shape.texRect.z, shape.texRect.w), local) - 0.5f;
+        texel = glm::clamp(texel, glm::vec2(0.0f), glm::vec2(atlasWidth - 1, atlasHeight - 1));
+
+        int texelX = std::min(static_cast<int>(texel.x), atlasWidth - 2);
+        int texelY = std::min(static_cast<int>(texel.y), atlasHeight - 2);
+        float fractionX = texel.x - texelX;
+        float fractionY = texel.y - texelY;
+        const uint8_t* row = atlas + static_cast<size_t>(texelY) * atlasWidth + texelX;
+        float top = row[0] + (row[1] - row[0]) * fractionX;
+        float bottom = row[atlasWidth] + (row[atlasWidth + 1] - row[atlasWidth]) * fractionX;
+        float field = (top + (bottom - top) * fractionY) * (1.0f / 255.0f);
+
+        float distance = (field - 0.5f) * 2.0f * spread + shape.glyphEdge.x;
+        coverage[i] *= glm::clamp(0.5f + distance * inverseRamp, 0.0f, 1.0f);
+    }
+}
+
+// ============================================================================
+// BLENDING
+// ============================================================================
+
+// Source-over blending, matching Framebuffer's blendPixel() exactly
+struct BlendSource {
+    float color[4];     // Straight RGB scaled to 0..255, alpha channel 255
+    float alpha;
+    uint32_t opaque;    // Packed pixel written when the coverage is full and alpha is 1
+};
+
+BlendSource makeBlendSource(const glm::vec4& color) {
+    BlendSource source;
+    source.color[0] = glm::clamp(color.r, 0.0f, 1.0f) * 255.0f;
+    source.color[1] = glm::clamp(color.g, 0.0f, 1.0f) * 255.0f;
+    source.color[2] = glm::clamp(color.b, 0.0f, 1.0f) * 255.0f;
+    source.color[3] = 255.0f;
+    source.alpha = glm::clamp(color.a, 0.0f, 1.0f);
+
+    uint8_t packed[4];
+    for (int i = 0; i < 4; ++i) {
+        packed[i] = static_cast<uint8_t>(source.color[i] + 0.5f);
+    }
+    std::memcpy(&source.opaque, packed, sizeof(packed));
+    return source;
+}
+
+// A pixel blended with zero alpha keeps its value, so spans need not skip
+// uncovered pixels
+inline void blendPixel(uint8_t* pixel, const BlendSource& source, float alpha) {
+    float inverse = 1.0f - alpha;
+    for (int i = 0; i < 4; ++i) {
+        pixel[i] = static_cast<uint8_t>(source.color[i] * alpha + pixel[i] * inverse + 0.5f);
+    }
+}
+
+#if defined(KALEM_SIMD_SSE2)
+
+inline __m128i blendChannels(__m128 source, __m128i destination, __m128 alpha) {
+    __m128 inverse = _mm_sub_ps(_mm_set1_ps(1.0f), alpha);
+    __m128 blended = _mm_add_ps(_mm_add_ps(_mm_mul_ps(source, alpha), _mm_mul_ps(_mm_cvtepi32_ps(destination), inverse)),
+                                _mm_set1_ps(0.5f));
+    return _mm_cvttps_epi32(blended);
+}
+
+// Four pixels at once, one RGBA pixel per float vector; alpha holds one
+// alpha per pixel
+inline void blendPixels4(uint8_t* pixels, __m128 color, __m128 alpha) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+    __m128i low = _mm_unpacklo_epi8(packed, zero);
+    __m128i high = _mm_unpackhi_epi8(packed, zero);
+
+    __m128i result0 = blendChannels(color, _mm_unpacklo_epi16(low, zero), _mm_shuffle_ps(alpha, alpha, _MM_SHUFFLE(0, 0, 0, 0)));
+    __m128i result1 = blendChannels(color, _mm_unpackhi_epi16(low, zero), _mm_shuffle_ps(alpha, alpha, _MM_SHUFFLE(1, 1, 1, 1)));
+    __m128i result2 = blendChannels(color, _mm_unpacklo_epi16(high, zero), _mm_shuffle_ps(alpha, alpha, _MM_SHUFFLE(2, 2, 2, 2)));
+    __m128i result3 = blendChannels(color, _mm_unpackhi_epi16(high, zero), _mm_shuffle_ps(alpha, alpha, _MM_SHUFFLE(3, 3, 3, 3)));
+
+    __m128i result = _mm_packus_epi16(_mm_packs_epi32(result0, result1), _mm_packs_epi32(result2, result3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), result);
+}
+
+#endif
+
+void blendSpan(uint8_t* pixels, int count, const BlendSource& source, const float* coverage) {
+    if (!coverage && source.alpha >= 1.0f) {
+        int i = 0;
+#if defined(KALEM_SIMD_SSE2)
+        __m128i opaque = _mm_set1_epi32(static_cast<int>(source.opaque));
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), opaque);
+        }
+#endif
+        for (; i < count; ++i) {
+            std::memcpy(pixels + i * 4, &source.opaque, sizeof(source.opaque));
+        }
+        return;
+    }
+
+    int i = 0;
+#if defined(KALEM_SIMD_SSE2)
+    __m128 color = _mm_loadu_ps(source.color);
+    __m128 alpha = _mm_set1_ps(source.alpha);
+    for (; i + 4 <= count; i += 4) {
+        __m128 pixelAlpha = coverage ? _mm_mul_ps(alpha, _mm_loadu_ps(coverage + i)) : alpha;
+        blendPixels4(pixels + i * 4, color, pixelAlpha);
+    }
+#endif
+    for (; i < count; ++i) {
+        blendPixel(pixels + i * 4, source, coverage ? source.alpha * coverage[i] : source.alpha);
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// SOFTWARE RASTERIZER
+// ============================================================================
+
+SoftwareRasterizer::SoftwareRasterizer()
+    : m_antialiasing(true)
+    , m_threadCount(1)
+    , m_glyphPixels(nullptr)
+    , m_glyphWidth(0)
+    , m_glyphHeight(0)
+    , m_glyphSpread(1.0f) {
+    setThreadCount(0);
+}
+
+SoftwareRasterizer::~SoftwareRasterizer() {
+}
+
+void SoftwareRasterizer::setAntialiasing(bool enabled) {
+    m_antialiasing = enabled;
+}
+
+bool SoftwareRasterizer::isAntialiasingEnabled() const {
+    return m_antialiasing;
+}
+
+void SoftwareRasterizer::setThreadCount(size_t threadCount) {
+    // The calling thread draws tiles too, so it counts as one
+    size_t available = JobSystem::instance().getThreadCount();
+    m_threadCount = threadCount == 0 ? available : std::min(threadCount, available);
+}
+
+size_t SoftwareRasterizer::getThreadCount() const {
+    return m_threadCount;
+}
+
+int SoftwareRasterizer::getBlockSize() {
+    return kLanes;
+}
+
+int SoftwareRasterizer::getTileSize() {
+    return kTileSize;
+}
+
+void SoftwareRasterizer::setGlyphAtlas(const uint8_t* pixels, int width, int height, float spread) {
+    m_glyphPixels = pixels;
+    m_glyphWidth = width;
+    m_glyphHeight = height;
+    m_glyphSpread = spread;
+}
+
+void SoftwareRasterizer::draw(Framebuffer& target, const RenderInstance& instance) {
+    draw(target, instance, PixelRect{0, 0, target.getWidth(), target.getHeight()});
+}
+
+void SoftwareRasterizer::draw(Framebuffer& target, const RenderInstance* instances, size_t count) {
+    const int width = target.getWidth();
+    const int height = target.getHeight();
+    const int tilesX = (width + kTileSize - 1) / kTileSize;
+    const int tilesY = (height + kTileSize - 1) / kTileSize;
+
+    if (m_threadCount <= 1 || tilesX * tilesY == 1) {
+        PixelRect clip{0, 0, width, height};
+        for (size_t i = 0; i < count; ++i) {
+            draw(target, instances[i], clip);
+        }
+        return;
+    }
+
+    binInstances(target, instances, count, tilesX, tilesY);
+
+    // Tiles cover disjoint pixels, so they can be drawn in any order
+    JobSystem::instance().parallelFor(static_cast<size_t>(tilesX) * tilesY, 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; ++tile) {
+            int x = static_cast<int>(tile % tilesX) * kTileSize;
+            int y = static_cast<int>(tile / tilesX) * kTileSize;
+            PixelRect clip{x, y, std::min(x + kTileSize, width), std::min(y + kTileSize, height)};
+
+            for (uint32_t i = m_binStarts[tile]; i < m_binStarts[tile + 1]; ++i) {
+                draw(target, instances[m_binEntries[i]], clip);
+            }
+        }
+    }, m_threadCount);
+}
+
+void SoftwareRasterizer::redraw(Framebuffer& target, const RenderInstance* instances, size_t count,
+                                const PixelRect* regions, size_t regionCount, const glm::vec4& background) {
+    if (regionCount == 0) return;
+
+    const int width = target.getWidth();
+    const int height = target.getHeight();
+    const int tilesX = (width + kTileSize - 1) / kTileSize;
+    const int tilesY = (height + kTileSize - 1) / kTileSize;
+    binInstances(target, instances, count, tilesX, tilesY);
+
+    auto redrawTiles = [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; ++tile) {
+            int x = static_cast<int>(tile % tilesX) * kTileSize;
+            int y = static_cast<int>(tile / tilesX) * kTileSize;
+            PixelRect tileRect{x, y, std::min(x + kTileSize, width), std::min(y + kTileSize, height)};
+
+            // Bounds of the regions within the tile; repainting a little
+            // more than the regions is harmless
+            PixelRect clip{tileRect.x1, tileRect.y1, tileRect.x0, tileRect.y0};
+            for (size_t i = 0; i < regionCount; ++i) {
+                const PixelRect& region = regions[i];
+                if (region.x0 >= tileRect.x1 || region.x1 <= tileRect.x0 ||
+                    region.y0 >= tileRect.y1 || region.y1 <= tileRect.y0) continue;
+                clip.x0 = std::min(clip.x0, std::max(region.x0, tileRect.x0));
+                clip.y0 = std::min(clip.y0, std::max(region.y0, tileRect.y0));
+                clip.x1 = std::max(clip.x1, std::min(region.x1, tileRect.x1));
+                clip.y1 = std::max(clip.y1, std::min(region.y1, tileRect.y1));
+            }
+            if (clip.x0 >= clip.x1 || clip.y0 >= clip.y1) continue;
+
+            target.clear(background, clip);
+            for (uint32_t i = m_binStarts[tile]; i < m_binStarts[tile + 1]; ++i) {
+                draw(target, instances[m_binEntries[i]], clip);
+            }
+        }
+    };
+
+    size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+    if (m_threadCount > 1 && tileCount > 1) {
+        JobSystem::instance().parallelFor(tileCount, 1, redrawTiles, m_threadCount);
+    } else {
+        redrawTiles(0, tileCount);
+    }
+}
+
+bool SoftwareRasterizer::getPixelBounds(const RenderInstance& instance, int width, int height, PixelRect& bounds) const {
+    PixelShape shape;
+    if (instance.color.a <= 0.0f || !setupShape(instance, width, height, m_antialiasing, shape)) return false;
+    return computePixelBounds(shape, width, height, PixelRect{0, 0, width, height}, bounds);
+}
+
+void SoftwareRasterizer::binInstances(const Framebuffer& target, const RenderInstance* instances, size_t count, int tilesX, int tilesY) {
+    const int width = target.getWidth();
+    const int height = target.getHeight();
+
+    // Tile range of every instance; empty when nothing is drawn
+    m_instanceTiles.resize(count);
+    m_binStarts.assign(static_cast<size_t>(tilesX) * tilesY + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        PixelRect bounds;
+        PixelRect& tiles = m_instanceTiles[i];
+        if (!getPixelBounds(instances[i], width, height, bounds)) {
+            tiles = PixelRect{0, 0, 0, 0};
+            continue;
+        }
+
+        tiles = PixelRect{bounds.x0 / kTileSize, bounds.y0 / kTileSize,
+                          (bounds.x1 - 1) / kTileSize + 1, (bounds.y1 - 1) / kTileSize + 1};
+        for (int y = tiles.y0; y < tiles.y1; ++y) {
+            for (int x = tiles.x0; x < tiles.x1; ++x) {
+                ++m_binStarts[static_cast<size_t>(y) * tilesX + x + 1];
+            }
+        }
+    }
+
+    // Counting sort into the bins; instances stay in submission order
+    for (size_t i = 1; i < m_binStarts.size(); ++i) {
+        m_binStarts[i] += m_binStarts[i - 1];
+    }
+    m_binEntries.resize(m_binStarts.back());
+
+    std::vector<uint32_t> cursor(m_binStarts.begin(), m_binStarts.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        const PixelRect& tiles = m_instanceTiles[i];
+        for (int y = tiles.y0; y < tiles.y1; ++y) {
+            for (int x = tiles.x0; x < tiles.x1; ++x) {
+                m_binEntries[cursor[static_cast<size_t>(y) * tilesX + x]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::draw(Framebuffer& target, const RenderInstance& instance, const PixelRect& clip) {
+    if (instance.color.a <= 0.0f) return;
+
+    const int width = target.getWidth();
+    const int height = target.getHeight();
+    PixelShape shape;
+    if (!setupShape(instance, width, height, m_antialiasing, shape)) return;
+    if (shape.glyph && (!m_glyphPixels || m_glyphWidth < 2 || m_glyphHeight < 2)) return;
+
+    PixelRect bounds;
+    if (!computePixelBounds(shape, width, height, clip, bounds)) return;
+    const int x0 = bounds.x0;
+    const int y0 = bounds.y0;
+    const int x1 = bounds.x1;
+    const int y1 = bounds.y1;
+
+    BlendSource source = makeBlendSource(instance.color);
+    uint8_t* pixels = target.getPixels();
+    float coverage[kLanes];
+
+    // Blocks are aligned to multiples of the block size on the whole framebuffer
+    for (int blockY = y0 - y0 % kLanes; blockY < y1; blockY += kLanes) {
+        int rowBegin = std::max(blockY, y0);
+        int rowEnd = std::min(blockY + kLanes, y1);
+
+        // Neighbouring inside blocks are filled as one span per row
+        int insideBegin = -1;
+        for (int blockX = x0 - x0 % kLanes; blockX < x1 + kLanes; blockX += kLanes) {
+            BlockCoverage blockCoverage = blockX < x1 ? classifyBlock(shape, blockX, blockY) : BlockCoverage::Outside;
+            if (shape.glyph && blockCoverage == BlockCoverage::Inside) {
+                // Glyph coverage comes from the atlas, so no block is solid
+                blockCoverage = BlockCoverage::Partial;
+            }
+            if (blockCoverage == BlockCoverage::Inside) {
+                if (insideBegin < 0) insideBegin = std::max(blockX, x0);
+                continue;
+            }
+
+            if (insideBegin >= 0) {
+                int insideEnd = std::min(blockX, x1);
+                for (int y = rowBegin; y < rowEnd; ++y) {
+                    blendSpan(pixels + (static_cast<size_t>(y) * width + insideBegin) * 4, insideEnd - insideBegin, source, nullptr);
+                }
+                insideBegin = -1;
+            }
+            if (blockCoverage == BlockCoverage::Outside) continue;
+
+            int columnBegin = std::max(blockX, x0);
+            int columnEnd = std::min(blockX + kLanes, x1);
+            for (int y = rowBegin; y < rowEnd; ++y) {
+                computeCoverage(shape, blockX, y, coverage);
+                if (shape.glyph) {
+                    applyGlyphCoverage(shape, m_glyphPixels, m_glyphWidth, m_glyphHeight, m_glyphSpread, blockX, y, coverage);
+                }
+                blendSpan(pixels + (static_cast<size_t>(y) * width + columnBegin) * 4, columnEnd - columnBegin, source,
+                          coverage + (columnBegin - blockX));
+            }
+        }
+    }
+}
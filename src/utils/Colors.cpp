@@ -34,15 +34,15 @@ namespace Colors {
     }
     
     glm::vec4 darken(const glm::vec4& color, float factor) {
-        return glm::vec4(color.rgb() * (1.0f - factor), color.a);
+        return glm::vec4(glm::vec3(color) * (1.0f - factor), color.a);
     }
     
     glm::vec4 lighten(const glm::vec4& color, float factor) {
-        return glm::vec4(color.rgb() + (glm::vec3(1.0f) - color.rgb()) * factor, color.a);
+        return glm::vec4(glm::vec3(color) + (glm::vec3(1.0f) - glm::vec3(color)) * factor, color.a);
     }
     
     glm::vec4 setAlpha(const glm::vec4& color, float alpha) {
-        return glm::vec4(color.rgb(), alpha);
+        return glm::vec4(glm::vec3(color), alpha);
     }
     
     void RGBtoHSV(float r, float g, float b, float& h, float& s, float& v) {
@@ -0,0 +1,167 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace {
+
+// Scheduler and queue index of the worker running on this thread, if any
+thread_local const JobSystem* t_jobSystem = nullptr;
+thread_local size_t t_workerIndex = 0;
+
+} // namespace
+
+JobSystem::JobSystem(size_t workerCount)
+    : m_queuedJobs(0)
+    , m_stopping(false) {
+    for (size_t i = 0; i <= workerCount; ++i) {
+        m_queues.push_back(std::make_unique<JobQueue>());
+    }
+    for (size_t i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stopping = true;
+    }
+    m_jobAvailable.notify_all();
+    
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::instance() {
+    static JobSystem jobSystem(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return jobSystem;
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body,
+                            size_t maxThreads) {
+    if (count == 0) return;
+    
+    grainSize = std::max<size_t>(1, grainSize);
+    const size_t chunkCount = (count + grainSize - 1) / grainSize;
+    if (maxThreads == 0) {
+        maxThreads = getThreadCount();
+    }
+    
+    size_t helpers = std::min({m_workers.size(), chunkCount - 1, maxThreads - 1});
+    if (helpers == 0) {
+        body(0, count);
+        return;
+    }
+    
+    struct Progress {
+        std::atomic<size_t> nextChunk{0};
+        size_t finishedChunks = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto progress = std::make_shared<Progress>();
+    
+    // Helpers that start after every chunk is taken return without touching body
+    auto runChunks = [progress, chunkCount, count, grainSize, &body]() {
+        size_t done = 0;
+        for (size_t chunk = progress->nextChunk++; chunk < chunkCount; chunk = progress->nextChunk++) {
+            size_t begin = chunk * grainSize;
+            body(begin, std::min(count, begin + grainSize));
+            ++done;
+        }
+        if (done == 0) return;
+        
+        std::lock_guard<std::mutex> lock(progress->mutex);
+        progress->finishedChunks += done;
+        if (progress->finishedChunks == chunkCount) {
+            progress->finished.notify_all();
+        }
+    };
+    
+    for (size_t i = 0; i < helpers; ++i) {
+        push(runChunks);
+    }
+    
+    runChunks();
+    
+    // Chunks still running elsewhere; help with other jobs meanwhile
+    size_t queueIndex = currentQueue();
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(progress->mutex);
+            if (progress->finishedChunks == chunkCount) return;
+        }
+        if (!runJob(queueIndex)) break;
+    }
+    
+    std::unique_lock<std::mutex> lock(progress->mutex);
+    progress->finished.wait(lock, [&progress, chunkCount] { return progress->finishedChunks == chunkCount; });
+}
+
+size_t JobSystem::getThreadCount() const {
+    return m_workers.size() + 1;
+}
+
+void JobSystem::push(std::function<void()> job) {
+    // Counted first, so the count never drops below the jobs queued, and
+    // under the wake mutex, so a worker about to sleep can't miss it
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        ++m_queuedJobs;
+    }
+    
+    JobQueue& queue = *m_queues[currentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    m_jobAvailable.notify_one();
+}
+
+bool JobSystem::runJob(size_t queueIndex) {
+    std::function<void()> job;
+    
+    // Newest job of our own queue first, while its data is still in cache
+    {
+        JobQueue& own = *m_queues[queueIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+        }
+    }
+    
+    // Otherwise steal the oldest job of another queue
+    for (size_t i = 1; !job && i < m_queues.size(); ++i) {
+        JobQueue& victim = *m_queues[(queueIndex + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+    }
+    
+    if (!job) return false;
+    --m_queuedJobs;
+    job();
+    return true;
+}
+
+size_t JobSystem::currentQueue() const {
+    return t_jobSystem == this ? t_workerIndex : m_workers.size();
+}
+
+void JobSystem::workerLoop(size_t index) {
+    t_jobSystem = this;
+    t_workerIndex = index;
+    
+    for (;;) {
+        if (runJob(index)) continue;
+        
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_jobAvailable.wait(lock, [this] { return m_stopping || m_queuedJobs > 0; });
+        
+        // Finish queued work before shutting down
+        if (m_stopping && m_queuedJobs == 0) return;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Work-stealing job scheduler shared by the whole engine
+ * 
+ * Every worker has its own job deque. A worker takes its newest job from
+ * the back of its own deque and, when that is empty, steals the oldest
+ * job from the front of another's, so work spreads to idle threads
+ * without a single contended queue. Threads that are not workers push
+ * their jobs onto a shared deque that every worker steals from.
+ * 
+ * parallelFor() splits an index range into fixed chunks that helper jobs
+ * and the calling thread claim one at a time. While the caller waits for
+ * the last chunks it runs other queued jobs, so parallelFor() may be
+ * called from inside a job without deadlocking. Scene updates, physics,
+ * the software rasterizer and GIF encoding all run on instance(), so they
+ * never oversubscribe the CPU with separate pools.
+ */
+class JobSystem {
+public:
+    explicit JobSystem(size_t workerCount);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Engine-wide scheduler with one worker per hardware thread but one
+    static JobSystem& instance();
+
+    /**
+     * @brief Run body(begin, end) over [0, count) in chunks of grainSize indices
+     *
+     * Blocks until every chunk has run. Chunk boundaries depend only on
+     * count and grainSize, never on timing, except that a range the
+     * calling thread runs alone goes to body in a single call. At most
+     * maxThreads threads, the caller included, work on the range; 0
+     * allows all of them and 1 runs it on the calling thread.
+     */
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body,
+                     size_t maxThreads = 0);
+
+    /**
+     * @brief Queue one task and return a future for its result
+     *
+     * Tasks run in no particular order on the workers, or right away on
+     * the calling thread when there are none. Waiting on the future does
+     * not run other jobs, so a job must not wait for a task queued after
+     * it.
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<decltype(task())> {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        if (m_workers.empty()) {
+            (*packaged)();
+        } else {
+            push([packaged]() { (*packaged)(); });
+        }
+        return result;
+    }
+
+    // Workers plus the calling thread
+    size_t getThreadCount() const;
+
+private:
+    struct JobQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<JobQueue>> m_queues;   // One per worker, then the shared one
+    std::atomic<size_t> m_queuedJobs;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_jobAvailable;
+    bool m_stopping;
+
+    void push(std::function<void()> job);
+    bool runJob(size_t queueIndex);
+    size_t currentQueue() const;
+    void workerLoop(size_t index);
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+/**
+ * @brief Instruction sets the SIMD kernels are compiled for
+ *
+ * KALEM_SIMD_AVX2 is defined when the build enables AVX2, see the
+ * KALEM_ENABLE_AVX2 option, and KALEM_SIMD_SSE2 on every x86-64 build,
+ * AVX2 ones included, each with its intrinsics header. Kernels use the
+ * widest set defined and plain C++ when there is none, so every build
+ * computes the same results.
+ */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define KALEM_SIMD_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KALEM_SIMD_SSE2
+#endif
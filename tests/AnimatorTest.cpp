@@ -0,0 +1,162 @@
+#include "engine/AnimationEngine.h"
+#include "engine/Animator.h"
+#include "engine/PhysicsEngine.h"
+#include "objects/Shape.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Linear scan for the segment around a time, with no cursor
+float referenceEvaluate(const std::vector<float>& times, const std::vector<float>& values,
+                        const std::vector<Easing>& easings, float time) {
+    if (time <= times.front()) return values.front();
+    if (time >= times.back()) return values.back();
+    size_t segment = 0;
+    while (!(times[segment] <= time && time < times[segment + 1])) ++segment;
+    float weight = applyEasing(easings[segment + 1], (time - times[segment]) / (times[segment + 1] - times[segment]));
+    return values[segment] + (values[segment + 1] - values[segment]) * weight;
+}
+
+} // namespace
+
+// Each key's easing shapes the segment that ends at it
+TEST(KeyframeTrackTest, EasingShapesSegments) {
+    KeyframeTrack<float> track;
+    track.addKey(0.0f, 0.0f);
+    track.addKey(1.0f, 10.0f, Easing::EaseIn);
+    track.addKey(2.0f, 20.0f, Easing::EaseOut);
+    track.addKey(3.0f, 30.0f, Easing::EaseInOut);
+    track.addKey(4.0f, 40.0f, Easing::Step);
+    track.addKey(5.0f, 50.0f, Easing::Linear);
+
+    EXPECT_FLOAT_EQ(track.evaluate(-1.0f), 0.0f);
+    EXPECT_FLOAT_EQ(track.evaluate(0.5f), 2.5f);
+    EXPECT_FLOAT_EQ(track.evaluate(1.5f), 17.5f);
+    EXPECT_FLOAT_EQ(track.evaluate(2.25f), 21.5625f);
+    EXPECT_FLOAT_EQ(track.evaluate(2.5f), 25.0f);
+    EXPECT_FLOAT_EQ(track.evaluate(3.5f), 30.0f);
+    EXPECT_FLOAT_EQ(track.evaluate(3.999f), 30.0f);
+    EXPECT_FLOAT_EQ(track.evaluate(4.0f), 40.0f);
+    EXPECT_FLOAT_EQ(track.evaluate(4.25f), 42.5f);
+    EXPECT_FLOAT_EQ(track.evaluate(9.0f), 50.0f);
+}
+
+// Forward playback, rewinding, scrubbing and jumps all find the segment
+// a plain scan finds, however the cached cursor was left
+TEST(KeyframeTrackTest, CursorMatchesBinarySearch) {
+    std::mt19937 random(21);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const Easing easings[] = { Easing::Linear, Easing::EaseIn, Easing::EaseOut, Easing::EaseInOut, Easing::Step };
+
+    std::vector<float> times, values;
+    std::vector<Easing> keyEasings;
+    KeyframeTrack<float> track;
+    float time = 0.0f;
+    for (int i = 0; i < 60; ++i) {
+        time += (i % 5 == 0) ? 0.001f : unit(random);
+        float value = unit(random) * 100.0f;
+        Easing easing = easings[random() % 5];
+        track.addKey(time, value, easing);
+        times.push_back(time);
+        values.push_back(value);
+        keyEasings.push_back(easing);
+    }
+    const float end = times.back();
+
+    std::vector<float> queries;
+    for (float t = -0.5f; t < end + 0.5f; t += 1.0f / 60.0f) queries.push_back(t);
+    for (float t = end + 0.5f; t > -0.5f; t -= 0.07f) queries.push_back(t);
+    for (int i = 0; i < 500; ++i) queries.push_back((unit(random) * 1.2f - 0.1f) * end);
+    for (float key : times) {
+        queries.push_back(key);
+        queries.push_back(key - 0.0005f);
+    }
+
+    for (float query : queries) {
+        ASSERT_EQ(track.evaluate(query), referenceEvaluate(times, values, keyEasings, query)) << "at " << query;
+    }
+
+    // Dropping keys resets the cursor past the new end
+    track.evaluate(end - 0.01f);
+    track.removeKeysAfter(times[20]);
+    times.resize(21);
+    values.resize(21);
+    keyEasings.resize(21);
+    for (float query : { times[19] + 0.001f, times[5], times[20], end }) {
+        ASSERT_EQ(track.evaluate(query), referenceEvaluate(times, values, keyEasings, query)) << "at " << query;
+    }
+}
+
+// Held values are written once, so changes made to the object while a
+// track holds stay
+TEST(AnimatorTest, HeldKeysAreWrittenOnce) {
+    auto ball = std::make_shared<Circle>(0.0f, 0.0f, 5.0f);
+    Animator animator;
+    Animator::Tracks& tracks = animator.getTracks(ball);
+    tracks.position.addKey(1.0f, glm::vec3(0.0f));
+    tracks.position.addKey(2.0f, glm::vec3(100.0f, 0.0f, 0.0f));
+    tracks.opacity.addKey(2.0f, 0.5f);
+
+    animator.evaluate(0.0f);
+    EXPECT_EQ(ball->getPosition(), glm::vec3(0.0f));
+    EXPECT_EQ(ball->getOpacity(), 0.5f);
+
+    ball->setPosition(glm::vec3(5.0f, 5.0f, 0.0f));
+    ball->setOpacity(1.0f);
+    animator.evaluate(0.5f);
+    EXPECT_EQ(ball->getPosition(), glm::vec3(5.0f, 5.0f, 0.0f));
+    EXPECT_EQ(ball->getOpacity(), 1.0f);
+
+    animator.evaluate(1.5f);
+    EXPECT_EQ(ball->getPosition(), glm::vec3(50.0f, 0.0f, 0.0f));
+
+    animator.evaluate(2.5f);
+    EXPECT_EQ(ball->getPosition(), glm::vec3(100.0f, 0.0f, 0.0f));
+    ball->setPosition(glm::vec3(100.0f, -40.0f, 0.0f));
+    for (float time : { 3.0f, 4.0f, 5.0f }) {
+        animator.evaluate(time);
+        EXPECT_EQ(ball->getPosition(), glm::vec3(100.0f, -40.0f, 0.0f));
+    }
+
+    // A seek writes every track again
+    animator.invalidate();
+    animator.evaluate(5.0f);
+    EXPECT_EQ(ball->getPosition(), glm::vec3(100.0f, 0.0f, 0.0f));
+    EXPECT_EQ(ball->getOpacity(), 0.5f);
+}
+
+// A body whose position animation ended falls under gravity like any other
+TEST(AnimatorTest, FinishedAnimationLeavesPhysicsAlone) {
+    AnimationEngine engine(RenderMode::Headless);
+    engine.enablePhysics(true);
+    engine.setGravity(0.0f, -9.81f);
+
+    auto ball = std::make_shared<Circle>(0.0f, 0.0f, 1.0f);
+    ball->setName("ball");
+    ball->setGravityAffected(true);
+    engine.addObject(ball);
+    engine.getPhysicsEngine()->addObject(ball);
+
+    Animator::Tracks& tracks = engine.getAnimator()->getTracks(ball);
+    tracks.position.addKey(0.0f, glm::vec3(0.0f));
+    tracks.position.addKey(1.0f, glm::vec3(100.0f, 0.0f, 0.0f));
+
+    engine.setDuration(3.0f);
+    engine.play();
+    std::vector<float> heights;
+    for (int frame = 1; frame <= 180; ++frame) {
+        engine.update(1.0f / 60.0f);
+        if (frame % 60 == 0) heights.push_back(ball->getPosition().y);
+    }
+
+    ASSERT_EQ(heights.size(), 3u);
+    EXPECT_EQ(ball->getPosition().x, 100.0f);
+    EXPECT_LT(heights[1], heights[0] - 4.0f);
+    EXPECT_LT(heights[2], heights[1] - 12.0f);
+
+    // Seeking back into the animation applies it again
+    engine.seek(0.5f);
+    EXPECT_EQ(ball->getPosition(), glm::vec3(50.0f, 0.0f, 0.0f));
+}
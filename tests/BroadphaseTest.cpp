@@ -0,0 +1,138 @@
+#include "engine/Broadphase.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Bodies of mixed sizes drifting around the origin: a few statics, a few
+// empty slots, some huge proxies and some exactly touching neighbours
+class ProxyScene {
+public:
+    explicit ProxyScene(size_t count)
+        : m_random(23) {
+        for (size_t i = 0; i < count; ++i) {
+            BroadphaseProxy proxy;
+            glm::vec2 center(uniform(-400.0f, 400.0f), uniform(-300.0f, 300.0f));
+            glm::vec2 half(uniform(2.0f, 15.0f), uniform(2.0f, 15.0f));
+            if (i % 37 == 0) half *= 30.0f;
+            proxy.min = center - half;
+            proxy.max = center + half;
+            proxy.isStatic = i % 11 == 0;
+            proxy.active = i % 13 != 5;
+            m_proxies.push_back(proxy);
+            m_velocities.push_back(proxy.isStatic ? glm::vec2(0.0f) : glm::vec2(uniform(-6.0f, 6.0f), uniform(-6.0f, 6.0f)));
+        }
+        // Touching bounds count as overlapping
+        m_proxies[1].min = glm::vec2(m_proxies[2].max.x, m_proxies[2].min.y);
+        m_proxies[1].max = m_proxies[1].min + glm::vec2(10.0f);
+        m_velocities[1] = m_velocities[2];
+    }
+
+    void step() {
+        for (size_t i = 0; i < m_proxies.size(); ++i) {
+            m_proxies[i].min += m_velocities[i];
+            m_proxies[i].max += m_velocities[i];
+        }
+        // Slots come and go like bodies being added and removed
+        size_t slot = m_random() % m_proxies.size();
+        if (slot != 1 && slot != 2) m_proxies[slot].active = !m_proxies[slot].active;
+    }
+
+    const std::vector<BroadphaseProxy>& getProxies() const { return m_proxies; }
+
+private:
+    std::mt19937 m_random;
+    std::vector<BroadphaseProxy> m_proxies;
+    std::vector<glm::vec2> m_velocities;
+
+    float uniform(float min, float max) { return std::uniform_real_distribution<float>(min, max)(m_random); }
+};
+
+// Every candidate from the all-pairs reference whose bounds overlap
+std::vector<BroadphasePair> referencePairs(const std::vector<BroadphaseProxy>& proxies) {
+    AllPairsBroadphase reference;
+    reference.update(proxies);
+    std::vector<BroadphasePair> candidates, pairs;
+    reference.findPairs(candidates);
+    for (const BroadphasePair& pair : candidates) {
+        const BroadphaseProxy& a = proxies[pair.first];
+        const BroadphaseProxy& b = proxies[pair.second];
+        if (a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y) {
+            pairs.push_back(pair);
+        }
+    }
+    return pairs;
+}
+
+bool samePairs(const std::vector<BroadphasePair>& a, const std::vector<BroadphasePair>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].first != b[i].first || a[i].second != b[i].second) return false;
+    }
+    return true;
+}
+
+bool pairLess(const BroadphasePair& a, const BroadphasePair& b) {
+    return a.first != b.first ? a.first < b.first : a.second < b.second;
+}
+
+// Pairs in a but not in b; both sorted
+std::vector<BroadphasePair> difference(const std::vector<BroadphasePair>& a, const std::vector<BroadphasePair>& b) {
+    std::vector<BroadphasePair> result;
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result), pairLess);
+    return result;
+}
+
+std::vector<BroadphasePair> sorted(std::vector<BroadphasePair> pairs) {
+    std::sort(pairs.begin(), pairs.end(), pairLess);
+    return pairs;
+}
+
+void expectMatchesReference(Broadphase& broadphase) {
+    ProxyScene scene(600);
+    std::vector<BroadphasePair> pairs;
+    size_t total = 0;
+    for (int step = 0; step < 40; ++step) {
+        broadphase.update(scene.getProxies());
+        broadphase.findPairs(pairs);
+        std::vector<BroadphasePair> expected = referencePairs(scene.getProxies());
+        EXPECT_TRUE(samePairs(pairs, expected)) << "step " << step << ": " << pairs.size() << " pairs, expected "
+                                                << expected.size();
+        total += expected.size();
+        scene.step();
+    }
+    EXPECT_GT(total, 0u);
+}
+
+} // namespace
+
+TEST(BroadphaseTest, SpatialHashMatchesAllPairs) {
+    SpatialHashBroadphase broadphase;
+    expectMatchesReference(broadphase);
+}
+
+TEST(BroadphaseTest, SweepAndPruneMatchesAllPairs) {
+    SweepAndPruneBroadphase broadphase;
+    expectMatchesReference(broadphase);
+}
+
+// Pair events are the difference between consecutive overlap sets
+TEST(BroadphaseTest, SweepAndPrunePairEvents) {
+    ProxyScene scene(300);
+    SweepAndPruneBroadphase broadphase;
+    std::vector<BroadphasePair> previous;
+    size_t events = 0;
+    for (int step = 0; step < 40; ++step) {
+        broadphase.update(scene.getProxies());
+        std::vector<BroadphasePair> current = referencePairs(scene.getProxies());
+        EXPECT_TRUE(samePairs(sorted(broadphase.getAddedPairs()), difference(current, previous))) << "step " << step;
+        EXPECT_TRUE(samePairs(sorted(broadphase.getRemovedPairs()), difference(previous, current))) << "step " << step;
+        events += broadphase.getAddedPairs().size() + broadphase.getRemovedPairs().size();
+        previous = current;
+        scene.step();
+    }
+    EXPECT_GT(events, 0u);
+}
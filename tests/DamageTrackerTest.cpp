@@ -0,0 +1,111 @@
+#include "rendering/DamageTracker.h"
+#include "rendering/SoftwareRasterizer.h"
+#include <gtest/gtest.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int kWidth = 160;
+const int kHeight = 120;
+const glm::vec4 kBackground(0.0f, 0.0f, 0.0f, 1.0f);
+
+RenderInstance makeInstance(std::mt19937& random) {
+    auto uniform = [&](float min, float max) { return std::uniform_real_distribution<float>(min, max)(random); };
+    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(kWidth), 0.0f, static_cast<float>(kHeight), -1.0f, 1.0f);
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(uniform(-10.0f, kWidth + 10.0f),
+                                                                  uniform(-10.0f, kHeight + 10.0f), 0.0f));
+    model = glm::rotate(model, uniform(0.0f, 6.3f), glm::vec3(0.0f, 0.0f, 1.0f));
+    model = glm::scale(model, glm::vec3(uniform(2.0f, 25.0f), uniform(2.0f, 25.0f), 1.0f));
+    glm::vec4 color(uniform(0.0f, 1.0f), uniform(0.0f, 1.0f), uniform(0.0f, 1.0f), uniform(0.3f, 1.0f));
+
+    RenderBatch batch;
+    if (random() % 2) {
+        batch.addCircle(projection * model, color);
+    } else {
+        batch.addQuad(projection * model, color);
+    }
+    return batch.getInstances()[0];
+}
+
+// The edits a scene makes between frames: moves, recolors, removals,
+// insertions, raising one to the top, and now and then nothing at all
+void editScene(std::vector<RenderInstance>& instances, std::mt19937& random, int frame) {
+    if (frame % 5 == 4) return;
+    for (int edit = 0; edit < 3; ++edit) {
+        size_t index = random() % instances.size();
+        switch (random() % 5) {
+        case 0:
+            instances[index].origin += glm::vec4(0.02f, -0.03f, 0.0f, 0.0f);
+            break;
+        case 1:
+            instances[index].color.g = 1.0f - instances[index].color.g;
+            break;
+        case 2:
+            instances.erase(instances.begin() + index);
+            break;
+        case 3:
+            instances.insert(instances.begin() + index, makeInstance(random));
+            break;
+        default: {
+            RenderInstance raised = instances[index];
+            instances.erase(instances.begin() + index);
+            instances.push_back(raised);
+            break;
+        }
+        }
+    }
+}
+
+size_t countDifferences(const Framebuffer& a, const Framebuffer& b) {
+    size_t differences = 0;
+    for (size_t i = 0; i < a.getSizeInBytes(); ++i) differences += a.getPixels()[i] != b.getPixels()[i];
+    return differences;
+}
+
+} // namespace
+
+// Repainting only the damage of each frame must give the full frame
+TEST(DamageTrackerTest, RedrawMatchesFullFrame) {
+    std::mt19937 random(17);
+    std::vector<RenderInstance> instances;
+    for (int i = 0; i < 80; ++i) instances.push_back(makeInstance(random));
+    std::vector<RenderInstance> overlay = { makeInstance(random) };
+
+    SoftwareRasterizer rasterizer;
+    DamageTracker tracker;
+    Framebuffer incremental(kWidth, kHeight), full(kWidth, kHeight);
+
+    for (int frame = 0; frame < 30; ++frame) {
+        editScene(instances, random, frame);
+        if (frame == 12) tracker.invalidate();
+
+        // The overlay is drawn after the tracked list, like text after shapes
+        tracker.beginFrame(rasterizer, instances.data(), instances.size(), kWidth, kHeight);
+        tracker.append(rasterizer, overlay.data(), overlay.size());
+        const std::vector<PixelRect>& damage = tracker.getDamage();
+
+        std::vector<RenderInstance> drawn = instances;
+        drawn.insert(drawn.end(), overlay.begin(), overlay.end());
+        rasterizer.redraw(incremental, drawn.data(), drawn.size(), damage.data(), damage.size(), kBackground);
+
+        full.clear(kBackground);
+        rasterizer.draw(full, drawn.data(), drawn.size());
+        EXPECT_EQ(countDifferences(incremental, full), 0u) << "frame " << frame;
+    }
+}
+
+// A frame identical to the last one has no damage
+TEST(DamageTrackerTest, UnchangedFrameHasNoDamage) {
+    std::mt19937 random(4);
+    std::vector<RenderInstance> instances;
+    for (int i = 0; i < 50; ++i) instances.push_back(makeInstance(random));
+
+    SoftwareRasterizer rasterizer;
+    DamageTracker tracker;
+    tracker.beginFrame(rasterizer, instances.data(), instances.size(), kWidth, kHeight);
+    ASSERT_EQ(tracker.getDamage().size(), 1u);
+    tracker.beginFrame(rasterizer, instances.data(), instances.size(), kWidth, kHeight);
+    EXPECT_TRUE(tracker.getDamage().empty());
+}
@@ -0,0 +1,149 @@
+#include "rendering/Font.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Values below are read from DejaVu Sans with an independent sfnt parser
+const float kUnitsPerEm = 2048.0f;
+const char* kBundledPath = KALEM_ASSET_DIR "/fonts/DejaVuSans.ttf";
+
+std::vector<uint8_t> readBundledFont() {
+    std::ifstream file(kBundledPath, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Rows from the first with any coverage to the last
+int inkedHeight(const GlyphBitmap& bitmap) {
+    int first = bitmap.height, last = -1;
+    for (int y = 0; y < bitmap.height; ++y) {
+        for (int x = 0; x < bitmap.width; ++x) {
+            if (bitmap.coverage[y * bitmap.width + x] == 0) continue;
+            first = std::min(first, y);
+            last = std::max(last, y);
+        }
+    }
+    return last - first + 1;
+}
+
+} // namespace
+
+TEST(FontTest, BundledFontMetrics) {
+    std::shared_ptr<Font> font = Font::loadFromFile(kBundledPath);
+    ASSERT_TRUE(font);
+
+    EXPECT_FLOAT_EQ(font->getAscent(), 1901 / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(font->getDescent(), -483 / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(font->getLineGap(), 0.0f);
+
+    // cmap format 4 for the BMP and format 12 past it
+    EXPECT_EQ(font->getGlyphIndex('A'), 36u);
+    EXPECT_EQ(font->getGlyphIndex('V'), 57u);
+    EXPECT_EQ(font->getGlyphIndex(' '), 3u);
+    EXPECT_EQ(font->getGlyphIndex(0x20AC), 2948u);
+    EXPECT_EQ(font->getGlyphIndex(0x1F643), 5920u);
+    EXPECT_EQ(font->getGlyphIndex(0x10FFFF), 0u);
+
+    // Glyphs past the last long metric share its advance
+    EXPECT_FLOAT_EQ(font->getAdvance(36), 1401 / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(font->getAdvance(font->getGlyphIndex('T')), 1251 / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(font->getAdvance(3), 651 / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(font->getAdvance(5920), 2135 / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(font->getAdvance(6250), 1508 / kUnitsPerEm);
+
+    glm::vec2 min, max;
+    ASSERT_TRUE(font->getGlyphBounds(36, min, max));
+    EXPECT_EQ(min * kUnitsPerEm, glm::vec2(16.0f, 0.0f));
+    EXPECT_EQ(max * kUnitsPerEm, glm::vec2(1384.0f, 1493.0f));
+    EXPECT_FALSE(font->getGlyphBounds(3, min, max));
+}
+
+TEST(FontTest, BundledFontKerning) {
+    std::shared_ptr<Font> font = Font::loadFromFile(kBundledPath);
+    ASSERT_TRUE(font);
+    uint32_t a = font->getGlyphIndex('A');
+    uint32_t v = font->getGlyphIndex('V');
+    uint32_t t = font->getGlyphIndex('T');
+    uint32_t o = font->getGlyphIndex('o');
+
+    EXPECT_FLOAT_EQ(font->getKerning(a, v), -131 / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(font->getKerning(v, a), -131 / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(font->getKerning(t, o), -348 / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(font->getKerning(a, a), 57 / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(font->getKerning(o, o), 0.0f);
+
+    std::vector<ShapedGlyph> glyphs;
+    float width = font->shape("AVA", glyphs);
+    ASSERT_EQ(glyphs.size(), 3u);
+    EXPECT_EQ(glyphs[0].x, 0.0f);
+    EXPECT_FLOAT_EQ(glyphs[1].x, (1401 - 131) / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(glyphs[2].x, (1401 - 131 + 1401 - 131) / kUnitsPerEm);
+    EXPECT_FLOAT_EQ(width, (3 * 1401 - 2 * 131) / kUnitsPerEm);
+}
+
+// é is a composite of e and an acute accent placed above it
+TEST(FontTest, CompositeGlyphs) {
+    std::shared_ptr<Font> font = Font::loadFromFile(kBundledPath);
+    ASSERT_TRUE(font);
+    uint32_t e = font->getGlyphIndex('e');
+    uint32_t eAcute = font->getGlyphIndex(0xE9);
+
+    glm::vec2 min, max;
+    ASSERT_TRUE(font->getGlyphBounds(eAcute, min, max));
+    EXPECT_EQ(min * kUnitsPerEm, glm::vec2(113.0f, -29.0f));
+    EXPECT_EQ(max * kUnitsPerEm, glm::vec2(1151.0f, 1638.0f));
+
+    const float pixelsPerEm = 64.0f;
+    GlyphBitmap plain, accented;
+    ASSERT_TRUE(font->rasterizeGlyph(e, pixelsPerEm, plain));
+    ASSERT_TRUE(font->rasterizeGlyph(eAcute, pixelsPerEm, accented));
+    EXPECT_NEAR(inkedHeight(accented), (1638 + 29) / kUnitsPerEm * pixelsPerEm, 2.0);
+    EXPECT_GT(inkedHeight(accented), inkedHeight(plain) + 10);
+    EXPECT_GE(accented.top, static_cast<int>(1638 / kUnitsPerEm * pixelsPerEm));
+}
+
+// Unknown families fall back to the bundled font, not to the host's
+TEST(FontTest, FindFallsBackToBundledFont) {
+    for (const char* family : { "DejaVu Sans", "No Such Family" }) {
+        std::shared_ptr<Font> font = Font::find(family);
+        ASSERT_TRUE(font) << family;
+        EXPECT_EQ(font->getGlyphIndex(0x1F643), 5920u) << family;
+        EXPECT_FLOAT_EQ(font->getAdvance(font->getGlyphIndex('A')), 1401 / kUnitsPerEm) << family;
+    }
+}
+
+// Files cut short anywhere before the last required table are rejected, and
+// damaged files never read past their data
+TEST(FontTest, TruncatedAndCorruptFiles) {
+    const std::vector<uint8_t> data = readBundledFont();
+    ASSERT_GT(data.size(), 680660u);
+
+    EXPECT_FALSE(Font::loadFromMemory({}));
+    for (size_t length : { size_t(3), size_t(12), size_t(300), size_t(50000), size_t(614200), size_t(680659) }) {
+        EXPECT_FALSE(Font::loadFromMemory(std::vector<uint8_t>(data.begin(), data.begin() + length))) << length;
+    }
+
+    std::mt19937 random(8);
+    for (int trial = 0; trial < 40; ++trial) {
+        std::vector<uint8_t> corrupt = data;
+        // Damage the table directory and the tables the parser reads
+        for (int i = 0; i < 30; ++i) {
+            size_t offset = (i % 3 == 0) ? random() % 332 : 48896 + random() % (680660 - 48896);
+            corrupt[offset] = static_cast<uint8_t>(random());
+        }
+        std::shared_ptr<Font> font = Font::loadFromMemory(std::move(corrupt));
+        if (!font) continue;
+
+        std::vector<ShapedGlyph> glyphs;
+        font->shape("AVATAR To é \xF0\x9F\x99\x83", glyphs);
+        for (const ShapedGlyph& glyph : glyphs) {
+            GlyphBitmap bitmap;
+            font->rasterizeGlyph(glyph.glyph, 24.0f, bitmap);
+            font->generateDistanceField(glyph.glyph, 24.0f, 4.0f, bitmap);
+        }
+    }
+}
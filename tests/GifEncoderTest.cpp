@@ -0,0 +1,230 @@
+#include "export/GifEncoder.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Textbook LZW decoder keeping every dictionary entry as its own string
+bool referenceLzwDecode(const std::vector<uint8_t>& data, int minCodeSize, std::vector<uint8_t>& out) {
+    const int clearCode = 1 << minCodeSize;
+    const int endCode = clearCode + 1;
+    std::vector<std::vector<uint8_t>> table;
+    int codeSize = 0;
+    auto reset = [&]() {
+        table.clear();
+        for (int i = 0; i < clearCode + 2; ++i) table.push_back({ static_cast<uint8_t>(i) });
+        codeSize = minCodeSize + 1;
+    };
+    reset();
+
+    std::vector<uint8_t> previous;
+    size_t bit = 0;
+    while (bit + codeSize <= data.size() * 8) {
+        int code = 0;
+        for (int i = 0; i < codeSize; ++i, ++bit) {
+            code |= ((data[bit / 8] >> (bit % 8)) & 1) << i;
+        }
+        if (code == clearCode) {
+            reset();
+            previous.clear();
+            continue;
+        }
+        if (code == endCode) return true;
+
+        std::vector<uint8_t> entry;
+        if (code < static_cast<int>(table.size())) {
+            entry = table[code];
+        } else if (code == static_cast<int>(table.size()) && !previous.empty()) {
+            entry = previous;
+            entry.push_back(previous[0]);
+        } else {
+            return false;
+        }
+        out.insert(out.end(), entry.begin(), entry.end());
+
+        if (!previous.empty() && table.size() < 4096) {
+            previous.push_back(entry[0]);
+            table.push_back(previous);
+            if (table.size() == (1u << codeSize) && codeSize < 12) ++codeSize;
+        }
+        previous = entry;
+    }
+    return false;  // No end code
+}
+
+// Decodes every frame and composites it onto an RGB canvas
+bool decodeGif(const std::vector<uint8_t>& file, int& width, int& height, std::vector<std::vector<uint8_t>>& frames) {
+    size_t at = 0;
+    auto byte = [&]() { return at < file.size() ? file[at++] : 0; };
+    auto shortValue = [&]() { int low = byte(); return low | (byte() << 8); };
+    auto subBlocks = [&](std::vector<uint8_t>* data) {
+        while (int length = byte()) {
+            if (at + length > file.size()) return false;
+            if (data) data->insert(data->end(), file.begin() + at, file.begin() + at + length);
+            at += length;
+        }
+        return true;
+    };
+
+    if (file.size() < 13 || std::string(file.begin(), file.begin() + 6) != "GIF89a") return false;
+    at = 6;
+    width = shortValue();
+    height = shortValue();
+    if (byte() & 0x80) return false;  // The encoder writes no global table
+    at += 2;
+
+    std::vector<uint8_t> canvas(static_cast<size_t>(width) * height * 3, 0);
+    while (at < file.size()) {
+        int block = byte();
+        if (block == 0x3B) return true;
+        if (block == 0x21) {
+            byte();
+            if (!subBlocks(nullptr)) return false;
+            continue;
+        }
+        if (block != 0x2C) return false;
+
+        int x = shortValue(), y = shortValue(), w = shortValue(), h = shortValue();
+        int flags = byte();
+        size_t paletteSize = static_cast<size_t>(3) << ((flags & 7) + 1);
+        if (!(flags & 0x80) || x + w > width || y + h > height || at + paletteSize > file.size()) return false;
+        std::vector<uint8_t> palette(file.begin() + at, file.begin() + at + paletteSize);
+        at += paletteSize;
+
+        int minCodeSize = byte();
+        std::vector<uint8_t> data, indices;
+        if (!subBlocks(&data) || !referenceLzwDecode(data, minCodeSize, indices)) return false;
+        if (indices.size() != static_cast<size_t>(w) * h) return false;
+
+        for (int row = 0; row < h; ++row) {
+            for (int column = 0; column < w; ++column) {
+                size_t index = indices[row * w + column];
+                if (index * 3 >= palette.size()) return false;
+                for (int c = 0; c < 3; ++c) {
+                    canvas[((y + row) * width + x + column) * 3 + c] = palette[index * 3 + c];
+                }
+            }
+        }
+        frames.push_back(canvas);
+    }
+    return false;  // No trailer
+}
+
+std::vector<uint8_t> readFile(const std::string& path) {
+    std::vector<uint8_t> data;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return data;
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    fclose(file);
+    return data;
+}
+
+struct TestFrame {
+    std::vector<uint8_t> rgba;
+    std::vector<PixelRect> damage;
+};
+
+// Frames that use at most 256 colors each, so they must round-trip exactly:
+// full noise (long code streams with dictionary resets), small edits, a
+// two-color frame and a repeat
+std::vector<TestFrame> makeFrames(int width, int height) {
+    std::mt19937 random(11);
+    std::vector<uint32_t> colors(256);
+    for (uint32_t& color : colors) color = random() & 0xFFFFFF;
+
+    std::vector<TestFrame> frames;
+    std::vector<uint8_t> image(static_cast<size_t>(width) * height * 4, 255);
+    auto setPixel = [&](int x, int y, uint32_t color) {
+        uint8_t* pixel = &image[(static_cast<size_t>(y) * width + x) * 4];
+        pixel[0] = color & 0xFF;
+        pixel[1] = (color >> 8) & 0xFF;
+        pixel[2] = (color >> 16) & 0xFF;
+    };
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) setPixel(x, y, colors[random() % 256]);
+    }
+    frames.push_back({ image, {} });
+
+    for (int f = 0; f < 4; ++f) {
+        PixelRect rect;
+        rect.x0 = static_cast<int>(random() % width);
+        rect.y0 = static_cast<int>(random() % height);
+        rect.x1 = std::min(width, rect.x0 + 1 + static_cast<int>(random() % 20));
+        rect.y1 = std::min(height, rect.y0 + 1 + static_cast<int>(random() % 20));
+        for (int y = rect.y0; y < rect.y1; ++y) {
+            for (int x = rect.x0; x < rect.x1; ++x) setPixel(x, y, colors[random() % 256]);
+        }
+        frames.push_back({ image, { rect } });
+    }
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) setPixel(x, y, ((x / 7 + y / 5) & 1) ? 0xFFFFFF : 0x000000);
+    }
+    frames.push_back({ image, { PixelRect{ 0, 0, width, height } } });
+    frames.push_back({ image, {} });
+    return frames;
+}
+
+std::vector<uint8_t> encode(const std::vector<TestFrame>& frames, int width, int height, const GifOptions& options,
+                            bool useDamage) {
+    const std::string path = ::testing::TempDir() + "kalem_gif_encoder_test.gif";
+    GifEncoder encoder(options);
+    EXPECT_TRUE(encoder.open(path, width, height, 30));
+    for (const TestFrame& frame : frames) {
+        EXPECT_TRUE(encoder.addFrame(frame.rgba.data(), false, useDamage ? &frame.damage : nullptr));
+    }
+    EXPECT_TRUE(encoder.close());
+    EXPECT_EQ(encoder.getFramesWritten(), static_cast<int>(frames.size()));
+
+    std::vector<uint8_t> file = readFile(path);
+    std::remove(path.c_str());
+    return file;
+}
+
+} // namespace
+
+TEST(GifEncoderTest, ExactColorsRoundTrip) {
+    const int width = 173, height = 131;
+    std::vector<TestFrame> frames = makeFrames(width, height);
+    std::vector<uint8_t> file = encode(frames, width, height, GifOptions(), false);
+
+    int decodedWidth = 0, decodedHeight = 0;
+    std::vector<std::vector<uint8_t>> decoded;
+    ASSERT_TRUE(decodeGif(file, decodedWidth, decodedHeight, decoded));
+    ASSERT_EQ(decodedWidth, width);
+    ASSERT_EQ(decodedHeight, height);
+    ASSERT_EQ(decoded.size(), frames.size());
+
+    for (size_t f = 0; f < frames.size(); ++f) {
+        size_t mismatches = 0;
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i) {
+            for (int c = 0; c < 3; ++c) mismatches += decoded[f][i * 3 + c] != frames[f].rgba[i * 4 + c];
+        }
+        EXPECT_EQ(mismatches, 0u) << "frame " << f;
+    }
+}
+
+// Damage only narrows where the changed rectangle is searched for
+TEST(GifEncoderTest, DamageMatchesFullSearch) {
+    const int width = 96, height = 80;
+    std::vector<TestFrame> frames = makeFrames(width, height);
+    EXPECT_EQ(encode(frames, width, height, GifOptions(), true), encode(frames, width, height, GifOptions(), false));
+}
+
+// Frames encoded concurrently on the job system are written in order
+TEST(GifEncoderTest, ParallelMatchesSerial) {
+    const int width = 96, height = 80;
+    std::vector<TestFrame> frames = makeFrames(width, height);
+    GifOptions serial;
+    serial.threadCount = 1;
+    EXPECT_EQ(encode(frames, width, height, GifOptions(), false), encode(frames, width, height, serial, false));
+}
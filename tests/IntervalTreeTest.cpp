@@ -0,0 +1,69 @@
+#include "engine/IntervalTree.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<uint32_t> referenceStab(const std::vector<IntervalTree::Interval>& intervals, float time) {
+    std::vector<uint32_t> values;
+    for (const IntervalTree::Interval& interval : intervals) {
+        if (interval.start <= time && time < interval.end) values.push_back(interval.value);
+    }
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+std::vector<uint32_t> treeStab(const IntervalTree& tree, float time) {
+    std::vector<uint32_t> values;
+    tree.stab(time, values);
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+} // namespace
+
+// Every size from empty through several tree levels, with short, long,
+// empty and duplicate intervals, queried at random times and exactly on
+// interval boundaries
+TEST(IntervalTreeTest, StabMatchesLinearScan) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> time(0.0f, 100.0f);
+
+    for (size_t count = 0; count < 140; ++count) {
+        std::vector<IntervalTree::Interval> intervals;
+        for (size_t i = 0; i < count; ++i) {
+            float start = std::floor(time(random) * 4.0f) / 4.0f;
+            float length = (i % 4 == 0) ? time(random) : time(random) * 0.05f;
+            if (i % 9 == 0) length = 0.0f;
+            intervals.push_back({ start, start + length, static_cast<uint32_t>(i) });
+        }
+        if (count > 2) intervals[count - 1] = { intervals[0].start, intervals[0].end, static_cast<uint32_t>(count - 1) };
+
+        IntervalTree tree;
+        tree.build(intervals);
+        ASSERT_EQ(tree.size(), count);
+
+        std::vector<float> queries = { -1.0f, 0.0f, 100.0f, 250.0f };
+        for (int q = 0; q < 30; ++q) queries.push_back(time(random));
+        for (const IntervalTree::Interval& interval : intervals) {
+            queries.push_back(interval.start);
+            queries.push_back(interval.end);
+        }
+        for (float query : queries) {
+            ASSERT_EQ(treeStab(tree, query), referenceStab(intervals, query)) << count << " intervals at " << query;
+        }
+    }
+}
+
+TEST(IntervalTreeTest, ClearEmptiesTheTree) {
+    IntervalTree tree;
+    tree.build({ { 0.0f, 10.0f, 1u }, { 5.0f, 6.0f, 2u } });
+    EXPECT_EQ(treeStab(tree, 5.5f), (std::vector<uint32_t>{ 1u, 2u }));
+
+    tree.clear();
+    EXPECT_EQ(tree.size(), 0u);
+    EXPECT_TRUE(treeStab(tree, 5.5f).empty());
+}
@@ -0,0 +1,91 @@
+#include "utils/JobSystem.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef std::vector<std::pair<size_t, size_t>> Chunks;
+
+// The chunks a serial loop over [0, count) in steps of grainSize visits,
+// or the whole range at once when only the calling thread works on it
+Chunks referenceChunks(size_t count, size_t grainSize, bool shared) {
+    Chunks chunks;
+    if (!shared) {
+        if (count > 0) chunks.emplace_back(0, count);
+        return chunks;
+    }
+    for (size_t begin = 0; begin < count; begin += grainSize) {
+        chunks.emplace_back(begin, std::min(count, begin + grainSize));
+    }
+    return chunks;
+}
+
+} // namespace
+
+// Explicit worker counts, so stealing is exercised on any machine
+TEST(JobSystemTest, ParallelForMatchesSerialChunks) {
+    for (size_t workers : { 0, 1, 3, 7 }) {
+        JobSystem jobs(workers);
+        EXPECT_EQ(jobs.getThreadCount(), workers + 1);
+
+        for (size_t count : { 0, 1, 5, 64, 1000, 4099 }) {
+            for (size_t grainSize : { 1, 7, 64, 5000 }) {
+                for (size_t maxThreads : { 0, 1, 2 }) {
+                    std::mutex mutex;
+                    Chunks chunks;
+                    std::vector<int> visits(count, 0);
+                    jobs.parallelFor(count, grainSize, [&](size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; ++i) ++visits[i];
+                        std::lock_guard<std::mutex> lock(mutex);
+                        chunks.emplace_back(begin, end);
+                    }, maxThreads);
+
+                    bool shared = workers > 0 && count > grainSize && maxThreads != 1;
+                    std::sort(chunks.begin(), chunks.end());
+                    EXPECT_EQ(chunks, referenceChunks(count, grainSize, shared))
+                        << workers << " workers, " << count << " / " << grainSize << ", max " << maxThreads;
+                    EXPECT_TRUE(std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }));
+                }
+            }
+        }
+    }
+}
+
+// Jobs that start their own parallel loops finish without deadlocking
+TEST(JobSystemTest, NestedParallelFor) {
+    JobSystem jobs(3);
+    for (int round = 0; round < 50; ++round) {
+        std::vector<long> sums(40, 0);
+        jobs.parallelFor(sums.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                std::atomic<long> sum(0);
+                jobs.parallelFor(1000, 37, [&](size_t innerBegin, size_t innerEnd) {
+                    long local = 0;
+                    for (size_t j = innerBegin; j < innerEnd; ++j) local += static_cast<long>(j * (i + 1));
+                    sum += local;
+                });
+                sums[i] = sum;
+            }
+        });
+        for (size_t i = 0; i < sums.size(); ++i) {
+            ASSERT_EQ(sums[i], 499500L * static_cast<long>(i + 1)) << "round " << round;
+        }
+    }
+}
+
+TEST(JobSystemTest, SubmitReturnsResults) {
+    for (size_t workers : { 0, 2 }) {
+        JobSystem jobs(workers);
+        std::vector<std::future<size_t>> results;
+        for (size_t i = 0; i < 200; ++i) {
+            results.push_back(jobs.submit([i]() { return i * i; }));
+        }
+        for (size_t i = 0; i < results.size(); ++i) {
+            EXPECT_EQ(results[i].get(), i * i) << workers << " workers";
+        }
+    }
+}
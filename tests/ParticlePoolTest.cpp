@@ -0,0 +1,157 @@
+#include "objects/ParticlePool.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+bool spawnAt(ParticlePool& pool, float x, float lifetime = 1.0f) {
+    return pool.spawn(glm::vec2(x, 0.0f), glm::vec2(0.0f), lifetime, 1.0f, glm::vec4(1.0f));
+}
+
+// Slots holding a live particle
+std::vector<size_t> liveSlots(const ParticlePool& pool) {
+    std::vector<size_t> slots;
+    for (size_t i = 0; i < pool.size(); ++i) {
+        if (pool.alive[i] != 0.0f) slots.push_back(i);
+    }
+    return slots;
+}
+
+} // namespace
+
+// Particles die on the step their age reaches their lifetime, fading
+// linearly until then. Quarter-second steps keep the ages exact.
+TEST(ParticlePoolTest, ParticlesExpireAtTheirLifetime) {
+    ParticlePool pool;
+    pool.setCapacity(64);
+    const float lifetimes[] = { 0.25f, 0.5f, 1.0f, 1.5f, 3.0f };
+    for (int i = 0; i < 40; ++i) spawnAt(pool, static_cast<float>(i), lifetimes[i % 5]);
+
+    for (int step = 1; step <= 12; ++step) {
+        pool.integrate(glm::vec2(0.0f), 1.0f, 0.0f, 1.0f, 0.25f, 0, pool.size());
+        float age = step * 0.25f;
+        for (size_t i = 0; i < pool.size(); ++i) {
+            if (pool.alive[i] == 0.0f) continue;
+            ASSERT_EQ(pool.age[i], age);
+            ASSERT_FLOAT_EQ(pool.opacity[i], 1.0f - std::min(age / pool.lifetime[i], 1.0f)) << "slot " << i;
+        }
+
+        pool.collectExpired();
+        size_t expected = 0;
+        for (int i = 0; i < 40; ++i) {
+            bool alive = lifetimes[i % 5] > age;
+            expected += alive;
+            ASSERT_EQ(pool.alive[i] != 0.0f, alive) << "slot " << i << " after " << age << " s";
+        }
+        ASSERT_EQ(pool.getAliveCount(), expected);
+        ASSERT_EQ(pool.freeSlots.size(), 40 - expected);
+    }
+    EXPECT_EQ(pool.getAliveCount(), 0u);
+}
+
+// Freed slots are handed out newest first and the live particles keep
+// their slots, so nothing moves while it lives
+TEST(ParticlePoolTest, FreedSlotsAreReused) {
+    ParticlePool pool;
+    pool.setCapacity(12);
+    for (int i = 0; i < 10; ++i) spawnAt(pool, static_cast<float>(i));
+
+    for (size_t slot : { 2, 7, 5 }) pool.kill(slot);
+    pool.kill(5);
+    pool.kill(40);
+    EXPECT_EQ(pool.getAliveCount(), 7u);
+    EXPECT_EQ(pool.opacity[7], 0.0f);
+    EXPECT_EQ(liveSlots(pool), (std::vector<size_t>{ 0, 1, 3, 4, 6, 8, 9 }));
+
+    spawnAt(pool, 50.0f);
+    spawnAt(pool, 51.0f);
+    EXPECT_EQ(pool.positionX[5], 50.0f);
+    EXPECT_EQ(pool.positionX[7], 51.0f);
+    EXPECT_EQ(pool.size(), 10u);
+
+    spawnAt(pool, 52.0f);
+    spawnAt(pool, 53.0f);
+    EXPECT_EQ(pool.positionX[2], 52.0f);
+    EXPECT_EQ(pool.positionX[10], 53.0f);
+    EXPECT_EQ(pool.size(), 11u);
+    for (size_t slot : { 0, 1, 3, 4, 6, 8, 9 }) EXPECT_EQ(pool.positionX[slot], static_cast<float>(slot));
+}
+
+// Spawning into a full pool does nothing until a particle dies; shrinking
+// the pool kills the particles past the new capacity
+TEST(ParticlePoolTest, SpawnStopsAtCapacity) {
+    ParticlePool pool;
+    pool.setCapacity(3);
+    EXPECT_TRUE(spawnAt(pool, 0.0f, 0.5f));
+    EXPECT_TRUE(spawnAt(pool, 1.0f));
+    EXPECT_TRUE(spawnAt(pool, 2.0f));
+    EXPECT_FALSE(spawnAt(pool, 3.0f));
+    EXPECT_EQ(pool.size(), 3u);
+    EXPECT_EQ(pool.getAliveCount(), 3u);
+
+    pool.integrate(glm::vec2(0.0f), 1.0f, 0.0f, 1.0f, 0.5f, 0, pool.size());
+    pool.collectExpired();
+    EXPECT_TRUE(spawnAt(pool, 4.0f));
+    EXPECT_EQ(pool.positionX[0], 4.0f);
+    EXPECT_FALSE(spawnAt(pool, 5.0f));
+
+    pool.kill(1);
+    pool.setCapacity(1);
+    EXPECT_EQ(pool.size(), 1u);
+    EXPECT_EQ(pool.getAliveCount(), 1u);
+    EXPECT_TRUE(pool.freeSlots.empty());
+    EXPECT_FALSE(spawnAt(pool, 6.0f));
+
+    pool.setCapacity(2);
+    EXPECT_TRUE(spawnAt(pool, 7.0f));
+    EXPECT_EQ(pool.positionX[1], 7.0f);
+}
+
+// One step of motion for the live particles of a range, across SIMD
+// groups and the scalar tail, with dead and out-of-range slots untouched
+TEST(ParticlePoolTest, StepMovesLiveParticlesInRange) {
+    ParticlePool pool;
+    pool.setCapacity(19);
+    for (int i = 0; i < 19; ++i) {
+        pool.spawn(glm::vec2(i, -i), glm::vec2(10.0f, 2.0f * i), 2.0f, 1.0f + i, glm::vec4(1.0f));
+    }
+    for (size_t slot = 0; slot < 19; slot += 3) pool.kill(slot);
+    const ParticlePool before = pool;
+
+    pool.integrate(glm::vec2(0.0f, -10.0f), 0.5f, 4.0f, 1.0f, 0.5f, 2, 17);
+    for (size_t i = 0; i < 19; ++i) {
+        if (i < 2 || i >= 17 || before.alive[i] == 0.0f) {
+            EXPECT_EQ(pool.positionY[i], before.positionY[i]) << "slot " << i;
+            EXPECT_EQ(pool.age[i], before.age[i]) << "slot " << i;
+            EXPECT_EQ(pool.opacity[i], before.opacity[i]) << "slot " << i;
+            continue;
+        }
+        float velocityY = (2.0f * i - 5.0f) * 0.5f;
+        EXPECT_FLOAT_EQ(pool.velocityX[i], 5.0f) << "slot " << i;
+        EXPECT_FLOAT_EQ(pool.velocityY[i], velocityY) << "slot " << i;
+        EXPECT_FLOAT_EQ(pool.positionX[i], i + 2.5f) << "slot " << i;
+        EXPECT_FLOAT_EQ(pool.positionY[i], -static_cast<float>(i) + velocityY * 0.5f) << "slot " << i;
+        EXPECT_FLOAT_EQ(pool.radius[i], 3.0f + i) << "slot " << i;
+        EXPECT_FLOAT_EQ(pool.opacity[i], 0.75f) << "slot " << i;
+    }
+}
+
+// Bounds cover the radius of every live particle in the range
+TEST(ParticlePoolTest, BoundsCoverLiveParticles) {
+    ParticlePool pool;
+    pool.setCapacity(8);
+    pool.spawn(glm::vec2(-5.0f, 1.0f), glm::vec2(0.0f), 1.0f, 2.0f, glm::vec4(1.0f));
+    pool.spawn(glm::vec2(100.0f, 100.0f), glm::vec2(0.0f), 1.0f, 1.0f, glm::vec4(1.0f));
+    pool.spawn(glm::vec2(3.0f, -4.0f), glm::vec2(0.0f), 1.0f, 0.5f, glm::vec4(1.0f));
+    pool.kill(1);
+
+    glm::vec2 min, max;
+    pool.computeBounds(0, pool.size(), min, max);
+    EXPECT_EQ(min, glm::vec2(-7.0f, -4.5f));
+    EXPECT_EQ(max, glm::vec2(3.5f, 3.0f));
+
+    pool.computeBounds(1, 2, min, max);
+    EXPECT_GT(min.x, max.x);
+    EXPECT_GT(min.y, max.y);
+}
@@ -0,0 +1,80 @@
+#include "engine/PhysicsBodyStore.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+PhysicsBodyStore makeStore(size_t count) {
+    std::mt19937 random(5);
+    auto uniform = [&](float min, float max) { return std::uniform_real_distribution<float>(min, max)(random); };
+
+    PhysicsBodyStore store;
+    store.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        store.setPosition(i, glm::vec3(uniform(-500.0f, 500.0f), uniform(-500.0f, 500.0f), uniform(-1.0f, 1.0f)));
+        store.setVelocity(i, glm::vec3(uniform(-50.0f, 50.0f), uniform(-50.0f, 50.0f), uniform(-1.0f, 1.0f)));
+        store.accelerationX[i] = uniform(-20.0f, 20.0f);
+        store.accelerationY[i] = uniform(-20.0f, 20.0f);
+        store.accelerationZ[i] = uniform(-1.0f, 1.0f);
+        store.gravityScale[i] = (random() % 4) ? 1.0f : 0.0f;
+        // Runs of movable and fixed bodies, so whole SIMD lanes get skipped too
+        store.movable[i] = ((i / 9) % 3 == 2 || random() % 5 == 0) ? 0.0f : 1.0f;
+    }
+    return store;
+}
+
+// One body at a time, straight from the documented update
+void referenceIntegrate(PhysicsBodyStore& store, const glm::vec3& gravity, float airResistance, float deltaTime,
+                        size_t begin, size_t end) {
+    const float damping = 1.0f - airResistance * deltaTime;
+    for (size_t i = begin; i < end; ++i) {
+        if (store.movable[i] == 0.0f) continue;
+        glm::vec3 acceleration = store.getAcceleration(i) + gravity * store.gravityScale[i];
+        glm::vec3 velocity = (store.getVelocity(i) + acceleration * deltaTime) * damping;
+        store.setPosition(i, store.getPosition(i) + velocity * deltaTime);
+        store.setVelocity(i, velocity);
+        store.accelerationX[i] = store.accelerationY[i] = store.accelerationZ[i] = 0.0f;
+    }
+}
+
+void expectSameBodies(const PhysicsBodyStore& actual, const PhysicsBodyStore& expected) {
+    const std::vector<float> PhysicsBodyStore::*arrays[] = {
+        &PhysicsBodyStore::positionX, &PhysicsBodyStore::positionY, &PhysicsBodyStore::positionZ,
+        &PhysicsBodyStore::velocityX, &PhysicsBodyStore::velocityY, &PhysicsBodyStore::velocityZ,
+        &PhysicsBodyStore::accelerationX, &PhysicsBodyStore::accelerationY, &PhysicsBodyStore::accelerationZ
+    };
+    for (auto array : arrays) {
+        for (size_t i = 0; i < actual.size(); ++i) {
+            ASSERT_FLOAT_EQ((actual.*array)[i], (expected.*array)[i]) << "body " << i;
+        }
+    }
+}
+
+} // namespace
+
+TEST(PhysicsBodyStoreTest, SimdIntegrateMatchesScalar) {
+    PhysicsBodyStore store = makeStore(1003);
+    PhysicsBodyStore expected = store;
+    const glm::vec3 gravity(0.0f, -981.0f, 0.0f);
+
+    for (int step = 0; step < 5; ++step) {
+        store.integrate(gravity, 0.3f, 1.0f / 120.0f);
+        referenceIntegrate(expected, gravity, 0.3f, 1.0f / 120.0f, 0, expected.size());
+    }
+    expectSameBodies(store, expected);
+}
+
+// Ranges that split SIMD blocks leave everything outside them alone
+TEST(PhysicsBodyStoreTest, SimdIntegrateRespectsRanges) {
+    PhysicsBodyStore store = makeStore(517);
+    PhysicsBodyStore expected = store;
+    const glm::vec3 gravity(3.0f, -9.81f, 0.5f);
+    const size_t bounds[] = { 0, 3, 10, 11, 250, 509, 517 };
+
+    for (size_t r = 0; r + 1 < sizeof(bounds) / sizeof(bounds[0]); r += 2) {
+        store.integrate(gravity, 0.1f, 0.02f, bounds[r], bounds[r + 1]);
+        referenceIntegrate(expected, gravity, 0.1f, 0.02f, bounds[r], bounds[r + 1]);
+    }
+    expectSameBodies(store, expected);
+}
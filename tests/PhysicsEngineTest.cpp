@@ -0,0 +1,201 @@
+#include "engine/PhysicsEngine.h"
+#include "objects/Shape.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace {
+
+const float kStep = 1.0f / 60.0f;
+const BroadphaseType kBroadphases[] = { BroadphaseType::AllPairs, BroadphaseType::SpatialHash,
+                                        BroadphaseType::SweepAndPrune };
+
+// Engine with no gravity or drag, so bodies move exactly velocity * dt per step
+std::unique_ptr<PhysicsEngine> makeEngine(BroadphaseType broadphase) {
+    auto engine = std::make_unique<PhysicsEngine>();
+    engine->setEnabled(true);
+    engine->setGravity(glm::vec3(0.0f));
+    engine->setAirResistance(0.0f);
+    engine->setBroadphase(broadphase);
+    return engine;
+}
+
+std::shared_ptr<Line> makeWall(float x, float thickness) {
+    auto wall = std::make_shared<Line>(x, -50.0f, x, 50.0f);
+    wall->setThickness(thickness);
+    wall->setStatic(true);
+    wall->setBounce(1.0f);
+    return wall;
+}
+
+// Balls dropped into a walled pit with random velocities, dense enough
+// that the contact solver splits them into islands
+void buildPile(PhysicsEngine& engine) {
+    engine.setEnabled(true);
+    engine.addGroundConstraint(0.0f);
+    engine.addWallConstraint(-120.0f, 0.0f, 240.0f, 1000.0f);
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (int i = 0; i < 400; ++i) {
+        auto ball = std::make_shared<Circle>((i % 20) * 11.0f - 105.0f, 10.0f + (i / 20) * 11.0f, 2.5f);
+        ball->setVelocity(unit(random) * 80.0f, unit(random) * 80.0f);
+        ball->setBounce(0.5f);
+        ball->setMass(1.0f + (i % 3));
+        ball->setGravityAffected(true);
+        engine.addObject(ball);
+    }
+    auto ramp = std::make_shared<Line>(-120.0f, 80.0f, 0.0f, 20.0f);
+    ramp->setStatic(true);
+    engine.addObject(ramp);
+}
+
+void expectSameBodies(const PhysicsEngine::State& expected, const PhysicsEngine::State& actual,
+                      const std::string& label) {
+    ASSERT_EQ(expected.bodies.size(), actual.bodies.size());
+    for (size_t i = 0; i < expected.bodies.size(); ++i) {
+        const PhysicsEngine::BodyState& a = expected.bodies[i];
+        const PhysicsEngine::BodyState& b = actual.bodies[i];
+        ASSERT_EQ(std::memcmp(&a.position, &b.position, sizeof(glm::vec3)), 0) << label << ", body " << i;
+        ASSERT_EQ(std::memcmp(&a.velocity, &b.velocity, sizeof(glm::vec3)), 0) << label << ", body " << i;
+        ASSERT_EQ(a.restingSteps, b.restingSteps) << label << ", body " << i;
+        ASSERT_EQ(a.sleeping, b.sleeping) << label << ", body " << i;
+    }
+}
+
+} // namespace
+
+// A ball covering 100 units per step bounces off a 1-unit wall it would
+// otherwise jump over, whether or not it is flagged as fast
+TEST(PhysicsEngineTest, FastCircleStopsAtWall) {
+    for (BroadphaseType broadphase : kBroadphases) {
+        for (bool flagged : { false, true }) {
+            auto engine = makeEngine(broadphase);
+            auto wall = makeWall(150.0f, 1.0f);
+            auto ball = std::make_shared<Circle>(0.0f, 0.0f, 2.0f);
+            ball->setVelocity(6000.0f, 0.0f);
+            ball->setBounce(1.0f);
+            ball->setFastMoving(flagged);
+            engine->addObject(wall);
+            engine->addObject(ball);
+
+            for (int step = 0; step < 30; ++step) {
+                engine->step(kStep);
+                ASSERT_LT(ball->getPosition().x, 150.0f) << "step " << step << (flagged ? ", flagged" : "");
+            }
+            EXPECT_FLOAT_EQ(ball->getVelocity().x, -6000.0f);
+            EXPECT_EQ(wall->getPosition().x, 150.0f);
+        }
+    }
+
+    // Without the sweep the same ball passes straight through
+    auto engine = makeEngine(BroadphaseType::SpatialHash);
+    engine->enableContinuousCollision(false);
+    auto wall = makeWall(150.0f, 1.0f);
+    auto ball = std::make_shared<Circle>(0.0f, 0.0f, 2.0f);
+    ball->setVelocity(6000.0f, 0.0f);
+    engine->addObject(wall);
+    engine->addObject(ball);
+    engine->step(kStep);
+    engine->step(kStep);
+    EXPECT_GT(ball->getPosition().x, 150.0f);
+}
+
+// A fast ball hands its momentum to a resting one instead of passing it
+TEST(PhysicsEngineTest, FastCircleHitsCircle) {
+    for (BroadphaseType broadphase : kBroadphases) {
+        for (bool flagged : { false, true }) {
+            auto engine = makeEngine(broadphase);
+            auto target = std::make_shared<Circle>(150.0f, 0.0f, 2.0f);
+            auto ball = std::make_shared<Circle>(0.0f, 0.0f, 2.0f);
+            ball->setVelocity(6000.0f, 0.0f);
+            ball->setFastMoving(flagged);
+            engine->addObject(target);
+            engine->addObject(ball);
+
+            for (int step = 0; step < 30; ++step) {
+                engine->step(kStep);
+                ASSERT_LT(ball->getPosition().x, target->getPosition().x) << "step " << step;
+            }
+            EXPECT_GT(target->getVelocity().x, 0.0f);
+            EXPECT_LE(ball->getVelocity().x, target->getVelocity().x);
+            EXPECT_FLOAT_EQ(ball->getVelocity().x + target->getVelocity().x, 6000.0f);
+        }
+    }
+}
+
+// Moving just over its radius per step, an unflagged ball can land with its
+// center past a zero-width wall yet still overlapping it; the discrete
+// contact would then push it out on the far side. The sweep starts there.
+TEST(PhysicsEngineTest, SweepStartsAboveRadiusPerStep) {
+    for (bool continuous : { true, false }) {
+        auto engine = makeEngine(BroadphaseType::SpatialHash);
+        engine->enableContinuousCollision(continuous);
+        auto wall = makeWall(100.0f, 0.0f);
+        auto ball = std::make_shared<Circle>(0.0f, 0.0f, 2.0f);
+        engine->addObject(wall);
+        engine->addObject(ball);
+
+        // The radius the engine collides the circle with
+        const float radius = ball->getScale().x;
+        const float motion = radius * 1.05f;
+        ball->setPosition(100.0f - radius - 0.1f - 5.0f * motion, 0.0f, 0.0f);
+        ball->setVelocity(motion / kStep, 0.0f);
+
+        float farthest = ball->getPosition().x;
+        for (int step = 0; step < 10; ++step) {
+            engine->step(kStep);
+            farthest = std::max(farthest, ball->getPosition().x);
+        }
+        if (continuous) {
+            EXPECT_LT(farthest, 100.0f - radius + 0.01f);
+        } else {
+            EXPECT_GT(ball->getPosition().x, 100.0f);
+        }
+    }
+}
+
+// Islands are solved in pair order, so the thread count never changes a bit
+TEST(PhysicsEngineTest, ThreadCountDoesNotChangeResults) {
+    PhysicsEngine::State reference;
+    for (size_t threads : { 1, 2, 0 }) {
+        PhysicsEngine engine;
+        buildPile(engine);
+        engine.setThreadCount(threads);
+
+        for (int step = 0; step < 240; ++step) {
+            engine.step(kStep);
+        }
+        PhysicsEngine::State state;
+        engine.saveState(state);
+        if (threads == 1) {
+            reference = state;
+        } else {
+            expectSameBodies(reference, state, std::to_string(threads) + " threads");
+        }
+    }
+}
+
+// The fixed step makes the simulation independent of the frame rate:
+// after three seconds every rate has run the same 180 steps
+TEST(PhysicsEngineTest, FrameRateDoesNotChangeResults) {
+    PhysicsEngine::State reference;
+    for (int fps : { 60, 30, 24 }) {
+        PhysicsEngine engine;
+        buildPile(engine);
+
+        for (int frame = 0; frame < 3 * fps; ++frame) {
+            engine.update(1.0f / fps);
+        }
+        PhysicsEngine::State state;
+        engine.saveState(state);
+        if (fps == 60) {
+            reference = state;
+        } else {
+            expectSameBodies(reference, state, std::to_string(fps) + " fps");
+        }
+    }
+}
@@ -0,0 +1,171 @@
+#include "rendering/SoftwareRasterizer.h"
+#include <gtest/gtest.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int kWidth = 203;
+const int kHeight = 157;
+const glm::vec4 kBackground(0.1f, 0.2f, 0.3f, 1.0f);
+
+// Quads and circles of every size, rotated, squashed, translucent and
+// partly off screen
+std::vector<RenderInstance> makeInstances(unsigned seed, size_t count) {
+    std::mt19937 random(seed);
+    auto uniform = [&](float min, float max) { return std::uniform_real_distribution<float>(min, max)(random); };
+
+    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(kWidth), 0.0f, static_cast<float>(kHeight), -1.0f, 1.0f);
+    RenderBatch batch;
+    for (size_t i = 0; i < count; ++i) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(uniform(-20.0f, kWidth + 20.0f),
+                                                                      uniform(-20.0f, kHeight + 20.0f), 0.0f));
+        model = glm::rotate(model, uniform(0.0f, 6.3f), glm::vec3(0.0f, 0.0f, 1.0f));
+        float size = (i % 7 == 0) ? uniform(60.0f, 160.0f) : uniform(0.5f, 30.0f);
+        model = glm::scale(model, glm::vec3(size, size * uniform(0.3f, 1.5f), 1.0f));
+
+        glm::vec4 color(uniform(0.0f, 1.0f), uniform(0.0f, 1.0f), uniform(0.0f, 1.0f),
+                        (i % 3 == 0) ? 1.0f : uniform(0.1f, 1.0f));
+        if (i % 2 == 0) {
+            batch.addQuad(projection * model, color);
+        } else {
+            batch.addCircle(projection * model, color);
+        }
+    }
+    return batch.getInstances();
+}
+
+// Straight per-pixel evaluation of the documented coverage and blending,
+// over the whole target with no bounds, block classification or spans
+void referenceDraw(Framebuffer& target, const RenderInstance& instance, bool antialiasing) {
+    const int width = target.getWidth();
+    const int height = target.getHeight();
+    float w = instance.origin.w;
+    glm::vec2 scale(0.5f * width / w, -0.5f * height / w);
+    glm::vec2 origin(instance.origin.x * scale.x + 0.5f * width, instance.origin.y * scale.y + 0.5f * height);
+    glm::vec2 axisX = glm::vec2(instance.axisX) * scale;
+    glm::vec2 axisY = glm::vec2(instance.axisY) * scale;
+    float determinant = axisX.x * axisY.y - axisY.x * axisX.y;
+    glm::vec3 localX = glm::vec3(axisY.y, -axisY.x, axisY.x * origin.y - axisY.y * origin.x) / determinant;
+    glm::vec3 localY = glm::vec3(-axisX.y, axisX.x, axisX.y * origin.x - axisX.x * origin.y) / determinant;
+
+    bool circle = static_cast<int>(instance.shape) == RenderInstance::Circle;
+    glm::vec3 edges[4];
+    float pixelRadius = std::sqrt(std::abs(determinant));
+    glm::vec3 half(0.0f, 0.0f, 0.5f);
+    float gradientX = glm::length(glm::vec2(localX));
+    float gradientY = glm::length(glm::vec2(localY));
+    edges[0] = (half - localX) / gradientX;
+    edges[1] = (half + localX) / gradientX;
+    edges[2] = (half - localY) / gradientY;
+    edges[3] = (half + localY) / gradientY;
+
+    auto evaluate = [](const glm::vec3& function, float x, float y) { return function.x * x + function.y * y + function.z; };
+    auto coverageOf = [&](float distance) {
+        return antialiasing ? std::min(std::max(distance + 0.5f, 0.0f), 1.0f) : (distance >= 0.0f ? 1.0f : 0.0f);
+    };
+
+    float color[4] = { glm::clamp(instance.color.r, 0.0f, 1.0f) * 255.0f, glm::clamp(instance.color.g, 0.0f, 1.0f) * 255.0f,
+                       glm::clamp(instance.color.b, 0.0f, 1.0f) * 255.0f, 255.0f };
+    float alpha = glm::clamp(instance.color.a, 0.0f, 1.0f);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            float px = x + 0.5f, py = y + 0.5f;
+            float coverage;
+            if (circle) {
+                float lx = evaluate(localX, px, py);
+                float ly = evaluate(localY, px, py);
+                coverage = coverageOf((1.0f - std::sqrt(lx * lx + ly * ly)) * pixelRadius);
+            } else {
+                coverage = coverageOf(evaluate(edges[0], px, py));
+                for (int i = 1; i < 4; ++i) coverage *= coverageOf(evaluate(edges[i], px, py));
+            }
+
+            float pixelAlpha = alpha * coverage;
+            uint8_t* pixel = target.getPixels() + (static_cast<size_t>(y) * width + x) * 4;
+            for (int c = 0; c < 4; ++c) {
+                pixel[c] = static_cast<uint8_t>(color[c] * pixelAlpha + pixel[c] * (1.0f - pixelAlpha) + 0.5f);
+            }
+        }
+    }
+}
+
+// Round blob distance field for glyph instances, spread 4 texels
+std::vector<uint8_t> makeGlyphAtlas(int size) {
+    std::vector<uint8_t> atlas(static_cast<size_t>(size) * size);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            float distance = size * 0.35f - glm::length(glm::vec2(x + 0.5f, y + 0.5f) - glm::vec2(size * 0.5f));
+            atlas[y * size + x] = static_cast<uint8_t>(glm::clamp(128.0f + distance * 32.0f, 0.0f, 255.0f));
+        }
+    }
+    return atlas;
+}
+
+size_t countDifferences(const Framebuffer& a, const Framebuffer& b) {
+    size_t differences = 0;
+    for (size_t i = 0; i < a.getSizeInBytes(); ++i) differences += a.getPixels()[i] != b.getPixels()[i];
+    return differences;
+}
+
+} // namespace
+
+// Skipped, filled and per-pixel blocks must all give the reference pixels
+TEST(SoftwareRasterizerTest, BlocksMatchPerPixelReference) {
+    std::vector<RenderInstance> instances = makeInstances(3, 120);
+    for (bool antialiasing : { true, false }) {
+        SoftwareRasterizer rasterizer;
+        rasterizer.setAntialiasing(antialiasing);
+        Framebuffer actual(kWidth, kHeight), expected(kWidth, kHeight);
+        actual.clear(kBackground);
+        expected.clear(kBackground);
+
+        for (const RenderInstance& instance : instances) {
+            rasterizer.draw(actual, instance);
+            referenceDraw(expected, instance, antialiasing);
+        }
+        EXPECT_EQ(countDifferences(actual, expected), 0u) << "antialiasing " << antialiasing;
+    }
+}
+
+// Binned tiles must match drawing every instance in turn. Lists are only
+// tiled with more than one job system thread, while redraw() bins them on
+// every machine, so both are checked.
+TEST(SoftwareRasterizerTest, TiledMatchesSerial) {
+    const int atlasSize = 32;
+    std::vector<uint8_t> atlas = makeGlyphAtlas(atlasSize);
+    std::vector<RenderInstance> instances = makeInstances(9, 600);
+    for (size_t i = 0; i < instances.size(); i += 5) {
+        instances[i].shape = static_cast<float>(RenderInstance::Glyph);
+        instances[i].texRect = glm::vec4(0.0f, 0.0f, atlasSize, atlasSize);
+        instances[i].glyphEdge = glm::vec2(0.5f * (i % 3), 0.0f);
+    }
+
+    for (bool antialiasing : { true, false }) {
+        SoftwareRasterizer tiled, serial;
+        for (SoftwareRasterizer* rasterizer : { &tiled, &serial }) {
+            rasterizer->setAntialiasing(antialiasing);
+            rasterizer->setGlyphAtlas(atlas.data(), atlasSize, atlasSize, 4.0f);
+        }
+        tiled.setThreadCount(0);
+        serial.setThreadCount(1);
+
+        Framebuffer actual(kWidth, kHeight), expected(kWidth, kHeight), repainted(kWidth, kHeight);
+        actual.clear(kBackground);
+        expected.clear(kBackground);
+        repainted.clear(glm::vec4(1.0f));
+        tiled.draw(actual, instances.data(), instances.size());
+        for (const RenderInstance& instance : instances) {
+            serial.draw(expected, instance);
+        }
+        PixelRect frame{ 0, 0, kWidth, kHeight };
+        tiled.redraw(repainted, instances.data(), instances.size(), &frame, 1, kBackground);
+
+        EXPECT_EQ(countDifferences(actual, expected), 0u) << "antialiasing " << antialiasing;
+        EXPECT_EQ(countDifferences(repainted, expected), 0u) << "antialiasing " << antialiasing;
+    }
+}
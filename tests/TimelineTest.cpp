@@ -0,0 +1,162 @@
+#include "engine/Timeline.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Quarter-second updates land exactly on whole and half seconds
+const float kFrame = 0.25f;
+
+struct Recorder {
+    std::vector<float> times;
+
+    Timeline::TimelineCallback callback() {
+        return [this](float time) { times.push_back(time); };
+    }
+};
+
+void playTo(Timeline& timeline, float time) {
+    timeline.play();
+    while (timeline.getCurrentTime() < time) {
+        timeline.update(kFrame);
+    }
+}
+
+std::vector<uint32_t> activeIntervals(const Timeline& timeline) {
+    std::vector<uint32_t> handles;
+    timeline.getActiveIntervals(handles);
+    std::sort(handles.begin(), handles.end());
+    return handles;
+}
+
+} // namespace
+
+// Each callback fires on the update that reaches its time, and only then
+TEST(TimelineTest, CallbacksFireOnceWhenCrossed) {
+    Timeline timeline;
+    timeline.setDuration(10.0f);
+    Recorder early, onFrame, betweenFrames, twin, late;
+    timeline.addTimeCallback(0.0f, early.callback());
+    timeline.addTimeCallback(1.0f, onFrame.callback());
+    timeline.addTimeCallback(1.1f, betweenFrames.callback());
+    timeline.addTimeCallback(1.0f, twin.callback());
+    timeline.addTimeCallback(9.0f, late.callback());
+
+    playTo(timeline, 3.0f);
+    EXPECT_EQ(early.times, std::vector<float>{ 0.25f });
+    EXPECT_EQ(onFrame.times, std::vector<float>{ 1.0f });
+    EXPECT_EQ(twin.times, std::vector<float>{ 1.0f });
+    EXPECT_EQ(betweenFrames.times, std::vector<float>{ 1.25f });
+    EXPECT_TRUE(late.times.empty());
+
+    // Pausing and stalled updates fire nothing again
+    timeline.pause();
+    timeline.update(kFrame);
+    timeline.play();
+    timeline.update(0.0f);
+    EXPECT_EQ(onFrame.times.size(), 1u);
+
+    // Removed callbacks stay silent; the end of the timeline is reached
+    timeline.removeTimeCallback(9.0f);
+    playTo(timeline, 10.0f);
+    EXPECT_TRUE(late.times.empty());
+    EXPECT_EQ(onFrame.times.size(), 1u);
+}
+
+// Callbacks and intervals added behind the playhead have been passed,
+// whether or not anything before them fired
+TEST(TimelineTest, CallbacksAddedBehindPlayheadDontFire) {
+    Timeline timeline;
+    timeline.setDuration(10.0f);
+    playTo(timeline, 2.0f);
+
+    Recorder behind, atPlayhead, ahead, enter, exit;
+    timeline.addTimeCallback(1.0f, behind.callback());
+    timeline.addTimeCallback(2.0f, atPlayhead.callback());
+    timeline.addTimeCallback(2.5f, ahead.callback());
+    timeline.addIntervalCallback(0.5f, 1.5f, enter.callback(), exit.callback());
+    timeline.update(kFrame);
+    EXPECT_TRUE(behind.times.empty());
+    EXPECT_EQ(atPlayhead.times, std::vector<float>{ 2.25f });
+    EXPECT_TRUE(ahead.times.empty());
+
+    // Now there are fired callbacks before the new ones
+    timeline.addTimeCallback(2.0f, behind.callback());
+    timeline.addTimeCallback(0.0f, behind.callback());
+    playTo(timeline, 4.0f);
+    EXPECT_TRUE(behind.times.empty());
+    EXPECT_EQ(ahead.times, std::vector<float>{ 2.5f });
+    EXPECT_EQ(atPlayhead.times.size(), 1u);
+    EXPECT_TRUE(enter.times.empty());
+    EXPECT_TRUE(exit.times.empty());
+}
+
+// A seek enters the intervals containing the new time and exits the ones
+// that no longer do; time callbacks it jumps over stay silent
+TEST(TimelineTest, SeekEntersAndExitsIntervals) {
+    Timeline timeline;
+    timeline.setDuration(10.0f);
+    Recorder enter, exit, other, callback;
+    uint32_t handle = timeline.addIntervalCallback(1.0f, 3.0f, enter.callback(), exit.callback());
+    uint32_t otherHandle = timeline.addIntervalCallback(2.0f, 5.0f, other.callback(), nullptr);
+    timeline.addTimeCallback(1.5f, callback.callback());
+
+    timeline.setCurrentTime(2.5f);
+    EXPECT_EQ(enter.times, std::vector<float>{ 2.5f });
+    EXPECT_EQ(other.times, std::vector<float>{ 2.5f });
+    EXPECT_EQ(activeIntervals(timeline), (std::vector<uint32_t>{ handle, otherHandle }));
+
+    timeline.setCurrentTime(1.5f);
+    EXPECT_EQ(enter.times.size(), 1u);
+    EXPECT_TRUE(exit.times.empty());
+    EXPECT_EQ(activeIntervals(timeline), std::vector<uint32_t>{ handle });
+
+    timeline.setCurrentTime(6.0f);
+    EXPECT_EQ(exit.times, std::vector<float>{ 6.0f });
+    EXPECT_TRUE(activeIntervals(timeline).empty());
+    playTo(timeline, 7.0f);
+    EXPECT_TRUE(callback.times.empty());
+
+    // Back before the interval, playback enters and exits it again
+    timeline.setCurrentTime(0.5f);
+    playTo(timeline, 4.0f);
+    EXPECT_EQ(enter.times, (std::vector<float>{ 2.5f, 1.0f }));
+    EXPECT_EQ(exit.times, (std::vector<float>{ 6.0f, 3.0f }));
+    EXPECT_EQ(callback.times, std::vector<float>{ 1.5f });
+}
+
+// Ranges are [start, end). A seek landing exactly on a start leaves the
+// entry, like a callback at that time, to the next update; one landing on
+// an end exits.
+TEST(TimelineTest, SeekToBoundaries) {
+    Timeline timeline;
+    timeline.setDuration(10.0f);
+    Recorder enter, exit, callback;
+    timeline.addIntervalCallback(1.0f, 3.0f, enter.callback(), exit.callback());
+    timeline.addTimeCallback(1.0f, callback.callback());
+
+    timeline.setCurrentTime(1.0f);
+    EXPECT_TRUE(enter.times.empty());
+    EXPECT_TRUE(callback.times.empty());
+    EXPECT_TRUE(activeIntervals(timeline).empty());
+
+    timeline.play();
+    timeline.update(0.0f);
+    EXPECT_EQ(enter.times, std::vector<float>{ 1.0f });
+    EXPECT_EQ(callback.times, std::vector<float>{ 1.0f });
+    timeline.update(kFrame);
+    EXPECT_EQ(enter.times.size(), 1u);
+    EXPECT_EQ(callback.times.size(), 1u);
+
+    timeline.setCurrentTime(3.0f);
+    EXPECT_EQ(exit.times, std::vector<float>{ 3.0f });
+    timeline.update(kFrame);
+    EXPECT_EQ(exit.times.size(), 1u);
+
+    // Playback reaching the end exactly exits too
+    timeline.setCurrentTime(2.0f);
+    EXPECT_EQ(enter.times.size(), 2u);
+    playTo(timeline, 3.0f);
+    EXPECT_EQ(exit.times, (std::vector<float>{ 3.0f, 3.0f }));
+}
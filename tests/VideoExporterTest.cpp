@@ -0,0 +1,119 @@
+#include "export/VideoExporter.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Whole-frame RGBA -> I420 with the exporter's BT.601 arithmetic, pixel by pixel
+std::vector<uint8_t> referenceI420(const std::vector<uint8_t>& rgba, int width, int height) {
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    std::vector<uint8_t> out(width * height + chromaWidth * chromaHeight * 2);
+    uint8_t* u = out.data() + width * height;
+    uint8_t* v = u + chromaWidth * chromaHeight;
+
+    auto channel = [&](int x, int y, int c) {
+        x = std::min(x, width - 1);
+        y = std::min(y, height - 1);
+        return static_cast<int>(rgba[(y * width + x) * 4 + c]);
+    };
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int r = channel(x, y, 0), g = channel(x, y, 1), b = channel(x, y, 2);
+            out[y * width + x] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+    for (int cy = 0; cy < chromaHeight; ++cy) {
+        for (int cx = 0; cx < chromaWidth; ++cx) {
+            int sum[3];
+            for (int c = 0; c < 3; ++c) {
+                sum[c] = (channel(cx * 2, cy * 2, c) + channel(cx * 2 + 1, cy * 2, c) +
+                          channel(cx * 2, cy * 2 + 1, c) + channel(cx * 2 + 1, cy * 2 + 1, c) + 2) >> 2;
+            }
+            u[cy * chromaWidth + cx] = static_cast<uint8_t>(((-38 * sum[0] - 74 * sum[1] + 112 * sum[2] + 128) >> 8) + 128);
+            v[cy * chromaWidth + cx] = static_cast<uint8_t>(((112 * sum[0] - 94 * sum[1] - 18 * sum[2] + 128) >> 8) + 128);
+        }
+    }
+    return out;
+}
+
+std::vector<uint8_t> readFile(const std::string& path) {
+    std::vector<uint8_t> data;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return data;
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    fclose(file);
+    return data;
+}
+
+} // namespace
+
+// Damaged frames are converted region by region into the previous frame;
+// every written frame must still match a full conversion of its pixels
+TEST(VideoExporterTest, DamagedI420MatchesFullConversion) {
+    const int width = 37, height = 23, frames = 12;
+    const std::string path = ::testing::TempDir() + "kalem_video_exporter_test.y4m";
+
+    std::mt19937 random(7);
+    std::vector<uint8_t> image(width * height * 4);
+    for (uint8_t& byte : image) byte = static_cast<uint8_t>(random());
+
+    std::vector<std::vector<uint8_t>> expected;
+    VideoExporter exporter(2);
+    ASSERT_TRUE(exporter.open(path, width, height, 30));
+    for (int f = 0; f < frames; ++f) {
+        std::vector<PixelRect> damage;
+        if (f > 0) {
+            // Odd-aligned rectangles, some hanging off the frame
+            for (int r = 0; r < 3; ++r) {
+                PixelRect rect;
+                rect.x0 = static_cast<int>(random() % (width + 4)) - 2;
+                rect.y0 = static_cast<int>(random() % (height + 4)) - 2;
+                rect.x1 = rect.x0 + 1 + static_cast<int>(random() % 9);
+                rect.y1 = rect.y0 + 1 + static_cast<int>(random() % 7);
+                for (int y = std::max(rect.y0, 0); y < std::min(rect.y1, height); ++y) {
+                    for (int x = std::max(rect.x0, 0); x < std::min(rect.x1, width); ++x) {
+                        for (int c = 0; c < 4; ++c) image[(y * width + x) * 4 + c] = static_cast<uint8_t>(random());
+                    }
+                }
+                damage.push_back(rect);
+            }
+        }
+        expected.push_back(referenceI420(image, width, height));
+
+        VideoFrame* frame = exporter.acquireFrame();
+        ASSERT_NE(frame, nullptr);
+        frame->bottomUp = (f % 3) == 1;
+        for (int y = 0; y < height; ++y) {
+            int row = frame->bottomUp ? height - 1 - y : y;
+            std::copy(image.begin() + y * width * 4, image.begin() + (y + 1) * width * 4,
+                      frame->pixels.begin() + row * width * 4);
+        }
+        frame->damage = damage;
+        frame->hasDamage = f > 0;
+        exporter.submitFrame(frame);
+    }
+    ASSERT_TRUE(exporter.close());
+    EXPECT_EQ(exporter.getFramesWritten(), frames);
+
+    std::vector<uint8_t> file = readFile(path);
+    std::remove(path.c_str());
+    const std::string marker = "FRAME\n";
+    auto position = std::find(file.begin(), file.end(), '\n') + 1;
+    for (int f = 0; f < frames; ++f) {
+        ASSERT_GE(static_cast<size_t>(file.end() - position), marker.size() + expected[f].size()) << "frame " << f;
+        ASSERT_TRUE(std::equal(marker.begin(), marker.end(), position)) << "frame " << f;
+        position += marker.size();
+        EXPECT_TRUE(std::equal(expected[f].begin(), expected[f].end(), position)) << "frame " << f;
+        position += expected[f].size();
+    }
+    EXPECT_EQ(position, file.end());
+}